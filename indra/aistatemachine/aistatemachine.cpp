@@ -287,10 +287,23 @@ void AIEngine::add(AIStateMachine* state_machine)
   Dout(dc::statemachine(state_machine->mSMDebug), "Adding state machine [" << (void*)state_machine << "] to " << mName);
   engine_state_type_wat engine_state_w(mEngineState);
   engine_state_w->list.push_back(QueueElement(state_machine));
-  if (engine_state_w->waiting)
-  {
-	engine_state_w.signal();
-  }
+}
+
+void AIEngine::addStats(U64 run_clocks, U32 runs, U32 yields, U32 queue_depth)
+{
+  stats_type_wat stats_w(mStats);
+  stats_w->run_clocks += run_clocks;
+  stats_w->runs += runs;
+  stats_w->yields += yields;
+  stats_w->max_queue_depth = llmax(stats_w->max_queue_depth, queue_depth);
+}
+
+void AIEngine::printStats(void) const
+{
+  stats_type stats = getStats();
+  F64 const tfactor = 1000 / calc_clock_frequency();
+  llinfos << mName << ": " << stats.runs << " runs in " << (stats.run_clocks * tfactor) << " ms, "
+		  << stats.yields << " yields, max queue depth " << stats.max_queue_depth << "." << llendl;
 }
 
 #if STATE_MACHINE_PROFILING
@@ -328,12 +341,16 @@ void print_statemachine_diagnostics(U64 total_clocks, AIStateMachine::StateTimer
 void AIEngine::mainloop(void)
 {
   queued_type::iterator queued_element, end;
+  U32 queue_depth;
   {
 	engine_state_type_wat engine_state_w(mEngineState);
 	end = engine_state_w->list.end();
 	queued_element = engine_state_w->list.begin();
+	queue_depth = engine_state_w->list.size();
   }
   U64 total_clocks = 0;
+  U32 runs = 0;
+  U32 yields = 0;
 #if STATE_MACHINE_PROFILING
   queued_type::value_type slowest_element(NULL);
   AIStateMachine::StateTimerRoot::TimeData slowest_timer;
@@ -347,6 +364,7 @@ void AIEngine::mainloop(void)
 		AIStateMachine::StateTimerRoot timer(state_machine.getName());
 		state_machine.multiplex(AIStateMachine::normal_run);
 		time_data = timer.GetTimerData();
+		++runs;
 	}
 	if (U64 delta = time_data.GetDuration())
 	{
@@ -371,6 +389,7 @@ void AIEngine::mainloop(void)
 	else
 	{
 	  ++queued_element;
+	  ++yields;
 	}
 	if (total_clocks >= sMaxCount)
 	{
@@ -382,6 +401,7 @@ void AIEngine::mainloop(void)
 	  break;
 	}
   }
+  addStats(total_clocks, runs, yields, queue_depth);
 }
 
 void AIEngine::flush(void)
@@ -1364,105 +1384,125 @@ char const* AIStateMachine::state_str(base_state_type state)
 }
 
 AIEngine gMainThreadEngine("gMainThreadEngine");
-AIEngine gStateMachineThreadEngine("gStateMachineThreadEngine");
+AIThreadPoolEngine gStateMachineThreadEngine("gStateMachineThreadEngine");
 
-// State Machine Thread main loop.
-void AIEngine::threadloop(void)
+//-----------------------------------------------------------------------------
+// AIThreadPoolEngine
+
+class AIThreadPoolEngine::Job : public LLThreadPool::Job
 {
-  queued_type::iterator queued_element, end;
+  public:
+	Job(AIThreadPoolEngine& engine, queued_type::iterator queued_element) : mEngine(engine), mQueuedElement(queued_element) { }
+
+	/*virtual*/ void run(void)
+	{
+	  mEngine.mRunningJobs++;
+	  mEngine.run(this, mQueuedElement);
+	  --mEngine.mRunningJobs;
+	}
+
+  private:
+	AIThreadPoolEngine& mEngine;
+	queued_type::iterator mQueuedElement;		// Our element in mEngineState; only erased by run() or flush().
+};
+
+void AIThreadPoolEngine::add(AIStateMachine* state_machine)
+{
+  Dout(dc::statemachine(state_machine->mSMDebug), "Adding state machine [" << (void*)state_machine << "] to " << mName);
+  U32 queue_depth;
   {
 	engine_state_type_wat engine_state_w(mEngineState);
-	end = engine_state_w->list.end();
-	queued_element = engine_state_w->list.begin();
-	if (queued_element == end)
+	queued_type::iterator queued_element = engine_state_w->list.insert(engine_state_w->list.end(), QueueElement(state_machine));
+	queue_depth = engine_state_w->list.size();
+	// If the pool isn't running (yet, or anymore) the state machine just stays in the list.
+	// It can't be run here instead: the caller, AIStateMachine::multiplex(), holds its mState.
+	if (mPool)
 	{
-	  // Nothing to do. Wait till something is added to the queue again.
-	  engine_state_w->waiting = true;
-	  engine_state_w.wait();
-	  engine_state_w->waiting = false;
-	  return;
+	  mPool->post(new Job(*this, queued_element));
 	}
   }
-  do
+  addStats(0, 0, 0, queue_depth);
+}
+
+void AIThreadPoolEngine::run(Job* job, queued_type::iterator queued_element)
+{
+  AIStateMachine& state_machine(queued_element->statemachine());
+  U64 delta;
   {
-	AIStateMachine& state_machine(queued_element->statemachine());
+	// Off the main thread, this timer isn't added to the profiling stack; it just measures the run.
+	AIStateMachine::StateTimerRoot timer(state_machine.getName());
 	state_machine.multiplex(AIStateMachine::normal_run);
-	bool active = state_machine.active(this);		// This locks mState shortly, so it must be called before locking mEngineState because add() locks mEngineState while holding mState.
+	AIStateMachine::StateTimerBase::TimeData time_data = timer.GetTimerData();
+	delta = time_data.GetDuration();
+  }
+  bool active = state_machine.active(this);		// This locks mState shortly, so it must be called before locking mEngineState because add() locks mEngineState while holding mState.
+  {
 	engine_state_type_wat engine_state_w(mEngineState);
 	if (!active)
 	{
 	  Dout(dc::statemachine(state_machine.mSMDebug), "Erasing state machine [" << (void*)&state_machine << "] from " << mName);
-	  engine_state_w->list.erase(queued_element++);
+	  engine_state_w->list.erase(queued_element);
 	}
 	else
 	{
-	  ++queued_element;
+	  // Still (or again) in this engine: run it again after the jobs that are already queued.
+	  // If the pool is shutting down (or gone), the job is dropped and the state machine stays in the list for
+	  // start() or flush(). Running it again here would keep this worker, and therefore stop(), from finishing.
+	  if (mPool)
+	  {
+		mPool->post(job);
+	  }
 	}
   }
-  while (queued_element != end);
+  addStats(delta, 1, active ? 1 : 0, 0);
 }
 
-void AIEngine::wake_up(void)
+void AIThreadPoolEngine::start(S32 num_threads)
 {
   engine_state_type_wat engine_state_w(mEngineState);
-  if (engine_state_w->waiting)
+  llassert(!mPool);
+  mPool = new LLThreadPool(mName, num_threads);
+  // Post the state machines that were added while the pool wasn't running.
+  for (queued_type::iterator iter = engine_state_w->list.begin(); iter != engine_state_w->list.end(); ++iter)
   {
-	engine_state_w.signal();
+	mPool->post(new Job(*this, iter));
   }
 }
 
-//-----------------------------------------------------------------------------
-// AIEngineThread
-
-class AIEngineThread : public LLThread
-{
-  public:
-	static AIEngineThread* sInstance;
-	bool volatile mRunning;
-
-  public:
-    // MAIN-THREAD
-    AIEngineThread(void);
-    virtual ~AIEngineThread();
-
-  protected:
-	virtual void run(void);
-};
-
-//static
-AIEngineThread* AIEngineThread::sInstance;
-
-AIEngineThread::AIEngineThread(void) : LLThread("AIEngineThread"), mRunning(true)
+void AIThreadPoolEngine::stop(void)
 {
-}
-
-AIEngineThread::~AIEngineThread(void)
-{
-}
-
-void AIEngineThread::run(void)
-{
-  while(mRunning)
+  if (mPool)
   {
-	gStateMachineThreadEngine.threadloop();
+	// Stop the workers without holding mEngineState, because they need it to finish their jobs.
+	mPool->shutdown();
+	// LLThread only waits a limited time for a thread to stop, so a job might still be running a state machine.
+	// It uses mPool when it finishes, so wait for it.
+	while (mRunningJobs)
+	{
+	  ms_sleep(10);
+	}
+	// Jobs can only be posted while holding mEngineState.
+	LLThreadPool* pool;
+	{
+	  engine_state_type_wat engine_state_w(mEngineState);
+	  pool = mPool;
+	  mPool = NULL;
+	}
+	delete pool;
   }
 }
 
-void startEngineThread(void)
+//-----------------------------------------------------------------------------
+// State machine thread pool
+
+void startEngineThread(S32 num_threads)
 {
-  AIEngineThread::sInstance = new AIEngineThread;
-  AIEngineThread::sInstance->start();
+  gStateMachineThreadEngine.start(num_threads);
 }
 
 void stopEngineThread(void)
 {
-  AIEngineThread::sInstance->mRunning = false;
-  gStateMachineThreadEngine.wake_up();
-  int count = 401;
-  while(--count && !AIEngineThread::sInstance->isStopped())
-  {
-	ms_sleep(10);
-  }
-  llinfos << "State machine thread" << (!AIEngineThread::sInstance->isStopped() ? " not" : "") << " stopped after " << ((400 - count) * 10) << "ms." << llendl;
+  gStateMachineThreadEngine.stop();
+  gStateMachineThreadEngine.printStats();
+  gMainThreadEngine.printStats();
 }
-
@@ -37,6 +37,7 @@
 #include "aithreadsafe.h"
 #include <llpointer.h>
 #include "lltimer.h"
+#include "llthreadpool.h"
 #include <list>
 #include <boost/signals2.hpp>
 
@@ -45,7 +46,7 @@ class AIStateMachine;
 
 class AIEngine
 {
-  private:
+  protected:
 	struct QueueElementComp;
 	class QueueElement {
 	  private:
@@ -68,36 +69,83 @@ class AIEngine
 	typedef std::list<QueueElement> queued_type;
 	struct engine_state_type {
 	  queued_type list;
-	  bool waiting;
-	  engine_state_type(void) : waiting(false) { }
 	};
 
-  private:
-	AIThreadSafeSimpleDC<engine_state_type, LLCondition>	mEngineState;
-	typedef AIAccessConst<engine_state_type, LLCondition>	engine_state_type_crat;
-	typedef AIAccess<engine_state_type, LLCondition>		engine_state_type_rat;
-	typedef AIAccess<engine_state_type, LLCondition>		engine_state_type_wat;
+	// Statistics, collected from the StateTimer of every run.
+	struct stats_type {
+	  U64 run_clocks;			// Total time spent in multiplex().
+	  U32 runs;					// Number of calls to multiplex().
+	  U32 yields;				// Number of runs after which the state machine stayed in the engine.
+	  U32 max_queue_depth;		// Largest number of queued state machines seen.
+	  stats_type(void) : run_clocks(0), runs(0), yields(0), max_queue_depth(0) { }
+	};
+
+  protected:
+	AIThreadSafeSimpleDC<engine_state_type>		mEngineState;
+	typedef AIAccessConst<engine_state_type>	engine_state_type_crat;
+	typedef AIAccess<engine_state_type>			engine_state_type_rat;
+	typedef AIAccess<engine_state_type>			engine_state_type_wat;
 	char const* mName;
 
+	AIThreadSafeSimpleDC<stats_type>			mStats;
+	typedef AIAccessConst<stats_type>			stats_type_crat;
+	typedef AIAccess<stats_type>				stats_type_wat;
+
 	static U64 sMaxCount;
 
+	void addStats(U64 run_clocks, U32 runs, U32 yields, U32 queue_depth);
+
   public:
 	AIEngine(char const* name) : mName(name) { }
+	virtual ~AIEngine() { }
 
-	void add(AIStateMachine* state_machine);
+	virtual void add(AIStateMachine* state_machine);
 
 	void mainloop(void);
-	void threadloop(void);
-	void wake_up(void);
 	void flush(void);
 
 	char const* name(void) const { return mName; }
 
+	stats_type getStats(void) const { return *stats_type_crat(mStats); }
+	void printStats(void) const;
+
 	static void setMaxCount(F32 StateMachineMaxTime);
 };
 
+// An engine that runs its state machines on a work-stealing LLThreadPool.
+//
+// Every state machine that is added to the engine is posted as a job;
+// after it ran, the job posts itself again for as long as the state
+// machine stays in this engine (that is, until it goes idle or moves to
+// another engine). A state machine is never run by two threads at the
+// same time: AIStateMachine::multiplex() serializes that, just like it
+// does between the main thread and any other thread.
+class AIThreadPoolEngine : public AIEngine
+{
+  private:
+	class Job;
+	LLThreadPool* mPool;			// Protected by mEngineState.
+	LLAtomicS32 mRunningJobs;		// Number of jobs inside run().
+
+  public:
+	AIThreadPoolEngine(char const* name) : AIEngine(name), mPool(NULL), mRunningJobs(0) { }
+	/*virtual*/ ~AIThreadPoolEngine() { stop(); }
+
+	/*virtual*/ void add(AIStateMachine* state_machine);
+
+	// Start num_threads threads (zero means one per core). MAIN-THREAD.
+	void start(S32 num_threads);
+	// Stop the threads and wait until no job uses the pool anymore. State machines that are still queued,
+	// or that are added while the pool isn't running, stay in the engine until start() or flush() is called. MAIN-THREAD.
+	void stop(void);
+
+  private:
+	// Called from a WORKER thread.
+	void run(Job* job, queued_type::iterator queued_element);
+};
+
 extern AIEngine gMainThreadEngine;
-extern AIEngine gStateMachineThreadEngine;
+extern AIThreadPoolEngine gStateMachineThreadEngine;
 
 #ifndef STATE_MACHINE_PROFILING
 #ifndef LL_RELEASE_FOR_DOWNLOAD
@@ -151,7 +199,7 @@ class AIStateMachine : public LLThreadSafeRefCount
 #else
 	protected:
 		// Ctors/dtors are hidden. Only StateTimerRoot and StateTimer are permitted to access them.
-		StateTimerBase() : mData(NULL) {}
+		StateTimerBase() : mData(NULL), mStart(get_clock_count()) {}
 		~StateTimerBase()
 		{
 			// If mData is null then the timer was not registered due to being in the wrong thread or the root timer wasn't in the expected state.
@@ -188,6 +236,7 @@ class AIStateMachine : public LLThreadSafeRefCount
 		}
 
 		TimeData* mData;
+		U64 mStart;		// Used when the timer isn't registered, so that other threads can still time a run.
 		static std::vector<StateTimerBase*> mTimerStack;
 
 	public:
@@ -207,7 +256,10 @@ class AIStateMachine : public LLThreadSafeRefCount
 				ret.mEnd = get_clock_count();	//set mEnd to current time, since GetTimerData() will always be called before the dtor, obv.
 				return ret;
 			}
-			return TimeData();
+			TimeData ret;
+			ret.mStart = mStart;
+			ret.mEnd = get_clock_count();
+			return ret;
 		}
 #endif
 	};
@@ -463,6 +515,7 @@ public:
 	}
 
 	friend class AIEngine;						// Calls multiplex() and force_killed().
+	friend class AIThreadPoolEngine;			// Calls multiplex().
 };
 
 bool AIEngine::QueueElementComp::operator()(QueueElement const& e1, QueueElement const& e2) const
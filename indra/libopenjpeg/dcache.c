@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2013, Linden Research, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "opj_includes.h"
+
+/** @defgroup DCACHE DCACHE - Resolution levels kept between decodes */
+/*@{*/
+
+/** @name Local data structures */
+/*@{*/
+
+/**
+Fingerprint of the data of a code-block. Data only gets appended to a codestream,
+so a code-block with the same fingerprint decodes to the same coefficients.
+*/
+typedef struct opj_dcache_cblk {
+	int len;
+	int numpasses;
+	int numbps;
+	unsigned int hash;
+} opj_dcache_cblk_t;
+
+/**
+What is kept of a tile-component
+*/
+typedef struct opj_dcache_comp {
+	/** Dimensions and transform, to notice a different codestream */
+	int x0, y0, x1, y1;
+	int numresolutions;
+	int qmfbid;
+	/** Fingerprints of all code-blocks, in the order of t1_decode_cblks() */
+	opj_dcache_cblk_t *cblks;
+	/** Number of resolution levels of which the fingerprints are valid */
+	int numkeyres;
+	/** Reconstructed resolution levels, each the size of its resolution */
+	int *levels[J2K_MAXRLVLS];
+	/** Number of valid levels */
+	int numlevels;
+} opj_dcache_comp_t;
+
+struct opj_decode_cache {
+	opj_dcache_comp_t *comps;
+	int numcomps;
+};
+
+/*@}*/
+
+/** @name Local static functions */
+/*@{*/
+
+/**
+Release what is kept of a tile-component
+*/
+static void dcache_reset(opj_dcache_comp_t *comp);
+/**
+Get the tile-component with index index, adding it if needed
+*/
+static opj_dcache_comp_t* dcache_get(opj_decode_cache_t *cache, int index);
+/**
+FNV-1a hash of len bytes at data
+*/
+static unsigned int dcache_hash(const unsigned char *data, int len);
+/**
+Copy the samples of resolution level resno between the tile-component and level
+*/
+static void dcache_copy(opj_tcd_tilecomp_t *tilec, int resno, int *level, opj_bool to_level);
+
+/*@}*/
+
+/*@}*/
+
+/* ----------------------------------------------------------------------- */
+
+static void dcache_reset(opj_dcache_comp_t *comp) {
+	int resno;
+	opj_free(comp->cblks);
+	for (resno = 0; resno < J2K_MAXRLVLS; ++resno) {
+		opj_free(comp->levels[resno]);
+	}
+	memset(comp, 0, sizeof(opj_dcache_comp_t));
+}
+
+static opj_dcache_comp_t* dcache_get(opj_decode_cache_t *cache, int index) {
+	if (index >= cache->numcomps) {
+		opj_dcache_comp_t *comps = (opj_dcache_comp_t*) opj_realloc(cache->comps, (index + 1) * sizeof(opj_dcache_comp_t));
+		if (!comps) {
+			return NULL;
+		}
+		memset(comps + cache->numcomps, 0, (index + 1 - cache->numcomps) * sizeof(opj_dcache_comp_t));
+		cache->comps = comps;
+		cache->numcomps = index + 1;
+	}
+	return &cache->comps[index];
+}
+
+static unsigned int dcache_hash(const unsigned char *data, int len) {
+	unsigned int hash = 2166136261u;
+	int i;
+	for (i = 0; i < len; ++i) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static void dcache_copy(opj_tcd_tilecomp_t *tilec, int resno, int *level, opj_bool to_level) {
+	opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+	int rw = res->x1 - res->x0;
+	int rh = res->y1 - res->y0;
+	int w = tilec->x1 - tilec->x0;
+	int j;
+	for (j = 0; j < rh; ++j) {
+		if (to_level) {
+			memcpy(&level[j * rw], &tilec->data[j * w], rw * sizeof(int));
+		} else {
+			memcpy(&tilec->data[j * w], &level[j * rw], rw * sizeof(int));
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+
+opj_decode_cache_t* OPJ_CALLCONV opj_create_decode_cache(void) {
+	return (opj_decode_cache_t*) opj_calloc(1, sizeof(opj_decode_cache_t));
+}
+
+void OPJ_CALLCONV opj_destroy_decode_cache(opj_decode_cache_t *cache) {
+	if (cache) {
+		int i;
+		for (i = 0; i < cache->numcomps; ++i) {
+			dcache_reset(&cache->comps[i]);
+		}
+		opj_free(cache->comps);
+		opj_free(cache);
+	}
+}
+
+int OPJ_CALLCONV opj_decode_cache_size(opj_decode_cache_t *cache) {
+	int size = 0;
+	int i, resno;
+	for (i = 0; i < cache->numcomps; ++i) {
+		opj_dcache_comp_t *comp = &cache->comps[i];
+		for (resno = 0; resno < comp->numresolutions; ++resno) {
+			if (comp->levels[resno]) {
+				/* The levels are the size of the resolutions of a tile-component with the same dimensions */
+				int levelno = comp->numresolutions - 1 - resno;
+				int rw = int_ceildivpow2(comp->x1, levelno) - int_ceildivpow2(comp->x0, levelno);
+				int rh = int_ceildivpow2(comp->y1, levelno) - int_ceildivpow2(comp->y0, levelno);
+				size += rw * rh * sizeof(int);
+			}
+		}
+	}
+	return size;
+}
+
+int dcache_match(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int qmfbid, int numres) {
+	opj_dcache_comp_t *comp = dcache_get(cache, index);
+	int resno, bandno, precno, cblkno;
+	int reuse, n;
+
+	if (!comp) {
+		return 0;
+	}
+	if (comp->x0 != tilec->x0 || comp->y0 != tilec->y0 || comp->x1 != tilec->x1 || comp->y1 != tilec->y1 ||
+			comp->numresolutions != tilec->numresolutions || comp->qmfbid != qmfbid) {
+		/* Not the codestream that was decoded before */
+		dcache_reset(comp);
+		comp->x0 = tilec->x0;
+		comp->y0 = tilec->y0;
+		comp->x1 = tilec->x1;
+		comp->y1 = tilec->y1;
+		comp->numresolutions = tilec->numresolutions;
+		comp->qmfbid = qmfbid;
+	}
+	if (!comp->cblks) {
+		n = 0;
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					opj_tcd_precinct_t *precinct = &res->bands[bandno].precincts[precno];
+					n += precinct->cw * precinct->ch;
+				}
+			}
+		}
+		comp->cblks = (opj_dcache_cblk_t*) opj_malloc(int_max(n, 1) * sizeof(opj_dcache_cblk_t));
+		if (!comp->cblks) {
+			return 0;
+		}
+		comp->numkeyres = 0;
+		comp->numlevels = 0;
+	}
+
+	/* The levels up to the first one with a changed code-block can be restored */
+	reuse = int_min(comp->numlevels, numres);
+	n = 0;
+	for (resno = 0; resno < tilec->numresolutions; ++resno) {
+		opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+		for (bandno = 0; bandno < res->numbands; ++bandno) {
+			for (precno = 0; precno < res->pw * res->ph; ++precno) {
+				opj_tcd_precinct_t *precinct = &res->bands[bandno].precincts[precno];
+				for (cblkno = 0; cblkno < precinct->cw * precinct->ch; ++cblkno, ++n) {
+					opj_tcd_cblk_dec_t *cblk = &precinct->cblks.dec[cblkno];
+					opj_dcache_cblk_t key;
+					int segno;
+					if (resno >= numres) {
+						continue;
+					}
+					memset(&key, 0, sizeof(key));
+					/* The other fields are only set once the code-block is included in a packet */
+					if (cblk->numsegs) {
+						key.len = cblk->len;
+						for (segno = 0; segno < cblk->numsegs; ++segno) {
+							key.numpasses += cblk->segs[segno].numpasses;
+						}
+						key.numbps = cblk->numbps;
+						key.hash = dcache_hash(cblk->data, cblk->len);
+					}
+					if (resno >= comp->numkeyres || memcmp(&key, &comp->cblks[n], sizeof(opj_dcache_cblk_t))) {
+						reuse = int_min(reuse, resno);
+					}
+					comp->cblks[n] = key;
+				}
+			}
+		}
+	}
+	comp->numkeyres = numres;
+	/* The levels from reuse up are decoded and kept again */
+	comp->numlevels = reuse;
+	return reuse;
+}
+
+void dcache_restore(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int resno) {
+	opj_dcache_comp_t *comp = &cache->comps[index];
+	dcache_copy(tilec, resno, comp->levels[resno], OPJ_FALSE);
+}
+
+void dcache_store(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int resno) {
+	opj_dcache_comp_t *comp = &cache->comps[index];
+	/* Nothing is reconstructed from the full resolution, so that isn't kept */
+	if (resno != comp->numlevels || resno == comp->numresolutions - 1) {
+		return;
+	}
+	if (!comp->levels[resno]) {
+		opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+		comp->levels[resno] = (int*) opj_malloc((res->x1 - res->x0) * (res->y1 - res->y0) * sizeof(int));
+		if (!comp->levels[resno]) {
+			return;
+		}
+	}
+	dcache_copy(tilec, resno, comp->levels[resno], OPJ_TRUE);
+	comp->numlevels = resno + 1;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2013, Linden Research, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __DCACHE_H
+#define __DCACHE_H
+/**
+@file dcache.h
+@brief Resolution levels kept between decodes of a codestream (DCACHE)
+
+The functions in DCACHE.C keep the reconstructed resolution levels of the tile-components
+of a codestream, together with a fingerprint of the data of every code-block. When the
+codestream is decoded again with more data or a lower reduce factor, the levels whose
+code-blocks didn't change are restored instead of being decoded by tier-1 and the DWT again.
+*/
+
+/** @defgroup DCACHE DCACHE - Resolution levels kept between decodes */
+/*@{*/
+
+/** @name Exported functions */
+/*@{*/
+/* ----------------------------------------------------------------------- */
+/**
+Compare the code-blocks of a tile-component with the ones of the previous decode and remember them
+@param cache Decode cache
+@param index Index of the tile-component (tile number * number of components + component number)
+@param tilec Tile-component, after tier-2 decoding
+@param qmfbid Wavelet transform of the tile-component (1 = 5-3, 0 = 9-7)
+@param numres Number of resolution levels that will be decoded
+@return Returns the number of resolution levels that can be restored with dcache_restore()
+*/
+int dcache_match(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int qmfbid, int numres);
+/**
+Copy a kept resolution level into the tile-component
+@param cache Decode cache
+@param index Index of the tile-component
+@param tilec Tile-component
+@param resno Resolution level, below the value returned by dcache_match()
+*/
+void dcache_restore(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int resno);
+/**
+Keep a resolution level of the tile-component, once it is reconstructed
+@param cache Decode cache
+@param index Index of the tile-component
+@param tilec Tile-component
+@param resno Resolution level; all lower levels must have been kept or restored. The highest level of the tile-component is not kept
+*/
+void dcache_store(opj_decode_cache_t *cache, int index, opj_tcd_tilecomp_t *tilec, int resno);
+/* ----------------------------------------------------------------------- */
+/*@}*/
+
+/*@}*/
+
+#endif /* __DCACHE_H */
@@ -31,10 +31,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#ifdef __SSE__
-#include <xmmintrin.h>
-#endif
-
 #include "opj_includes.h"
 
 /** @defgroup DWT DWT - Implementation of a discrete wavelet transform */
@@ -79,6 +75,10 @@ static const float c13318 = 1.625732422f;
 Virtual function type for wavelet transform in 1-D 
 */
 typedef void (*DWT1DFN)(dwt_t* v);
+/**
+Virtual function type for the 9-7 wavelet transform in 1-D of four rows or columns
+*/
+typedef void (*V4DWT1DFN)(v4dwt_t* v);
 
 /** @name Local static functions */
 /*@{*/
@@ -118,7 +118,13 @@ static void dwt_encode_stepsize(int stepsize, int numbps, opj_stepsize_t *bandno
 /**
 Inverse wavelet transform in 2-D.
 */
-static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int i, DWT1DFN fn);
+static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int first, int numres, DWT1DFN fn);
+#ifdef OPJ_HAVE_SSE2
+/**
+Inverse 5-3 wavelet transform in 2-D, four rows or columns at a time with SSE2.
+*/
+static void dwt_decode_tile_sse2(opj_tcd_tilecomp_t* tilec, int first, int numres);
+#endif
 
 /*@}*/
 
@@ -380,7 +386,21 @@ void dwt_encode(opj_tcd_tilecomp_t * tilec) {
 /* Inverse 5-3 wavelet transform in 2-D. */
 /* </summary>                           */
 void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres) {
-	dwt_decode_tile(tilec, numres, &dwt_decode_1);
+	dwt_decode_from(tilec, 0, numres);
+}
+
+/* <summary>                                                  */
+/* Inverse 5-3 wavelet transform in 2-D, starting from a      */
+/* resolution level that is already reconstructed.            */
+/* </summary>                                                 */
+void dwt_decode_from(opj_tcd_tilecomp_t* tilec, int first, int numres) {
+#ifdef OPJ_HAVE_SSE2
+	if (opj_use_sse2()) {
+		dwt_decode_tile_sse2(tilec, first, numres);
+		return;
+	}
+#endif
+	dwt_decode_tile(tilec, first, numres, &dwt_decode_1);
 }
 
 
@@ -516,17 +536,18 @@ static int dwt_decode_max_resolution(opj_tcd_resolution_t* restrict r, int i) {
 /* <summary>                            */
 /* Inverse wavelet transform in 2-D.     */
 /* </summary>                           */
-static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int numres, DWT1DFN dwt_1D) {
+static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int first, int numres, DWT1DFN dwt_1D) {
 	dwt_t h;
 	dwt_t v;
 
-	opj_tcd_resolution_t* tr = tilec->resolutions;
+	opj_tcd_resolution_t* tr = tilec->resolutions + first;
 
 	int rw = tr->x1 - tr->x0;	/* width of the resolution level computed */
 	int rh = tr->y1 - tr->y0;	/* height of the resolution level computed */
 
 	int w = tilec->x1 - tilec->x0;
 
+	numres -= first;
 	h.mem = (int*)opj_aligned_malloc(dwt_decode_max_resolution(tr, numres) * sizeof(int));
 	v.mem = h.mem;
 
@@ -565,6 +586,209 @@ static void dwt_decode_tile(opj_tcd_tilecomp_t* tilec, int numres, DWT1DFN dwt_1
 	opj_aligned_free(h.mem);
 }
 
+#ifdef OPJ_HAVE_SSE2
+
+/* Transpose the 4x4 matrix of which r0 - r3 are the rows */
+#define DWT_TRANSPOSE4_SSE2(r0, r1, r2, r3) { \
+	__m128i t0 = _mm_unpacklo_epi32(r0, r1); \
+	__m128i t1 = _mm_unpacklo_epi32(r2, r3); \
+	__m128i t2 = _mm_unpackhi_epi32(r0, r1); \
+	__m128i t3 = _mm_unpackhi_epi32(r2, r3); \
+	r0 = _mm_unpacklo_epi64(t0, t1); \
+	r1 = _mm_unpackhi_epi64(t0, t1); \
+	r2 = _mm_unpacklo_epi64(t2, t3); \
+	r3 = _mm_unpackhi_epi64(t2, t3); \
+}
+
+/* <summary>                                                  */
+/* Gather count samples of the four rows a, a + x, a + 2x and */
+/* a + 3x into every other element of b.                      */
+/* </summary>                                                 */
+static void dwt_interleave_h_sse2(__m128i* restrict b, const int* restrict a, int x, int count) {
+	int i;
+	for (i = 0; i + 3 < count; i += 4) {
+		__m128i r0 = _mm_loadu_si128((const __m128i*) &a[i]);
+		__m128i r1 = _mm_loadu_si128((const __m128i*) &a[i + x]);
+		__m128i r2 = _mm_loadu_si128((const __m128i*) &a[i + 2 * x]);
+		__m128i r3 = _mm_loadu_si128((const __m128i*) &a[i + 3 * x]);
+		DWT_TRANSPOSE4_SSE2(r0, r1, r2, r3);
+		b[2 * i] = r0;
+		b[2 * i + 2] = r1;
+		b[2 * i + 4] = r2;
+		b[2 * i + 6] = r3;
+	}
+	for (; i < count; ++i) {
+		b[2 * i] = _mm_setr_epi32(a[i], a[i + x], a[i + 2 * x], a[i + 3 * x]);
+	}
+}
+
+/* <summary>                                                   */
+/* Scatter count samples of b back to the four rows a, a + x,  */
+/* a + 2x and a + 3x.                                          */
+/* </summary>                                                  */
+static void dwt_deinterleave_h_sse2(int* restrict a, const __m128i* restrict b, int x, int count) {
+	int i;
+	for (i = 0; i + 3 < count; i += 4) {
+		__m128i r0 = b[i];
+		__m128i r1 = b[i + 1];
+		__m128i r2 = b[i + 2];
+		__m128i r3 = b[i + 3];
+		DWT_TRANSPOSE4_SSE2(r0, r1, r2, r3);
+		_mm_storeu_si128((__m128i*) &a[i], r0);
+		_mm_storeu_si128((__m128i*) &a[i + x], r1);
+		_mm_storeu_si128((__m128i*) &a[i + 2 * x], r2);
+		_mm_storeu_si128((__m128i*) &a[i + 3 * x], r3);
+	}
+	for (; i < count; ++i) {
+		int tmp[4];
+		_mm_storeu_si128((__m128i*) tmp, b[i]);
+		a[i] = tmp[0];
+		a[i + x] = tmp[1];
+		a[i + 2 * x] = tmp[2];
+		a[i + 3 * x] = tmp[3];
+	}
+}
+
+#define VS(i) w[(i)*2]
+#define VD(i) w[(1+(i)*2)]
+
+/* <summary>                                                  */
+/* Inverse 5-3 wavelet transform in 1-D of four rows or       */
+/* columns at once. Same as dwt_decode_1_() for every lane.   */
+/* </summary>                                                 */
+static void v4dwt_decode_53_sse2(__m128i* restrict w, int dn, int sn, int cas) {
+	const __m128i two = _mm_set1_epi32(2);
+	__m128i prev, cur;
+	int i;
+
+	if (!cas) {
+		if ((dn > 0) || (sn > 1)) { /* NEW :  CASE ONE ELEMENT */
+			/* S(i) -= (D_(i - 1) + D_(i) + 2) >> 2 */
+			prev = VD(0);
+			for (i = 0; i < sn; i++) {
+				cur = VD(int_min(i, dn - 1));
+				VS(i) = _mm_sub_epi32(VS(i), _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(prev, cur), two), 2));
+				prev = cur;
+			}
+			/* D(i) += (S_(i) + S_(i + 1)) >> 1 */
+			prev = VS(0);
+			for (i = 0; i < dn; i++) {
+				cur = VS(int_min(i + 1, sn - 1));
+				VD(i) = _mm_add_epi32(VD(i), _mm_srai_epi32(_mm_add_epi32(prev, cur), 1));
+				prev = cur;
+			}
+		}
+	} else {
+		if (!sn && dn == 1) {         /* NEW :  CASE ONE ELEMENT */
+			/* S(0) /= 2, rounding towards zero */
+			cur = VS(0);
+			VS(0) = _mm_srai_epi32(_mm_add_epi32(cur, _mm_srli_epi32(cur, 31)), 1);
+		} else {
+			/* D(i) -= (SS_(i) + SS_(i + 1) + 2) >> 2 */
+			if (sn > 0) {
+				prev = VS(0);
+				for (i = 0; i < sn; i++) {
+					cur = VS(int_min(i + 1, dn - 1));
+					VD(i) = _mm_sub_epi32(VD(i), _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(prev, cur), two), 2));
+					prev = cur;
+				}
+			}
+			/* S(i) += (DD_(i) + DD_(i - 1)) >> 1 */
+			if (dn > 0) {
+				prev = VD(0);
+				for (i = 0; i < dn; i++) {
+					cur = VD(int_min(i, sn - 1));
+					VS(i) = _mm_add_epi32(VS(i), _mm_srai_epi32(_mm_add_epi32(cur, prev), 1));
+					prev = cur;
+				}
+			}
+		}
+	}
+}
+
+#undef VS
+#undef VD
+
+/* <summary>                                                  */
+/* Inverse 5-3 wavelet transform in 2-D with SSE2. Rows are   */
+/* transposed four at a time so that the samples of four      */
+/* rows, and of four neighbouring columns, are transformed    */
+/* together; the rows and columns left over are done one by   */
+/* one like dwt_decode_tile() does.                           */
+/* </summary>                                                 */
+static void dwt_decode_tile_sse2(opj_tcd_tilecomp_t* tilec, int first, int numres) {
+	dwt_t h;
+	dwt_t v;
+	__m128i* w4;
+
+	opj_tcd_resolution_t* tr = tilec->resolutions + first;
+
+	int rw = tr->x1 - tr->x0;	/* width of the resolution level computed */
+	int rh = tr->y1 - tr->y0;	/* height of the resolution level computed */
+
+	int w = tilec->x1 - tilec->x0;
+
+	numres -= first;
+	w4 = (__m128i*) opj_aligned_malloc(dwt_decode_max_resolution(tr, numres) * sizeof(__m128i));
+	h.mem = (int*) w4;
+	v.mem = h.mem;
+
+	while( --numres) {
+		int * restrict tiledp = tilec->data;
+		int j;
+
+		++tr;
+		h.sn = rw;
+		v.sn = rh;
+
+		rw = tr->x1 - tr->x0;
+		rh = tr->y1 - tr->y0;
+
+		h.dn = rw - h.sn;
+		h.cas = tr->x0 % 2;
+
+		for(j = 0; j + 3 < rh; j += 4) {
+			dwt_interleave_h_sse2(w4 + h.cas, &tiledp[j*w], w, h.sn);
+			dwt_interleave_h_sse2(w4 + 1 - h.cas, &tiledp[j*w + h.sn], w, h.dn);
+			v4dwt_decode_53_sse2(w4, h.dn, h.sn, h.cas);
+			dwt_deinterleave_h_sse2(&tiledp[j*w], w4, w, rw);
+		}
+		for(; j < rh; ++j) {
+			dwt_interleave_h(&h, &tiledp[j*w]);
+			dwt_decode_1(&h);
+			memcpy(&tiledp[j*w], h.mem, rw * sizeof(int));
+		}
+
+		v.dn = rh - v.sn;
+		v.cas = tr->y0 % 2;
+
+		for(j = 0; j + 3 < rw; j += 4) {
+			int k;
+			for(k = 0; k < v.sn; ++k) {
+				w4[v.cas + 2*k] = _mm_loadu_si128((const __m128i*) &tiledp[k*w + j]);
+			}
+			for(k = 0; k < v.dn; ++k) {
+				w4[1 - v.cas + 2*k] = _mm_loadu_si128((const __m128i*) &tiledp[(v.sn + k)*w + j]);
+			}
+			v4dwt_decode_53_sse2(w4, v.dn, v.sn, v.cas);
+			for(k = 0; k < rh; ++k) {
+				_mm_storeu_si128((__m128i*) &tiledp[k*w + j], w4[k]);
+			}
+		}
+		for(; j < rw; ++j){
+			int k;
+			dwt_interleave_v(&v, &tiledp[j], w);
+			dwt_decode_1(&v);
+			for(k = 0; k < rh; ++k) {
+				tiledp[k * w + j] = v.mem[k];
+			}
+		}
+	}
+	opj_aligned_free(w4);
+}
+
+#endif
+
 static void v4dwt_interleave_h(v4dwt_t* restrict w, float* restrict a, int x, int size){
 	float* restrict bi = (float*) (w->wavelet + w->cas);
 	int count = w->sn;
@@ -618,7 +842,7 @@ static void v4dwt_interleave_v(v4dwt_t* restrict v , float* restrict a , int x){
 	}
 }
 
-#ifdef __SSE__
+#ifdef OPJ_HAVE_SSE2
 
 static void v4dwt_decode_step1_sse(v4* w, int count, const __m128 c){
 	__m128* restrict vw = (__m128*) w;
@@ -667,7 +891,7 @@ static void v4dwt_decode_step2_sse(v4* l, v4* w, int k, int m, __m128 c){
 	}
 }
 
-#else
+#endif
 
 static void v4dwt_decode_step1(v4* w, int count, const float c){
 	float* restrict fw = (float*) w;
@@ -732,8 +956,6 @@ static void v4dwt_decode_step2(v4* l, v4* w, int k, int m, float c){
 	}
 }
 
-#endif
-
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
@@ -752,37 +974,74 @@ static void v4dwt_decode(v4dwt_t* restrict dwt){
 		a = 1;
 		b = 0;
 	}
-#ifdef __SSE__
-	v4dwt_decode_step1_sse(dwt->wavelet+a, dwt->sn, _mm_set1_ps(K));
-	v4dwt_decode_step1_sse(dwt->wavelet+b, dwt->dn, _mm_set1_ps(c13318));
-	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_delta));
-	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_gamma));
-	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_beta));
-	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_alpha));
-#else
 	v4dwt_decode_step1(dwt->wavelet+a, dwt->sn, K);
 	v4dwt_decode_step1(dwt->wavelet+b, dwt->dn, c13318);
 	v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), dwt_delta);
 	v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), dwt_gamma);
 	v4dwt_decode_step2(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), dwt_beta);
 	v4dwt_decode_step2(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), dwt_alpha);
-#endif
 }
 
+#ifdef OPJ_HAVE_SSE2
+
+/* <summary>                                       */
+/* Inverse 9-7 wavelet transform in 1-D with SSE. */
+/* </summary>                                      */
+static void v4dwt_decode_sse(v4dwt_t* restrict dwt){
+	int a, b;
+	if(dwt->cas == 0) {
+		if(!((dwt->dn > 0) || (dwt->sn > 1))){
+			return;
+		}
+		a = 0;
+		b = 1;
+	}else{
+		if(!((dwt->sn > 0) || (dwt->dn > 1))) {
+			return;
+		}
+		a = 1;
+		b = 0;
+	}
+	v4dwt_decode_step1_sse(dwt->wavelet+a, dwt->sn, _mm_set1_ps(K));
+	v4dwt_decode_step1_sse(dwt->wavelet+b, dwt->dn, _mm_set1_ps(c13318));
+	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_delta));
+	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_gamma));
+	v4dwt_decode_step2_sse(dwt->wavelet+b, dwt->wavelet+a+1, dwt->sn, int_min(dwt->sn, dwt->dn-a), _mm_set1_ps(dwt_beta));
+	v4dwt_decode_step2_sse(dwt->wavelet+a, dwt->wavelet+b+1, dwt->dn, int_min(dwt->dn, dwt->sn-b), _mm_set1_ps(dwt_alpha));
+}
+
+#endif
+
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
 void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
+	dwt_decode_real_from(tilec, 0, numres);
+}
+
+/* <summary>                                                  */
+/* Inverse 9-7 wavelet transform in 2-D, starting from a      */
+/* resolution level that is already reconstructed.            */
+/* </summary>                                                 */
+void dwt_decode_real_from(opj_tcd_tilecomp_t* restrict tilec, int first, int numres){
 	v4dwt_t h;
 	v4dwt_t v;
 
-	opj_tcd_resolution_t* res = tilec->resolutions;
+	opj_tcd_resolution_t* res = tilec->resolutions + first;
 
 	int rw = res->x1 - res->x0;	/* width of the resolution level computed */
 	int rh = res->y1 - res->y0;	/* height of the resolution level computed */
 
 	int w = tilec->x1 - tilec->x0;
 
+	V4DWT1DFN v4dwt_1D = &v4dwt_decode;
+#ifdef OPJ_HAVE_SSE2
+	if (opj_use_sse2()) {
+		v4dwt_1D = &v4dwt_decode_sse;
+	}
+#endif
+
+	numres -= first;
 	h.wavelet = (v4*) opj_aligned_malloc((dwt_decode_max_resolution(res, numres)+5) * sizeof(v4));
 	v.wavelet = h.wavelet;
 
@@ -805,7 +1064,7 @@ void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
 		for(j = rh; j > 3; j -= 4){
 			int k;
 			v4dwt_interleave_h(&h, aj, w, bufsize);
-			v4dwt_decode(&h);
+			(v4dwt_1D)(&h);
 				for(k = rw; --k >= 0;){
 					aj[k    ] = h.wavelet[k].f[0];
 					aj[k+w  ] = h.wavelet[k].f[1];
@@ -819,7 +1078,7 @@ void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
 				int k;
 			j = rh & 0x03;
 			v4dwt_interleave_h(&h, aj, w, bufsize);
-			v4dwt_decode(&h);
+			(v4dwt_1D)(&h);
 				for(k = rw; --k >= 0;){
 					switch(j) {
 						case 3: aj[k+w*2] = h.wavelet[k].f[2];
@@ -836,7 +1095,7 @@ void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
 		for(j = rw; j > 3; j -= 4){
 			int k;
 			v4dwt_interleave_v(&v, aj, w);
-			v4dwt_decode(&v);
+			(v4dwt_1D)(&v);
 				for(k = 0; k < rh; ++k){
 					memcpy(&aj[k*w], &v.wavelet[k], 4 * sizeof(float));
 				}
@@ -846,7 +1105,7 @@ void dwt_decode_real(opj_tcd_tilecomp_t* restrict tilec, int numres){
 				int k;
 			j = rw & 0x03;
 			v4dwt_interleave_v(&v, aj, w);
-			v4dwt_decode(&v);
+			(v4dwt_1D)(&v);
 				for(k = 0; k < rh; ++k){
 					memcpy(&aj[k*w], &v.wavelet[k], j * sizeof(float));
 				}
@@ -61,6 +61,13 @@ Apply a reversible inverse DWT transform to a component of an image.
 */
 void dwt_decode(opj_tcd_tilecomp_t* tilec, int numres);
 /**
+Inverse 5-3 wavelet tranform in 2-D, starting from a resolution level that is already reconstructed.
+@param tilec Tile component information (current tile)
+@param first Resolution level that is already reconstructed
+@param numres Number of resolution levels to decode
+*/
+void dwt_decode_from(opj_tcd_tilecomp_t* tilec, int first, int numres);
+/**
 Get the gain of a subband for the reversible 5-3 DWT.
 @param orient Number that identifies the subband (0->LL, 1->HL, 2->LH, 3->HH)
 @return Returns 0 if orient = 0, returns 1 if orient = 1 or 2, returns 2 otherwise
@@ -87,6 +94,13 @@ Apply an irreversible inverse DWT transform to a component of an image.
 */
 void dwt_decode_real(opj_tcd_tilecomp_t* tilec, int numres);
 /**
+Inverse 9-7 wavelet transform in 2-D, starting from a resolution level that is already reconstructed.
+@param tilec Tile component information (current tile)
+@param first Resolution level that is already reconstructed
+@param numres Number of resolution levels to decode
+*/
+void dwt_decode_real_from(opj_tcd_tilecomp_t* tilec, int first, int numres);
+/**
 Get the gain of a subband for the irreversible 9-7 DWT.
 @param orient Number that identifies the subband (0->LL, 1->HL, 2->LH, 3->HH)
 @return Returns the gain of the 9-7 wavelet transform
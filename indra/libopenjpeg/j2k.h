@@ -228,6 +228,8 @@ typedef struct opj_cp {
 	int layer;
 	/** if == NO_LIMITATION, decode entire codestream; if == LIMIT_TO_MAIN_HEADER then only decode the main header */
 	OPJ_LIMIT_DECODING limit_decoding;
+	/** Resolution levels kept from an earlier decode, or NULL */
+	opj_decode_cache_t *decode_cache;
 	/** XTOsiz */
 	int tx0;
 	/** YTOsiz */
@@ -33,6 +33,61 @@
 #endif /* _WIN32 */
 #include "opj_includes.h"
 
+#if defined(OPJ_HAVE_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static opj_parallel_for_fn opj_parallel_for_hook = NULL;
+
+void OPJ_CALLCONV opj_set_parallel_for(opj_parallel_for_fn parallel_for) {
+	opj_parallel_for_hook = parallel_for;
+}
+
+opj_bool opj_has_parallel_for(void) {
+	return opj_parallel_for_hook != NULL;
+}
+
+void opj_parallel_for(opj_parallel_job_fn job, void *data, int count) {
+	int index;
+	if (opj_parallel_for_hook && count > 1) {
+		opj_parallel_for_hook(job, data, count);
+		return;
+	}
+	for (index = 0; index < count; ++index) {
+		job(data, index);
+	}
+}
+
+/* -1 = not determined yet, 0 = don't use the SSE2 kernels, 1 = use them */
+static int opj_sse2_state = -1;
+
+void OPJ_CALLCONV opj_set_use_simd(opj_bool use_simd) {
+	/* Determine the CPU support again when turning them back on */
+	opj_sse2_state = use_simd ? -1 : 0;
+}
+
+opj_bool opj_use_sse2(void) {
+	if (opj_sse2_state < 0) {
+#if !defined(OPJ_HAVE_SSE2)
+		opj_sse2_state = 0;
+#elif defined(_M_X64) || defined(__x86_64__)
+		/* SSE2 is part of x86-64 */
+		opj_sse2_state = 1;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		opj_sse2_state = (info[3] >> 26) & 1;
+#else
+		/*
+		Other compilers only define __SSE2__ when they generate SSE2 code anywhere,
+		so the CPU must support it already: this is decided at compile time.
+		*/
+		opj_sse2_state = 1;
+#endif
+	}
+	return opj_sse2_state;
+}
+
 double opj_clock(void) {
 #ifdef _WIN32
 	/* _WIN32: use QueryPerformance (very accurate) */
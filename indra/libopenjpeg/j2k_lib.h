@@ -45,6 +45,23 @@ Difference in successive opj_clock() calls tells you the elapsed time
 */
 double opj_clock(void);
 
+/**
+Run job(data, index) for every index from 0 to count - 1, in parallel if opj_set_parallel_for() was called
+@param job Function that runs one part of the job
+@param data The job
+@param count Number of parts
+*/
+void opj_parallel_for(opj_parallel_job_fn job, void *data, int count);
+/**
+@return Returns true if opj_parallel_for() can run parts in parallel
+*/
+opj_bool opj_has_parallel_for(void);
+
+/**
+@return Returns true if the SSE2 kernels are compiled in, the CPU supports SSE2 and opj_set_use_simd() didn't turn them off
+*/
+opj_bool opj_use_sse2(void);
+
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
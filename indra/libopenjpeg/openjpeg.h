@@ -357,6 +357,11 @@ typedef struct opj_cparameters {
 
 #define OPJ_DPARAMETERS_IGNORE_PCLR_CMAP_CDEF_FLAG	0x0001
 
+/**
+Resolution levels kept from an earlier decode of a codestream, see opj_create_decode_cache()
+*/
+typedef struct opj_decode_cache opj_decode_cache_t;
+
 /**
 Decompression parameters
 */
@@ -410,6 +415,13 @@ typedef struct opj_dparameters {
 	OPJ_LIMIT_DECODING cp_limit_decoding;
 
 	unsigned int flags;
+
+	/**
+	Resolution levels kept from an earlier decode of the same codestream, with less data or a higher cp_reduce.
+	Levels whose code-blocks didn't change are taken from it instead of being decoded again, and the new levels
+	are added to it. NULL (the default) decodes everything.
+	*/
+	opj_decode_cache_t *decode_cache;
 } opj_dparameters_t;
 
 /** Common fields between JPEG-2000 compression and decompression master structs. */
@@ -731,6 +743,37 @@ extern "C" {
 
 OPJ_API const char * OPJ_CALLCONV opj_version(void);
 
+/* 
+==========================================================
+   multithreading
+==========================================================
+*/
+
+/** Part index of a job that is split into independent parts */
+typedef void (*opj_parallel_job_fn)(void *data, int index);
+/** Runs job(data, index) for every index from 0 to count - 1, possibly on other threads, and returns when all are done */
+typedef void (*opj_parallel_for_fn)(opj_parallel_job_fn job, void *data, int count);
+
+/**
+Let the encoder run independent work, like the tier-1 coding of code-blocks, through parallel_for.
+Without it (or with NULL) everything runs on the calling thread. The codestream is the same either way.
+@param parallel_for Function that runs the parts of a job, possibly in parallel
+*/
+OPJ_API void OPJ_CALLCONV opj_set_parallel_for(opj_parallel_for_fn parallel_for);
+
+/* 
+==========================================================
+   SIMD
+==========================================================
+*/
+
+/**
+Let the decoder use the SSE2 versions of the inverse wavelet and colour transforms when the CPU supports them (the default).
+The decoded image is the same either way.
+@param use_simd OPJ_FALSE to always use the plain C versions
+*/
+OPJ_API void OPJ_CALLCONV opj_set_use_simd(opj_bool use_simd);
+
 /* 
 ==========================================================
    image functions definitions
@@ -843,6 +886,23 @@ Decode an image from a JPEG-2000 codestream and extract the codestream informati
 */
 OPJ_API opj_image_t* OPJ_CALLCONV opj_decode_with_info(opj_dinfo_t *dinfo, opj_cio_t *cio, opj_codestream_info_t *cstr_info);
 /**
+Create a cache for decoding a codestream progressively, as more of it arrives or at lower
+reduce factors (see opj_dparameters_t::decode_cache). The decoded image is the same as without it.
+A cache can be used by one decoder at a time.
+@return Returns an empty cache
+*/
+OPJ_API opj_decode_cache_t* OPJ_CALLCONV opj_create_decode_cache(void);
+/**
+Destroy a decode cache
+@param cache Cache to destroy
+*/
+OPJ_API void OPJ_CALLCONV opj_destroy_decode_cache(opj_decode_cache_t *cache);
+/**
+@param cache Decode cache
+@return Returns the number of bytes of decoded samples that the cache keeps
+*/
+OPJ_API int OPJ_CALLCONV opj_decode_cache_size(opj_decode_cache_t *cache);
+/**
 Creates a J2K/JP2 compression structure
 @param format Coder to select
 @return Returns a handle to a compressor if successful, returns NULL otherwise
@@ -86,6 +86,17 @@ Most compilers implement their own version of this keyword ...
 	#endif
 #endif
 
+/*
+Can the SSE2 versions of the decoder kernels be compiled?
+With MSVC on 32-bit x86 whether they are used is decided at run time, see opj_use_sse2().
+Elsewhere __SSE2__ means that the compiler may use SSE2 anywhere, so they always are.
+Included before opj_malloc.h, which poisons malloc and free.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_MSC_VER) && defined(_M_IX86))
+	#define OPJ_HAVE_SSE2
+	#include <emmintrin.h>
+#endif
+
 /* MSVC and Borland C do not have lrintf */
 #if defined(_MSC_VER) || defined(__BORLANDC__)
 static INLINE long lrintf(float f){
@@ -123,6 +134,7 @@ static INLINE long lrintf(float f){
 #include "tcd.h"
 #include "t1.h"
 #include "dwt.h"
+#include "dcache.h"
 #include "t2.h"
 #include "mct.h"
 #include "int.h"
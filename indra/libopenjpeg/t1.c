@@ -241,7 +241,7 @@ Encode 1 code-block
 @param cblksty Code-block style
 @param numcomps
 @param mct
-@param tile
+@param distortion Incremented by the weighted distortion decrease of the passes
 */
 static void t1_encode_cblk(
 		opj_t1_t *t1,
@@ -254,7 +254,7 @@ static void t1_encode_cblk(
 		int cblksty,
 		int numcomps,
 		int mct,
-		opj_tcd_tile_t * tile);
+		double *distortion);
 /**
 Decode 1 code-block
 @param t1 T1 handle
@@ -1167,7 +1167,7 @@ static void t1_encode_cblk(
 		int cblksty,
 		int numcomps,
 		int mct,
-		opj_tcd_tile_t * tile)
+		double *distortion)
 {
 	double cumwmsedec = 0.0;
 
@@ -1219,7 +1219,7 @@ static void t1_encode_cblk(
 		/* fixed_quality */
 		tempwmsedec = t1_getwmsedec(nmsedec, compno, level, orient, bpno, qmfbid, stepsize, numcomps, mct);
 		cumwmsedec += tempwmsedec;
-		tile->distotile += tempwmsedec;
+		*distortion += tempwmsedec;
 		
 		/* Code switch "RESTART" (i.e. TERMALL) */
 		if ((cblksty & J2K_CCP_CBLKSTY_TERMALL)	&& !((passtype == 2) && (bpno - 1 < 0))) {
@@ -1409,111 +1409,224 @@ void t1_destroy(opj_t1_t *t1) {
 	}
 }
 
+/** A code-block to encode, with where to find its samples */
+typedef struct opj_t1_cblk_job {
+	opj_tcd_tilecomp_t *tilec;
+	opj_tccp_t *tccp;
+	opj_tcd_band_t *band;
+	opj_tcd_cblk_enc_t *cblk;
+	int compno;
+	int resno;
+	/** Weighted distortion decrease of the code-block */
+	double distortion;
+} opj_t1_cblk_job_t;
+
+/** The code-blocks of a tile, encoded in parts by t1_encode_part */
+typedef struct opj_t1_encode_job {
+	opj_common_ptr cinfo;
+	opj_tcd_tile_t *tile;
+	opj_tcp_t *tcp;
+	opj_t1_cblk_job_t *cblks;
+	int numcblks;
+	int numparts;
+	/** Set when a part failed to allocate its buffers */
+	opj_bool failed;
+} opj_t1_encode_job_t;
+
+static opj_bool t1_encode_cblk_job(opj_t1_t *t1, opj_t1_cblk_job_t *job, int numcomps, int mct) {
+	opj_tcd_tilecomp_t *tilec = job->tilec;
+	opj_tccp_t *tccp = job->tccp;
+	opj_tcd_band_t *band = job->band;
+	opj_tcd_cblk_enc_t *cblk = job->cblk;
+	int resno = job->resno;
+	int tile_w = tilec->x1 - tilec->x0;
+	int bandconst = 8192 * 8192 / ((int) floor(band->stepsize * 8192));
+	int* restrict datap;
+	int* restrict tiledp;
+	int cblk_w;
+	int cblk_h;
+	int i, j;
+
+	int x = cblk->x0 - band->x0;
+	int y = cblk->y0 - band->y0;
+	if (band->bandno & 1) {
+		opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
+		x += pres->x1 - pres->x0;
+	}
+	if (band->bandno & 2) {
+		opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
+		y += pres->y1 - pres->y0;
+	}
+
+	if(!allocate_buffers(
+				t1,
+				cblk->x1 - cblk->x0,
+				cblk->y1 - cblk->y0))
+	{
+		return OPJ_FALSE;
+	}
+
+	datap=t1->data;
+	cblk_w = t1->w;
+	cblk_h = t1->h;
+
+	tiledp=&tilec->data[(y * tile_w) + x];
+	if (tccp->qmfbid == 1) {
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				int tmp = tiledp[(j * tile_w) + i];
+				datap[(j * cblk_w) + i] = tmp << T1_NMSEDEC_FRACBITS;
+			}
+		}
+	} else {		/* if (tccp->qmfbid == 0) */
+		for (j = 0; j < cblk_h; ++j) {
+			for (i = 0; i < cblk_w; ++i) {
+				int tmp = tiledp[(j * tile_w) + i];
+				datap[(j * cblk_w) + i] =
+					fix_mul(
+					tmp,
+					bandconst) >> (11 - T1_NMSEDEC_FRACBITS);
+			}
+		}
+	}
+
+	job->distortion = 0.0;
+	t1_encode_cblk(
+			t1,
+			cblk,
+			band->bandno,
+			job->compno,
+			tilec->numresolutions - 1 - resno,
+			tccp->qmfbid,
+			band->stepsize,
+			tccp->cblksty,
+			numcomps,
+			mct,
+			&job->distortion);
+	return OPJ_TRUE;
+}
+
+/* Encode part index of the code-blocks of a tile, each part with its own T1 handle */
+static void t1_encode_part(void *data, int index) {
+	opj_t1_encode_job_t *job = (opj_t1_encode_job_t*)data;
+	int first = (int)((double)job->numcblks * index / job->numparts);
+	int last = (int)((double)job->numcblks * (index + 1) / job->numparts);
+	int cblkno;
+	opj_t1_t *t1 = t1_create(job->cinfo);
+	if (!t1) {
+		job->failed = OPJ_TRUE;
+		return;
+	}
+	for (cblkno = first; cblkno < last; ++cblkno) {
+		if (!t1_encode_cblk_job(t1, &job->cblks[cblkno], job->tile->numcomps, job->tcp->mct)) {
+			job->failed = OPJ_TRUE;
+			break;
+		}
+	}
+	t1_destroy(t1);
+}
+
 void t1_encode_cblks(
 		opj_t1_t *t1,
 		opj_tcd_tile_t *tile,
 		opj_tcp_t *tcp)
 {
 	int compno, resno, bandno, precno, cblkno;
+	opj_t1_encode_job_t job;
+	int numcblks = 0;
 
 	tile->distotile = 0;		/* fixed_quality */
 
+	/* List the code-blocks first, so that they can be encoded in parallel */
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+		for (resno = 0; resno < tilec->numresolutions; ++resno) {
+			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
+			for (bandno = 0; bandno < res->numbands; ++bandno) {
+				opj_tcd_band_t* restrict band = &res->bands[bandno];
+				for (precno = 0; precno < res->pw * res->ph; ++precno) {
+					numcblks += band->precincts[precno].cw * band->precincts[precno].ch;
+				}
+			}
+		}
+	}
+
+	job.cinfo = t1->cinfo;
+	job.tile = tile;
+	job.tcp = tcp;
+	job.numcblks = 0;
+	job.failed = OPJ_FALSE;
+	job.cblks = (opj_t1_cblk_job_t*) opj_malloc(numcblks * sizeof(opj_t1_cblk_job_t));
+	if (!job.cblks && numcblks) {
+		opj_event_msg(t1->cinfo, EVT_ERROR, "Not enough memory to encode the code-blocks\n");
+		return;
+	}
+
 	for (compno = 0; compno < tile->numcomps; ++compno) {
 		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
 		opj_tccp_t* tccp = &tcp->tccps[compno];
-		int tile_w = tilec->x1 - tilec->x0;
 
 		for (resno = 0; resno < tilec->numresolutions; ++resno) {
 			opj_tcd_resolution_t *res = &tilec->resolutions[resno];
 
 			for (bandno = 0; bandno < res->numbands; ++bandno) {
 				opj_tcd_band_t* restrict band = &res->bands[bandno];
-        int bandconst = 8192 * 8192 / ((int) floor(band->stepsize * 8192));
 
 				for (precno = 0; precno < res->pw * res->ph; ++precno) {
 					opj_tcd_precinct_t *prc = &band->precincts[precno];
 
 					for (cblkno = 0; cblkno < prc->cw * prc->ch; ++cblkno) {
-						opj_tcd_cblk_enc_t* cblk = &prc->cblks.enc[cblkno];
-						int* restrict datap;
-						int* restrict tiledp;
-						int cblk_w;
-						int cblk_h;
-						int i, j;
-
-						int x = cblk->x0 - band->x0;
-						int y = cblk->y0 - band->y0;
-						if (band->bandno & 1) {
-							opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
-							x += pres->x1 - pres->x0;
-						}
-						if (band->bandno & 2) {
-							opj_tcd_resolution_t *pres = &tilec->resolutions[resno - 1];
-							y += pres->y1 - pres->y0;
-						}
-
-						if(!allocate_buffers(
-									t1,
-									cblk->x1 - cblk->x0,
-									cblk->y1 - cblk->y0))
-						{
-							return;
-						}
-
-						datap=t1->data;
-						cblk_w = t1->w;
-						cblk_h = t1->h;
-
-						tiledp=&tilec->data[(y * tile_w) + x];
-						if (tccp->qmfbid == 1) {
-							for (j = 0; j < cblk_h; ++j) {
-								for (i = 0; i < cblk_w; ++i) {
-									int tmp = tiledp[(j * tile_w) + i];
-									datap[(j * cblk_w) + i] = tmp << T1_NMSEDEC_FRACBITS;
-								}
-							}
-						} else {		/* if (tccp->qmfbid == 0) */
-							for (j = 0; j < cblk_h; ++j) {
-								for (i = 0; i < cblk_w; ++i) {
-									int tmp = tiledp[(j * tile_w) + i];
-									datap[(j * cblk_w) + i] =
-										fix_mul(
-										tmp,
-										bandconst) >> (11 - T1_NMSEDEC_FRACBITS);
-								}
-							}
-						}
-
-						t1_encode_cblk(
-								t1,
-								cblk,
-								band->bandno,
-								compno,
-								tilec->numresolutions - 1 - resno,
-								tccp->qmfbid,
-								band->stepsize,
-								tccp->cblksty,
-								tile->numcomps,
-								tcp->mct,
-								tile);
-
+						opj_t1_cblk_job_t *cblk_job = &job.cblks[job.numcblks++];
+						cblk_job->tilec = tilec;
+						cblk_job->tccp = tccp;
+						cblk_job->band = band;
+						cblk_job->cblk = &prc->cblks.enc[cblkno];
+						cblk_job->compno = compno;
+						cblk_job->resno = resno;
+						cblk_job->distortion = 0.0;
 					} /* cblkno */
 				} /* precno */
 			} /* bandno */
 		} /* resno  */
 	} /* compno  */
+
+	if (opj_has_parallel_for()) {
+		/* A few parts per thread, so that they even out */
+		job.numparts = int_min(numcblks, 64);
+		opj_parallel_for(t1_encode_part, &job, job.numparts);
+	} else {
+		for (cblkno = 0; cblkno < numcblks; ++cblkno) {
+			if (!t1_encode_cblk_job(t1, &job.cblks[cblkno], tile->numcomps, tcp->mct)) {
+				job.failed = OPJ_TRUE;
+				break;
+			}
+		}
+	}
+
+	/* Add up in code-block order, so that the result doesn't depend on the parallelism */
+	for (cblkno = 0; cblkno < numcblks; ++cblkno) {
+		tile->distotile += job.cblks[cblkno].distortion;
+	}
+	if (job.failed) {
+		opj_event_msg(t1->cinfo, EVT_ERROR, "Not enough memory to encode the code-blocks\n");
+	}
+	opj_free(job.cblks);
 }
 
 void t1_decode_cblks(
 		opj_t1_t* t1,
 		opj_tcd_tilecomp_t* tilec,
-		opj_tccp_t* tccp)
+		opj_tccp_t* tccp,
+		int first,
+		int numres)
 {
 	int resno, bandno, precno, cblkno;
 
 	int tile_w = tilec->x1 - tilec->x0;
 
 	for (resno = 0; resno < tilec->numresolutions; ++resno) {
+		/* The code-blocks of the other resolution levels are only freed */
+		opj_bool decode = resno >= first && resno < numres;
 		opj_tcd_resolution_t* res = &tilec->resolutions[resno];
 
 		for (bandno = 0; bandno < res->numbands; ++bandno) {
@@ -1529,6 +1642,12 @@ void t1_decode_cblks(
 					int x, y;
 					int i, j;
 
+					if (!decode) {
+						opj_free(cblk->data);
+						opj_free(cblk->segs);
+						continue;
+					}
+
 					t1_decode_cblk(
 							t1,
 							cblk,
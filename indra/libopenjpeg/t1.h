@@ -133,12 +133,14 @@ Encode the code-blocks of a tile
 */
 void t1_encode_cblks(opj_t1_t *t1, opj_tcd_tile_t *tile, opj_tcp_t *tcp);
 /**
-Decode the code-blocks of a tile
+Decode the code-blocks of a tile-component and free them
 @param t1 T1 handle
-@param tilec The tile to decode
+@param tilec The tile-component to decode
 @param tccp Tile coding parameters
+@param first First resolution level to decode
+@param numres Number of resolution levels that are needed; the code-blocks of higher levels are only freed
 */
-void t1_decode_cblks(opj_t1_t* t1, opj_tcd_tilecomp_t* tilec, opj_tccp_t* tccp);
+void t1_decode_cblks(opj_t1_t* t1, opj_tcd_tilecomp_t* tilec, opj_tccp_t* tccp, int first, int numres);
 /* ----------------------------------------------------------------------- */
 /*@}*/
 
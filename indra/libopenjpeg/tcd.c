@@ -667,8 +667,9 @@ void tcd_malloc_decode(opj_tcd_t *tcd, opj_image_t * image, opj_cp_t * cp) {
 			y1 = j == 0 ? tilec->y1 : int_max(y1,	(unsigned int) tilec->y1);
 		}
 
-		w = int_ceildivpow2(x1 - x0, image->comps[i].factor);
-		h = int_ceildivpow2(y1 - y0, image->comps[i].factor);
+		/* The size of the reduced resolution level, which differs from the reduced size when x0 or y0 is odd */
+		w = int_ceildivpow2(x1, image->comps[i].factor) - int_ceildivpow2(x0, image->comps[i].factor);
+		h = int_ceildivpow2(y1, image->comps[i].factor) - int_ceildivpow2(y0, image->comps[i].factor);
 
 		image->comps[i].w = w;
 		image->comps[i].h = h;
@@ -1178,6 +1179,17 @@ opj_bool tcd_rateallocate(opj_tcd_t *tcd, unsigned char *dest, int len, opj_code
 	return OPJ_TRUE;
 }
 
+/* Forward DWT of component compno of the current tile */
+static void tcd_dwt_encode_comp(void *data, int compno) {
+	opj_tcd_t *tcd = (opj_tcd_t*)data;
+	opj_tcd_tilecomp_t *tilec = &tcd->tcd_tile->comps[compno];
+	if (tcd->tcp->tccps[compno].qmfbid == 1) {
+		dwt_encode(tilec);
+	} else if (tcd->tcp->tccps[compno].qmfbid == 0) {
+		dwt_encode_real(tilec);
+	}
+}
+
 int tcd_encode_tile(opj_tcd_t *tcd, int tileno, unsigned char *dest, int len, opj_codestream_info_t *cstr_info) {
 	int compno;
 	int l, i, numpacks = 0;
@@ -1271,14 +1283,8 @@ int tcd_encode_tile(opj_tcd_t *tcd, int tileno, unsigned char *dest, int len, op
 		
 		/*----------------DWT---------------------*/
 		
-		for (compno = 0; compno < tile->numcomps; compno++) {
-			opj_tcd_tilecomp_t *tilec = &tile->comps[compno];
-			if (tcd_tcp->tccps[compno].qmfbid == 1) {
-				dwt_encode(tilec);
-			} else if (tcd_tcp->tccps[compno].qmfbid == 0) {
-				dwt_encode_real(tilec);
-			}
-		}
+		/* The components are independent */
+		opj_parallel_for(tcd_dwt_encode_comp, tcd, tile->numcomps);
 		
 		/*------------------TIER1-----------------*/
 		t1 = t1_create(tcd->cinfo);
@@ -1331,6 +1337,7 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 	int l;
 	int compno;
 	int eof = 0;
+	int *reuse = NULL;
 	double tile_time, t1_time, dwt_time;
 	opj_tcd_tile_t *tile = NULL;
 
@@ -1383,6 +1390,28 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 		opj_event_msg(tcd->cinfo, EVT_ERROR, "tcd_decode: incomplete bistream\n");
 	}
 	
+	/* Number of resolution levels to decode */
+	for (compno = 0; compno < tile->numcomps; ++compno) {
+		if (tcd->cp->reduce != 0) {
+			if ( tile->comps[compno].numresolutions < ( tcd->cp->reduce - 1 ) ) {
+				opj_event_msg(tcd->cinfo, EVT_ERROR, "Error decoding tile. The number of resolutions to remove [%d+1] is higher than the number "
+							  " of resolutions in the original codestream [%d]\nModify the cp_reduce parameter.\n", tcd->cp->reduce, tile->comps[compno].numresolutions);
+				return OPJ_FALSE;
+			}
+			else {
+				tcd->image->comps[compno].resno_decoded =
+						tile->comps[compno].numresolutions - tcd->cp->reduce - 1;
+			}
+		}
+	}
+
+	/* Number of resolution levels that the decode cache still has from an earlier decode */
+	reuse = (int*) opj_calloc(tile->numcomps, sizeof(int));
+	if (reuse == NULL) {
+		opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+		return OPJ_FALSE;
+	}
+
 	/*------------------TIER1-----------------*/
 	
 	t1_time = opj_clock();	/* time needed to decode a tile */
@@ -1391,20 +1420,27 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
     {
         opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
         t1_destroy(t1);
+        opj_free(reuse);
         return OPJ_FALSE;
     }
 
 	for (compno = 0; compno < tile->numcomps; ++compno) {
 		opj_tcd_tilecomp_t* tilec = &tile->comps[compno];
+		int numres2decode = tcd->image->comps[compno].resno_decoded + 1;
 		/* The +3 is headroom required by the vectorized DWT */
 		tilec->data = (int*) opj_aligned_malloc((((tilec->x1 - tilec->x0) * (tilec->y1 - tilec->y0))+3) * sizeof(int));
         if (tilec->data == NULL)
         {
             opj_event_msg(tcd->cinfo, EVT_ERROR, "Out of memory\n");
+            opj_free(reuse);
             return OPJ_FALSE;
         }
 
-		t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno]);
+		if (tcd->cp->decode_cache) {
+			reuse[compno] = dcache_match(tcd->cp->decode_cache, tileno * tile->numcomps + compno, tilec,
+					tcd->tcp->tccps[compno].qmfbid, numres2decode);
+		}
+		t1_decode_cblks(t1, tilec, &tcd->tcp->tccps[compno], reuse[compno], numres2decode);
 	}
 	t1_destroy(t1);
 	t1_time = opj_clock() - t1_time;
@@ -1415,27 +1451,32 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 	dwt_time = opj_clock();	/* time needed to decode a tile */
 	for (compno = 0; compno < tile->numcomps; compno++) {
 		opj_tcd_tilecomp_t *tilec = &tile->comps[compno];
-		int numres2decode;
-
-		if (tcd->cp->reduce != 0) {
-			if ( tile->comps[compno].numresolutions < ( tcd->cp->reduce - 1 ) ) {
-				opj_event_msg(tcd->cinfo, EVT_ERROR, "Error decoding tile. The number of resolutions to remove [%d+1] is higher than the number "
-							  " of resolutions in the original codestream [%d]\nModify the cp_reduce parameter.\n", tcd->cp->reduce, tile->comps[compno].numresolutions);
-				return OPJ_FALSE;
-			}
-			else {
-				tcd->image->comps[compno].resno_decoded =
-						tile->comps[compno].numresolutions - tcd->cp->reduce - 1;
-			}
-		}
+		int numres2decode = tcd->image->comps[compno].resno_decoded + 1;
 
 		if(!tilec->data) {
 			opj_event_msg(tcd->cinfo, EVT_ERROR, "Error decoding tile. null data\n");
+			opj_free(reuse);
 			return OPJ_FALSE;
 		}
 
-		numres2decode = tcd->image->comps[compno].resno_decoded + 1;
-		if(numres2decode > 0){
+		if (tcd->cp->decode_cache && numres2decode > 0) {
+			/* Restore the levels that didn't change, then reconstruct and keep the others one at a time */
+			int index = tileno * tile->numcomps + compno;
+			int resno;
+			if (reuse[compno] > 0) {
+				dcache_restore(tcd->cp->decode_cache, index, tilec, reuse[compno] - 1);
+			}
+			for (resno = reuse[compno]; resno < numres2decode; ++resno) {
+				if (resno > 0) {
+					if (tcd->tcp->tccps[compno].qmfbid == 1) {
+						dwt_decode_from(tilec, resno - 1, resno + 1);
+					} else {
+						dwt_decode_real_from(tilec, resno - 1, resno + 1);
+					}
+				}
+				dcache_store(tcd->cp->decode_cache, index, tilec, resno);
+			}
+		} else if(numres2decode > 0){
 			if (tcd->tcp->tccps[compno].qmfbid == 1) {
 				dwt_decode(tilec, numres2decode);
 			} else {
@@ -1443,6 +1484,7 @@ opj_bool tcd_decode_tile(opj_tcd_t *tcd, unsigned char *src, int len, int tileno
 			}
 		}
 	}
+	opj_free(reuse);
 	dwt_time = opj_clock() - dwt_time;
 	opj_event_msg(tcd->cinfo, EVT_INFO, "- dwt took %f s\n", dwt_time);
 
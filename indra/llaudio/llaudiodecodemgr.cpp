@@ -35,664 +35,205 @@
 
 #include "llvorbisdecode.h"
 #include "llaudioengine.h"
-#include "lllfsthread.h"
+#include "lldecodedaudiocache.h"
+#include "llthreadpool.h"
 #include "llvfile.h"
 #include "llstring.h"
 #include "lldir.h"
-#include "llendianswizzle.h"
+#include "llapr.h"
 #include "llassetstorage.h"
-#include "llrefcount.h"
 
-#include "vorbis/codec.h"
-#include "vorbis/vorbisfile.h"
-#include "llvorbisencode.h"
-#include <iterator> //VS2010
+#include <set>
 
 extern LLAudioEngine *gAudiop;
 
 LLAudioDecodeMgr *gAudioDecodeMgrp = NULL;
 
-static const S32 WAV_HEADER_SIZE = 44;
+// At most this many bytes of decoded sounds are kept in memory.
+static const U32 DECODED_AUDIO_CACHE_SIZE = 64 * 1024 * 1024;
 
 
 //////////////////////////////////////////////////////////////////////////////
 
+class LLAudioDecodeJob;
 
-class LLVorbisDecodeState : public LLRefCount
+class LLAudioDecodeMgr::Impl
 {
+	friend class LLAudioDecodeMgr;
 public:
-	class WriteResponder : public LLLFSThread::Responder
-	{
-	public:
-		WriteResponder(LLVorbisDecodeState* decoder) : mDecoder(decoder) {}
-		~WriteResponder() {}
-		void completed(S32 bytes)
-		{
-			mDecoder->ioComplete(bytes);
-		}
-		LLPointer<LLVorbisDecodeState> mDecoder;
-	};
-	
-	LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename);
+	Impl();
+	~Impl();
 
-	BOOL initDecode();
-	BOOL decodeSection(); // Return TRUE if done.
-	BOOL finishDecode();
-
-	void flushBadFile();
+	void processQueue(const F32 num_secs = 0.005);
 
-	void ioComplete(S32 bytes)			{ mBytesRead = bytes; }
-	BOOL isValid() const				{ return mValid; }
-	BOOL isDone() const					{ return mDone; }
-	const LLUUID &getUUID() const		{ return mUUID; }
+	// Called from a worker thread when job finished.
+	void decodeDone(LLAudioDecodeJob *job);
 
 protected:
-	virtual ~LLVorbisDecodeState();
+	void startDecode(const LLUUID &uuid);
 
-	BOOL mValid;
-	BOOL mDone;
-	LLAtomicS32 mBytesRead;
-	LLUUID mUUID;
+	LLLinkedQueue<LLUUID> mDecodeQueue;
+	std::set<LLUUID> mDecoding;							// Posted to mDecodePool, but not handed to the audio engine yet.
 
-	std::vector<U8> mWAVBuffer;
-#if !defined(USE_WAV_VFILE)
-	std::string mOutFilename;
-	LLLFSThread::handle_t mFileHandle;
-#endif
-	
-	LLVFile *mInFilep;
-	OggVorbis_File mVF;
-	S32 mCurrentSection;
-};
+	LLThreadPool *mDecodePool;
+	LLThreadPool::Group mDecodeGroup;
+	S32 mMaxDecoding;
 
-size_t vfs_read(void *ptr, size_t size, size_t nmemb, void *datasource)
-{
-	LLVFile *file = (LLVFile *)datasource;
+	LLMutex mDoneMutex;									// Protects mDone.
+	std::vector<LLPointer<LLAudioDecodeJob> > mDone;
 
-	if (file->read((U8*)ptr, (S32)(size * nmemb)))	/*Flawfinder: ignore*/
-	{
-		S32 read = file->getLastBytesRead();
-		return  read / size;	/*Flawfinder: ignore*/
-	}
-	else
-	{
-		return 0;
-	}
-}
+	LLDecodedAudioCache mDecodedCache;
+};
 
-int vfs_seek(void *datasource, ogg_int64_t offset, int whence)
+// Decodes a sound asset from the VFS and writes the WAV file to the cache directory.
+class LLAudioDecodeJob : public LLThreadPool::Job
 {
-	LLVFile *file = (LLVFile *)datasource;
-
-	// vfs has 31-bit files
-	if (offset > S32_MAX)
-	{
-		return -1;
-	}
-
-	S32 origin;
-	switch (whence) {
-	case SEEK_SET:
-		origin = 0;
-		break;
-	case SEEK_END:
-		origin = file->getSize();
-		break;
-	case SEEK_CUR:
-		origin = -1;
-		break;
-	default:
-		llerrs << "Invalid whence argument to vfs_seek" << llendl;
-		return -1;
-	}
-
-	if (file->seek((S32)offset, origin))
-	{
-		return 0;
-	}
-	else
+public:
+	LLAudioDecodeJob(LLAudioDecodeMgr::Impl *mgr, const LLUUID &uuid, const std::string &out_filename, bool allow_large_sounds) :
+		mMgr(mgr), mUUID(uuid), mOutFilename(out_filename), mAllowLargeSounds(allow_large_sounds), mValid(false)
 	{
-		return -1;
 	}
-}
-
-int vfs_close (void *datasource)
-{
-	LLVFile *file = (LLVFile *)datasource;
-	delete file;
-	return 0;
-}
 
-long vfs_tell (void *datasource)
-{
-	LLVFile *file = (LLVFile *)datasource;
-	return file->tell();
-}
+	/*virtual*/ void run(void);
 
-LLVorbisDecodeState::LLVorbisDecodeState(const LLUUID &uuid, const std::string &out_filename) :
-	mValid(FALSE), mDone(FALSE), mBytesRead(-1), mUUID(uuid),
-#if !defined(USE_WAV_VFILE)
-	mOutFilename(out_filename), mFileHandle(LLLFSThread::nullHandle()),
-#endif
-	mInFilep(NULL), mCurrentSection(0)
-{
-}
-
-LLVorbisDecodeState::~LLVorbisDecodeState()
-{
-	if (!mDone)
-	{
-		delete mInFilep;
-		mInFilep = NULL;
-	}
-}
+	LLAudioDecodeMgr::Impl *mMgr;
+	const LLUUID mUUID;
+	const std::string mOutFilename;
+	const bool mAllowLargeSounds;
 
+	// Results.
+	bool mValid;
+	std::vector<U8> mWAVBuffer;
+};
 
-BOOL LLVorbisDecodeState::initDecode()
+void LLAudioDecodeJob::run(void)
 {
-	ov_callbacks vfs_callbacks;
-	vfs_callbacks.read_func = vfs_read;
-	vfs_callbacks.seek_func = vfs_seek;
-	vfs_callbacks.close_func = vfs_close;
-	vfs_callbacks.tell_func = vfs_tell;
-
-	//llinfos << "Initing decode from vfile: " << mUUID << llendl;
-
-	mInFilep = new LLVFile(gVFS, mUUID, LLAssetType::AT_SOUND);
-	if (!mInFilep || !mInFilep->getSize())
+	LLVFile infile(gVFS, mUUID, LLAssetType::AT_SOUND);
+	S32 size = infile.getSize();
+	if (size <= 0)
 	{
 		llwarns << "unable to open vorbis source vfile for reading" << llendl;
-		delete mInFilep;
-		mInFilep = NULL;
-		return FALSE;
-	}
-
-	int r = ov_open_callbacks(mInFilep, &mVF, NULL, 0, vfs_callbacks);
-	if(r < 0) 
-	{
-		llwarns << r << " Input to vorbis decode does not appear to be an Ogg bitstream: " << mUUID << llendl;
-		return(FALSE);
 	}
-	
-	S32 sample_count = ov_pcm_total(&mVF, -1);
-	size_t size_guess = (size_t)sample_count;
-	vorbis_info* vi = ov_info(&mVF, -1);
-	size_guess *= (vi? vi->channels : 1);
-	size_guess *= 2;
-	size_guess += 2048;
-	
-	bool abort_decode = false;
-
-	if (vi)
+	else
 	{
-		if( vi->channels < 1 || vi->channels > LLVORBIS_CLIP_MAX_CHANNELS )
+		std::vector<U8> ogg_data(size);
+		if (!infile.read(&ogg_data[0], size) || infile.getLastBytesRead() != size)
 		{
-			abort_decode = true;
-			llwarns << "Bad channel count: " << vi->channels << llendl;
+			llwarns << "unable to read vorbis source vfile " << mUUID << llendl;
 		}
-	}
-	else // !vi
-	{
-		abort_decode = true;
-		llwarns << "No default bitstream found" << llendl;	
-	}
-	// <edit>
-	// This magic value is equivalent to 150MiB of data.
-	// Prevents griefers from utilizing a huge xbox sound the size of god to instafry the viewer
-	if(size_guess >= 157286400)
-	{
-		llwarns << "Bad sound caught by zmagic" << llendl;
-		abort_decode = true;
-	}
-	else if(!gAudiop->getAllowLargeSounds())
-	{
-	// </edit> 
-	//Much more restrictive than zmagic. Perhaps make toggleable.
-	if( (size_t)sample_count > LLVORBIS_CLIP_REJECT_SAMPLES ||
-	    (size_t)sample_count <= 0)
-	{
-		abort_decode = true;
-		llwarns << "Illegal sample count: " << sample_count << llendl;
-	}
-	
-	if( size_guess > LLVORBIS_CLIP_REJECT_SIZE ||
-	    size_guess < 0)
-	{
-		abort_decode = true;
-		llwarns << "Illegal sample size: " << size_guess << llendl;
-	}
-	// <edit>
-	}
-	// </edit>
-	if( abort_decode )
-	{
-		llwarns << "Canceling initDecode. Bad asset: " << mUUID << llendl;
-		vorbis_comment* comment = ov_comment(&mVF,-1);
-		if (comment && comment->vendor)
+		else
 		{
-			llwarns << "Bad asset encoded by: " << comment->vendor << llendl;
+			bool corrupt;
+			mValid = decode_vorbis_to_wav(mUUID, &ogg_data[0], size, mAllowLargeSounds, mWAVBuffer, corrupt);
+			if (corrupt)
+			{
+				llwarns << "Flushing bad vorbis file from VFS for " << mUUID << llendl;
+				infile.remove();
+			}
 		}
-		delete mInFilep;
-		mInFilep = NULL;
-		return FALSE;
 	}
-	
-	// <edit>
-	try
-	{
-	// </edit>
-		mWAVBuffer.reserve(size_guess);
-		mWAVBuffer.resize(WAV_HEADER_SIZE);
-	// <edit>
-	}
-	catch(std::bad_alloc)
+
+	if (mValid)
 	{
-		llwarns << "bad_alloc" << llendl;
-		if(mInFilep)
+#if defined(USE_WAV_VFILE)
+		LLVFile output(gVFS, mUUID, LLAssetType::AT_SOUND_WAV);
+		output.write(&mWAVBuffer[0], mWAVBuffer.size());
+#else
+		if (LLAPRFile::writeEx(mOutFilename, &mWAVBuffer[0], 0, (S32)mWAVBuffer.size()) != (S32)mWAVBuffer.size())
 		{
-			delete mInFilep;
-			mInFilep = NULL;
+			llwarns << "Unable to write file " << mOutFilename << llendl;
+			mValid = false;
 		}
-		return FALSE;
+#endif
 	}
-	// </edit>
 
-	{
-		// write the .wav format header
-		//"RIFF"
-		mWAVBuffer[0] = 0x52;
-		mWAVBuffer[1] = 0x49;
-		mWAVBuffer[2] = 0x46;
-		mWAVBuffer[3] = 0x46;
-
-		// length = datalen + 36 (to be filled in later)
-		mWAVBuffer[4] = 0x00;
-		mWAVBuffer[5] = 0x00;
-		mWAVBuffer[6] = 0x00;
-		mWAVBuffer[7] = 0x00;
-
-		//"WAVE"
-		mWAVBuffer[8] = 0x57;
-		mWAVBuffer[9] = 0x41;
-		mWAVBuffer[10] = 0x56;
-		mWAVBuffer[11] = 0x45;
-
-		// "fmt "
-		mWAVBuffer[12] = 0x66;
-		mWAVBuffer[13] = 0x6D;
-		mWAVBuffer[14] = 0x74;
-		mWAVBuffer[15] = 0x20;
-
-		// chunk size = 16
-		mWAVBuffer[16] = 0x10;
-		mWAVBuffer[17] = 0x00;
-		mWAVBuffer[18] = 0x00;
-		mWAVBuffer[19] = 0x00;
-
-		// format (1 = PCM)
-		mWAVBuffer[20] = 0x01;
-		mWAVBuffer[21] = 0x00;
-
-		// number of channels
-		mWAVBuffer[22] = 0x01;
-		mWAVBuffer[23] = 0x00;
-
-		// samples per second
-		mWAVBuffer[24] = 0x44;
-		mWAVBuffer[25] = 0xAC;
-		mWAVBuffer[26] = 0x00;
-		mWAVBuffer[27] = 0x00;
-
-		// average bytes per second
-		mWAVBuffer[28] = 0x88;
-		mWAVBuffer[29] = 0x58;
-		mWAVBuffer[30] = 0x01;
-		mWAVBuffer[31] = 0x00;
-
-		// bytes to output at a single time
-		mWAVBuffer[32] = 0x02;
-		mWAVBuffer[33] = 0x00;
-		 
-		// 16 bits per sample
-		mWAVBuffer[34] = 0x10;
-		mWAVBuffer[35] = 0x00;
-
-		// "data"
-		mWAVBuffer[36] = 0x64;
-		mWAVBuffer[37] = 0x61;
-		mWAVBuffer[38] = 0x74;
-		mWAVBuffer[39] = 0x61;
-
-		// these are the length of the data chunk, to be filled in later
-		mWAVBuffer[40] = 0x00;
-		mWAVBuffer[41] = 0x00;
-		mWAVBuffer[42] = 0x00;
-		mWAVBuffer[43] = 0x00;
-	}
-	
-	//{
-		//char **ptr=ov_comment(&mVF,-1)->user_comments;
-//		vorbis_info *vi=ov_info(&vf,-1);
-		//while(*ptr){
-		//	fprintf(stderr,"%s\n",*ptr);
-		//	++ptr;
-		//}
-//    fprintf(stderr,"\nBitstream is %d channel, %ldHz\n",vi->channels,vi->rate);
-//    fprintf(stderr,"\nDecoded length: %ld samples\n", (long)ov_pcm_total(&vf,-1));
-//    fprintf(stderr,"Encoded by: %s\n\n",ov_comment(&vf,-1)->vendor);
-	//}
-	return TRUE;
+	mMgr->decodeDone(this);
 }
 
-BOOL LLVorbisDecodeState::decodeSection()
+LLAudioDecodeMgr::Impl::Impl() :
+	mDecodedCache(DECODED_AUDIO_CACHE_SIZE)
 {
-	if (!mInFilep)
-	{
-		llwarns << "No VFS file to decode in vorbis!" << llendl;
-		return TRUE;
-	}
-	if (mDone)
-	{
-// 		llwarns << "Already done with decode, aborting!" << llendl;
-		return TRUE;
-	}
-	char pcmout[4096];	/*Flawfinder: ignore*/
+	// Leave most cores to the rest of the viewer; sounds are short.
+	mDecodePool = new LLThreadPool("audio decode", llclamp(LLThreadPool::getDefaultThreadCount() / 4, 1, 2));
+	// Keep a few decodes queued per thread, the rest waits in mDecodeQueue.
+	mMaxDecoding = 4 * mDecodePool->getThreadCount();
+}
 
-	BOOL eof = FALSE;
-	long ret=ov_read(&mVF, pcmout, sizeof(pcmout), 0, 2, 1, &mCurrentSection);
-	if (ret == 0)
-	{
-		/* EOF */
-		eof = TRUE;
-		mDone = TRUE;
-		mValid = TRUE;
-//			llinfos << "Vorbis EOF" << llendl;
-	}
-	else if (ret < 0)
-	{
-		/* error in the stream.  Not a problem, just reporting it in
-		   case we (the app) cares.  In this case, we don't. */
+LLAudioDecodeMgr::Impl::~Impl()
+{
+	// Jobs point to this object; wait until they finished or were discarded.
+	mDecodePool->shutdown();
+	mDecodeGroup.wait();
+	delete mDecodePool;
+}
 
-		llwarns << "BAD vorbis decode in decodeSection." << llendl;
+void LLAudioDecodeMgr::Impl::decodeDone(LLAudioDecodeJob *job)
+{
+	LLMutexLock lock(&mDoneMutex);
+	mDone.push_back(job);
+}
 
-		mValid = FALSE;
-		mDone = TRUE;
-		// We're done, return TRUE.
-		return TRUE;
-	}
-	else
+void LLAudioDecodeMgr::Impl::startDecode(const LLUUID &uuid)
+{
+	lldebugs << "Decoding " << uuid << " from audio queue!" << llendl;
+
+	std::string uuid_str;
+	uuid.toString(uuid_str);
+	std::string d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
+
+	mDecoding.insert(uuid);
+	LLPointer<LLThreadPool::Job> job = new LLAudioDecodeJob(this, uuid, d_path, gAudiop->getAllowLargeSounds());
+	if (!mDecodePool->post(job, &mDecodeGroup))
 	{
-//			llinfos << "Vorbis read " << ret << "bytes" << llendl;
-		/* we don't bother dealing with sample rate changes, etc, but.
-		   you'll have to*/
-		std::copy(pcmout, pcmout+ret, std::back_inserter(mWAVBuffer));
+		job->run();
 	}
-	return eof;
 }
 
-BOOL LLVorbisDecodeState::finishDecode()
+void LLAudioDecodeMgr::Impl::processQueue(const F32 num_secs)
 {
-	if (!isValid())
+	LLTimer decode_timer;
+
+	// Hand the finished decodes to the audio engine.
+	std::vector<LLPointer<LLAudioDecodeJob> > done;
 	{
-		llwarns << "Bogus vorbis decode state for " << getUUID() << ", aborting!" << llendl;
-		return TRUE; // We've finished
+		LLMutexLock lock(&mDoneMutex);
+		done.swap(mDone);
 	}
-
-#if !defined(USE_WAV_VFILE)	
-	if (mFileHandle == LLLFSThread::nullHandle())
-#endif
+	for (std::vector<LLPointer<LLAudioDecodeJob> >::iterator iter = done.begin(); iter != done.end(); ++iter)
 	{
-		ov_clear(&mVF);
-  
-		// write "data" chunk length, in little-endian format
-		S32 data_length = mWAVBuffer.size() - WAV_HEADER_SIZE;
-		mWAVBuffer[40] = (data_length) & 0x000000FF;
-		mWAVBuffer[41] = (data_length >> 8) & 0x000000FF;
-		mWAVBuffer[42] = (data_length >> 16) & 0x000000FF;
-		mWAVBuffer[43] = (data_length >> 24) & 0x000000FF;
-		// write overall "RIFF" length, in little-endian format
-		data_length += 36;
-		mWAVBuffer[4] = (data_length) & 0x000000FF;
-		mWAVBuffer[5] = (data_length >> 8) & 0x000000FF;
-		mWAVBuffer[6] = (data_length >> 16) & 0x000000FF;
-		mWAVBuffer[7] = (data_length >> 24) & 0x000000FF;
-
-		//
-		// FUDGECAKES!!! Vorbis encode/decode messes up loop point transitions (pop)
-		// do a cheap-and-cheesy crossfade 
-		//
+		LLAudioDecodeJob *job = *iter;
+		mDecoding.erase(job->mUUID);
+		if (job->mValid)
 		{
-			S16 *samplep;
-			S32 i;
-			S32 fade_length;
-			char pcmout[4096];		/*Flawfinder: ignore*/ 	
-
-			fade_length = llmin((S32)128,(S32)(data_length-36)/8);			
-			// <edit>
-			//if((S32)mWAVBuffer.size() >= (WAV_HEADER_SIZE + 2* fade_length))
-			if((S32)mWAVBuffer.size() > (WAV_HEADER_SIZE + 2* fade_length))
-			// </edit>
-			{
-				memcpy(pcmout, &mWAVBuffer[WAV_HEADER_SIZE], (2 * fade_length));	/*Flawfinder: ignore*/
-			}
-			llendianswizzle(&pcmout, 2, fade_length);
-	
-			samplep = (S16 *)pcmout;
-			for (i = 0 ;i < fade_length; i++)
-			{
-				*samplep = llfloor((F32)*samplep * ((F32)i/(F32)fade_length));
-				samplep++;
-			}
-
-			llendianswizzle(&pcmout, 2, fade_length);			
-			if((WAV_HEADER_SIZE+(2 * fade_length)) < (S32)mWAVBuffer.size())
-			{
-				memcpy(&mWAVBuffer[WAV_HEADER_SIZE], pcmout, (2 * fade_length));	/*Flawfinder: ignore*/
-			}
-			S32 near_end = mWAVBuffer.size() - (2 * fade_length);
-			// <edit>
-			//if ((S32)mWAVBuffer.size() >= ( near_end + 2* fade_length))
-			if ((S32)mWAVBuffer.size() > ( near_end + 2* fade_length))
-			// </edit>
-			{
-				memcpy(pcmout, &mWAVBuffer[near_end], (2 * fade_length));	/*Flawfinder: ignore*/
-			}
-			llendianswizzle(&pcmout, 2, fade_length);
-
-			samplep = (S16 *)pcmout;
-			for (i = fade_length-1 ; i >=  0; i--)
-			{
-				*samplep = llfloor((F32)*samplep * ((F32)i/(F32)fade_length));
-				samplep++;
-			}
-	
-			llendianswizzle(&pcmout, 2, fade_length);			
-			if (near_end + (2 * fade_length) < (S32)mWAVBuffer.size())
-			{
-				memcpy(&mWAVBuffer[near_end], pcmout, (2 * fade_length));/*Flawfinder: ignore*/
-			}
+			mDecodedCache.add(job->mUUID, job->mWAVBuffer);
 		}
-
-		if (36 == data_length)
+		LLAudioData *adp = gAudiop->getAudioData(job->mUUID);
+		if (!adp)
 		{
-			llwarns << "BAD Vorbis decode in finishDecode!" << llendl;
-			mValid = FALSE;
-			return TRUE; // we've finished
+			llwarns << "Missing LLAudioData for decode of " << job->mUUID << llendl;
 		}
-#if !defined(USE_WAV_VFILE)
-		mBytesRead = -1;
-		mFileHandle = LLLFSThread::sLocal->write(mOutFilename, &mWAVBuffer[0], 0, mWAVBuffer.size(),
-							 new WriteResponder(this));
-#endif
-	}
-
-	if (mFileHandle != LLLFSThread::nullHandle())
-	{
-		if (mBytesRead >= 0)
+		else if (job->mValid)
 		{
-			if (mBytesRead == 0)
-			{
-				llwarns << "Unable to write file in LLVorbisDecodeState::finishDecode" << llendl;
-				mValid = FALSE;
-				return TRUE; // we've finished
-			}
+			adp->setLoadState(LLAudioData::STATE_LOAD_READY);
 		}
 		else
 		{
-			return FALSE; // not done
+			adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
+			llinfos << "Vorbis decode failed for " << job->mUUID << llendl;
 		}
 	}
-	
-	mDone = TRUE;
-
-#if defined(USE_WAV_VFILE)
-	// write the data.
-	LLVFile output(gVFS, mUUID, LLAssetType::AT_SOUND_WAV);
-	output.write(&mWAVBuffer[0], mWAVBuffer.size());
-#endif
-	//llinfos << "Finished decode for " << getUUID() << llendl;
 
-	return TRUE;
-}
-
-void LLVorbisDecodeState::flushBadFile()
-{
-	if (mInFilep)
+	// Start new decodes, as long as the pool isn't full and there is time left.
+	while ((S32)mDecoding.size() < mMaxDecoding && mDecodeQueue.getLength() && decode_timer.getElapsedTimeF32() < num_secs)
 	{
-		llwarns << "Flushing bad vorbis file from VFS for " << mUUID << llendl;
-		mInFilep->remove();
-	}
-}
-
-//////////////////////////////////////////////////////////////////////////////
-
-class LLAudioDecodeMgr::Impl
-{
-	friend class LLAudioDecodeMgr;
-public:
-	Impl() {};
-	~Impl() {};
-
-	void processQueue(const F32 num_secs = 0.005);
-
-protected:
-	LLLinkedQueue<LLUUID> mDecodeQueue;
-	LLPointer<LLVorbisDecodeState> mCurrentDecodep;
-};
-
-
-void LLAudioDecodeMgr::Impl::processQueue(const F32 num_secs)
-{
-	LLUUID uuid;
-
-	LLTimer decode_timer;
-
-	BOOL done = FALSE;
-	while (!done)
-	{
-		if (mCurrentDecodep)
-		{
-			// <edit> rawrning
-			//BOOL res;
-			BOOL res = false;
-			// </edit>
-
-			// Decode in a loop until we're done or have run out of time.
-			/* <edit> */ try{ /* </edit> */
-			while(!(res = mCurrentDecodep->decodeSection()) && (decode_timer.getElapsedTimeF32() < num_secs))
-			{
-				// decodeSection does all of the work above
-			}
-			/* <edit> */ }catch(std::bad_alloc){llerrs<<"bad_alloc whilst decoding"<<llendl;} /* </edit> */
-
-			if (mCurrentDecodep->isDone() && !mCurrentDecodep->isValid())
-			{
-				// We had an error when decoding, abort.
-				llwarns << mCurrentDecodep->getUUID() << " has invalid vorbis data, aborting decode" << llendl;
-				mCurrentDecodep->flushBadFile();
-				LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-				if(adp)
-				{
-					adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-				}
-				mCurrentDecodep = NULL;
-				done = TRUE;
-			}
-
-			if (!res)
-			{
-				// We've used up out time slice, bail...
-				done = TRUE;
-			}
-			else if (mCurrentDecodep)
-			{
-				if (mCurrentDecodep->finishDecode())
-				{
-					// We finished!
-					LLAudioData *adp = gAudiop->getAudioData(mCurrentDecodep->getUUID());
-					if (!adp)
-					{
-						llwarns << "Missing LLAudioData for decode of " << mCurrentDecodep->getUUID() << llendl;
-					}
-					else if (mCurrentDecodep->isValid() && mCurrentDecodep->isDone())
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_READY);
-						// At this point, we could see if anyone needs this sound immediately, but
-						// I'm not sure that there's a reason to - we need to poll all of the playing
-						// sounds anyway.
-						//llinfos << "Finished the vorbis decode, now what?" << llendl;
-					}
-					else
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-						llinfos << "Vorbis decode failed for " << mCurrentDecodep->getUUID() << llendl;
-					}
-					mCurrentDecodep = NULL;
-				}
-				done = TRUE; // done for now
-			}
-		}
-
-		if (!done)
+		LLUUID uuid;
+		mDecodeQueue.pop(uuid);
+		if (mDecoding.count(uuid) || mDecodedCache.has(uuid) || gAudiop->hasDecodedFile(uuid))
 		{
-			if (!mDecodeQueue.getLength())
-			{
-				// Nothing else on the queue.
-				done = TRUE;
-			}
-			else
-			{
-				LLUUID uuid;
-				mDecodeQueue.pop(uuid);
-				if (gAudiop->hasDecodedFile(uuid))
-				{
-					// This file has already been decoded, don't decode it again.
-					continue;
-				}
-
-				lldebugs << "Decoding " << uuid << " from audio queue!" << llendl;
-
-				std::string uuid_str;
-				std::string d_path;
-
-				LLTimer timer;
-				timer.reset();
-
-				uuid.toString(uuid_str);
-				d_path = gDirUtilp->getExpandedFilename(LL_PATH_CACHE,uuid_str) + ".dsf";
-
-				mCurrentDecodep = new LLVorbisDecodeState(uuid, d_path);
-				if (!mCurrentDecodep->initDecode())
-				{
-					LLAudioData *adp = gAudiop->getAudioData(uuid);
-					if(adp)
-					{
-						adp->setLoadState(LLAudioData::STATE_LOAD_ERROR);
-					}
-					mCurrentDecodep = NULL;
-				}
-			}
+			// This file is being decoded or has already been decoded, don't decode it again.
+			continue;
 		}
+		startDecode(uuid);
 	}
 }
 
@@ -713,6 +254,16 @@ void LLAudioDecodeMgr::processQueue(const F32 num_secs)
 	mImpl->processQueue(num_secs);
 }
 
+const std::vector<U8> *LLAudioDecodeMgr::getDecodedData(const LLUUID &uuid)
+{
+	return mImpl->mDecodedCache.get(uuid);
+}
+
+bool LLAudioDecodeMgr::hasDecodedData(const LLUUID &uuid) const
+{
+	return mImpl->mDecodedCache.has(uuid);
+}
+
 bool LLAudioDecodeMgr::addDecodeRequest(const LLUUID &uuid)
 {
 	if(!uuid.notNull())
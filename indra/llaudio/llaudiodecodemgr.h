@@ -26,6 +26,8 @@
 #ifndef LL_LLAUDIODECODEMGR_H
 #define LL_LLAUDIODECODEMGR_H
 
+#include <vector>
+
 #include "stdtypes.h"
 
 #include "lllinkedqueue.h"
@@ -35,7 +37,6 @@
 #include "llframetimer.h"
 
 class LLVFS;
-class LLVorbisDecodeState;
 
 class LLAudioDecodeMgr
 {
@@ -43,11 +44,19 @@ public:
 	LLAudioDecodeMgr();
 	~LLAudioDecodeMgr();
 
+	// Hand finished decodes to the audio engine and start new ones on worker threads,
+	// spending at most about num_secs on the latter.
 	void processQueue(const F32 num_secs = 0.005);
 	bool addDecodeRequest(const LLUUID &uuid);
 	void addAudioRequest(const LLUUID &uuid);
+
+	// Returns the WAV file image of a recently decoded sound, or NULL if it isn't kept in memory (anymore).
+	// The pointer is valid until the next call to processQueue().
+	const std::vector<U8> *getDecodedData(const LLUUID &uuid);
+	bool hasDecodedData(const LLUUID &uuid) const;
 	
 protected:
+	friend class LLAudioDecodeJob;
 	class Impl;
 	Impl* mImpl;
 };
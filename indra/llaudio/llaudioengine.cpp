@@ -1752,7 +1752,7 @@ LLAudioData::LLAudioData(const LLUUID &uuid) :
 		return;
 	}
 
-	if(gAudiop->hasDecodedFile(getID()))
+	if((gAudioDecodeMgrp && gAudioDecodeMgrp->hasDecodedData(getID())) || gAudiop->hasDecodedFile(getID()))
 		mLoadState = STATE_LOAD_READY;
 	else if(gAssetStorage && gAssetStorage->hasLocalAsset(getID(), LLAssetType::AT_SOUND))
 		mLoadState = STATE_LOAD_REQ_DECODE;
@@ -1802,6 +1802,14 @@ bool LLAudioData::load()
 		return false;
 	}
 
+	// Recently decoded sounds are still in memory; avoid reading them back from disk.
+	const std::vector<U8>* decoded = gAudioDecodeMgrp ? gAudioDecodeMgrp->getDecodedData(mID) : NULL;
+	if (decoded && mBufferp->loadWAVData(&decoded->front(), (U32)decoded->size()))
+	{
+		mBufferp->mAudioDatap = this;
+		return true;
+	}
+
 	std::string uuid_str;
 	std::string wav_path;
 	mID.toString(uuid_str);
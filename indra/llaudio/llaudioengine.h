@@ -480,6 +480,8 @@ public:
 	LLAudioBuffer() : mInUse(true), mAudioDatap(NULL) { mLastUseTimer.reset(); }
 	virtual ~LLAudioBuffer() {};
 	virtual bool loadWAV(const std::string& filename) = 0;
+	// Load a WAV file image that is already in memory. Returns false if not supported by the implementation.
+	virtual bool loadWAVData(const U8* data, U32 size) { return false; }
 	virtual U32 getLength() = 0;
 
 	friend class LLAudioEngine;
@@ -976,6 +976,35 @@ bool LLAudioBufferFMODEX::loadWAV(const std::string& filename)
 }
 
 
+bool LLAudioBufferFMODEX::loadWAVData(const U8* data, U32 size)
+{
+	if (mSoundp)
+	{
+		gSoundCheck.removeSound(mSoundp);
+		// If there's already something loaded in this buffer, clean it up.
+		Check_FMOD_Error(mSoundp->release(),"FMOD::Sound::release");
+		mSoundp = NULL;
+	}
+
+	FMOD_MODE base_mode = FMOD_LOOP_NORMAL | FMOD_SOFTWARE | FMOD_OPENMEMORY;
+	FMOD_CREATESOUNDEXINFO exinfo;
+	memset(&exinfo,0,sizeof(exinfo));
+	exinfo.cbsize = sizeof(exinfo);
+	exinfo.length = size;
+	exinfo.suggestedsoundtype = FMOD_SOUND_TYPE_WAV;	//Hint to speed up loading.
+	// FMOD_OPENMEMORY copies the data into the sample, so the caller may free it.
+	FMOD_RESULT result = getSystem()->createSound((const char*)data, base_mode, &exinfo, &mSoundp);
+	if (result != FMOD_OK)
+	{
+		LL_WARNS("AudioImpl") << "Could not load decoded data: " << FMOD_ErrorString(result) << LL_ENDL;
+		return false;
+	}
+
+	gSoundCheck.addNewSound(mSoundp);
+
+	return true;
+}
+
 U32 LLAudioBufferFMODEX::getLength()
 {
 	if (!mSoundp)
@@ -124,6 +124,7 @@ public:
 	virtual ~LLAudioBufferFMODSTUDIO();
 
 	/*virtual*/ bool loadWAV(const std::string& filename);
+	/*virtual*/ bool loadWAVData(const U8* data, U32 size);
 	/*virtual*/ U32 getLength();
 	friend class LLAudioChannelFMODSTUDIO;
 protected:
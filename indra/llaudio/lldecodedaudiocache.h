@@ -0,0 +1,115 @@
+/**
+ * @file lldecodedaudiocache.h
+ * @brief A size bounded, least recently used cache of decoded sounds.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLDECODEDAUDIOCACHE_H
+#define LL_LLDECODEDAUDIOCACHE_H
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "stdtypes.h"
+#include "lluuid.h"
+
+//============================================================================
+// LLDecodedAudioCache keeps the WAV images of recently decoded sounds in
+// memory, so that a sound that is played again doesn't have to be decoded
+// or read from disk again. When the total size exceeds the maximum, the
+// least recently used images are dropped.
+//
+// Not thread safe.
+
+class LLDecodedAudioCache
+{
+public:
+	LLDecodedAudioCache(U32 max_size) : mSize(0), mMaxSize(max_size) { }
+
+	// Add the WAV image of uuid, taking the contents of wav. Images larger than the maximum size are not kept.
+	void add(const LLUUID &uuid, std::vector<U8> &wav)
+	{
+		remove(uuid);
+		if (wav.empty() || wav.size() > mMaxSize)
+		{
+			return;
+		}
+		mEntries.push_front(Entry());
+		mEntries.front().mID = uuid;
+		mEntries.front().mData.swap(wav);
+		mIndex[uuid] = mEntries.begin();
+		mSize += (U32)mEntries.front().mData.size();
+		while (mSize > mMaxSize)
+		{
+			LLUUID oldest = mEntries.back().mID;
+			remove(oldest);
+		}
+	}
+
+	// Returns the WAV image of uuid, or NULL if it isn't cached, and makes it the most recently used image.
+	// The pointer stays valid until the image is removed (by add() or remove()).
+	const std::vector<U8> *get(const LLUUID &uuid)
+	{
+		index_t::iterator iter = mIndex.find(uuid);
+		if (iter == mIndex.end())
+		{
+			return NULL;
+		}
+		mEntries.splice(mEntries.begin(), mEntries, iter->second);
+		return &iter->second->mData;
+	}
+
+	bool has(const LLUUID &uuid) const { return mIndex.find(uuid) != mIndex.end(); }
+
+	void remove(const LLUUID &uuid)
+	{
+		index_t::iterator iter = mIndex.find(uuid);
+		if (iter != mIndex.end())
+		{
+			mSize -= (U32)iter->second->mData.size();
+			mEntries.erase(iter->second);
+			mIndex.erase(iter);
+		}
+	}
+
+	// Total size of the cached images, in bytes.
+	U32 getSize(void) const { return mSize; }
+	U32 getCount(void) const { return (U32)mIndex.size(); }
+
+private:
+	struct Entry
+	{
+		LLUUID mID;
+		std::vector<U8> mData;
+	};
+	typedef std::list<Entry> entry_list_t;				// Most recently used first.
+	typedef std::map<LLUUID, entry_list_t::iterator> index_t;
+
+	entry_list_t mEntries;
+	index_t mIndex;
+	U32 mSize;
+	U32 const mMaxSize;
+};
+
+#endif // LL_LLDECODEDAUDIOCACHE_H
@@ -37,6 +37,10 @@
 #include "llerror.h"
 #include "llmath.h"
 #include "llvfile.h"
+#include "llvorbisdecode.h"
+#include "llvorbisencode.h"
+#include "llendianswizzle.h"
+#include <iterator>
 
 #if 0
 
@@ -324,3 +328,247 @@ BOOL decode_vorbis_file(LLVFS *vfs, const LLUUID &in_uuid, char *out_fname)
 	return(TRUE);
 }
 #endif
+
+static const S32 WAV_HEADER_SIZE = 44;
+
+namespace
+{
+	// An Ogg stream in memory, for ov_open_callbacks.
+	struct LLVorbisMemorySource
+	{
+		const U8 *mData;
+		S32 mSize;
+		S32 mPosition;
+	};
+
+	size_t memory_read(void *ptr, size_t size, size_t nmemb, void *datasource)
+	{
+		LLVorbisMemorySource *source = (LLVorbisMemorySource *)datasource;
+		if (size == 0)
+		{
+			return 0;
+		}
+		size_t count = llmin(nmemb, (size_t)(source->mSize - source->mPosition) / size);
+		memcpy(ptr, source->mData + source->mPosition, count * size);	/*Flawfinder: ignore*/
+		source->mPosition += (S32)(count * size);
+		return count;
+	}
+
+	int memory_seek(void *datasource, ogg_int64_t offset, int whence)
+	{
+		LLVorbisMemorySource *source = (LLVorbisMemorySource *)datasource;
+		ogg_int64_t origin;
+		switch (whence)
+		{
+		case SEEK_SET:
+			origin = 0;
+			break;
+		case SEEK_END:
+			origin = source->mSize;
+			break;
+		case SEEK_CUR:
+			origin = source->mPosition;
+			break;
+		default:
+			return -1;
+		}
+		if (origin + offset < 0 || origin + offset > source->mSize)
+		{
+			return -1;
+		}
+		source->mPosition = (S32)(origin + offset);
+		return 0;
+	}
+
+	long memory_tell(void *datasource)
+	{
+		return ((LLVorbisMemorySource *)datasource)->mPosition;
+	}
+}
+
+bool decode_vorbis_to_wav(const LLUUID &uuid, const U8 *ogg_data, S32 ogg_size, bool allow_large_sounds,
+						  std::vector<U8> &wav, bool &corrupt)
+{
+	corrupt = false;
+
+	ov_callbacks memory_callbacks;
+	memory_callbacks.read_func = memory_read;
+	memory_callbacks.seek_func = memory_seek;
+	memory_callbacks.close_func = NULL;			// The caller owns the data.
+	memory_callbacks.tell_func = memory_tell;
+
+	LLVorbisMemorySource source;
+	source.mData = ogg_data;
+	source.mSize = ogg_size;
+	source.mPosition = 0;
+
+	OggVorbis_File vf;
+	int r = ov_open_callbacks(&source, &vf, NULL, 0, memory_callbacks);
+	if (r < 0)
+	{
+		llwarns << r << " Input to vorbis decode does not appear to be an Ogg bitstream: " << uuid << llendl;
+		return false;
+	}
+
+	S32 sample_count = ov_pcm_total(&vf, -1);
+	size_t size_guess = (size_t)sample_count;
+	vorbis_info* vi = ov_info(&vf, -1);
+	size_guess *= (vi? vi->channels : 1);
+	size_guess *= 2;
+	size_guess += 2048;
+
+	bool abort_decode = false;
+	if (vi)
+	{
+		if (vi->channels < 1 || vi->channels > LLVORBIS_CLIP_MAX_CHANNELS)
+		{
+			abort_decode = true;
+			llwarns << "Bad channel count: " << vi->channels << llendl;
+		}
+	}
+	else
+	{
+		abort_decode = true;
+		llwarns << "No default bitstream found" << llendl;
+	}
+	// This magic value is equivalent to 150MiB of data.
+	// Prevents griefers from utilizing a huge xbox sound the size of god to instafry the viewer
+	if (size_guess >= 157286400)
+	{
+		llwarns << "Bad sound caught by zmagic" << llendl;
+		abort_decode = true;
+	}
+	else if (!allow_large_sounds)
+	{
+		//Much more restrictive than zmagic. Perhaps make toggleable.
+		if ((size_t)sample_count > LLVORBIS_CLIP_REJECT_SAMPLES || sample_count <= 0)
+		{
+			abort_decode = true;
+			llwarns << "Illegal sample count: " << sample_count << llendl;
+		}
+		if (size_guess > LLVORBIS_CLIP_REJECT_SIZE)
+		{
+			abort_decode = true;
+			llwarns << "Illegal sample size: " << size_guess << llendl;
+		}
+	}
+	if (abort_decode)
+	{
+		llwarns << "Canceling initDecode. Bad asset: " << uuid << llendl;
+		vorbis_comment* comment = ov_comment(&vf, -1);
+		if (comment && comment->vendor)
+		{
+			llwarns << "Bad asset encoded by: " << comment->vendor << llendl;
+		}
+		ov_clear(&vf);
+		return false;
+	}
+
+	try
+	{
+		wav.clear();
+		wav.reserve(size_guess);
+		wav.resize(WAV_HEADER_SIZE);
+
+		char pcmout[4096];	/*Flawfinder: ignore*/
+		int current_section = 0;
+		long ret;
+		while ((ret = ov_read(&vf, pcmout, sizeof(pcmout), 0, 2, 1, &current_section)) > 0)
+		{
+			/* we don't bother dealing with sample rate changes, etc, but.
+			   you'll have to*/
+			std::copy(pcmout, pcmout + ret, std::back_inserter(wav));
+		}
+		ov_clear(&vf);
+		if (ret < 0)
+		{
+			llwarns << "BAD vorbis decode of " << uuid << llendl;
+			corrupt = true;
+			return false;
+		}
+	}
+	catch (std::bad_alloc&)
+	{
+		llwarns << "bad_alloc whilst decoding " << uuid << llendl;
+		ov_clear(&vf);
+		return false;
+	}
+
+	// Mono, 16 bit PCM at 44.1 kHz; the lengths are filled in below.
+	static const U8 header[WAV_HEADER_SIZE] = {
+		'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+		'f', 'm', 't', ' ', 0x10, 0, 0, 0, 0x01, 0, 0x01, 0,
+		0x44, 0xAC, 0, 0, 0x88, 0x58, 0x01, 0, 0x02, 0, 0x10, 0,
+		'd', 'a', 't', 'a', 0, 0, 0, 0 };
+	memcpy(&wav[0], header, WAV_HEADER_SIZE);	/*Flawfinder: ignore*/
+
+	// write "data" chunk length, in little-endian format
+	S32 data_length = wav.size() - WAV_HEADER_SIZE;
+	wav[40] = (data_length) & 0x000000FF;
+	wav[41] = (data_length >> 8) & 0x000000FF;
+	wav[42] = (data_length >> 16) & 0x000000FF;
+	wav[43] = (data_length >> 24) & 0x000000FF;
+	// write overall "RIFF" length, in little-endian format
+	data_length += 36;
+	wav[4] = (data_length) & 0x000000FF;
+	wav[5] = (data_length >> 8) & 0x000000FF;
+	wav[6] = (data_length >> 16) & 0x000000FF;
+	wav[7] = (data_length >> 24) & 0x000000FF;
+
+	//
+	// FUDGECAKES!!! Vorbis encode/decode messes up loop point transitions (pop)
+	// do a cheap-and-cheesy crossfade 
+	//
+	{
+		S16 *samplep;
+		S32 i;
+		S32 fade_length;
+		char pcmout[4096];		/*Flawfinder: ignore*/ 	
+
+		fade_length = llmin((S32)128,(S32)(data_length-36)/8);			
+		if((S32)wav.size() > (WAV_HEADER_SIZE + 2* fade_length))
+		{
+			memcpy(pcmout, &wav[WAV_HEADER_SIZE], (2 * fade_length));	/*Flawfinder: ignore*/
+		}
+		llendianswizzle(&pcmout, 2, fade_length);
+
+		samplep = (S16 *)pcmout;
+		for (i = 0 ;i < fade_length; i++)
+		{
+			*samplep = llfloor((F32)*samplep * ((F32)i/(F32)fade_length));
+			samplep++;
+		}
+
+		llendianswizzle(&pcmout, 2, fade_length);			
+		if((WAV_HEADER_SIZE+(2 * fade_length)) < (S32)wav.size())
+		{
+			memcpy(&wav[WAV_HEADER_SIZE], pcmout, (2 * fade_length));	/*Flawfinder: ignore*/
+		}
+		S32 near_end = wav.size() - (2 * fade_length);
+		if ((S32)wav.size() > ( near_end + 2* fade_length))
+		{
+			memcpy(pcmout, &wav[near_end], (2 * fade_length));	/*Flawfinder: ignore*/
+		}
+		llendianswizzle(&pcmout, 2, fade_length);
+
+		samplep = (S16 *)pcmout;
+		for (i = fade_length-1 ; i >=  0; i--)
+		{
+			*samplep = llfloor((F32)*samplep * ((F32)i/(F32)fade_length));
+			samplep++;
+		}
+
+		llendianswizzle(&pcmout, 2, fade_length);			
+		if (near_end + (2 * fade_length) < (S32)wav.size())
+		{
+			memcpy(&wav[near_end], pcmout, (2 * fade_length));/*Flawfinder: ignore*/
+		}
+	}
+
+	if (36 == data_length)
+	{
+		llwarns << "BAD Vorbis decode of " << uuid << ", no samples" << llendl;
+		return false;
+	}
+	return true;
+}
@@ -33,10 +33,19 @@
 #ifndef LL_VORBISDECODE_H
 #define LL_VORBISDECODE_H
 
+#include <vector>
+
 class LLVFS;
 class LLUUID;
 
 BOOL decode_vorbis_file(LLVFS *vfs, const LLUUID &in_uuid, char *out_fname);
 
+// Decode the Ogg Vorbis sound asset uuid, ogg_size bytes at ogg_data, into the WAV file image wav,
+// fading the first and last samples in and out to hide the pop at the loop point.
+// Returns false, after logging why, if the asset is not a valid sound; corrupt is then set if the
+// Ogg stream is broken halfway, rather than refused up front. Thread safe.
+bool decode_vorbis_to_wav(const LLUUID &uuid, const U8 *ogg_data, S32 ogg_size, bool allow_large_sounds,
+						  std::vector<U8> &wav, bool &corrupt);
+
 #endif
 
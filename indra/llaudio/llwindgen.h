@@ -33,8 +33,18 @@
 #define WINDGEN_H
 
 #include "llcommon.h"
-#include "llrand.h"
+#include "llmath.h"
+#include "llmemory.h"
 
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+// Wind noise: pink noise through a resonant low-pass filter, panned between the left and right channel.
+//
+// This runs in the audio callback, so whole buffers are generated a block at a time: the white noise
+// comes from four xorshift generators in parallel, the (recursive) filters run per sample, and the gain,
+// panning, interpolation to the output rate and conversion to the output format are done four samples
+// at a time with SSE2. What is left of a buffer after the last whole group of four is done per sample.
 template <class MIXBUFFERFORMAT_T>
 class LLWindGen
 {
@@ -44,7 +54,6 @@ public:
 		mTargetFreq(100.f),
 		mTargetPanGainR(0.5f),
 		mInputSamplingRate(sample_rate),
-		mSubSamples(2),
 		mFilterBandWidth(50.f),
 		mBuf0(0.0f),
 		mBuf1(0.0f),
@@ -56,8 +65,13 @@ public:
 		mCurrentPanGainR(0.5f),
 		mLastSample(0.f)
 	{
-		mSamplePeriod = (F32)mSubSamples / (F32)mInputSamplingRate;
+		mSamplePeriod = (F32)SUB_SAMPLES / (F32)mInputSamplingRate;
 		mB2 = expf(-F_TWO_PI * mFilterBandWidth * mSamplePeriod);
+		// Any non-zero seeds will do.
+		mSeed[0] = 0x6b8b4567;
+		mSeed[1] = 0x327b23c6;
+		mSeed[2] = 0x643c9869;
+		mSeed[3] = 0x66334873;
 	}
 
 	const U32 getInputSamplingRate() { return mInputSamplingRate; }
@@ -82,44 +96,33 @@ public:
 		//if the frequency isn't changing much, we don't need to interpolate in the inner loop
 		if (llabs(mTargetFreq - mCurrentFreq) < (mCurrentFreq * 0.112))
 		{
-			// calculate resonant filter coefficients
 			mCurrentFreq = mTargetFreq;
-			b1 = (-4.0f * mB2) / (1.0f + mB2) * cosf(F_TWO_PI * (mCurrentFreq * mSamplePeriod));
-			a0 = (1.0f - mB2) * sqrtf(1.0f - (b1 * b1) / (4.0f * mB2));
+			calculateCoefficients(a0, b1);
 		}
 		else
 		{
 			interp_freq = true;
 		}
+
+		// Whole groups of four synthesized samples, that is eight output frames.
+		while (numsamples >= 4 * SUB_SAMPLES)
+		{
+			int count = llmin(numsamples / (4 * SUB_SAMPLES) * 4, (int)BLOCK_SIZE);
+			generateBlock(cursamplep, count, interp_freq, a0, b1);
+			cursamplep += count * SUB_SAMPLES * 2;
+			numsamples -= count * SUB_SAMPLES;
+		}
 		
+		// The rest, one sample at a time.
 		while (numsamples)
 		{
-			F32 next_sample;
-			
-			// Start with white noise
-			// This expression is fragile, rearrange it and it will break!
-			next_sample = getNextSample();
-			
-			// Apply a pinking filter
-			// Magic numbers taken from PKE method at http://www.firstpr.com.au/dsp/pink-noise/
-			mBuf0 = mBuf0 * 0.99765f + next_sample * 0.0990460f;
-			mBuf1 = mBuf1 * 0.96300f + next_sample * 0.2965164f;
-			mBuf2 = mBuf2 * 0.57000f + next_sample * 1.0526913f;
-			
-			next_sample = mBuf0 + mBuf1 + mBuf2 + next_sample * 0.1848f;
-			
 			if (interp_freq)
 			{
 				// calculate and interpolate resonant filter coefficients
 				mCurrentFreq = (0.999f * mCurrentFreq) + (0.001f * mTargetFreq);
-				b1 = (-4.0f * mB2) / (1.0f + mB2) * cosf(F_TWO_PI * (mCurrentFreq * mSamplePeriod));
-				a0 = (1.0f - mB2) * sqrtf(1.0f - (b1 * b1) / (4.0f * mB2));
+				calculateCoefficients(a0, b1);
 			}
-			
-			// Apply a resonant low-pass filter on the pink noise
-	        next_sample = a0 * next_sample - b1 * mY0 - mB2 * mY1;
-			mY1 = mY0;
-			mY0 = next_sample;
+			F32 next_sample = filterSample(getNextSample(), a0, b1);
 			
 			mCurrentGain = (0.999f * mCurrentGain) + (0.001f * mTargetGain);
 			mCurrentPanGainR = (0.999f * mCurrentPanGainR) + (0.001f * mTargetPanGainR);
@@ -129,10 +132,10 @@ public:
 		    next_sample *= mCurrentGain;
 			
 			// delta is used to interpolate between synthesized samples
-			F32 delta = (next_sample - mLastSample) / (F32)mSubSamples;
+			F32 delta = (next_sample - mLastSample) / (F32)SUB_SAMPLES;
 			
 			// Fill the audio buffer, clipping if necessary
-			for (U8 i=mSubSamples; i && numsamples; --i, --numsamples) 
+			for (U8 i=SUB_SAMPLES; i && numsamples; --i, --numsamples) 
 			{
 				mLastSample = mLastSample + delta;
 				MIXBUFFERFORMAT_T	sample_right = (MIXBUFFERFORMAT_T)getClampedSample(clip, mLastSample * mCurrentPanGainR);
@@ -154,8 +157,103 @@ public:
 	F32 mTargetPanGainR;
 	
 private:
+	enum {
+		SUB_SAMPLES = 2,			// Output frames per synthesized sample; the vector code depends on this being 2.
+		BLOCK_SIZE = 64				// Synthesized samples per block; a multiple of four.
+	};
+
+	// The amplitude of the white noise.
+	static F32 getNoiseScale();
+
+	// Write four stereo frames: mono panned with pan_right.
+	static void storeFrames(MIXBUFFERFORMAT_T *out, __m128 mono, __m128 pan_right);
+
+	void calculateCoefficients(F32& a0, F32& b1)
+	{
+		// calculate resonant filter coefficients
+		b1 = (-4.0f * mB2) / (1.0f + mB2) * cosf(F_TWO_PI * (mCurrentFreq * mSamplePeriod));
+		a0 = (1.0f - mB2) * sqrtf(1.0f - (b1 * b1) / (4.0f * mB2));
+	}
+
+	F32 filterSample(F32 next_sample, F32 a0, F32 b1)
+	{
+		// Apply a pinking filter
+		// Magic numbers taken from PKE method at http://www.firstpr.com.au/dsp/pink-noise/
+		mBuf0 = mBuf0 * 0.99765f + next_sample * 0.0990460f;
+		mBuf1 = mBuf1 * 0.96300f + next_sample * 0.2965164f;
+		mBuf2 = mBuf2 * 0.57000f + next_sample * 1.0526913f;
+		
+		next_sample = mBuf0 + mBuf1 + mBuf2 + next_sample * 0.1848f;
+
+		// Apply a resonant low-pass filter on the pink noise
+		next_sample = a0 * next_sample - b1 * mY0 - mB2 * mY1;
+		mY1 = mY0;
+		mY0 = next_sample;
+		return next_sample;
+	}
+
+	// Generate count synthesized samples, a multiple of four and at most BLOCK_SIZE, into count * SUB_SAMPLES frames at out.
+	void generateBlock(MIXBUFFERFORMAT_T *out, int count, bool interp_freq, F32& a0, F32& b1)
+	{
+		// White noise, four samples at a time, through the filters.
+		LL_ALIGN_16(F32 filtered[BLOCK_SIZE]);
+		LL_ALIGN_16(F32 noise[4]);
+		__m128i seed = _mm_loadu_si128((__m128i const*)mSeed);
+		__m128 const noise_scale = _mm_set1_ps(getNoiseScale() / 2147483648.f);
+		for (int i = 0; i < count; i += 4)
+		{
+			seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 13));
+			seed = _mm_xor_si128(seed, _mm_srli_epi32(seed, 17));
+			seed = _mm_xor_si128(seed, _mm_slli_epi32(seed, 5));
+			_mm_store_ps(noise, _mm_mul_ps(_mm_cvtepi32_ps(seed), noise_scale));
+			if (interp_freq)
+			{
+				// Move the frequency four samples at once; calculating the coefficients is the expensive part.
+				mCurrentFreq = mTargetFreq + (mCurrentFreq - mTargetFreq) * 0.996006f;	// 0.999^4
+				calculateCoefficients(a0, b1);
+			}
+			filtered[i] = filterSample(noise[0], a0, b1);
+			filtered[i + 1] = filterSample(noise[1], a0, b1);
+			filtered[i + 2] = filterSample(noise[2], a0, b1);
+			filtered[i + 3] = filterSample(noise[3], a0, b1);
+		}
+		_mm_storeu_si128((__m128i*)mSeed, seed);
+
+		// The gain and panning move 0.1% towards their target per sample, so sample n of a group
+		// of four (counting from 1) is at target + (current - target) * 0.999^n.
+		__m128 const decay = _mm_set_ps(0.996006f, 0.997003f, 0.998001f, 0.999f);
+		__m128 const decay4 = _mm_set1_ps(0.996006f);
+		__m128 const gain_target = _mm_set1_ps(mTargetGain);
+		__m128 const pan_target = _mm_set1_ps(mTargetPanGainR);
+		__m128 gain_offset = _mm_mul_ps(_mm_set1_ps(mCurrentGain - mTargetGain), decay);
+		__m128 pan_offset = _mm_mul_ps(_mm_set1_ps(mCurrentPanGainR - mTargetPanGainR), decay);
+		__m128 const half = _mm_set1_ps(0.5f);
+		__m128 last = _mm_set1_ps(mLastSample);
+		__m128 gain = gain_target;
+		__m128 pan = pan_target;
+		for (int i = 0; i < count; i += 4)
+		{
+			gain = _mm_add_ps(gain_target, gain_offset);
+			pan = _mm_add_ps(pan_target, pan_offset);
+			__m128 sample = _mm_mul_ps(_mm_load_ps(filtered + i), gain);
+			// previous = { last[3], sample[0], sample[1], sample[2] }
+			__m128 previous = _mm_shuffle_ps(last, sample, _MM_SHUFFLE(0, 0, 3, 3));
+			previous = _mm_shuffle_ps(previous, sample, _MM_SHUFFLE(2, 1, 2, 0));
+			// Each synthesized sample gives two frames: halfway from the previous one, and the sample itself.
+			__m128 halfway = _mm_mul_ps(_mm_add_ps(previous, sample), half);
+			storeFrames(out, _mm_unpacklo_ps(halfway, sample), _mm_unpacklo_ps(pan, pan));
+			storeFrames(out + 8, _mm_unpackhi_ps(halfway, sample), _mm_unpackhi_ps(pan, pan));
+			out += 16;
+			last = sample;
+			gain_offset = _mm_mul_ps(gain_offset, decay4);
+			pan_offset = _mm_mul_ps(pan_offset, decay4);
+		}
+		mLastSample = _mm_cvtss_f32(_mm_shuffle_ps(last, last, _MM_SHUFFLE(3, 3, 3, 3)));
+		mCurrentGain = _mm_cvtss_f32(_mm_shuffle_ps(gain, gain, _MM_SHUFFLE(3, 3, 3, 3)));
+		mCurrentPanGainR = _mm_cvtss_f32(_mm_shuffle_ps(pan, pan, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+
 	U32 mInputSamplingRate;
-	U8  mSubSamples;
 	F32 mSamplePeriod;
 	F32 mFilterBandWidth;
 	F32 mB2;
@@ -170,11 +268,54 @@ private:
 	F32 mCurrentFreq;
 	F32 mCurrentPanGainR;
 	F32 mLastSample;
+
+	U32 mSeed[4];					// State of the xorshift generators; getNextSample() only uses the first.
 };
 
-template<class T> inline const F32 LLWindGen<T>::getNextSample() { return (F32)rand() * (1.0f / (F32)(RAND_MAX / (U16_MAX / 8))) + (F32)(S16_MIN / 8); }
-template<> inline const F32 LLWindGen<F32>::getNextSample() { return ll_frand()-.5f; }
+template<class T> inline F32 LLWindGen<T>::getNoiseScale() { return (F32)(U16_MAX / 16); }
+template<> inline F32 LLWindGen<F32>::getNoiseScale() { return 0.5f; }
+template<class T> inline const F32 LLWindGen<T>::getNextSample()
+{
+	U32 x = mSeed[0];
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	mSeed[0] = x;
+	return (F32)(S32)x * (getNoiseScale() / 2147483648.f);
+}
 template<class T> inline const F32 LLWindGen<T>::getClampedSample(bool clamp, F32 sample) { return clamp ? (F32)llclamp((S32)sample,(S32)S16_MIN,(S32)S16_MAX) : sample; }
 template<> inline const F32 LLWindGen<F32>::getClampedSample(bool clamp, F32 sample) { return sample; }
 
+template<class T> inline void LLWindGen<T>::storeFrames(T *out, __m128 mono, __m128 pan_right)
+{
+	LL_ALIGN_16(F32 samples[4]);
+	LL_ALIGN_16(F32 pan[4]);
+	_mm_store_ps(samples, mono);
+	_mm_store_ps(pan, pan_right);
+	for (int i = 0; i < 4; ++i)
+	{
+		T right = (T)llclamp(samples[i] * pan[i], (F32)S16_MIN, (F32)S16_MAX);
+		*out++ = (T)llclamp(samples[i] - (F32)right, (F32)S16_MIN, (F32)S16_MAX);
+		*out++ = right;
+	}
+}
+
+template<> inline void LLWindGen<F32>::storeFrames(F32 *out, __m128 mono, __m128 pan_right)
+{
+	__m128 right = _mm_mul_ps(mono, pan_right);
+	__m128 left = _mm_sub_ps(mono, right);
+	_mm_storeu_ps(out, _mm_unpacklo_ps(left, right));
+	_mm_storeu_ps(out + 4, _mm_unpackhi_ps(left, right));
+}
+
+template<> inline void LLWindGen<S16>::storeFrames(S16 *out, __m128 mono, __m128 pan_right)
+{
+	// Always clamp; it's free here.
+	__m128 const min_sample = _mm_set1_ps((F32)S16_MIN);
+	__m128 const max_sample = _mm_set1_ps((F32)S16_MAX);
+	__m128i right = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(mono, pan_right), min_sample), max_sample));
+	__m128i left = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_sub_ps(mono, _mm_cvtepi32_ps(right)), min_sample), max_sample));
+	_mm_storeu_si128((__m128i*)out, _mm_packs_epi32(_mm_unpacklo_epi32(left, right), _mm_unpackhi_epi32(left, right)));
+}
+
 #endif
@@ -219,6 +219,47 @@ void LLCharacter::updateMotions(e_update_t update_type)
 }
 
 
+namespace
+{
+	// Prepares the motions of one character on a worker thread.
+	class LLPrepareMotionsJob : public LLThreadPool::Job
+	{
+	public:
+		LLPrepareMotionsJob(LLMotionController& controller) : mController(controller) { }
+		/*virtual*/ void run(void) { mController.prepareMotions(); }
+
+	private:
+		LLMotionController& mController;
+	};
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+//static
+void LLCharacter::prepareMotions(std::vector<LLCharacter*> const& characters, LLThreadPool* pool)
+{
+	if (characters.empty())
+	{
+		return;
+	}
+
+	LLThreadPool::Group group;
+	// The first character is done by this thread, while the workers do the rest.
+	std::vector<LLCharacter*>::const_iterator iter = characters.begin();
+	LLCharacter* first = *iter;
+	for (++iter; iter != characters.end(); ++iter)
+	{
+		LLPointer<LLThreadPool::Job> job = new LLPrepareMotionsJob((*iter)->mMotionController);
+		if (!pool || !pool->post(job, &group))
+		{
+			job->run();
+		}
+	}
+	first->mMotionController.prepareMotions();
+	group.wait();
+}
+
 //-----------------------------------------------------------------------------
 // deactivateAllMotions()
 //-----------------------------------------------------------------------------
@@ -38,6 +38,7 @@
 #include "string_table.h"
 #include "llpointer.h"
 #include "llthread.h"
+#include "llthreadpool.h"
 #include "llsortedvector.h"
 #include <boost/unordered_map.hpp>
 
@@ -158,6 +159,12 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// Let the motions of all characters do the per-motion part of this frame's
+	// updateMotions() in parallel: one job per character is posted to pool (or
+	// everything is done here when pool is NULL), and this returns when all are
+	// done. Call it from the main thread, before the updateMotions() calls.
+	static void prepareMotions(std::vector<LLCharacter*> const& characters, LLThreadPool* pool);
+
 	LLAnimPauseRequest requestPause();
 	void requestPause(std::vector<LLAnimPauseRequest>& avatar_pause_handles);
 	void pauseAllSyncedCharacters(std::vector<LLAnimPauseRequest>& avatar_pause_handles);
@@ -49,6 +49,12 @@
 LLVFS*				LLKeyframeMotion::sVFS = NULL;
 LLKeyframeDataCache::keyframe_data_map_t	LLKeyframeDataCache::sKeyframeDataMap;
 
+// The mutex that protects sKeyframeDataMap.
+static LLMutex* keyframe_data_mutex()
+{
+	return &AICachedPointer<LLUUID, LLKeyframeMotion::JointMotionList>::sMutex;
+}
+
 //-----------------------------------------------------------------------------
 // Globals
 //-----------------------------------------------------------------------------
@@ -144,6 +150,114 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo(bool silent) const
 //-----------------------------------------------------------------------------
 
 
+namespace
+{
+	// Returns the index of the first key at or after time, or the number of keys
+	// if there is none; the same as std::lower_bound. cursor is where to start
+	// looking, and is set to the result.
+	U32 find_key(const std::vector<F32>& times, F32 time, U32& cursor)
+	{
+		U32 const num_keys = times.size();
+		U32 right = llmin(cursor, num_keys);
+		if (right > 0 && !(times[right - 1] < time))
+		{
+			// Went back in time (looped or restarted): search the keys before the cursor.
+			right = std::lower_bound(times.begin(), times.begin() + right, time) - times.begin();
+		}
+		else
+		{
+			// Normally time moved forward less than a few keys.
+			U32 const near_end = llmin(right + 4, num_keys);
+			while (right < near_end && times[right] < time)
+			{
+				++right;
+			}
+			if (right == near_end && right < num_keys && times[right] < time)
+			{
+				right = std::lower_bound(times.begin() + right, times.end(), time) - times.begin();
+			}
+		}
+		cursor = right;
+		return right;
+	}
+
+	template<typename T>
+	void add_key(std::vector<F32>& times, std::vector<T>& values, F32 time, const T& value)
+	{
+		// Keys are nearly always added in order.
+		if (times.empty() || times.back() < time)
+		{
+			times.push_back(time);
+			values.push_back(value);
+			return;
+		}
+		std::vector<F32>::iterator iter = std::lower_bound(times.begin(), times.end(), time);
+		size_t index = iter - times.begin();
+		if (*iter == time)
+		{
+			values[index] = value;
+		}
+		else
+		{
+			times.insert(iter, time);
+			values.insert(values.begin() + index, value);
+		}
+	}
+
+	// Returns the u at which to interpolate between key right - 1 and key right,
+	// or -1 if the value is that of key index exactly.
+	F32 get_interpolant(const std::vector<F32>& times, F32 time, U32 right, U32& index)
+	{
+		if (right == times.size())
+		{
+			// Past last key
+			index = right - 1;
+			return -1.f;
+		}
+		if (right == 0 || times[right] == time)
+		{
+			// Before first key or exactly on a key
+			index = right;
+			return -1.f;
+		}
+		// Between two keys
+		index = right - 1;
+		return (time - times[right - 1]) / (times[right] - times[right - 1]);
+	}
+
+	// The same as lerp(before, after, u), four components at a time.
+	LLVector3 lerp_key(const LLVector3& before, const LLVector3& after, F32 u)
+	{
+		LLVector4a a;
+		LLVector4a b;
+		a.load3(before.mV);
+		b.load3(after.mV);
+		LLVector4a value;
+		value.setLerp(a, b, u);
+		LL_ALIGN_16(F32 v[4]);
+		value.store4a(v);
+		return LLVector3(v);
+	}
+
+	// The same as nlerp(u, before, after).
+	LLQuaternion nlerp_key(F32 u, const LLQuaternion& before, const LLQuaternion& after)
+	{
+		LLQuaternion2 a(before);
+		LLQuaternion2 b(after);
+		if (a.getVector4a().dot4(b.getVector4a()).getF32() < 0.f)
+		{
+			// Rare for consecutive keys; nlerp takes the slow path for this too.
+			return slerp(u, before, after);
+		}
+		LLQuaternion2 value;
+		value.getVector4aRw().setLerp(a.getVector4a(), b.getVector4a(), u);
+		value.normalize();
+		LLQuaternion result;
+		_mm_storeu_ps(result.mQ, value.getVector4a());
+		return result;
+	}
+}
+
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
@@ -158,70 +272,40 @@ LLKeyframeMotion::ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::ScaleCurve::~ScaleCurve() 
 {
-	mKeys.clear();
 	mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
-// getValue()
+// ScaleCurve::addKey()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+void LLKeyframeMotion::ScaleCurve::addKey(const ScaleKey& key)
 {
-	LLVector3 value;
-
-	if (mKeys.empty())
-	{
-		value.clearVec();
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mScale;
-	}
-	else if (right == mKeys.begin() || right->first == time)
-	{
-		// Before first key or exactly on a key
-		value = right->second.mScale;
-	}
-	else
-	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
-		{
-			scale_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, scale_before, scale_after);
-	}
-	return value;
+	add_key(mTimes, mScales, key.mTime, key.mScale);
 }
 
 //-----------------------------------------------------------------------------
-// interp()
+// ScaleCurve::getValue()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration) const
 {
-	switch (mInterpolationType)
+	U32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
+
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration, U32& cursor) const
+{
+	if (mTimes.empty())
 	{
-	case IT_STEP:
-		return before.mScale;
+		return LLVector3::zero;
+	}
 
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return lerp(before.mScale, after.mScale, u);
+	U32 index;
+	F32 u = get_interpolant(mTimes, time, find_key(mTimes, time, cursor), index);
+	if (u < 0.f || mInterpolationType == IT_STEP)
+	{
+		return mScales[index];
 	}
+	return lerp_key(mScales[index], mScales[index + 1], u);
 }
 
 //-----------------------------------------------------------------------------
@@ -238,73 +322,42 @@ LLKeyframeMotion::RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::RotationCurve::~RotationCurve()
 {
-	mKeys.clear();
 	mNumKeys = 0;
 }
 
 //-----------------------------------------------------------------------------
-// RotationCurve::getValue()
+// RotationCurve::addKey()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
+void LLKeyframeMotion::RotationCurve::addKey(const RotationKey& key)
 {
-	LLQuaternion value;
-
-	if (mKeys.empty())
-	{
-		value = LLQuaternion::DEFAULT;
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
-	{
-		// Past last key
-		--right;
-		value = right->second.mRotation;
-	}
-	else if (right == mKeys.begin() || right->first == time)
-	{
-		// Before first key or exactly on a key
-		value = right->second.mRotation;
-	}
-	else
-	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
-		{
-			rot_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, rot_before, rot_after);
-	}
-	return value;
+	add_key(mTimes, mRotations, key.mTime, key.mRotation);
 }
 
 //-----------------------------------------------------------------------------
-// interp()
+// RotationCurve::getValue()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration) const
+{
+	U32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
+
+LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration, U32& cursor) const
 {
-	switch (mInterpolationType)
+	if (mTimes.empty())
 	{
-	case IT_STEP:
-		return before.mRotation;
+		return LLQuaternion::DEFAULT;
+	}
 
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return nlerp(u, before.mRotation, after.mRotation);
+	U32 index;
+	F32 u = get_interpolant(mTimes, time, find_key(mTimes, time, cursor), index);
+	if (u < 0.f || mInterpolationType == IT_STEP)
+	{
+		return mRotations[index];
 	}
+	return nlerp_key(u, mRotations[index], mRotations[index + 1]);
 }
 
-
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
@@ -319,51 +372,43 @@ LLKeyframeMotion::PositionCurve::PositionCurve()
 //-----------------------------------------------------------------------------
 LLKeyframeMotion::PositionCurve::~PositionCurve()
 {
-	mKeys.clear();
 	mNumKeys = 0;
 }
 
+//-----------------------------------------------------------------------------
+// PositionCurve::addKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::addKey(const PositionKey& key)
+{
+	add_key(mTimes, mPositions, key.mTime, key.mPosition);
+}
+
 //-----------------------------------------------------------------------------
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration) const
 {
-	LLVector3 value;
+	U32 cursor = 0;
+	return getValue(time, duration, cursor);
+}
 
-	if (mKeys.empty())
-	{
-		value.clearVec();
-		return value;
-	}
-	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration, U32& cursor) const
+{
+	if (mTimes.empty())
 	{
-		// Past last key
-		--right;
-		value = right->second.mPosition;
+		return LLVector3::zero;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+
+	U32 index;
+	F32 u = get_interpolant(mTimes, time, find_key(mTimes, time, cursor), index);
+	LLVector3 value;
+	if (u < 0.f || mInterpolationType == IT_STEP)
 	{
-		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		value = mPositions[index];
 	}
 	else
 	{
-		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, pos_before, pos_after);
+		value = lerp_key(mPositions[index], mPositions[index + 1], u);
 	}
 
 	llassert(value.isFinite());
@@ -371,22 +416,6 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 	return value;
 }
 
-//-----------------------------------------------------------------------------
-// interp()
-//-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
-{
-	switch (mInterpolationType)
-	{
-	case IT_STEP:
-		return before.mPosition;
-	default:
-	case IT_LINEAR:
-	case IT_SPLINE:
-		return lerp(before.mPosition, after.mPosition, u);
-	}
-}
-
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -397,7 +426,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration, CurveCursors& cursors) const
 {
 	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
 	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -413,7 +442,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
 	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+		joint_state->setScale( mScaleCurve.getValue( time, duration, cursors.mScale ) );
 	}
 
 	//-------------------------------------------------------------------------
@@ -421,7 +450,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		joint_state->setRotation( mRotationCurve.getValue( time, duration, cursors.mRotation ) );
 	}
 
 	//-------------------------------------------------------------------------
@@ -429,7 +458,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		joint_state->setPosition( mPositionCurve.getValue( time, duration, cursors.mPosition ) );
 	}
 }
 
@@ -450,6 +479,8 @@ LLKeyframeMotion::LLKeyframeMotion(const LLUUID &id, LLMotionController* control
 		mLastSkeletonSerialNum(0),
 		mLastUpdateTime(0.f),
 		mLastLoopedTime(0.f),
+		mPreparedTime(0.f),
+		mPrepared(false),
 		mAssetStatus(ASSET_UNDEFINED)
 {
 
@@ -702,39 +733,11 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 {
 	llassert(time >= 0.f);
 
-	if (mJointMotionList->mLoop)
+	if (mJointMotionList->mLoop && mJointMotionList->mDuration == 0.0f)
 	{
-		if (mJointMotionList->mDuration == 0.0f)
-		{
-			time = 0.f;
-			mLastLoopedTime = 0.0f;
-		}
-		else if (mStopped)
-		{
-			mLastLoopedTime = llmin(mJointMotionList->mDuration, mLastLoopedTime + time - mLastUpdateTime);
-		}
-		else if (time > mJointMotionList->mLoopOutPoint)
-		{
-			if ((mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint) == 0.f)
-			{
-				mLastLoopedTime = mJointMotionList->mLoopOutPoint;
-			}
-			else
-			{
-				mLastLoopedTime = mJointMotionList->mLoopInPoint + 
-					fmod(time - mJointMotionList->mLoopOutPoint, 
-					mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint);
-			}
-		}
-		else
-		{
-			mLastLoopedTime = time;
-		}
-	}
-	else
-	{
-		mLastLoopedTime = time;
+		time = 0.f;
 	}
+	mLastLoopedTime = getLoopedTime(time);
 
 	applyKeyframes(mLastLoopedTime);
 
@@ -746,17 +749,80 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 }
 
 //-----------------------------------------------------------------------------
-// applyKeyframes()
+// onPrepareUpdate()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::applyKeyframes(F32 time)
+void LLKeyframeMotion::onPrepareUpdate(F32 time)
+{
+	if (!mJointMotionList || time < 0.f)
+	{
+		return;
+	}
+	mPreparedTime = getLoopedTime(time);
+	updateJointStates(mPreparedTime);
+	mPrepared = true;
+}
+
+//-----------------------------------------------------------------------------
+// getLoopedTime()
+//-----------------------------------------------------------------------------
+F32 LLKeyframeMotion::getLoopedTime(F32 time) const
+{
+	if (!mJointMotionList->mLoop)
+	{
+		return time;
+	}
+	if (mJointMotionList->mDuration == 0.0f)
+	{
+		return 0.f;
+	}
+	if (mStopped)
+	{
+		return llmin(mJointMotionList->mDuration, mLastLoopedTime + time - mLastUpdateTime);
+	}
+	if (time > mJointMotionList->mLoopOutPoint)
+	{
+		if ((mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint) == 0.f)
+		{
+			return mJointMotionList->mLoopOutPoint;
+		}
+		return mJointMotionList->mLoopInPoint + 
+			fmod(time - mJointMotionList->mLoopOutPoint, 
+			mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint);
+	}
+	return time;
+}
+
+//-----------------------------------------------------------------------------
+// updateJointStates()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::updateJointStates(F32 time)
 {
-	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+	U32 const num_joint_motions = mJointMotionList->getNumJointMotions();
+	llassert_always (num_joint_motions <= mJointStates.size());
+	if (mCurveCursors.size() != num_joint_motions)
+	{
+		mCurveCursors.resize(num_joint_motions);
+	}
+	for (U32 i=0; i<num_joint_motions; i++)
 	{
 		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
 													  time, 
-													  mJointMotionList->mDuration );
+													  mJointMotionList->mDuration,
+													  mCurveCursors[i] );
 	}
+}
+
+//-----------------------------------------------------------------------------
+// applyKeyframes()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::applyKeyframes(F32 time)
+{
+	// Skip the curves if onPrepareUpdate already evaluated them for this time.
+	if (!mPrepared || mPreparedTime != time)
+	{
+		updateJointStates(time);
+	}
+	mPrepared = false;
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
 	if (pose_priority)
@@ -1671,7 +1737,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 
-			rCurve->mKeys[time] = rot_key;
+			rCurve->addKey(rot_key);
 		}
 
 		//---------------------------------------------------------------------
@@ -1750,7 +1816,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
+			pCurve->addKey(pos_key);
 
 			if (is_pelvis)
 			{
@@ -2023,14 +2089,13 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
 		success &= dp.packS32(joint_motionp->mRotationCurve.mNumKeys, "num_rot_keys");
 
-		for (RotationCurve::key_map_t::iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
-			 iter != joint_motionp->mRotationCurve.mKeys.end(); ++iter)
+		RotationCurve& rot_curve = joint_motionp->mRotationCurve;
+		for (U32 k = 0; k < rot_curve.mTimes.size(); ++k)
 		{
-			RotationKey& rot_key = iter->second;
-			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
+			U16 time_short = F32_to_U16(rot_curve.mTimes[k], 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
-			LLVector3 rot_angles = rot_key.mRotation.packToVector3();
+			LLVector3 rot_angles = rot_curve.mRotations[k].packToVector3();
 			
 			U16 x, y, z;
 			rot_angles.quantize16(-1.f, 1.f, -1.f, 1.f);
@@ -2043,18 +2108,18 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		}
 
 		success &= dp.packS32(joint_motionp->mPositionCurve.mNumKeys, "num_pos_keys");
-		for (PositionCurve::key_map_t::iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
-			 iter != joint_motionp->mPositionCurve.mKeys.end(); ++iter)
+		PositionCurve& pos_curve = joint_motionp->mPositionCurve;
+		for (U32 k = 0; k < pos_curve.mTimes.size(); ++k)
 		{
-			PositionKey& pos_key = iter->second;
-			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
+			U16 time_short = F32_to_U16(pos_curve.mTimes[k], 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
+			LLVector3& position = pos_curve.mPositions[k];
 			U16 x, y, z;
-			pos_key.mPosition.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			x = F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			y = F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
-			z = F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			position.quantize16(-LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET, -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			x = F32_to_U16(position.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			y = F32_to_U16(position.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
+			z = F32_to_U16(position.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET);
 			success &= dp.packU16(x, "pos_x");
 			success &= dp.packU16(y, "pos_y");
 			success &= dp.packU16(z, "pos_z");
@@ -2337,6 +2402,8 @@ void LLKeyframeMotion::onLoadComplete(LLVFS *vfs,
 // </singu>
 void LLKeyframeDataCache::dumpDiagInfo(int quiet)
 {
+	LLMutexLock lock(keyframe_data_mutex());
+
 	// keep track of totals
 	U32 total_size = 0;
 
@@ -2389,6 +2456,7 @@ void LLKeyframeDataCache::dumpDiagInfo(int quiet)
 //<singu> This function replaces LLKeyframeDataCache::addKeyframeData and was rewritten to fix a memory leak (aka, the usage of AICachedPointer).
 LLKeyframeMotion::JointMotionListPtr LLKeyframeDataCache::createKeyframeData(LLUUID const& id)
 {
+	LLMutexLock lock(keyframe_data_mutex());
 	std::pair<keyframe_data_map_t::iterator, bool> result =
 		sKeyframeDataMap.insert(AICachedPointer<LLUUID, LLKeyframeMotion::JointMotionList>(id, new LLKeyframeMotion::JointMotionList, &sKeyframeDataMap));
 	llassert(result.second);	// id may not already exist in the cache.
@@ -2401,6 +2469,7 @@ LLKeyframeMotion::JointMotionListPtr LLKeyframeDataCache::createKeyframeData(LLU
 //--------------------------------------------------------------------
 void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 {
+	LLMutexLock lock(keyframe_data_mutex());
 	keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
 	if (found_data != sKeyframeDataMap.end())
 	{
@@ -2413,6 +2482,7 @@ void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 //--------------------------------------------------------------------
 LLKeyframeMotion::JointMotionListPtr LLKeyframeDataCache::getKeyframeData(const LLUUID& id)
 {
+	LLMutexLock lock(keyframe_data_mutex());
 	keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
 	if (found_data == sKeyframeDataMap.end())
 	{
@@ -2434,6 +2504,7 @@ LLKeyframeDataCache::~LLKeyframeDataCache()
 //-----------------------------------------------------------------------------
 void LLKeyframeDataCache::clear()
 {
+	LLMutexLock lock(keyframe_data_mutex());
 	sKeyframeDataMap.clear();
 }
 
@@ -39,6 +39,7 @@
 //-----------------------------------------------------------------------------
 
 #include <string>
+#include <vector>
 
 #include "llassetstorage.h"
 #include "llbboxlocal.h"
@@ -46,6 +47,7 @@
 #include "lljointstate.h"
 #include "llmotion.h"
 #include "llquaternion.h"
+#include "llthread.h"
 #include "v3dmath.h"
 #include "v3math.h"
 #include "llbvhconsts.h"
@@ -80,6 +82,10 @@ class AICachedPointer
   public:
 	typedef std::set<AICachedPointer<KEY, T> > container_type;
 
+  public:
+	// Protects the container and the reference counts of its elements.
+	static LLGlobalMutex sMutex;
+
   private:
 	KEY mKey;							// The unique key.
 	LLPointer<T> mData;					// The actual data pointer.
@@ -115,12 +121,16 @@ class AICachedPointer
 	AICachedPointer& operator=(AICachedPointer const&);
 };
 
+template<typename KEY, typename T>
+LLGlobalMutex AICachedPointer<KEY, T>::sMutex;
+
 template<typename KEY, typename T>
 void intrusive_ptr_add_ref(AICachedPointer<KEY, T> const* p)
 {
   llassert(p->mCache);
   if (p->mCache)
   {
+	LLMutexLock lock(&AICachedPointer<KEY, T>::sMutex);
 	p->mRefCount++;
   }
 }
@@ -131,6 +141,7 @@ void intrusive_ptr_release(AICachedPointer<KEY, T> const* p)
   llassert(p->mCache);
   if (p->mCache)
   {
+	LLMutexLock lock(&AICachedPointer<KEY, T>::sMutex);
 	if (--p->mRefCount == 0)
 	{
 	  p->mCache->erase(p->mKey);
@@ -143,12 +154,12 @@ class AICachedPointerPtr
 {
   private:
 	boost::intrusive_ptr<AICachedPointer<KEY, T> const> mPtr;
-	static int sCnt;
+	static LLAtomicS32 sCnt;
 
   public:
-	AICachedPointerPtr(void) { ++sCnt; }
-	AICachedPointerPtr(AICachedPointerPtr const& cpp) : mPtr(cpp.mPtr) { ++sCnt; }
-	AICachedPointerPtr(AICachedPointer<KEY, T> const* cp) : mPtr(cp) { ++sCnt; }
+	AICachedPointerPtr(void) { sCnt++; }
+	AICachedPointerPtr(AICachedPointerPtr const& cpp) : mPtr(cpp.mPtr) { sCnt++; }
+	AICachedPointerPtr(AICachedPointer<KEY, T> const* cp) : mPtr(cp) { sCnt++; }
 	~AICachedPointerPtr() { --sCnt; }
 
 	typedef boost::intrusive_ptr<AICachedPointer<KEY, T> const> const AICachedPointerPtr<KEY, T>::* const bool_type;
@@ -163,7 +174,7 @@ class AICachedPointerPtr
 };
 
 template<typename KEY, typename T>
-int AICachedPointerPtr<KEY, T>::sCnt;
+LLAtomicS32 AICachedPointerPtr<KEY, T>::sCnt;
 
 // </singu>
 //-----------------------------------------------------------------------------
@@ -251,6 +262,9 @@ public:
 	// must return FALSE when the motion is completed.
 	virtual BOOL onUpdate(F32 time, U8* joint_mask);
 
+	// evaluates the joint curves ahead of onUpdate.
+	/*virtual*/ void onPrepareUpdate(F32 time);
+
 	// called when a motion is deactivated
 	virtual void onDeactivate();
 
@@ -372,6 +386,12 @@ protected:
 
 	void applyConstraints(F32 time, U8* joint_mask);
 
+	// The time in the animation (taking looping into account) that onUpdate(time) will apply.
+	F32 getLoopedTime(F32 time) const;
+
+	// Set the joint states to the curves at time.
+	void updateJointStates(F32 time);
+
 	void activateConstraint(JointConstraint* constraintp);
 
 	void initializeConstraint(JointConstraint* constraint);
@@ -426,6 +446,17 @@ public:
 		LLVector3	mPosition;
 	};
 
+	//-------------------------------------------------------------------------
+	// Curves
+	//
+	// The keys of a curve are sorted on time and stored as two parallel arrays:
+	// the times, which are searched, and the values, which are interpolated.
+	// The curves are shared by every motion instance that plays the same
+	// animation, so the position of the last lookup (the cursor) is kept by
+	// the caller. During playback time only moves forward a little each frame,
+	// so with a cursor finding the keys around a time is usually O(1).
+	//-------------------------------------------------------------------------
+
 	//-------------------------------------------------------------------------
 	// ScaleCurve
 	//-------------------------------------------------------------------------
@@ -434,13 +465,15 @@ public:
 	public:
 		ScaleCurve();
 		~ScaleCurve();
-		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+		// Insert a key, or replace the key with the same time.
+		void addKey(const ScaleKey& key);
+		LLVector3 getValue(F32 time, F32 duration) const;
+		LLVector3 getValue(F32 time, F32 duration, U32& cursor) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
+		std::vector<F32>		mTimes;
+		std::vector<LLVector3>	mScales;
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
 	};
@@ -453,13 +486,15 @@ public:
 	public:
 		RotationCurve();
 		~RotationCurve();
-		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		// Insert a key, or replace the key with the same time.
+		void addKey(const RotationKey& key);
+		LLQuaternion getValue(F32 time, F32 duration) const;
+		LLQuaternion getValue(F32 time, F32 duration, U32& cursor) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
+		std::vector<F32>			mTimes;
+		std::vector<LLQuaternion>	mRotations;
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
 	};
@@ -472,17 +507,32 @@ public:
 	public:
 		PositionCurve();
 		~PositionCurve();
-		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		// Insert a key, or replace the key with the same time.
+		void addKey(const PositionKey& key);
+		LLVector3 getValue(F32 time, F32 duration) const;
+		LLVector3 getValue(F32 time, F32 duration, U32& cursor) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
+		std::vector<F32>		mTimes;
+		std::vector<LLVector3>	mPositions;
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
 	};
 
+	//-------------------------------------------------------------------------
+	// CurveCursors
+	//-------------------------------------------------------------------------
+	// The cursors into the three curves of one JointMotion, for one motion instance.
+	struct CurveCursors
+	{
+		CurveCursors() : mScale(0), mRotation(0), mPosition(0) { }
+
+		U32 mScale;
+		U32 mRotation;
+		U32 mPosition;
+	};
+
 	//-------------------------------------------------------------------------
 	// JointMotion
 	//-------------------------------------------------------------------------
@@ -496,7 +546,7 @@ public:
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		void update(LLJointState* joint_state, F32 time, F32 duration, CurveCursors& cursors) const;
 	};
 	
 	//-------------------------------------------------------------------------
@@ -549,9 +599,16 @@ protected:
 	U32								mLastSkeletonSerialNum;
 	F32								mLastUpdateTime;
 	F32								mLastLoopedTime;
+	std::vector<CurveCursors>		mCurveCursors;				// One for each joint motion of mJointMotionList.
+	F32								mPreparedTime;				// The looped time that the joint states were set for by onPrepareUpdate.
+	bool							mPrepared;					// Set while mPreparedTime is valid.
 	AssetStatus						mAssetStatus;
 };
 
+// All access to sKeyframeDataMap is serialized by AICachedPointer::sMutex,
+// so JointMotionListPtr's can be created and released from any thread.
+// The JointMotionList objects themselves are read-only once loaded and
+// may be read concurrently.
 class LLKeyframeDataCache
 {
 private:
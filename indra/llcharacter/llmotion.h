@@ -235,6 +235,14 @@ public:
 	// must return FALSE when the motion is completed.
 	virtual BOOL onUpdate(F32 activeTime, U8* joint_mask) = 0;
 
+	// called before onUpdate, earlier in the same frame, with the activeTime that
+	// onUpdate will most likely be called with. May be called from any thread,
+	// concurrently with the motions of other characters, so it may only touch the
+	// state of this motion. Lets motions do expensive work that doesn't depend on
+	// other joints (for example, evaluating curves) in parallel; onUpdate must
+	// still give the same result when it isn't called, or called with another time.
+	virtual void onPrepareUpdate(F32 activeTime) { }
+
 	// called when a motion is deactivated
 	virtual void onDeactivate() = 0;
 
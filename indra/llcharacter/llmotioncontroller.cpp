@@ -881,7 +881,7 @@ void LLMotionController::updateMotions(bool force_update)
             // Moreover, just rounding off to the nearest integer with ll_round(update_time / mTimeStep) makes a lot more sense:
             // it is the best we can do to get as close to what we should draw as possible.
             // However, mAnimTime may only be incremented; therefore make sure of that with the llmax.
-			S32 quantum_count = llmax(ll_round(update_time / mTimeStep), llceil(mAnimTime / mTimeStep));
+			S32 quantum_count = getQuantumCount(update_time);
             //</singu>
 			if (quantum_count == mTimeStepCount)
 			{
@@ -947,6 +947,56 @@ void LLMotionController::updateMotions(bool force_update)
 //	llinfos << "Motion controller time " << motionTimer.getElapsedTimeF32() << llendl;
 }
 
+//-----------------------------------------------------------------------------
+// getQuantumCount()
+//-----------------------------------------------------------------------------
+S32 LLMotionController::getQuantumCount(F32 update_time) const
+{
+	return llmax(ll_round(update_time / mTimeStep), llceil(mAnimTime / mTimeStep));
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::prepareMotions()
+{
+	if (mPaused || mActiveMotions.empty())
+	{
+		return;
+	}
+
+	// Predict mAnimTime the same way as updateMotions() will; mTimer is an
+	// LLFrameTimer, so it returns the same time during the whole frame.
+	F32 update_time = mAnimTime + (mTimer.getElapsedTimeF32() - mPrevTimerElapsed) * mTimeFactor;
+	F32 anim_time;
+	if (mTimeStep != 0.f)
+	{
+		S32 quantum_count = getQuantumCount(update_time);
+		if (quantum_count == mTimeStepCount)
+		{
+			// updateMotions() will only interpolate.
+			return;
+		}
+		anim_time = llmax(mAnimTime, (F32)quantum_count * mTimeStep);
+	}
+	else
+	{
+		anim_time = llmax(mAnimTime, update_time);
+	}
+
+	for (motion_list_t::iterator iter = mActiveMotions.begin(); iter != mActiveMotions.end(); ++iter)
+	{
+		LLMotion* motionp = *iter;
+		// Skip motions that won't be updated with anim_time (see updateMotionsByType).
+		if (anim_time < motionp->mActivationTimestamp ||
+			(motionp->isStopped() && anim_time > motionp->getStopTime() + motionp->getEaseOutDuration()))
+		{
+			continue;
+		}
+		motionp->onPrepareUpdate(anim_time - motionp->mActivationTimestamp);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // updateMotionsMinimal()
 // minimal update (e.g. while hidden)
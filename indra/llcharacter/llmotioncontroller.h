@@ -143,6 +143,12 @@ public:
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
+	// Calls LLMotion::onPrepareUpdate for the active motions, with the times that the
+	// next updateMotions() in this frame will pass to onUpdate. Only touches this
+	// controller and its motions, so the controllers of different characters may do
+	// this concurrently, on any thread.
+	void prepareMotions();
+
 	void clearBlenders() { mPoseBlender.clearBlenders(); }
 
 	// flush motions
@@ -204,6 +210,8 @@ protected:
 	void updateAdditiveMotions();
 	void resetJointSignatures();
 	void updateMotionsByType(LLMotion::LLMotionBlendType motion_type);
+	// The time quantum that update_time falls in, when mTimeStep is set.
+	S32 getQuantumCount(F32 update_time) const;
 	void updateIdleMotion(LLMotion* motionp);
 	void updateIdleActiveMotions();
 	void purgeExcessMotions();
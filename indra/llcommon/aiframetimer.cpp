@@ -64,26 +64,27 @@
 static F64 const NEVER = 1e16;				// 317 million years.
 
 F64 AIFrameTimer::sNextExpiration;
-AIFrameTimer::timer_list_type AIFrameTimer::sTimerList;
+LLTimerWheel AIFrameTimer::sTimerWheel;
+LLTimerWheel::List AIFrameTimer::sExpired;
 LLGlobalMutex AIFrameTimer::sMutex;
+F64 const AIFrameTimer::TICKS_PER_SECOND = 1000.0;
 
 // Notes on thread-safety of AIRunningFrameTimer (continued from aiframetimer.h)
 //
-// Most notably, the constructor and init() should be called as follows:
-// 1) The object is constructed (AIRunningFrameTimer::AIRunningFrameTimer).
-// 2) The lock is obtained.
-// 3) The object is inserted in the list (operator<(AIRunningFrameTimer const&, AIRunningFrameTimer const&)).
-// 4) The object is initialized (AIRunningFrameTimer::init).
-// 5) The lock is released.
-// This assures that the object is not yet shared at the moment that it is initialized.
+// The constructor connects the callback, so the object is completely
+// initialized before the lock is obtained and it is inserted in sTimerWheel.
+// From then on it is only accessed with the lock held, except for the call
+// to do_callback() (see handleExpiration).
 
 void AIFrameTimer::create(F64 expiration, signal_type::slot_type const& slot)
 {
-	AIRunningFrameTimer new_timer(expiration, this);
+	AIRunningFrameTimer* new_timer = new AIRunningFrameTimer(expiration, this, slot);
+	F64 now = LLFrameTimer::getElapsedSeconds();
 	LLMutexLock lock(sMutex);
-	llassert(mHandle.mRunningTimer == sTimerList.end());	// Create may only be called when the timer isn't already running.
-	mHandle.init(sTimerList.insert(new_timer), slot);
-	sNextExpiration = sTimerList.begin()->expiration();
+	llassert(!mHandle.mRunningTimer);	// Create may only be called when the timer isn't already running.
+	mHandle.mRunningTimer = new_timer;
+	sTimerWheel.insert(new_timer, (U64)ceil(new_timer->expiration() * TICKS_PER_SECOND), (U64)(now * TICKS_PER_SECOND));
+	sNextExpiration = llmin(sNextExpiration, new_timer->expiration());
 }
 
 void AIFrameTimer::cancel(void)
@@ -100,11 +101,17 @@ void AIFrameTimer::cancel(void)
 	// in the case we manage to get it first.
 	{
 		LLMutexLock lock(sMutex);
-		if (mHandle.mRunningTimer != sTimerList.end())
+		if (mHandle.mRunningTimer)
 		{
-			sTimerList.erase(mHandle.mRunningTimer);
-			mHandle.mRunningTimer = sTimerList.end();
-			sNextExpiration = sTimerList.empty() ? NEVER : sTimerList.begin()->expiration();
+			// This also removes it from sExpired, if handleExpiration is processing it.
+			// sNextExpiration is left alone: it is a lower bound.
+			sTimerWheel.remove(mHandle.mRunningTimer);
+			delete mHandle.mRunningTimer;
+			mHandle.mRunningTimer = NULL;
+			if (sTimerWheel.empty())
+			{
+				sNextExpiration = NEVER;
+			}
 		}
 	}
     mHandle.mMutex.unlock();
@@ -112,22 +119,21 @@ void AIFrameTimer::cancel(void)
 
 void AIFrameTimer::handleExpiration(F64 current_frame_time)
 {
+	U64 const now = (U64)(current_frame_time * TICKS_PER_SECOND);
     sMutex.lock();
 	for(;;)
 	{
-		if (sTimerList.empty())
+		if (sExpired.empty())
 		{
-			// No running timers left.
-			sNextExpiration = NEVER;
-			break;
-		}
-		timer_list_type::iterator running_timer = sTimerList.begin();
-		sNextExpiration = running_timer->expiration();
-		if (sNextExpiration > current_frame_time)
-		{
-			// Didn't expire yet.
-			break;
+			// Collect the timers that expired, including those that were created
+			// by the callbacks below with an expiration that already passed.
+			sTimerWheel.advance(now, sExpired);
+			if (sExpired.empty())
+			{
+				break;
+			}
 		}
+		AIRunningFrameTimer* running_timer = static_cast<AIRunningFrameTimer*>(sExpired.pop_front());
 
 		// Obtain handle of running timer through the associated AIFrameTimer object.
 		// Note that if the AIFrameTimer object was destructed (when running_timer->getTimer()
@@ -135,8 +141,8 @@ void AIFrameTimer::handleExpiration(F64 current_frame_time)
 		Handle& handle(running_timer->getTimer()->mHandle);
 		llassert_always(running_timer == handle.mRunningTimer);
 
-		// We're going to erase this timer, so stop cancel() from doing the same.
-		handle.mRunningTimer = sTimerList.end();
+		// We're going to delete this timer, so stop cancel() from doing the same.
+		handle.mRunningTimer = NULL;
 
 		// We keep handle.mMutex during the callback to prevent the thread that
 		// owns the AIFrameTimer from deleting the callback function while we
@@ -151,15 +157,15 @@ void AIFrameTimer::handleExpiration(F64 current_frame_time)
 		// 1. It hasn't obtained the first lock yet, we obtain the handle.mMutex
 		// lock and the other thread will stall on the first line of cancel().
 		// After do_callback returns, the other thread will do nothing because
-		// handle.mRunningTimer equals sTimerList.end(), exit the function and
+		// handle.mRunningTimer is NULL, exit the function and
 		// (possibly) delete the callback object, but that is ok as we already
 		// returned from the callback function.
 		//
 		// 2. It already called cancel() and hangs on the second line trying to
 		// obtain sMutex.lock(). The trylock below fails and we never call the
-		// callback function. We erase the running timer here and release sMutex
+		// callback function. We delete the running timer here and release sMutex
 		// at the end, after which the other thread does nothing because
-		// handle.mRunningTimer equals sTimerList.end(), exits the function and
+		// handle.mRunningTimer is NULL, exits the function and
 		// (possibly) deletes the callback object.
 		//
 		// Note that if the other thread actually obtained the sMutex then we
@@ -172,9 +178,12 @@ void AIFrameTimer::handleExpiration(F64 current_frame_time)
 			handle.mMutex.unlock();				// Allow other thread to return from cancel() and possibly delete the callback object.
 		}
 
-		// Erase the timer from the running list.
-		sTimerList.erase(running_timer);
+		// Delete the timer; it was already removed from sExpired.
+		delete running_timer;
 	}
+	// Everything up to now was handled, so this is later than current_frame_time.
+	U64 next = sTimerWheel.nextExpiration();
+	sNextExpiration = next == LLTimerWheel::NEVER ? NEVER : next / TICKS_PER_SECOND;
     sMutex.unlock();
 }
 
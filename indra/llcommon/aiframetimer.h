@@ -33,8 +33,8 @@
 
 #include "llframetimer.h"
 #include "llthread.h"
+#include "lltimerwheel.h"
 #include <boost/signals2.hpp>
-#include <set>
 
 class LL_COMMON_API AIFrameTimer
 {
@@ -42,85 +42,53 @@ class LL_COMMON_API AIFrameTimer
 	typedef boost::signals2::signal<void (void)> signal_type;
 
   private:
-	// Use separate struct for this object because it is non-copyable.
-	struct Signal {
-		signal_type mSignal;
-	};
-
 	// Notes on Thread-Safety
 	//
-	// This is the type of the objects stored in AIFrameTimer::sTimerList, and as such leans
-	// for it's thread-safety on the same lock as is used for that std::multiset as follows.
-	// An arbitrary thread can create, insert and initialize this object. Other threads can
+	// This is the type of the objects stored in AIFrameTimer::sTimerWheel, and as such leans
+	// for it's thread-safety on the same lock as is used for that wheel as follows.
+	// An arbitrary thread can create, initialize and insert this object. Other threads can
 	// not access it until that has completed.
 	//
 	// After creation two threads can access it: the thread that created it (owns the
 	// AIFrameTimer object, which has an mHandle that points to this object), or the main
-	// thread by finding it in sTimerList.
+	// thread by finding it in sTimerWheel.
 	//
 	// See aiframetimer.cpp for more notes.
-	class AIRunningFrameTimer {
+	class AIRunningFrameTimer : public LLTimerWheel::Node {
 	  private:
 		F64 mExpire;						// Time at which the timer expires, in seconds since application start (compared to LLFrameTimer::sFrameTime).
 		AIFrameTimer* mTimer;				// The actual timer.
-		// Can be mutable, since only the mExpire is used for ordering this object in the multiset AIFrameTimer::sTimerList.
-		mutable Signal* mCallback;			// Pointer to callback struct, or NULL when the object wasn't added to sTimerList yet.
+		signal_type mSignal;
 
 	  public:
-		AIRunningFrameTimer(F64 expiration, AIFrameTimer* timer) : mExpire(LLFrameTimer::getElapsedSeconds() + expiration), mTimer(timer), mCallback(NULL) { }
-		~AIRunningFrameTimer() { delete mCallback; }
-
-		// This function is called after the final object was added to sTimerList (where it is initialized in-place).
-		void init(signal_type::slot_type const& slot) const
-			{
-			  // We may only call init() once.
-			  llassert(!mCallback);
-			  mCallback = new Signal;
-			  mCallback->mSignal.connect(slot);
-			}
-
-		// Order AIFrameTimer::sTimerList so that the timer that expires first is up front.
-		friend bool operator<(AIRunningFrameTimer const& ft1, AIRunningFrameTimer const& ft2) { return ft1.mExpire < ft2.mExpire; }
-
-		void do_callback(void) const { mCallback->mSignal(); }
+		AIRunningFrameTimer(F64 expiration, AIFrameTimer* timer, signal_type::slot_type const& slot) :
+			mExpire(LLFrameTimer::getElapsedSeconds() + expiration), mTimer(timer) { mSignal.connect(slot); }
+
+		void do_callback(void) const { mSignal(); }
 		F64 expiration(void) const { return mExpire; }
 		AIFrameTimer* getTimer(void) const { return mTimer; }
-
-#if LL_DEBUG
-		// May not copy this object after it was initialized.
-		AIRunningFrameTimer(AIRunningFrameTimer const& running_frame_timer) :
-			mExpire(running_frame_timer.mExpire), mTimer(running_frame_timer.mTimer), mCallback(running_frame_timer.mCallback)
-			{ llassert(!mCallback); }
-#endif
 	};
 
-	typedef std::multiset<AIRunningFrameTimer> timer_list_type;
-
-	static LLGlobalMutex sMutex;				// Mutex for the two global variables below.
-	static timer_list_type sTimerList;			// List with all running timers.
-	static F64 sNextExpiration;					// Cache of smallest value in sTimerList.
+	static LLGlobalMutex sMutex;				// Mutex for the three global variables below.
+	static LLTimerWheel sTimerWheel;			// All running timers, in ticks of TICKS_PER_SECOND.
+	static LLTimerWheel::List sExpired;			// Timers that expired and are being handled by handleExpiration().
+	static F64 sNextExpiration;					// Lower bound of the smallest expiration in sTimerWheel.
 	friend class LLFrameTimer;					// Access to sNextExpiration.
 
+	// Frame timers are kept in the wheel with a resolution of one millisecond.
+	static F64 const TICKS_PER_SECOND;
+
 	class Handle {
 	  public:
-		timer_list_type::iterator mRunningTimer;	// Points to the running timer, or to sTimerList.end() when not running.
-													// Access to this iterator is protected by the AIFrameTimer::sMutex!
+		AIRunningFrameTimer* mRunningTimer;			// Points to the running timer, or NULL when not running.
+													// Access to this pointer is protected by the AIFrameTimer::sMutex!
 		LLMutex mMutex;								// A mutex used to protect us from deletion of the callback object while
 													// calling the callback function in the case of simultaneous expiration
 													// and cancellation by the thread owning the AIFrameTimer (by calling
 													// AIFrameTimer::cancel).
 
 		// Constructor for a not-running timer.
-		Handle(void) : mRunningTimer(sTimerList.end()) { }
-
-		// Actual initialization used by AIFrameTimer::create.
-		void init(timer_list_type::iterator const& running_timer, signal_type::slot_type const& slot)
-			{
-			  // Locking AIFrameTimer::sMutex is not neccessary here, because we're creating
-			  // the object and no other thread knows of mRunningTimer at this point.
-			  mRunningTimer = running_timer;
-			  mRunningTimer->init(slot);
-			}
+		Handle(void) : mRunningTimer(NULL) { }
 
 	  private:
 		// LLMutex has no assignment operator.
@@ -146,7 +114,7 @@ class LL_COMMON_API AIFrameTimer
 	void create(F64 expiration, signal_type::slot_type const& slot);
 	void cancel(void);
 
-	bool isRunning(void) const { bool running; sMutex.lock(); running = mHandle.mRunningTimer != sTimerList.end(); sMutex.unlock(); return running; }
+	bool isRunning(void) const { bool running; sMutex.lock(); running = mHandle.mRunningTimer != NULL; sMutex.unlock(); return running; }
 
   protected:
 	static void handleExpiration(F64 current_frame_time);
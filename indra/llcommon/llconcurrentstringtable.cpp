@@ -0,0 +1,199 @@
+/**
+ * @file llconcurrentstringtable.cpp
+ * @brief Implementation of LLConcurrentStringTable.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llconcurrentstringtable.h"
+
+LLConcurrentStringTable::LLConcurrentStringTable(U32 table_size, U32 max_length) :
+	mMaxLength(max_length), mNumLevels(0), mNumChunks(1), mChunkUsed(sizeof(U32)), mSize(0)
+{
+	llassert_always(max_length > 0 && sizeof(Header) + max_length + sizeof(U32) <= CHUNK_SIZE);
+	U32 size = 16;
+	while (size < table_size)
+	{
+		size <<= 1;
+	}
+	initLevel(mLevels[0], size);
+	mNumLevels = 1;
+	// Position 0 marks an empty slot, so nothing is ever stored at the start of the first chunk.
+	mChunks[0] = new char[CHUNK_SIZE];
+}
+
+LLConcurrentStringTable::~LLConcurrentStringTable()
+{
+	U32 num_levels = mNumLevels;
+	for (U32 i = 0; i < num_levels; ++i)
+	{
+		delete [] mLevels[i].mSlots;
+	}
+	for (U32 i = 0; i < mNumChunks; ++i)
+	{
+		delete [] mChunks[i];
+	}
+}
+
+//static
+void LLConcurrentStringTable::initLevel(Level& level, U32 size)
+{
+	level.mMask = size - 1;
+	level.mUsed = 0;
+	level.mSlots = new LLAtomicU32[size];
+	for (U32 i = 0; i < size; ++i)
+	{
+		level.mSlots[i] = 0;
+	}
+}
+
+//static
+U32 LLConcurrentStringTable::hash(char const* str, U32& length, U32 max_length)
+{
+	// FNV-1a, over at most max_length - 1 characters.
+	U32 hash = 2166136261U;
+	char const* p = str;
+	char const* end = str + max_length - 1;
+	while (p != end && *p)
+	{
+		hash = (hash ^ (U8)*p++) * 16777619U;
+	}
+	length = p - str;
+	return hash;
+}
+
+char const* LLConcurrentStringTable::find(char const* str, U32 hash, U32 length, U32 num_levels) const
+{
+	// Newest first: that is where most strings are, once there is more than one level.
+	for (S32 i = num_levels - 1; i >= 0; --i)
+	{
+		Level const& level(mLevels[i]);
+		for (U32 index = hash & level.mMask;; index = (index + 1) & level.mMask)
+		{
+			U32 position = level.mSlots[index];
+			if (!position)
+			{
+				break;
+			}
+			Header const* entry = header(position);
+			if (entry->mHash == hash && entry->mLength == length && !memcmp(text(entry), str, length))
+			{
+				return text(entry);
+			}
+		}
+	}
+	return NULL;
+}
+
+char const* LLConcurrentStringTable::find(char const* str) const
+{
+	if (!str)
+	{
+		return NULL;
+	}
+	U32 length;
+	U32 h = hash(str, length, mMaxLength);
+	return find(str, h, length, mNumLevels);
+}
+
+char const* LLConcurrentStringTable::insert(char const* str)
+{
+	if (!str)
+	{
+		return NULL;
+	}
+	U32 length;
+	U32 h = hash(str, length, mMaxLength);
+	char const* result = find(str, h, length, mNumLevels);
+	if (result)
+	{
+		return result;
+	}
+
+	LLMutexLock lock(mInsertMutex);
+	// Another thread might have added it in the meantime.
+	U32 num_levels = mNumLevels;
+	result = find(str, h, length, num_levels);
+	if (result)
+	{
+		return result;
+	}
+	Level* level = &mLevels[num_levels - 1];
+	if (2 * (level->mUsed + 1) > level->mMask + 1)
+	{
+		// Keep the load factor at most 1/2, so that probe sequences stay short.
+		llassert_always(num_levels < MAX_LEVELS);
+		U32 size = 2 * (level->mMask + 1);
+		level = &mLevels[num_levels];
+		initLevel(*level, size);
+		mNumLevels = num_levels + 1;			// Publish the new level.
+	}
+	U32 position = allocate(str, h, length);
+	U32 index = h & level->mMask;
+	while (level->mSlots[index])
+	{
+		index = (index + 1) & level->mMask;
+	}
+	level->mSlots[index] = position;			// Publish the string.
+	++level->mUsed;
+	mSize++;
+	return text(header(position));
+}
+
+U32 LLConcurrentStringTable::allocate(char const* str, U32 hash, U32 length)
+{
+	// Keep the headers aligned.
+	U32 bytes = (sizeof(Header) + length + 1 + sizeof(U32) - 1) & ~(sizeof(U32) - 1);
+	if (mChunkUsed + bytes > CHUNK_SIZE)
+	{
+		llassert_always(mNumChunks < MAX_CHUNKS);
+		mChunks[mNumChunks++] = new char[CHUNK_SIZE];
+		mChunkUsed = 0;
+	}
+	U32 position = ((mNumChunks - 1) << CHUNK_BITS) | mChunkUsed;
+	mChunkUsed += bytes;
+	Header* entry = reinterpret_cast<Header*>(mChunks[mNumChunks - 1] + (position & (CHUNK_SIZE - 1)));
+	entry->mHash = hash;
+	entry->mLength = length;
+	char* copy = reinterpret_cast<char*>(entry + 1);
+	memcpy(copy, str, length);
+	copy[length] = 0;
+	return position;
+}
+
+void LLConcurrentStringTable::getStrings(std::vector<char const*>& strings) const
+{
+	U32 num_levels = mNumLevels;
+	for (U32 i = 0; i < num_levels; ++i)
+	{
+		Level const& level(mLevels[i]);
+		for (U32 index = 0; index <= level.mMask; ++index)
+		{
+			U32 position = level.mSlots[index];
+			if (position)
+			{
+				strings.push_back(text(header(position)));
+			}
+		}
+	}
+}
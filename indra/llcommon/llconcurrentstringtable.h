@@ -0,0 +1,134 @@
+/**
+ * @file llconcurrentstringtable.h
+ * @brief An append-only string interning table with lock-free lookups.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLCONCURRENTSTRINGTABLE_H
+#define LL_LLCONCURRENTSTRINGTABLE_H
+
+#include <string>
+#include <vector>
+
+#include "stdtypes.h"
+#include "llatomic.h"
+#include "llthread.h"
+
+//============================================================================
+// LLConcurrentStringTable returns a unique copy of every string that is
+// inserted, so that interned strings can be compared by pointer. Strings
+// are never removed; the copies live until the table is destroyed.
+//
+// Any number of threads may call find() and insert() at the same time.
+// Looking up a string that is already in the table takes no lock: the
+// slots of the hash table are atomic, and a slot is only filled after the
+// string it refers to was written. Adding a new string takes a mutex.
+//
+// The strings are copied into large chunks of memory ("the arena"), so
+// interning doesn't allocate per string. Strings longer than max_length - 1
+// characters are truncated, like LLStringTable and LLMessageStringTable do.
+//
+// Instead of rehashing when it gets full, the table adds a hash table twice
+// the size of the last one; a lookup probes all of them, newest first. That
+// way no slot ever moves, and readers never see a half-rebuilt table. With
+// a reasonable initial size there is only one.
+//
+// Example usage:
+//   LLConcurrentStringTable table(4096, 64);
+//   char const* name = table.insert("AgentData");
+//   ...
+//   if (table.find(str) == name) ...			// NULL if str was never inserted.
+
+class LL_COMMON_API LLConcurrentStringTable
+{
+public:
+	// table_size is the initial number of slots (rounded up to a power of two).
+	LLConcurrentStringTable(U32 table_size, U32 max_length);
+	~LLConcurrentStringTable();
+
+	// Return the interned copy of str, or NULL if str wasn't inserted.
+	char const* find(char const* str) const;
+	char const* find(std::string const& str) const { return find(str.c_str()); }
+
+	// Return the interned copy of str, adding it if necessary.
+	char const* insert(char const* str);
+	char const* insert(std::string const& str) { return insert(str.c_str()); }
+
+	// The number of unique strings.
+	U32 size(void) const { return mSize; }
+
+	// Append all strings to strings, in no particular order.
+	void getStrings(std::vector<char const*>& strings) const;
+
+private:
+	// Not copyable.
+	LLConcurrentStringTable(LLConcurrentStringTable const&);
+	LLConcurrentStringTable& operator=(LLConcurrentStringTable const&);
+
+	enum {
+		CHUNK_BITS = 16,
+		CHUNK_SIZE = 1 << CHUNK_BITS,			// Bytes per arena chunk.
+		MAX_CHUNKS = 4096,						// 256 MB of strings.
+		MAX_LEVELS = 16
+	};
+
+	// A string in the arena is preceded by its hash and length.
+	struct Header
+	{
+		U32 mHash;
+		U32 mLength;
+	};
+
+	// A hash table of (level) slots. A slot holds the arena position of a
+	// Header, or 0 when it is empty.
+	struct Level
+	{
+		U32 mMask;
+		U32 mUsed;								// Only accessed with mInsertMutex locked.
+		LLAtomicU32* mSlots;
+	};
+
+	// Allocate the slots of level, all empty.
+	static void initLevel(Level& level, U32 size);
+	// Hash of the first max_length - 1 characters of str; returns the number of those in length.
+	static U32 hash(char const* str, U32& length, U32 max_length);
+
+	Header const* header(U32 position) const { return reinterpret_cast<Header const*>(mChunks[position >> CHUNK_BITS] + (position & (CHUNK_SIZE - 1))); }
+	static char const* text(Header const* header) { return reinterpret_cast<char const*>(header + 1); }
+
+	// Look for str in the first num_levels levels.
+	char const* find(char const* str, U32 hash, U32 length, U32 num_levels) const;
+	// Copy str to the arena and return its position. Called with mInsertMutex locked.
+	U32 allocate(char const* str, U32 hash, U32 length);
+
+	U32 const mMaxLength;
+	Level mLevels[MAX_LEVELS];
+	LLAtomicU32 mNumLevels;						// Set after mLevels[mNumLevels - 1] was initialized.
+	char* mChunks[MAX_CHUNKS];					// Filled before any slot refers to them.
+	U32 mNumChunks;								// Only accessed with mInsertMutex locked.
+	U32 mChunkUsed;								// Bytes used in the last chunk. Only accessed with mInsertMutex locked.
+	LLAtomicU32 mSize;
+	LLMutex mInsertMutex;
+};
+
+#endif // LL_LLCONCURRENTSTRINGTABLE_H
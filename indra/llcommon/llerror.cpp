@@ -41,6 +41,7 @@
 #endif // !LL_WINDOWS
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include "llapp.h"
 #include "llapr.h"
@@ -50,6 +51,7 @@
 #include "llsdserialize.h"
 #include "llstl.h"
 #include "lltimer.h"
+#include "llthread.h"
 
 #include "aithreadsafe.h"
 
@@ -458,7 +460,47 @@ namespace LLError
 
 		static AIThreadSafeSimple<Settings>* sSettings;
 	};
+}
+
+namespace
+{
+	// While the log writer thread runs, the threads that log only queue their messages,
+	// each in a LogBuffer of its own, and the log writer thread passes them to the
+	// recorders. See LLError::startLogWriterThread.
+	class LogWriter
+	{
+	public:
+		// Set while the log writer thread runs. Only changed while holding the Settings lock.
+		static bool sRunning;
+
+		// Serializes the use of the recorders outside of the Settings lock, and protects sRecorders and sTimeFunction.
+		static LLGlobalMutex sRecordersMutex;
+
+		static void start(void);
+		static void stop(void);
+
+		// Copy the recorders and time function for use by the log writer thread.
+		// Must be called with the Settings lock held, every time those changed.
+		static void setRecorders(LLError::Settings const& settings);
+
+		// Queue message for the log writer thread; takes the contents of message.
+		// Must be called with the Settings lock held. Returns false if the calling
+		// thread has no LLThreadLocalData; the message must be written directly then.
+		static bool push(LLError::Settings const& settings, LLError::ELevel level, std::string& message);
 
+		// Write everything that is queued. Must be called with sRecordersMutex locked.
+		static void write(void);
+
+	private:
+		static Recorders sRecorders;
+		static LLError::TimeFunction sTimeFunction;
+		static U32 sSequence;					// Protected by the Settings lock.
+		static LLThread* sThread;
+	};
+}
+
+namespace LLError
+{
 	// Pointer to current AIThreadSafeSimple<Settings> object if any (NULL otherwise).
 	AIThreadSafeSimple<Settings>* Settings::sSettings;
 	
@@ -474,8 +516,11 @@ namespace LLError
 	void Settings::reset()
 	{
 		AIAccess<Globals>(Globals::get())->invalidateCallSites();
-		delete sSettings;
+		AIThreadSafeSimple<Settings>* oldSettings = sSettings;
 		sSettings = new AIThreadSafeSimpleDC<Settings>;
+		// Stop the log writer thread from using the recorders before they are deleted.
+		LogWriter::setRecorders(*AIAccess<Settings>(*sSettings));
+		delete oldSettings;
 	}
 	
 	AIThreadSafeSimple<Settings>* Settings::saveAndReset()
@@ -483,14 +528,17 @@ namespace LLError
 		AIAccess<Globals>(Globals::get())->invalidateCallSites();
 		AIThreadSafeSimple<Settings>* originalSettings = sSettings;
 		sSettings = new AIThreadSafeSimpleDC<Settings>;
+		LogWriter::setRecorders(*AIAccess<Settings>(*sSettings));
 		return originalSettings;
 	}
 	
 	void Settings::restore(AIThreadSafeSimple<Settings>* originalSettings)
 	{
 		AIAccess<Globals>(Globals::get())->invalidateCallSites();
-		delete sSettings;
+		AIThreadSafeSimple<Settings>* oldSettings = sSettings;
 		sSettings = originalSettings;
+		LogWriter::setRecorders(*AIAccess<Settings>(*sSettings));
+		delete oldSettings;
 	}
 }
 
@@ -616,7 +664,9 @@ namespace LLError
 
 	void setTimeFunction(TimeFunction f)
 	{
-		AIAccess<Settings>(Settings::get())->timeFunction = f;
+		AIAccess<Settings> settings_w(Settings::get());
+		settings_w->timeFunction = f;
+		LogWriter::setRecorders(*settings_w);
 	}
 
 	void setDefaultLevel(AIAccess<Settings> const& settings_w, ELevel level)
@@ -741,6 +791,7 @@ namespace LLError
 			return;
 		}
 		settings_w->recorders.push_back(recorder);
+		LogWriter::setRecorders(*settings_w);
 	}
 
 	void addRecorder(Recorder* recorder)
@@ -757,6 +808,7 @@ namespace LLError
 		settings_w->recorders.erase(
 			std::remove(settings_w->recorders.begin(), settings_w->recorders.end(), recorder),
 			settings_w->recorders.end());
+		LogWriter::setRecorders(*settings_w);
 	}
 
 	void removeRecorder(Recorder* recorder)
@@ -818,6 +870,31 @@ namespace LLError
 
 namespace
 {
+	// Used by the log writer thread, with the time that was taken when the message was logged.
+	void writeToRecorders(Recorders const& recorders, LLError::ELevel level, const std::string& time, const std::string& message)
+	{
+		std::string messageWithTime;
+
+		for (Recorders::const_iterator i = recorders.begin(); i != recorders.end(); ++i)
+		{
+			LLError::Recorder* r = *i;
+
+			if (r->wantsTime() && !time.empty())
+			{
+				if (messageWithTime.empty())
+				{
+					messageWithTime = time + " " + message;
+				}
+
+				r->recordMessage(level, messageWithTime);
+			}
+			else
+			{
+				r->recordMessage(level, message);
+			}
+		}
+	}
+
 	void writeToRecorders(AIAccess<LLError::Settings> const& settings_w, LLError::ELevel level, const std::string& message)
 	{
 		std::string messageWithTime;
@@ -845,6 +922,266 @@ namespace
 	}
 }
 
+namespace
+{
+	// The queue of log messages of one thread, for the log writer thread.
+	// It is only written by the thread that owns it (while holding the Settings lock)
+	// and only read while holding LogWriter::sRecordersMutex, so a ring buffer with
+	// atomic indices suffices. When it is full, messages are dropped and counted.
+	class LogBuffer
+	{
+	public:
+		enum { SIZE = 256 };
+
+		struct Entry
+		{
+			U32 mSequence;						// Order of the message among the messages of all threads.
+			LLError::ELevel mLevel;
+			std::string mTime;					// The time at which it was logged, if there is a time function.
+			std::string mMessage;
+		};
+
+		LogBuffer(std::string const& thread_name) : mThreadName(thread_name), mExited(false), mHead(0), mTail(0), mDropped(0) { }
+
+		// Called by the owning thread. Takes the contents of time and message.
+		void push(U32 sequence, LLError::ELevel level, std::string& time, std::string& message)
+		{
+			U32 head = mHead;
+			if (head - mTail == SIZE)
+			{
+				mDropped++;
+				return;
+			}
+			Entry& entry(mEntries[head % SIZE]);
+			entry.mSequence = sequence;
+			entry.mLevel = level;
+			entry.mTime.swap(time);
+			entry.mMessage.swap(message);
+			mHead = head + 1;					// Publish the entry.
+		}
+
+		// Called by the log writer. Moves all queued entries to the end of entries,
+		// and returns the number of messages that were dropped since the last call.
+		U32 pop_all(std::vector<Entry>& entries)
+		{
+			U32 tail = mTail;
+			U32 head = mHead;
+			for (; tail != head; ++tail)
+			{
+				Entry& entry(mEntries[tail % SIZE]);
+				entries.push_back(Entry());
+				Entry& copy(entries.back());
+				copy.mSequence = entry.mSequence;
+				copy.mLevel = entry.mLevel;
+				copy.mTime.swap(entry.mTime);
+				copy.mMessage.swap(entry.mMessage);
+			}
+			mTail = tail;						// Release the entries.
+			U32 dropped = mDropped;
+			if (dropped)
+			{
+				mDropped -= dropped;
+			}
+			return dropped;
+		}
+
+		std::string const mThreadName;
+		bool mExited;							// Set when the thread exited. Protected by sLogBuffersMutex.
+
+	private:
+		Entry mEntries[SIZE];
+		LLAtomicU32 mHead;						// Index of the next entry to write; only changed by the owning thread.
+		LLAtomicU32 mTail;						// Index of the next entry to read; only changed by the log writer.
+		LLAtomicU32 mDropped;
+	};
+
+	// The LogBuffer objects are owned by sLogBuffers, not by the threads, so that the
+	// messages of a thread that exited can still be written; they are deleted after that.
+	typedef std::vector<LogBuffer*> log_buffers_t;
+	log_buffers_t sLogBuffers;
+	LLGlobalMutex sLogBuffersMutex;				// Protects sLogBuffers and LogBuffer::mExited.
+
+	// Stored in LLThreadLocalData to find the LogBuffer of the current thread, and to tell when the thread exits.
+	class LogBufferHolder : public LLThreadLocalDataMember
+	{
+	public:
+		LogBufferHolder(LogBuffer* buffer) : mBuffer(buffer) { }
+		/*virtual*/ ~LogBufferHolder()
+		{
+			LLMutexLock lock(sLogBuffersMutex);
+			mBuffer->mExited = true;
+		}
+
+		LogBuffer* const mBuffer;
+	};
+
+	class LogWriterThread : public LLThread
+	{
+	public:
+		LogWriterThread(void) : LLThread("log writer") { }
+
+	protected:
+		/*virtual*/ void run(void)
+		{
+			while (!isQuitting())
+			{
+				ms_sleep(WRITE_INTERVAL_MS);
+				LLMutexLock lock(LogWriter::sRecordersMutex);
+				LogWriter::write();
+			}
+		}
+
+	private:
+		// Polling keeps the threads that log from ever having to wake up this thread.
+		static int const WRITE_INTERVAL_MS = 20;
+	};
+
+	bool LogWriter::sRunning;
+	LLGlobalMutex LogWriter::sRecordersMutex;
+	Recorders LogWriter::sRecorders;
+	LLError::TimeFunction LogWriter::sTimeFunction;
+	U32 LogWriter::sSequence;
+	LLThread* LogWriter::sThread;
+
+	//static
+	void LogWriter::start(void)
+	{
+		{
+			AIAccess<LLError::Settings> settings_w(LLError::Settings::get());
+			if (sRunning)
+			{
+				return;
+			}
+			sRunning = true;
+			setRecorders(*settings_w);
+		}
+		sThread = new LogWriterThread;
+		sThread->start();
+	}
+
+	//static
+	void LogWriter::stop(void)
+	{
+		LLThread* thread = sThread;
+		sThread = NULL;
+		thread->shutdown();
+		delete thread;
+		{
+			// Holding the Settings lock guarantees that nobody is queuing a message right now,
+			// and that after this everything is written directly again.
+			AIAccess<LLError::Settings> settings_w(LLError::Settings::get());
+			LLMutexLock lock(sRecordersMutex);
+			write();
+			sRunning = false;
+			sRecorders.clear();
+		}
+	}
+
+	//static
+	void LogWriter::setRecorders(LLError::Settings const& settings)
+	{
+		if (!sRunning)
+		{
+			return;
+		}
+		LLMutexLock lock(sRecordersMutex);
+		sRecorders = settings.recorders;
+		sTimeFunction = settings.timeFunction;
+	}
+
+	//static
+	bool LogWriter::push(LLError::Settings const& settings, LLError::ELevel level, std::string& message)
+	{
+		// Threads that were not started by LLThread (and the main thread before
+		// LLThreadLocalData::init) have nowhere to store their LogBuffer.
+		LLThreadLocalData* tldata = LLThreadLocalData::peek();
+		if (!tldata)
+		{
+			return false;
+		}
+		if (!tldata->mLogBuffer)
+		{
+			LogBuffer* buffer = new LogBuffer(tldata->mName);
+			LLMutexLock lock(sLogBuffersMutex);
+			sLogBuffers.push_back(buffer);
+			tldata->mLogBuffer = new LogBufferHolder(buffer);
+		}
+		// The time is taken now, not when the message is written.
+		std::string time;
+		if (settings.timeFunction)
+		{
+			time = settings.timeFunction();
+		}
+		static_cast<LogBufferHolder*>(tldata->mLogBuffer)->mBuffer->push(sSequence++, level, time, message);
+		return true;
+	}
+
+	// Wrap-around safe ordering of LogBuffer::Entry::mSequence.
+	struct EntryLess
+	{
+		bool operator()(LogBuffer::Entry const& lhs, LogBuffer::Entry const& rhs) const { return (S32)(lhs.mSequence - rhs.mSequence) < 0; }
+	};
+
+	//static
+	void LogWriter::write(void)
+	{
+		static std::vector<LogBuffer::Entry> entries;			// Protected by sRecordersMutex.
+		std::vector<std::string> dropped_messages;
+		{
+			LLMutexLock lock(sLogBuffersMutex);
+			log_buffers_t::iterator buffer = sLogBuffers.begin();
+			while (buffer != sLogBuffers.end())
+			{
+				U32 dropped = (*buffer)->pop_all(entries);
+				if (dropped)
+				{
+					std::ostringstream msg;
+					msg << "WARNING: log buffer of thread \"" << (*buffer)->mThreadName << "\" was full; " << dropped << " messages were dropped.";
+					dropped_messages.push_back(msg.str());
+				}
+				if ((*buffer)->mExited)
+				{
+					// The thread is gone, so nothing will be added anymore.
+					delete *buffer;
+					buffer = sLogBuffers.erase(buffer);
+				}
+				else
+				{
+					++buffer;
+				}
+			}
+		}
+		std::sort(entries.begin(), entries.end(), EntryLess());
+		for (std::vector<LogBuffer::Entry>::iterator entry = entries.begin(); entry != entries.end(); ++entry)
+		{
+			writeToRecorders(sRecorders, entry->mLevel, entry->mTime, entry->mMessage);
+		}
+		entries.clear();
+		for (std::vector<std::string>::iterator msg = dropped_messages.begin(); msg != dropped_messages.end(); ++msg)
+		{
+			writeToRecorders(sRecorders, LLError::LEVEL_WARN, sTimeFunction ? sTimeFunction() : std::string(), *msg);
+		}
+	}
+
+	// Pass message to the recorders, or queue it for the log writer thread if that runs.
+	// Fatal errors are always written before returning, after everything that was queued.
+	void recordMessage(AIAccess<LLError::Settings> const& settings_w, LLError::ELevel level, std::string& message)
+	{
+		if (!LogWriter::sRunning)
+		{
+			writeToRecorders(settings_w, level, message);
+			return;
+		}
+		if (level != LLError::LEVEL_ERROR && LogWriter::push(*settings_w, level, message))
+		{
+			return;
+		}
+		LLMutexLock lock(LogWriter::sRecordersMutex);
+		LogWriter::write();
+		writeToRecorders(settings_w, level, message);
+	}
+}
+
 
 /*
 Recorder formats:
@@ -1064,7 +1401,8 @@ namespace LLError
 			fatalMessage << abbreviateFile(site.mFile)
 						<< "(" << site.mLine << ") : error";
 			
-			writeToRecorders(settings_w, site.mLevel, fatalMessage.str());
+			std::string fatal = fatalMessage.str();
+			recordMessage(settings_w, site.mLevel, fatal);
 		}
 		
 		
@@ -1165,7 +1503,7 @@ namespace LLError
 		prefix << message;
 		message = prefix.str();
 		
-		writeToRecorders(settings_w, site.mLevel, message);
+		recordMessage(settings_w, site.mLevel, message);
 		
 		if (site.mLevel == LEVEL_ERROR  &&  settings_w->crashFunction)
 		{
@@ -1181,6 +1519,19 @@ namespace LLError
 {
 	class ThreadSafeSettings { };
 
+	void startLogWriterThread()
+	{
+		LogWriter::start();
+	}
+
+	void stopLogWriterThread()
+	{
+		if (LogWriter::sRunning)
+		{
+			LogWriter::stop();
+		}
+	}
+
 	ThreadSafeSettings* saveAndResetSettings()
 	{
 		return reinterpret_cast<ThreadSafeSettings*>(Settings::saveAndReset());
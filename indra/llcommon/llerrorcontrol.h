@@ -165,6 +165,16 @@ namespace LLError
 	LL_COMMON_API std::string logFileName();
 		// returns name of current logging file, empty string if none
 
+	LL_COMMON_API void startLogWriterThread();
+	LL_COMMON_API void stopLogWriterThread();
+		// While the log writer thread runs, messages are queued per thread
+		// and written to the recorders by that thread, so that logging doesn't
+		// wait for I/O. If a thread logs faster than the messages are written,
+		// messages are dropped (and the number dropped is logged). Fatal errors
+		// are still written immediately, after everything that was queued.
+		// stopLogWriterThread() writes what is left and returns to writing
+		// every message synchronously.
+
 
 	/*
 		Utilities for use by the unit tests of LLError itself.
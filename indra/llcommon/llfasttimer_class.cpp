@@ -151,6 +151,7 @@
 #include "llsingleton.h"
 #include "lltreeiterators.h"
 #include "llsdserialize.h"
+#include "llthread.h"
 
 #include <boost/bind.hpp>
 
@@ -191,6 +192,7 @@ const int LLFastTimer::NamedTimer::HISTORY_NUM = 300;
 std::vector<LLFastTimer::FrameState>* LLFastTimer::sTimerInfos = NULL;
 U64				LLFastTimer::sTimerCycles = 0;
 U32				LLFastTimer::sTimerCalls = 0;
+bool			LLFastTimer::sTrace = false;
 
 
 // FIXME: move these declarations to the relevant modules
@@ -919,6 +921,204 @@ void LLFastTimer::writeLog(std::ostream& os)
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Tracing
+//
+// While sTrace is set, every LLFastTimer writes a begin and an end event to a ring
+// buffer of the thread that runs it, in any thread, so that stalls of one thread
+// on another become visible. Only the last ThreadLog::SIZE events per thread are kept.
+//
+// The ThreadLog objects are owned by sThreadLogs, not by the thread: the events of
+// threads that exited are written too. The logs of those threads are deleted by the
+// next startTrace().
+//
+// The ring buffers are not locked; the thread that owns it is the only one writing
+// to it, and writeChromeTrace() should only be called after stopTrace().
+
+class LLFastTimer::ThreadLog
+{
+public:
+	enum { SIZE = 1 << 16 };						// Events per thread (1 MB on 64-bit).
+	static U64 const END = (U64)1 << 63;			// Set in Event::mTime for the end of a timer.
+
+	struct Event
+	{
+		U64 mTime;									// getCPUClockCount64(), or'ed with END.
+		NamedTimer const* mTimer;
+	};
+
+	ThreadLog(std::string const& name, U32 id) : mName(name), mID(id), mCount(0), mExited(false), mEvents(new Event[SIZE]) { }
+	~ThreadLog() { delete [] mEvents; }
+
+	void record(U64 time, NamedTimer const* timer)
+	{
+		Event& event(mEvents[mCount & (SIZE - 1)]);
+		event.mTime = time;
+		event.mTimer = timer;
+		++mCount;
+	}
+
+	std::string const mName;						// The name of the thread.
+	U32 const mID;									// Thread id in the trace.
+	U32 mCount;										// The number of events recorded since startTrace().
+	bool mExited;									// Set when the thread exited. Protected by sThreadLogsMutex.
+	Event* mEvents;
+};
+
+typedef std::vector<LLFastTimer::ThreadLog*> thread_logs_t;
+static thread_logs_t sThreadLogs;
+static LLGlobalMutex sThreadLogsMutex;				// Protects sThreadLogs, sNextThreadLogID and ThreadLog::mExited.
+static U32 sNextThreadLogID = 1;
+static U64 sTraceStart;
+
+namespace {
+
+// Stored in LLThreadLocalData::mFastTimerLog; it is deleted when the thread exits.
+class ThreadLogHolder : public LLThreadLocalDataMember
+{
+public:
+	ThreadLogHolder(LLFastTimer::ThreadLog* log) : mLog(log) { }
+	/*virtual*/ ~ThreadLogHolder()
+	{
+		LLMutexLock lock(&sThreadLogsMutex);
+		mLog->mExited = true;
+	}
+
+	LLFastTimer::ThreadLog* const mLog;
+};
+
+LLFastTimer::ThreadLog* current_thread_log(void)
+{
+	LLThreadLocalData& tldata(LLThread::tldata());
+	if (LL_UNLIKELY(!tldata.mFastTimerLog))
+	{
+		LLMutexLock lock(&sThreadLogsMutex);
+		LLFastTimer::ThreadLog* log = new LLFastTimer::ThreadLog(tldata.mName, sNextThreadLogID++);
+		sThreadLogs.push_back(log);
+		tldata.mFastTimerLog = new ThreadLogHolder(log);
+	}
+	return static_cast<ThreadLogHolder*>(tldata.mFastTimerLog)->mLog;
+}
+
+// Timer names are plain text, but quote them anyway.
+void write_json_string(std::ostream& os, std::string const& str)
+{
+	os << '"';
+	for (std::string::const_iterator iter = str.begin(); iter != str.end(); ++iter)
+	{
+		if (*iter == '"' || *iter == '\\')
+		{
+			os << '\\';
+		}
+		if ((unsigned char)*iter >= 32)
+		{
+			os << *iter;
+		}
+	}
+	os << '"';
+}
+
+} // namespace
+
+//static
+void LLFastTimer::traceBegin(NamedTimer const* timer)
+{
+	current_thread_log()->record(getCPUClockCount64(), timer);
+}
+
+//static
+void LLFastTimer::traceEnd(NamedTimer const* timer)
+{
+	current_thread_log()->record(getCPUClockCount64() | ThreadLog::END, timer);
+}
+
+//static
+void LLFastTimer::startTrace()
+{
+	LLMutexLock lock(&sThreadLogsMutex);
+	if (sTrace)
+	{
+		return;
+	}
+	// Forget the previous trace, and the threads that no longer exist.
+	thread_logs_t::iterator log = sThreadLogs.begin();
+	while (log != sThreadLogs.end())
+	{
+		if ((*log)->mExited)
+		{
+			delete *log;
+			log = sThreadLogs.erase(log);
+		}
+		else
+		{
+			(*log)->mCount = 0;
+			++log;
+		}
+	}
+	sTraceStart = getCPUClockCount64();
+	sTrace = true;
+}
+
+//static
+void LLFastTimer::stopTrace()
+{
+	sTrace = false;
+}
+
+//static
+void LLFastTimer::writeChromeTrace(std::ostream& os)
+{
+	llassert(!sTrace);
+	// countsPerSecond() is for the 32-bit clock, which drops the lowest 8 bits.
+	F64 const usec_per_count = 1.0e6 / ((F64)countsPerSecond() * 256.0);
+	std::vector<ThreadLog::Event const*> stack;
+
+	std::ios_base::fmtflags old_flags = os.flags();
+	std::streamsize old_precision = os.precision();
+	os << std::fixed << std::setprecision(3);
+
+	LLMutexLock lock(&sThreadLogsMutex);
+	os << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (thread_logs_t::iterator log = sThreadLogs.begin(); log != sThreadLogs.end(); ++log)
+	{
+		ThreadLog const& thread_log(**log);
+		os << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread_log.mID << ",\"args\":{\"name\":";
+		write_json_string(os, thread_log.mName);
+		os << "}}";
+		first = false;
+
+		// Match the begin and end events; the ones that have no partner (because the begin event was
+		// overwritten, or the timer was already running when the trace started or still running when
+		// it stopped) are left out.
+		stack.clear();
+		U32 count = thread_log.mCount;
+		for (U32 i = count > ThreadLog::SIZE ? count - ThreadLog::SIZE : 0; i < count; ++i)
+		{
+			ThreadLog::Event const& event(thread_log.mEvents[i & (ThreadLog::SIZE - 1)]);
+			if (!(event.mTime & ThreadLog::END))
+			{
+				stack.push_back(&event);
+				continue;
+			}
+			if (stack.empty() || stack.back()->mTimer != event.mTimer)
+			{
+				continue;
+			}
+			ThreadLog::Event const& begin(*stack.back());
+			stack.pop_back();
+			os << ",\n{\"name\":";
+			write_json_string(os, begin.mTimer->getName());
+			os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread_log.mID
+			   << ",\"ts\":" << (S64)(begin.mTime - sTraceStart) * usec_per_count
+			   << ",\"dur\":" << (S64)((event.mTime & ~ThreadLog::END) - begin.mTime) * usec_per_count << "}";
+		}
+	}
+	os << "\n]}\n";
+	os.flags(old_flags);
+	os.precision(old_precision);
+}
+
 //static
 const LLFastTimer::NamedTimer* LLFastTimer::getTimerByName(const std::string& name)
 {
@@ -31,12 +31,12 @@
 
 #define FAST_TIMER_ON 1
 #define TIME_FAST_TIMERS 0
-#define DEBUG_FAST_TIMER_THREADS 1
 
 class LLMutex;
 
 #include <queue>
 #include "llsd.h"
+#include "aithreadid.h"
 
 LL_COMMON_API void assert_main_thread();
 
@@ -159,6 +159,18 @@ public:
 		U64 timer_start = getCPUClockCount64();
 #endif
 #if FAST_TIMER_ON
+		if (LL_UNLIKELY(sTrace))
+		{
+			traceBegin(&timer.mTimer);
+		}
+		if (LL_UNLIKELY(!AIThreadID::in_main_thread()))
+		{
+			// The frame states belong to the main thread; other threads only leave a trace.
+			// mLastTimerData is not used in that case, except to remember the timer for traceEnd().
+			mFrameState = NULL;
+			mLastTimerData.mNamedTimer = &timer.mTimer;
+			return;
+		}
 		LLFastTimer::FrameState* frame_state = mFrameState;
 		mStartTime = getCPUClockCount32();
 
@@ -177,11 +189,6 @@ public:
 #if TIME_FAST_TIMERS
 		U64 timer_end = getCPUClockCount64();
 		sTimerCycles += timer_end - timer_start;
-#endif
-#if DEBUG_FAST_TIMER_THREADS
-#if !LL_RELEASE
-		assert_main_thread();
-#endif
 #endif
 	}
 
@@ -192,6 +199,19 @@ public:
 #endif
 #if FAST_TIMER_ON
 		LLFastTimer::FrameState* frame_state = mFrameState;
+		if (LL_UNLIKELY(!frame_state))
+		{
+			// Not the main thread.
+			if (LL_UNLIKELY(sTrace))
+			{
+				traceEnd(mLastTimerData.mNamedTimer);
+			}
+			return;
+		}
+		if (LL_UNLIKELY(sTrace))
+		{
+			traceEnd(frame_state->mTimer);
+		}
 		U32 total_time = getCPUClockCount32() - mStartTime;
 
 		frame_state->mSelfTimeCounter += total_time - LLFastTimer::sCurTimerData.mChildTime;
@@ -223,6 +243,7 @@ public:
 	static bool 			sResetHistory;
 	static U64				sTimerCycles;
 	static U32				sTimerCalls;
+	static bool				sTrace;			// Set while recording the begin and end of timers in all threads.
 
 	typedef std::vector<FrameState> info_list_t;
 	static info_list_t& getFrameStateList();
@@ -246,6 +267,16 @@ public:
 	static S32 getCurFrameIndex() { return sCurFrameIndex; }
 
 	static void writeLog(std::ostream& os);
+
+	// Start recording the begin and end of every timer, in every thread, and forget what was recorded before.
+	static void startTrace();
+	// Stop recording. The recorded events are kept.
+	static void stopTrace();
+	// Write the recorded events in the JSON format of chrome://tracing. Call stopTrace() first.
+	static void writeChromeTrace(std::ostream& os);
+
+	// The ring buffer of trace events of one thread.
+	class ThreadLog;
 	static const NamedTimer* getTimerByName(const std::string& name);
 
 	struct CurTimerData
@@ -262,6 +293,9 @@ private:
 	static U32 getCPUClockCount32();
 	static U64 getCPUClockCount64();
 
+	static void traceBegin(NamedTimer const* timer);
+	static void traceEnd(NamedTimer const* timer);
+
 	static S32				sCurFrameIndex;
 	static S32				sLastFrameIndex;
 	static U64				sLastFrameTime;
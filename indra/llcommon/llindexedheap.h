@@ -0,0 +1,186 @@
+/**
+ * @file llindexedheap.h
+ * @brief A d-ary heap whose elements know their own position.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINDEXEDHEAP_H
+#define LL_LLINDEXEDHEAP_H
+
+#include <vector>
+
+#include "lldefs.h"
+#include "llerror.h"
+
+//============================================================================
+// LLIndexedHeap is a priority queue of pointers, like std::priority_queue,
+// except that every element stores its own index in the heap. That makes it
+// possible to remove an arbitrary element, or to restore the heap after the
+// priority of an element changed, in O(log n) without searching for it.
+//
+// T        is the (pointer) type of the elements.
+// Compare  is a functor; Compare()(a, b) returns true if a must be popped before b.
+// IndexOf  is a functor; IndexOf()(a) returns an S32& inside the element where the
+//          heap keeps the index of a. It is -1 while a isn't in a heap; the
+//          element must initialize it to -1.
+// D        is the number of children per node. A wider heap is shallower, which
+//          makes push and update cheaper and keeps siblings in one cache line.
+//
+// An element can be in only one LLIndexedHeap at a time. Not thread-safe.
+
+template<typename T, typename Compare, typename IndexOf, U32 D = 4>
+class LLIndexedHeap
+{
+public:
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	bool empty() const { return mHeap.empty(); }
+	U32 size() const { return mHeap.size(); }
+
+	// The element that pop() would return. The heap may not be empty.
+	T top() const { llassert(!mHeap.empty()); return mHeap.front(); }
+
+	// The elements, in no particular order.
+	const_iterator begin() const { return mHeap.begin(); }
+	const_iterator end() const { return mHeap.end(); }
+
+	// True if element is in a heap.
+	static bool contains(T element) { return IndexOf()(element) >= 0; }
+
+	void push(T element)
+	{
+		llassert(!contains(element));
+		mHeap.push_back(element);
+		siftUp(mHeap.size() - 1, element);
+	}
+
+	T pop()
+	{
+		T element = top();
+		erase(element);
+		return element;
+	}
+
+	void erase(T element)
+	{
+		S32& index = IndexOf()(element);
+		llassert(index >= 0 && index < (S32)mHeap.size() && mHeap[index] == element);
+		U32 hole = index;
+		index = -1;
+		T last = mHeap.back();
+		mHeap.pop_back();
+		if (hole < mHeap.size())
+		{
+			// Move the last element into the hole; it can go either way from there.
+			restore(hole, last);
+		}
+	}
+
+	// Call this after the priority of element changed.
+	void update(T element)
+	{
+		S32 index = IndexOf()(element);
+		llassert(index >= 0 && index < (S32)mHeap.size() && mHeap[index] == element);
+		restore(index, element);
+	}
+
+	void clear()
+	{
+		for (typename std::vector<T>::iterator iter = mHeap.begin(); iter != mHeap.end(); ++iter)
+		{
+			IndexOf()(*iter) = -1;
+		}
+		mHeap.clear();
+	}
+
+	void reserve(U32 size) { mHeap.reserve(size); }
+
+private:
+	void place(U32 index, T element)
+	{
+		mHeap[index] = element;
+		IndexOf()(element) = index;
+	}
+
+	// Put element, which belongs at hole, where it belongs.
+	void restore(U32 hole, T element)
+	{
+		if (hole > 0 && mCompare(element, mHeap[(hole - 1) / D]))
+		{
+			siftUp(hole, element);
+		}
+		else
+		{
+			siftDown(hole, element);
+		}
+	}
+
+	void siftUp(U32 hole, T element)
+	{
+		while (hole > 0)
+		{
+			U32 parent = (hole - 1) / D;
+			if (!mCompare(element, mHeap[parent]))
+			{
+				break;
+			}
+			place(hole, mHeap[parent]);
+			hole = parent;
+		}
+		place(hole, element);
+	}
+
+	void siftDown(U32 hole, T element)
+	{
+		U32 const size = mHeap.size();
+		while (true)
+		{
+			U32 first_child = hole * D + 1;
+			if (first_child >= size)
+			{
+				break;
+			}
+			U32 last_child = llmin(first_child + D, size);
+			U32 best = first_child;
+			for (U32 child = first_child + 1; child < last_child; ++child)
+			{
+				if (mCompare(mHeap[child], mHeap[best]))
+				{
+					best = child;
+				}
+			}
+			if (!mCompare(mHeap[best], element))
+			{
+				break;
+			}
+			place(hole, mHeap[best]);
+			hole = best;
+		}
+		place(hole, element);
+	}
+
+	std::vector<T> mHeap;
+	Compare mCompare;
+};
+
+#endif // LL_LLINDEXEDHEAP_H
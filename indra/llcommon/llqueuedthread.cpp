@@ -88,6 +88,10 @@ void LLQueuedThread::shutdown()
 		mStatus = STOPPED;
 	}
 
+	// The heap stores its indices in the requests; empty it before deleting them.
+	mRequestQueue.clear();
+	mPriorityUpdates.clear();
+
 	QueuedRequest* req;
 	S32 active_count = 0;
 	while ( (req = (QueuedRequest*)mRequestHash.pop_element()) )
@@ -197,7 +201,7 @@ void LLQueuedThread::printQueueStats()
 	lockData();
 	if (!mRequestQueue.empty())
 	{
-		QueuedRequest *req = *mRequestQueue.begin();
+		QueuedRequest *req = mRequestQueue.top();
 		llinfos << llformat("Pending Requests:%d Current status:%d", mRequestQueue.size(), req->getStatus()) << llendl;
 	}
 	else
@@ -230,7 +234,7 @@ bool LLQueuedThread::addRequest(QueuedRequest* req)
 	
 	lockData();
 	req->setStatus(STATUS_QUEUED);
-	mRequestQueue.insert(req);
+	mRequestQueue.push(req);
 	mRequestHash.insert(req);
 #if _DEBUG
 // 	llinfos << llformat("LLQueuedThread::Added req [%08d]",handle) << llendl;
@@ -332,10 +336,36 @@ void LLQueuedThread::setFlags(handle_t handle, U32 flags)
 	unlockData();
 }
 
+// May be called from any thread
 void LLQueuedThread::setPriority(handle_t handle, U32 priority)
 {
-	lockData();
-	QueuedRequest* req = (QueuedRequest*)mRequestHash.find(handle);
+	if (!mThreaded || &LLThread::tldata() == mThreadLocalData)
+	{
+		// Our own thread (ie, LLTextureFetchWorker::doWork), or there is no
+		// thread: nobody else is competing for the lock.
+		lockData();
+		applyPriority((QueuedRequest*)mRequestHash.find(handle), priority);
+		unlockData();
+		return;
+	}
+
+	bool apply_now;
+	{
+		LLMutexLock lock(&mPriorityMutex);
+		mPriorityUpdates.push_back(std::make_pair(handle, priority));
+		apply_now = mPriorityUpdates.size() >= MAX_PRIORITY_UPDATES;
+	}
+	if (apply_now)
+	{
+		// The thread isn't keeping up (or is paused); don't let the batch grow without bound.
+		lockData();
+		applyPriorityUpdates();
+		unlockData();
+	}
+}
+
+void LLQueuedThread::applyPriority(QueuedRequest* req, U32 priority)
+{
 	if (req)
 	{
 		if(req->getStatus() == STATUS_INPROGRESS)
@@ -343,15 +373,33 @@ void LLQueuedThread::setPriority(handle_t handle, U32 priority)
 			// not in list
 			req->setPriority(priority);
 		}
-		else if(req->getStatus() == STATUS_QUEUED)
+		else if(req->getStatus() == STATUS_QUEUED && req->getPriority() != priority)
 		{
-			// remove from list then re-insert
-			llverify(mRequestQueue.erase(req) == 1);
+			// move it to its new place in the heap
 			req->setPriority(priority);
-			mRequestQueue.insert(req);
+			mRequestQueue.update(req);
 		}
 	}
-	unlockData();
+}
+
+void LLQueuedThread::applyPriorityUpdates()
+{
+	// Swap the batch out, so that other threads can continue to add to it
+	// while we're applying it.
+	{
+		LLMutexLock lock(&mPriorityMutex);
+		if (mPriorityUpdates.empty())
+		{
+			return;
+		}
+		mApplyingPriorityUpdates.swap(mPriorityUpdates);
+	}
+	// Updates are applied in the order they were made, so the last one for a handle wins.
+	for (priority_updates_t::iterator iter = mApplyingPriorityUpdates.begin(); iter != mApplyingPriorityUpdates.end(); ++iter)
+	{
+		applyPriority((QueuedRequest*)mRequestHash.find(iter->first), iter->second);
+	}
+	mApplyingPriorityUpdates.clear();
 }
 
 bool LLQueuedThread::completeRequest(handle_t handle)
@@ -411,6 +459,7 @@ S32 LLQueuedThread::processNextRequest()
 	QueuedRequest *req;
 	// Get next request from pool
 	lockData();
+	applyPriorityUpdates();
 	while(1)
 	{
 		req = NULL;
@@ -418,8 +467,7 @@ S32 LLQueuedThread::processNextRequest()
 		{
 			break;
 		}
-		req = *mRequestQueue.begin();
-		mRequestQueue.erase(mRequestQueue.begin());
+		req = mRequestQueue.pop();
 		if ((req->getFlags() & FLAG_ABORT) || (mStatus == QUITTING))
 		{
 			req->setStatus(STATUS_ABORTED);
@@ -509,7 +557,7 @@ S32 LLQueuedThread::processNextRequest()
 		{
 			lockData();
 			req->setStatus(STATUS_QUEUED);
-			mRequestQueue.insert(req);
+			mRequestQueue.push(req);
 			unlockData();
 			if (mThreaded && start_priority < PRIORITY_NORMAL)
 			{
@@ -588,7 +636,8 @@ LLQueuedThread::QueuedRequest::QueuedRequest(LLQueuedThread::handle_t handle, U3
 	LLSimpleHashEntry<LLQueuedThread::handle_t>(handle),
 	mStatus(STATUS_UNKNOWN),
 	mPriority(priority),
-	mFlags(flags)
+	mFlags(flags),
+	mHeapIndex(-1)
 {
 }
 
@@ -30,12 +30,13 @@
 #include <queue>
 #include <string>
 #include <map>
-#include <set>
+#include <vector>
 
 #include "llapr.h"
 
 #include "llthread.h"
 #include "llsimplehash.h"
+#include "llindexedheap.h"
 
 //============================================================================
 // Note: ~LLQueuedThread is O(N) N=# of queued threads, assumed to be small
@@ -72,12 +73,16 @@ public:
 
 	typedef U32 handle_t;
 	
+protected:
+	struct queued_request_heap_index;
+
 	//------------------------------------------------------------------------
 public:
 
 	class LL_COMMON_API QueuedRequest : public LLSimpleHashEntry<handle_t>
 	{
 		friend class LLQueuedThread;
+		friend struct queued_request_heap_index;
 		
 	protected:
 		virtual ~QueuedRequest(); // use deleteRequest()
@@ -129,7 +134,7 @@ public:
 
 		void setPriority(U32 pri)
 		{
-			// Only do this on a request that is not in a queued list!
+			// Only do this on a request that is not in the queue, or call mRequestQueue.update(this) afterwards!
 			mPriority = pri;
 		};
 		
@@ -137,6 +142,7 @@ public:
 		LLAtomic32<status_t> mStatus;
 		U32 mPriority;
 		U32 mFlags;
+		S32 mHeapIndex;		// Position in mRequestQueue, or -1.
 	};
 
 protected:
@@ -144,10 +150,21 @@ protected:
 	{
 		bool operator()(const QueuedRequest* lhs, const QueuedRequest* rhs) const
 		{
-			return lhs->higherPriority(*rhs); // higher priority in front of queue (set)
+			return lhs->higherPriority(*rhs); // higher priority in front of queue (heap)
 		}
 	};
 
+	struct queued_request_heap_index
+	{
+		S32& operator()(QueuedRequest* req) const
+		{
+			return req->mHeapIndex;
+		}
+	};
+
+	// Maximum number of batched priority updates before the caller applies them itself.
+	enum { MAX_PRIORITY_UPDATES = 4096 };
+
 
 	//------------------------------------------------------------------------
 	
@@ -175,6 +192,8 @@ protected:
 	bool addRequest(QueuedRequest* req);
 	S32  processNextRequest(void);
 	void incQueue();
+	void applyPriorityUpdates();	// lockData() must be held.
+	void applyPriority(QueuedRequest* req, U32 priority);
 
 public:
 	bool waitForResult(handle_t handle, bool auto_complete = true);
@@ -206,9 +225,18 @@ protected:
 	BOOL mStarted;  // required when mThreaded is false to call startThread() from update()
 	LLAtomic32<BOOL> mIdleThread; // request queue is empty (or we are quitting) and the thread is idle
 	
-	typedef std::set<QueuedRequest*, queued_request_less> request_queue_t;
+	typedef LLIndexedHeap<QueuedRequest*, queued_request_less, queued_request_heap_index> request_queue_t;
 	request_queue_t mRequestQueue;
 
+	// setPriority() calls from other threads than our own are batched here, so that
+	// the caller doesn't have to wait for lockData() while the thread is using it.
+	// The batch is applied by the thread itself, before it takes the next request.
+	// Lock order: lockData() before mPriorityMutex.
+	typedef std::vector<std::pair<handle_t, U32> > priority_updates_t;
+	LLMutex mPriorityMutex;
+	priority_updates_t mPriorityUpdates;
+	priority_updates_t mApplyingPriorityUpdates;	// Only accessed with lockData() held.
+
 	enum { REQUEST_HASH_SIZE = 512 }; // must be power of 2
 	typedef LLSimpleHash<handle_t, REQUEST_HASH_SIZE> request_hash_t;
 	request_hash_t mRequestHash;
@@ -0,0 +1,84 @@
+/**
+ * @file llrowlayout.h
+ * @brief Cumulative heights of a list of rows, for finding the rows in a window.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLROWLAYOUT_H
+#define LL_LLROWLAYOUT_H
+
+#include <algorithm>
+#include <vector>
+
+#include "stdtypes.h"
+
+//============================================================================
+// LLRowLayout keeps the offsets of a list of rows that are laid out from the
+// top down, so that the rows that overlap a window (for example, the visible
+// part of a scrolled list) can be found with a binary search instead of by
+// looking at every row.
+//
+// Offsets are measured downwards from the top of the first row.
+//
+// Example usage:
+//   LLRowLayout layout;
+//   for (...) layout.addRow(row_height);
+//   U32 first, last;
+//   layout.getRowsIn(scroll_offset, scroll_offset + window_height, first, last);
+//   for (U32 row = first; row < last; ++row) ...
+
+class LLRowLayout
+{
+public:
+	LLRowLayout() { mOffsets.push_back(0); }
+
+	void clear(void) { mOffsets.resize(1); }
+	void reserve(U32 rows) { mOffsets.reserve(rows + 1); }
+
+	// Append a row; returns the offset of its top.
+	S32 addRow(S32 height)
+	{
+		S32 top = mOffsets.back();
+		mOffsets.push_back(top + height);
+		return top;
+	}
+
+	U32 size(void) const { return (U32)mOffsets.size() - 1; }
+	bool empty(void) const { return mOffsets.size() == 1; }
+	S32 getTop(U32 row) const { return mOffsets[row]; }
+	S32 getHeight(U32 row) const { return mOffsets[row + 1] - mOffsets[row]; }
+	S32 getTotalHeight(void) const { return mOffsets.back(); }
+
+	// Set [first, last) to the rows that overlap the offsets [top, bottom).
+	void getRowsIn(S32 top, S32 bottom, U32& first, U32& last) const
+	{
+		// The first row whose bottom is below top, up to the first row whose top is at or below bottom.
+		first = (U32)(std::upper_bound(mOffsets.begin() + 1, mOffsets.end(), top) - mOffsets.begin()) - 1;
+		last = (U32)(std::lower_bound(mOffsets.begin() + first, mOffsets.end() - 1, bottom) - mOffsets.begin());
+	}
+
+private:
+	std::vector<S32> mOffsets;			// The top of every row, followed by the bottom of the last one.
+};
+
+#endif // LL_LLROWLAYOUT_H
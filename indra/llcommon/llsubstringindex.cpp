@@ -0,0 +1,186 @@
+/**
+ * @file llsubstringindex.cpp
+ * @brief Implementation of LLSubstringIndex.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsubstringindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+// static
+void LLSubstringIndex::getTrigrams(std::string const& text, std::vector<U32>& trigrams)
+{
+	size_t const first = trigrams.size();
+	for (size_t i = 0; i + 2 < text.length(); ++i)
+	{
+		trigrams.push_back((U32)(U8)text[i] << 16 | (U32)(U8)text[i + 1] << 8 | (U32)(U8)text[i + 2]);
+	}
+	std::sort(trigrams.begin() + first, trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin() + first, trigrams.end()), trigrams.end());
+}
+
+void LLSubstringIndex::addTrigrams(U32 entry)
+{
+	std::vector<U32> trigrams;
+	getTrigrams(mEntries[entry].mText, trigrams);
+	for (std::vector<U32>::iterator trigram = trigrams.begin(); trigram != trigrams.end(); ++trigram)
+	{
+		// New entries are added at the end of mEntries, so this is usually a push_back.
+		entry_list_t& list(mTrigrams[*trigram]);
+		list.insert(std::lower_bound(list.begin(), list.end(), entry), entry);
+	}
+}
+
+void LLSubstringIndex::removeTrigrams(U32 entry)
+{
+	std::vector<U32> trigrams;
+	getTrigrams(mEntries[entry].mText, trigrams);
+	for (std::vector<U32>::iterator trigram = trigrams.begin(); trigram != trigrams.end(); ++trigram)
+	{
+		trigram_map_t::iterator list = mTrigrams.find(*trigram);
+		llassert_always(list != mTrigrams.end());
+		entry_list_t::iterator iter = std::lower_bound(list->second.begin(), list->second.end(), entry);
+		llassert_always(iter != list->second.end() && *iter == entry);
+		list->second.erase(iter);
+		if (list->second.empty())
+		{
+			mTrigrams.erase(list);
+		}
+	}
+}
+
+bool LLSubstringIndex::set(LLUUID const& id, std::string const& text)
+{
+	LLUUIDFlatMap<U32>::iterator iter = mEntryIndex.find(id);
+	U32 entry;
+	if (iter != mEntryIndex.end())
+	{
+		entry = iter->second;
+		if (mEntries[entry].mText == text)
+		{
+			return false;
+		}
+		removeTrigrams(entry);
+	}
+	else
+	{
+		if (mFreeEntries.empty())
+		{
+			entry = (U32)mEntries.size();
+			mEntries.push_back(Entry());
+		}
+		else
+		{
+			entry = mFreeEntries.back();
+			mFreeEntries.pop_back();
+		}
+		mEntries[entry].mID = id;
+		mEntryIndex[id] = entry;
+	}
+	mEntries[entry].mText = text;
+	addTrigrams(entry);
+	return true;
+}
+
+bool LLSubstringIndex::remove(LLUUID const& id)
+{
+	LLUUIDFlatMap<U32>::iterator iter = mEntryIndex.find(id);
+	if (iter == mEntryIndex.end())
+	{
+		return false;
+	}
+	U32 entry = iter->second;
+	removeTrigrams(entry);
+	mEntryIndex.erase(id);
+	mEntries[entry].mID.setNull();
+	// Release the memory of the text too.
+	std::string().swap(mEntries[entry].mText);
+	mFreeEntries.push_back(entry);
+	return true;
+}
+
+void LLSubstringIndex::clear(void)
+{
+	mEntries.clear();
+	mFreeEntries.clear();
+	mEntryIndex.clear();
+	mTrigrams.clear();
+}
+
+namespace
+{
+	struct LLShorterList
+	{
+		template<typename T>
+		bool operator()(T const* list1, T const* list2) const { return list1->size() < list2->size(); }
+	};
+}
+
+bool LLSubstringIndex::find(std::string const& substring, uuid_vec_t& matches) const
+{
+	if (!canFind(substring))
+	{
+		return false;
+	}
+
+	std::vector<U32> trigrams;
+	getTrigrams(substring, trigrams);
+	std::vector<entry_list_t const*> lists;
+	for (std::vector<U32>::iterator trigram = trigrams.begin(); trigram != trigrams.end(); ++trigram)
+	{
+		trigram_map_t::const_iterator list = mTrigrams.find(*trigram);
+		if (list == mTrigrams.end())
+		{
+			// No text has this trigram, so none contains the substring.
+			return true;
+		}
+		lists.push_back(&list->second);
+	}
+
+	// Intersect the lists, shortest first, until few enough candidates are left
+	// that comparing the substring with each of them is cheaper than going on.
+	std::sort(lists.begin(), lists.end(), LLShorterList());
+	entry_list_t candidates(*lists[0]);
+	entry_list_t intersection;
+	for (size_t i = 1; i < lists.size() && candidates.size() > 16; ++i)
+	{
+		intersection.clear();
+		std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(intersection));
+		candidates.swap(intersection);
+	}
+
+	// Having all trigrams of a longer substring doesn't mean having them in the right order.
+	bool const verify = substring.length() > MIN_SUBSTRING_LENGTH;
+	for (entry_list_t::iterator entry = candidates.begin(); entry != candidates.end(); ++entry)
+	{
+		Entry const& candidate(mEntries[*entry]);
+		if (!verify || candidate.mText.find(substring) != std::string::npos)
+		{
+			matches.push_back(candidate.mID);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file llsubstringindex.h
+ * @brief A trigram index for finding the texts that contain a substring.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSUBSTRINGINDEX_H
+#define LL_LLSUBSTRINGINDEX_H
+
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "stdtypes.h"
+#include "lluuid.h"
+#include "lluuidflatmap.h"
+
+//============================================================================
+// LLSubstringIndex holds a text per UUID and finds the UUIDs of all texts
+// that contain a given substring, without looking at every text.
+//
+// For every trigram (three consecutive bytes) it keeps the sorted list of
+// texts that contain it. A text can only contain the substring if it has all
+// trigrams of the substring, so find() intersects their lists, starting with
+// the shortest, and then only compares the substring with the few texts that
+// are left. Substrings shorter than a trigram can't be looked up this way;
+// find() returns false for those and the caller has to search the texts itself.
+//
+// The comparison is bytewise: the caller should normalize texts and
+// substrings the same way (for example with LLStringUtil::toUpper).
+//
+// Example usage:
+//   LLSubstringIndex index;
+//   index.set(item_id, upper_case_name);
+//   uuid_vec_t matches;
+//   if (index.find(upper_case_search_string, matches)) ...
+
+class LL_COMMON_API LLSubstringIndex
+{
+public:
+	enum { MIN_SUBSTRING_LENGTH = 3 };
+
+	LLSubstringIndex() { }
+
+	// Add the text of id, or replace it. Returns false if id already had this text.
+	bool set(LLUUID const& id, std::string const& text);
+	// Returns false if there was no text for id.
+	bool remove(LLUUID const& id);
+	void clear(void);
+
+	// The number of texts.
+	U32 size(void) const { return (U32)mEntryIndex.size(); }
+
+	// Append the ids of all texts that contain substring to matches, in no particular
+	// order. Returns false, without matches, if substring is too short to look up.
+	bool find(std::string const& substring, uuid_vec_t& matches) const;
+
+	static bool canFind(std::string const& substring) { return substring.length() >= MIN_SUBSTRING_LENGTH; }
+
+private:
+	struct Entry
+	{
+		LLUUID mID;
+		std::string mText;
+	};
+
+	typedef std::vector<U32> entry_list_t;				// Indices into mEntries, sorted.
+	typedef boost::unordered_map<U32, entry_list_t> trigram_map_t;
+
+	// Append the unique trigrams of text to trigrams, sorted.
+	static void getTrigrams(std::string const& text, std::vector<U32>& trigrams);
+
+	void addTrigrams(U32 entry);
+	void removeTrigrams(U32 entry);
+
+	std::vector<Entry> mEntries;
+	std::vector<U32> mFreeEntries;						// Indices of unused elements of mEntries.
+	LLUUIDFlatMap<U32> mEntryIndex;						// Index into mEntries, by id.
+	trigram_map_t mTrigrams;
+};
+
+#endif // LL_LLSUBSTRINGINDEX_H
@@ -297,7 +297,7 @@ void LLThread::wakeLocked()
 // The thread private handle to access the LLThreadLocalData instance.
 apr_threadkey_t* LLThreadLocalData::sThreadLocalDataKey;
 
-LLThreadLocalData::LLThreadLocalData(char const* name) : mCurlMultiHandle(NULL), mCurlErrorBuffer(NULL), mName(name)
+LLThreadLocalData::LLThreadLocalData(char const* name) : mCurlMultiHandle(NULL), mCurlErrorBuffer(NULL), mName(name), mThreadPool(NULL), mThreadPoolIndex(-1), mFastTimerLog(NULL), mLogBuffer(NULL)
 {
 }
 
@@ -305,6 +305,8 @@ LLThreadLocalData::~LLThreadLocalData()
 {
   delete mCurlMultiHandle;
   delete [] mCurlErrorBuffer;
+  delete mFastTimerLog;
+  delete mLogBuffer;
 }
 
 //static
@@ -362,6 +364,19 @@ LLThreadLocalData& LLThreadLocalData::tldata(void)
 	return *static_cast<LLThreadLocalData*>(data);
 }
 
+//static
+LLThreadLocalData* LLThreadLocalData::peek(void)
+{
+	if (!sThreadLocalDataKey)
+	{
+		return NULL;
+	}
+
+	void* data;
+	apr_status_t status = apr_threadkey_private_get(&data, sThreadLocalDataKey);
+	return status == APR_SUCCESS ? static_cast<LLThreadLocalData*>(data) : NULL;
+}
+
 //============================================================================
 
 #if defined(NEEDS_MUTEX_IMPL)
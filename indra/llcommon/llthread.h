@@ -49,6 +49,7 @@
 class LLThread;
 class LLMutex;
 class LLCondition;
+class LLThreadPool;
 
 class LL_COMMON_API LLThreadLocalDataMember
 {
@@ -68,11 +69,18 @@ public:
 	LLThreadLocalDataMember* mCurlMultiHandle;	// Initialized by AICurlMultiHandle::getInstance
 	char* mCurlErrorBuffer;						// NULL, or pointing to a buffer used by libcurl.
 	std::string mName;							// "main thread", or a copy of LLThread::mName.
+	LLThreadPool* mThreadPool;					// The pool that this thread is a worker of, or NULL.
+	S32 mThreadPoolIndex;						// The index of this worker in mThreadPool.
+	LLThreadLocalDataMember* mFastTimerLog;		// Initialized by LLFastTimer when tracing.
+	LLThreadLocalDataMember* mLogBuffer;		// Initialized by LLError while the log writer thread runs.
 
 	static void init(void);
 	static void destroy(void* thread_local_data);
 	static void create(LLThread* pthread);
 	static LLThreadLocalData& tldata(void);
+	// Like tldata(), but returns NULL instead of creating anything: before init(),
+	// and in threads that were not started by LLThread.
+	static LLThreadLocalData* peek(void);
 
 private:
 	LLThreadLocalData(char const* name);
@@ -0,0 +1,307 @@
+/**
+ * @file llthreadpool.cpp
+ * @brief A fixed size pool of worker threads that run queued jobs.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llthreadpool.h"
+
+#include "llformat.h"
+#include "llstl.h"
+
+#if LL_WINDOWS
+#	define WIN32_LEAN_AND_MEAN
+#	include <winsock2.h>
+#	include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+//============================================================================
+
+// MAIN THREAD
+LLThreadPool::LLThreadPool(std::string const& name, S32 num_threads) :
+	mSleeping(0),
+	mQuitting(0),
+	mNextWorker(0),
+	mQueueDepth(0),
+	mActiveCount(0),
+	mStealCount(0)
+{
+	if (num_threads <= 0)
+	{
+		num_threads = getDefaultThreadCount();
+	}
+	num_threads = llmin(num_threads, (S32)MAX_THREADS);
+	mWorkers.reserve(num_threads);
+	for (S32 i = 0; i < num_threads; ++i)
+	{
+		mWorkers.push_back(new Worker(llformat("%s %d", name.c_str(), i), *this, i));
+	}
+	// Only start the threads once mWorkers is complete, they steal from each other.
+	for (S32 i = 0; i < num_threads; ++i)
+	{
+		mWorkers[i]->start();
+	}
+	llinfos << "Started thread pool \"" << name << "\" with " << num_threads << " threads." << llendl;
+}
+
+// MAIN THREAD
+LLThreadPool::~LLThreadPool()
+{
+	shutdown();
+}
+
+// MAIN THREAD
+void LLThreadPool::shutdown(void)
+{
+	mSleepCondition.lock();
+	mQuitting = 1;
+	mSleepCondition.broadcast();
+	mSleepCondition.unlock();
+
+	// Discard everything that is still queued. Because mQuitting is set,
+	// post() won't add anything anymore once we had the lock of a queue.
+	for (std::vector<Worker*>::iterator worker = mWorkers.begin(); worker != mWorkers.end(); ++worker)
+	{
+		(*worker)->mQueueMutex.lock();
+		for (std::deque<LLPointer<Job> >::iterator iter = (*worker)->mQueue.begin(); iter != (*worker)->mQueue.end(); ++iter)
+		{
+			if ((*iter)->mGroup)
+			{
+				(*iter)->mGroup->done();
+			}
+		}
+		mQueueDepth -= (S32)(*worker)->mQueue.size();
+		(*worker)->mQueue.clear();
+		(*worker)->mQueueMutex.unlock();
+	}
+
+	// ~LLThread waits (a bounded time) for each thread to leave run().
+	for_each(mWorkers.begin(), mWorkers.end(), DeletePointer());
+	mWorkers.clear();
+}
+
+bool LLThreadPool::post(Job* job, Group* group)
+{
+	LLPointer<Job> keep(job);	// Make sure the job is deleted when we drop it.
+	if (mWorkers.empty())
+	{
+		return false;
+	}
+
+	// Jobs posted by one of our own workers stay with that worker.
+	LLThreadLocalData& tldata = LLThread::tldata();
+	S32 index = tldata.mThreadPool == this ? tldata.mThreadPoolIndex : (S32)(mNextWorker++ % mWorkers.size());
+	Worker* worker = mWorkers[index];
+
+	worker->mQueueMutex.lock();
+	bool accepted = !mQuitting;
+	if (accepted)
+	{
+		if (group)
+		{
+			job->mGroup = group;
+			group->add(this);
+		}
+		worker->mQueue.push_back(keep);
+		mQueueDepth++;
+	}
+	worker->mQueueMutex.unlock();
+
+	// A worker increments mSleeping before it checks mQueueDepth, so if we see
+	// zero here then it will see the job that we just added.
+	if (accepted && mSleeping > 0)
+	{
+		mSleepCondition.lock();
+		mSleepCondition.signal();
+		mSleepCondition.unlock();
+	}
+	return accepted;
+}
+
+bool LLThreadPool::popJob(S32 index, bool steal, LLPointer<Job>& job)
+{
+	Worker* worker = mWorkers[index];
+	worker->mQueueMutex.lock();
+	bool have_job = !worker->mQueue.empty();
+	if (have_job)
+	{
+		if (steal)
+		{
+			job = worker->mQueue.back();
+			worker->mQueue.pop_back();
+		}
+		else
+		{
+			job = worker->mQueue.front();
+			worker->mQueue.pop_front();
+		}
+		mQueueDepth -= 1;
+	}
+	worker->mQueueMutex.unlock();
+	return have_job;
+}
+
+// WORKER THREAD
+bool LLThreadPool::nextJob(S32 index, LLPointer<Job>& job)
+{
+	S32 const num_workers = (S32)mWorkers.size();
+	while (!mQuitting)
+	{
+		if (popJob(index, false, job))
+		{
+			return true;
+		}
+		for (S32 i = 1; i < num_workers; ++i)
+		{
+			if (popJob((index + i) % num_workers, true, job))
+			{
+				mStealCount++;
+				return true;
+			}
+		}
+
+		mSleepCondition.lock();
+		mSleeping++;
+		while (mQueueDepth == 0 && !mQuitting)
+		{
+			mSleepCondition.wait();
+		}
+		mSleeping -= 1;
+		mSleepCondition.unlock();
+	}
+	return false;
+}
+
+bool LLThreadPool::popGroupJob(Group* group, LLPointer<Job>& job)
+{
+	for (std::vector<Worker*>::iterator worker = mWorkers.begin(); worker != mWorkers.end(); ++worker)
+	{
+		(*worker)->mQueueMutex.lock();
+		std::deque<LLPointer<Job> >& queue = (*worker)->mQueue;
+		// The jobs of a group were usually posted last, so look from the back.
+		for (std::deque<LLPointer<Job> >::reverse_iterator iter = queue.rbegin(); iter != queue.rend(); ++iter)
+		{
+			if ((*iter)->mGroup == group)
+			{
+				job = *iter;
+				queue.erase(--iter.base());
+				mQueueDepth -= 1;
+				(*worker)->mQueueMutex.unlock();
+				return true;
+			}
+		}
+		(*worker)->mQueueMutex.unlock();
+	}
+	return false;
+}
+
+void LLThreadPool::runJob(LLPointer<Job>& job)
+{
+	mActiveCount++;
+	job->run();
+	Group* group = job->mGroup;
+	job = NULL;		// Release the job in this thread.
+	mActiveCount -= 1;
+	if (group)
+	{
+		group->done();
+	}
+}
+
+// WORKER THREAD
+//virtual
+void LLThreadPool::Worker::run(void)
+{
+	LLThreadLocalData& tldata = LLThread::tldata();
+	tldata.mThreadPool = &mPool;
+	tldata.mThreadPoolIndex = mIndex;
+
+	LLPointer<Job> job;
+	while (!isQuitting() && mPool.nextJob(mIndex, job))
+	{
+		mPool.runJob(job);
+	}
+
+	tldata.mThreadPool = NULL;
+}
+
+void LLThreadPool::Group::add(LLThreadPool* pool)
+{
+	mCondition.lock();
+	llassert(!mPending || mPool == pool);
+	mPool = pool;
+	++mPending;
+	mCondition.unlock();
+}
+
+void LLThreadPool::Group::done(void)
+{
+	mCondition.lock();
+	if (--mPending == 0)
+	{
+		mCondition.broadcast();
+	}
+	mCondition.unlock();
+}
+
+void LLThreadPool::Group::wait(void)
+{
+	// Don't just sleep until the workers get to our jobs, they may be busy with other ones:
+	// run what they didn't start yet here, then wait for the jobs that are running.
+	// Only look at the pool while jobs are pending, a finished group may outlive its pool.
+	mCondition.lock();
+	LLThreadPool* pool = mPending > 0 ? mPool : NULL;
+	mCondition.unlock();
+	if (pool)
+	{
+		LLPointer<Job> job;
+		while (pool->popGroupJob(this, job))
+		{
+			pool->runJob(job);
+		}
+	}
+
+	mCondition.lock();
+	while (mPending > 0)
+	{
+		mCondition.wait();
+	}
+	mCondition.unlock();
+}
+
+//static
+S32 LLThreadPool::getDefaultThreadCount(void)
+{
+	S32 cores;
+#if LL_WINDOWS
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	cores = (S32)sysinfo.dwNumberOfProcessors;
+#else
+	cores = (S32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return llclamp(cores, 1, (S32)MAX_THREADS);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file llthreadpool.h
+ * @brief A fixed size pool of worker threads that run queued jobs.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTHREADPOOL_H
+#define LL_LLTHREADPOOL_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "llthread.h"
+#include "llpointer.h"
+
+//============================================================================
+// LLThreadPool runs independent jobs on a fixed number of LLThreads.
+//
+// Every worker has its own queue. Jobs posted from outside the pool are
+// spread round robin over the workers; jobs posted by a job are added to
+// the queue of the worker that runs it. A worker runs the jobs of its own
+// queue in order and, when that is empty, steals from the back of the
+// queue of another worker. As a result jobs may start and finish in any
+// order, so anything that must be serialized has to be serialized by the
+// job itself.
+//
+// Jobs are reference counted; the pool holds a reference until Job::run()
+// returned.
+//
+// Example usage:
+//   class MyJob : public LLThreadPool::Job { /*virtual*/ void run() { ... } };
+//   LLThreadPool pool("my pool");		// One thread per core.
+//   pool.post(new MyJob);
+//
+// To wait for a number of jobs to finish, post them with a Group:
+//   LLThreadPool::Group group;
+//   for (...) pool.post(new MyJob, &group);
+//   group.wait();				// Returns once every job posted with group has run.
+// While waiting, wait() runs the jobs of the group that no worker started yet
+// on the calling thread, so it doesn't depend on how busy the workers are.
+
+class LL_COMMON_API LLThreadPool
+{
+public:
+	class Group;
+
+	class LL_COMMON_API Job : public LLThreadSafeRefCount
+	{
+	protected:
+		virtual ~Job() { }		// use unref()
+
+	public:
+		Job(void) : mGroup(NULL) { }
+
+		// Called from a WORKER thread.
+		virtual void run(void) = 0;
+
+	private:
+		friend class LLThreadPool;
+		Group* mGroup;
+	};
+
+	// Counts the jobs posted with it that didn't finish yet.
+	// A Group must outlive its jobs; the destructor waits for them.
+	// The jobs of a group must all be posted to the same pool.
+	class LL_COMMON_API Group
+	{
+	public:
+		Group(void) : mPool(NULL), mPending(0) { }
+		~Group() { wait(); }
+
+		// Block until all jobs posted with this group have run (or were discarded).
+		// Jobs of this group that are still queued are run on the calling thread.
+		void wait(void);
+
+	private:
+		friend class LLThreadPool;
+		void add(LLThreadPool* pool);
+		void done(void);
+
+		LLCondition mCondition;		// Protects mPool and mPending.
+		LLThreadPool* mPool;		// The pool that the jobs were posted to.
+		S32 mPending;
+	};
+
+	// A num_threads of zero means one thread per core (see getDefaultThreadCount()).
+	LLThreadPool(std::string const& name, S32 num_threads = 0);
+	~LLThreadPool();
+
+	// Add a job to a queue. May be called from any thread, including from Job::run().
+	// Returns false (and drops the job) when the pool is shutting down.
+	// If group is not NULL, the job is counted by it until it finished.
+	bool post(Job* job, Group* group = NULL);
+
+	// Stop all worker threads. Jobs that didn't start yet are discarded.
+	void shutdown(void);
+
+	// Number of jobs that are queued, but not yet started.
+	S32 getQueueDepth(void) const { return mQueueDepth; }
+	// Number of jobs that are currently running.
+	S32 getActiveCount(void) const { return mActiveCount; }
+	// Number of jobs that were run by another worker than the one they were queued for.
+	U32 getStealCount(void) const { return mStealCount; }
+	S32 getThreadCount(void) const { return (S32)mWorkers.size(); }
+
+	// The number of hardware threads, clamped to [1, MAX_THREADS].
+	static S32 getDefaultThreadCount(void);
+
+	enum { MAX_THREADS = 16 };	// LLThread asserts if there are ever more than 50 threads.
+
+private:
+	// No copy constructor or copy assignment
+	LLThreadPool(LLThreadPool const&);
+	LLThreadPool& operator=(LLThreadPool const&);
+
+	class Worker : public LLThread
+	{
+	public:
+		Worker(std::string const& name, LLThreadPool& pool, S32 index) : LLThread(name), mPool(pool), mIndex(index) { }
+
+		LLMutex mQueueMutex;						// Protects mQueue.
+		std::deque<LLPointer<Job> > mQueue;
+
+	protected:
+		/*virtual*/ void run(void);
+
+	private:
+		LLThreadPool& mPool;
+		S32 mIndex;
+	};
+
+	// Called from WORKER thread. Blocks until a job is available; returns false when the thread should exit.
+	bool nextJob(S32 index, LLPointer<Job>& job);
+	// Pop a job from the front of the queue of worker index, or from the back of any other queue if steal is set.
+	bool popJob(S32 index, bool steal, LLPointer<Job>& job);
+	// Remove a queued job of group from any queue, starting at the back.
+	bool popGroupJob(Group* group, LLPointer<Job>& job);
+	// Run job on the calling thread, release it and count it as done by its group.
+	void runJob(LLPointer<Job>& job);
+
+	std::vector<Worker*> mWorkers;
+	LLCondition mSleepCondition;				// Idle workers wait for this.
+	LLAtomicS32 mSleeping;						// Number of workers waiting for mSleepCondition.
+	LLAtomicU32 mQuitting;
+	LLAtomicU32 mNextWorker;					// Round robin counter for jobs posted from outside the pool.
+	LLAtomicS32 mQueueDepth;
+	LLAtomicS32 mActiveCount;
+	LLAtomicU32 mStealCount;
+};
+
+#endif // LL_LLTHREADPOOL_H
@@ -0,0 +1,272 @@
+/**
+ * @file lltimerwheel.cpp
+ * @brief Implementation of LLTimerWheel.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltimerwheel.h"
+
+#if LL_MSVC
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the lowest set bit; bits may not be zero.
+	inline U32 lowest_bit(U32 bits)
+	{
+#if LL_MSVC
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return index;
+#else
+		return __builtin_ctz(bits);
+#endif
+	}
+}
+
+LLTimerWheel::LLTimerWheel(void) : mNext(0), mSize(0)
+{
+	memset(mBitmap, 0, sizeof(mBitmap));
+}
+
+LLTimerWheel::~LLTimerWheel()
+{
+	// The owners of the nodes must have removed them.
+	llassert(mSize == 0);
+}
+
+void LLTimerWheel::insert(Node* node, U64 expire, U64 now)
+{
+	llassert(!node->isQueued());
+	if (mSize == 0 && now >= mNext)
+	{
+		// Nothing is waiting for the ticks in between; skip them.
+		mNext = now + 1;
+	}
+	node->mExpire = expire;
+	place(node);
+	++mSize;
+}
+
+void LLTimerWheel::remove(Node* node)
+{
+	if (!node->isQueued())
+	{
+		return;
+	}
+	U32 slot = node->mSlot;
+	node->unlink();
+	if (slot != NOT_IN_WHEEL)
+	{
+		--mSize;
+		if (slot < OVERFLOW_SLOT && mSlots[slot].empty())
+		{
+			mBitmap[slot / LEVEL_SIZE][(slot & LEVEL_MASK) / 32] &= ~(1U << (slot & 31));
+		}
+	}
+}
+
+void LLTimerWheel::place(Node* node)
+{
+	U64 expire = node->mExpire;
+	if (expire < mNext)
+	{
+		mDue.push_back(node, DUE_SLOT);
+		return;
+	}
+	U64 delta = expire - mNext;
+	for (U32 level = 0; level < LEVELS; ++level)
+	{
+		U32 shift = LEVEL_BITS * level;
+		if (delta < ((U64)1 << (shift + LEVEL_BITS)))
+		{
+			U32 index = (U32)(expire >> shift) & LEVEL_MASK;
+			mSlots[level * LEVEL_SIZE + index].push_back(node, level * LEVEL_SIZE + index);
+			mBitmap[level][index / 32] |= 1U << (index & 31);
+			return;
+		}
+	}
+	mOverflow.push_back(node, OVERFLOW_SLOT);
+}
+
+void LLTimerWheel::expire(U32 slot_index, List& expired)
+{
+	List& list(slot(slot_index));
+	while (!list.empty())
+	{
+		Node* node = list.pop_front();
+		expired.push_back(node, NOT_IN_WHEEL);
+		--mSize;
+	}
+	if (slot_index < OVERFLOW_SLOT)
+	{
+		mBitmap[0][slot_index / 32] &= ~(1U << (slot_index & 31));
+	}
+}
+
+void LLTimerWheel::cascade(void)
+{
+	List pending;
+	for (U32 level = 1; level < LEVELS; ++level)
+	{
+		U32 index = (U32)(mNext >> (LEVEL_BITS * level)) & LEVEL_MASK;
+		List& list(mSlots[level * LEVEL_SIZE + index]);
+		while (!list.empty())
+		{
+			Node* node = list.pop_front();
+			pending.push_back(node, NOT_IN_WHEEL);
+		}
+		mBitmap[level][index / 32] &= ~(1U << (index & 31));
+		if (index != 0)
+		{
+			break;
+		}
+		if (level == LEVELS - 1)
+		{
+			// Every wheel wrapped around; the overflow list might be in range now.
+			while (!mOverflow.empty())
+			{
+				Node* node = mOverflow.pop_front();
+				pending.push_back(node, NOT_IN_WHEEL);
+			}
+		}
+	}
+	while (!pending.empty())
+	{
+		place(pending.pop_front());
+	}
+}
+
+U32 LLTimerWheel::findSlot(U32 level, U32 from) const
+{
+	U32 word = from / 32;
+	if (word >= BITMAP_WORDS)
+	{
+		return LEVEL_SIZE;
+	}
+	U32 bits = mBitmap[level][word] & (~0U << (from & 31));
+	while (!bits)
+	{
+		if (++word == BITMAP_WORDS)
+		{
+			return LEVEL_SIZE;
+		}
+		bits = mBitmap[level][word];
+	}
+	return word * 32 + lowest_bit(bits);
+}
+
+void LLTimerWheel::advance(U64 now, List& expired)
+{
+	// Timers that were inserted after their expiration.
+	expire(DUE_SLOT, expired);
+
+	while (mSize > 0 && mNext <= now)
+	{
+		// Jump over the ticks where nothing expires and nothing needs to be cascaded.
+		U64 next = nextExpiration();
+		if (next > now)
+		{
+			break;
+		}
+		if (next > mNext)
+		{
+			mNext = next;
+		}
+		U32 index = (U32)mNext & LEVEL_MASK;
+		if (index == 0)
+		{
+			cascade();
+		}
+		expire(index, expired);
+		++mNext;
+	}
+	if (mNext <= now)
+	{
+		mNext = now + 1;
+	}
+}
+
+U64 LLTimerWheel::nextExpiration(void) const
+{
+	if (mSize == 0)
+	{
+		return NEVER;
+	}
+	U64 result = NEVER;
+	for (Node const* node = mDue.mHead.mNext; node != &mDue.mHead; node = node->mNext)
+	{
+		if (node->mExpire < result)
+		{
+			result = node->mExpire;
+		}
+	}
+	if (result != NEVER)
+	{
+		return result;
+	}
+
+	for (U32 level = 0; level < LEVELS; ++level)
+	{
+		U32 shift = LEVEL_BITS * level;
+		U64 base = mNext >> shift;
+		U32 current = (U32)base & LEVEL_MASK;
+		// The slot of mNext itself is still to be processed (or cascaded) if mNext is the first
+		// tick of it. Otherwise it was already cascaded, and anything in it belongs to the next round.
+		bool pending = (mNext & (((U64)1 << shift) - 1)) == 0;
+		U32 first = pending ? current : current + 1;
+		U32 index = findSlot(level, first);
+		U64 distance;
+		if (index < LEVEL_SIZE)
+		{
+			distance = index - current;
+		}
+		else if ((index = findSlot(level, 0)) < LEVEL_SIZE)
+		{
+			distance = index + LEVEL_SIZE - current;
+		}
+		else
+		{
+			continue;
+		}
+		// At level 0 this is the exact expiration, otherwise the tick at which the slot is cascaded.
+		U64 tick = (base + distance) << shift;
+		if (tick < result)
+		{
+			result = tick;
+		}
+	}
+	if (!mOverflow.empty())
+	{
+		U32 shift = LEVEL_BITS * LEVELS;
+		bool pending = (mNext & (((U64)1 << shift) - 1)) == 0;
+		U64 tick = ((mNext >> shift) + (pending ? 0 : 1)) << shift;
+		if (tick < result)
+		{
+			result = tick;
+		}
+	}
+	return result;
+}
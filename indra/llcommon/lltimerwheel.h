@@ -0,0 +1,197 @@
+/**
+ * @file lltimerwheel.h
+ * @brief A hierarchical timing wheel with O(1) insertion and removal.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTIMERWHEEL_H
+#define LL_LLTIMERWHEEL_H
+
+#include "stdtypes.h"
+#include "llerror.h"
+
+//============================================================================
+// LLTimerWheel keeps timers, ordered by the tick at which they expire, in
+// LEVELS wheels of LEVEL_SIZE slots. The first wheel has a slot per tick,
+// the next one a slot per LEVEL_SIZE ticks, and so on; when the first wheel
+// wraps around, the next slot of the second wheel is redistributed over
+// the first (a "cascade"). Timers more than 2^32 ticks away wait in an
+// overflow list.
+//
+// Inserting and removing a timer is O(1) and doesn't allocate: the timers
+// are intrusive Nodes, normally a base class of whatever the timer owner
+// needs to find back on expiration. What a tick is, is up to the user (the
+// curl thread uses milliseconds).
+//
+// Not thread-safe; the users lock it themselves.
+//
+// Example usage:
+//   struct MyTimer : public LLTimerWheel::Node { ... };
+//   wheel.insert(&my_timer, now + 100, now);	// Expire 100 ticks from now.
+//   wheel.remove(&my_timer);					// Cancel it (no-op if it isn't queued).
+//   ...
+//   LLTimerWheel::List expired;
+//   wheel.advance(now, expired);				// Collect everything that expired at or before now.
+//   while (!expired.empty()) { MyTimer* timer = static_cast<MyTimer*>(expired.pop_front()); ... }
+
+class LL_COMMON_API LLTimerWheel
+{
+public:
+	enum {
+		LEVEL_BITS = 8,
+		LEVEL_SIZE = 1 << LEVEL_BITS,
+		LEVEL_MASK = LEVEL_SIZE - 1,
+		LEVELS = 4
+	};
+
+	static U64 const NEVER = ~(U64)0;
+
+	class List;
+
+	class LL_COMMON_API Node
+	{
+	public:
+		Node(void) : mPrev(NULL), mNext(NULL), mExpire(0), mSlot(NOT_IN_WHEEL) { }
+
+		// True if the node is in a wheel or in a List.
+		bool isQueued(void) const { return mNext != NULL; }
+		// The tick passed to the last insert().
+		U64 getExpiration(void) const { return mExpire; }
+
+	private:
+		friend class LLTimerWheel;
+		friend class List;
+
+		// Not copyable; the wheel points to it.
+		Node(Node const&);
+		Node& operator=(Node const&);
+
+		void unlink(void)
+		{
+			mPrev->mNext = mNext;
+			mNext->mPrev = mPrev;
+			mPrev = mNext = NULL;
+			mSlot = NOT_IN_WHEEL;
+		}
+
+		Node* mPrev;
+		Node* mNext;
+		U64 mExpire;
+		U32 mSlot;			// Where in the wheel this node is, see slot_type.
+	};
+
+	// A doubly linked list of Nodes, as returned by advance().
+	class LL_COMMON_API List
+	{
+	public:
+		List(void) { mHead.mPrev = mHead.mNext = &mHead; }
+		~List() { llassert(empty()); }
+
+		bool empty(void) const { return mHead.mNext == &mHead; }
+		Node* front(void) const { return empty() ? NULL : mHead.mNext; }
+
+		// Remove and return the first node.
+		Node* pop_front(void)
+		{
+			Node* node = mHead.mNext;
+			llassert(node != &mHead);
+			node->unlink();
+			return node;
+		}
+
+	private:
+		friend class LLTimerWheel;
+
+		// Not copyable; the nodes point to mHead.
+		List(List const&);
+		List& operator=(List const&);
+
+		void push_back(Node* node, U32 slot)
+		{
+			node->mPrev = mHead.mPrev;
+			node->mNext = &mHead;
+			mHead.mPrev->mNext = node;
+			mHead.mPrev = node;
+			node->mSlot = slot;
+		}
+
+		Node mHead;
+	};
+
+	LLTimerWheel(void);
+	~LLTimerWheel();
+
+	// Add node to the wheel, to expire at tick expire. now is the current tick;
+	// it is only used when the wheel is empty (see advance()). A node that
+	// expires at or before the last tick passed to advance() is returned by
+	// the next call to advance().
+	void insert(Node* node, U64 expire, U64 now);
+
+	// Remove node from the wheel, or from the List it was returned in.
+	// Does nothing if the node isn't queued.
+	void remove(Node* node);
+
+	// Move every node that expires at or before tick now to the back of expired.
+	void advance(U64 now, List& expired);
+
+	// A lower bound of the tick at which the next node expires, or NEVER if the wheel is empty.
+	// It is exact if that node is less than LEVEL_SIZE ticks away; otherwise it is the
+	// tick at which the node will be cascaded, at which point this has to be asked again.
+	U64 nextExpiration(void) const;
+
+	bool empty(void) const { return mSize == 0; }
+	U32 size(void) const { return mSize; }
+
+private:
+	// Not copyable.
+	LLTimerWheel(LLTimerWheel const&);
+	LLTimerWheel& operator=(LLTimerWheel const&);
+
+	enum slot_type {
+		// 0 .. LEVELS * LEVEL_SIZE - 1 are the slots of the wheels: level * LEVEL_SIZE + index.
+		OVERFLOW_SLOT = LEVELS * LEVEL_SIZE,	// More than 2^(LEVEL_BITS * LEVELS) ticks away.
+		DUE_SLOT,								// Already expired when it was inserted.
+		NOT_IN_WHEEL = 0xffffffff				// Not queued, or in a List returned by advance().
+	};
+	enum { BITMAP_WORDS = LEVEL_SIZE / 32 };
+
+	// Put node in the slot that corresponds to its expiration, relative to mNext.
+	void place(Node* node);
+	// Move all nodes of slot to expired.
+	void expire(U32 slot, List& expired);
+	// Redistribute the slots that are due at tick mNext.
+	void cascade(void);
+	// The first non-empty slot of level, at index from or later, or LEVEL_SIZE if there is none.
+	U32 findSlot(U32 level, U32 from) const;
+
+	List& slot(U32 slot) { return slot == OVERFLOW_SLOT ? mOverflow : (slot == DUE_SLOT ? mDue : mSlots[slot]); }
+
+	List mSlots[LEVELS * LEVEL_SIZE];
+	U32 mBitmap[LEVELS][BITMAP_WORDS];		// A bit per non-empty slot of mSlots.
+	List mOverflow;
+	List mDue;
+	U64 mNext;								// The next tick to process; everything before it was returned by advance().
+	U32 mSize;
+};
+
+#endif // LL_LLTIMERWHEEL_H
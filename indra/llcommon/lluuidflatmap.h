@@ -0,0 +1,260 @@
+/**
+ * @file lluuidflatmap.h
+ * @brief An open addressing hash map with LLUUID keys.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDFLATMAP_H
+#define LL_LLUUIDFLATMAP_H
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "stdtypes.h"
+#include "lluuid.h"
+
+//============================================================================
+// LLUUIDFlatMap is a replacement for std::map<LLUUID, T> for large maps that
+// are mostly used for lookups. The elements are stored in one array, using
+// open addressing with linear probing, so that a lookup is a hash and (in
+// general) a single cache miss instead of a walk down a tree of nodes.
+//
+// It has the subset of the std::map interface that is needed to use it with
+// get_ptr_in_map() and friends. The differences with std::map:
+// - The elements are not ordered.
+// - Inserting an element invalidates all iterators and references to elements.
+// - So does erasing one: elements are shifted back into the hole, so that
+//   there are no tombstones that slow down lookups. Hence there is no
+//   erase(iterator), and one must not erase elements while iterating.
+// - value_type is std::pair<LLUUID, T>; never change the key through an iterator.
+//
+// Example usage:
+//   LLUUIDFlatMap<LLViewerObject*> objects;
+//   objects[id] = object;
+//   LLViewerObject* object = get_ptr_in_map(objects, id);
+
+template<typename T>
+class LLUUIDFlatMap
+{
+public:
+	typedef LLUUID key_type;
+	typedef T mapped_type;
+	typedef std::pair<LLUUID, T> value_type;
+	typedef size_t size_type;
+
+	template<typename MAP, typename VALUE>
+	class iterator_base
+	{
+	public:
+		iterator_base() : mMap(NULL), mIndex(0) { }
+		iterator_base(MAP* map, size_type index) : mMap(map), mIndex(index) { }
+		// Allow conversion from iterator to const_iterator.
+		template<typename MAP2, typename VALUE2>
+		iterator_base(iterator_base<MAP2, VALUE2> const& iter) : mMap(iter.mMap), mIndex(iter.mIndex) { }
+
+		VALUE& operator*() const { return mMap->mSlots[mIndex]; }
+		VALUE* operator->() const { return &mMap->mSlots[mIndex]; }
+
+		iterator_base& operator++() { mIndex = mMap->nextUsed(mIndex + 1); return *this; }
+		iterator_base operator++(int) { iterator_base tmp(*this); ++*this; return tmp; }
+
+		template<typename MAP2, typename VALUE2>
+		bool operator==(iterator_base<MAP2, VALUE2> const& iter) const { return mIndex == iter.mIndex; }
+		template<typename MAP2, typename VALUE2>
+		bool operator!=(iterator_base<MAP2, VALUE2> const& iter) const { return mIndex != iter.mIndex; }
+
+	private:
+		template<typename MAP2, typename VALUE2> friend class iterator_base;
+		MAP* mMap;
+		size_type mIndex;
+	};
+
+	typedef iterator_base<LLUUIDFlatMap, value_type> iterator;
+	typedef iterator_base<LLUUIDFlatMap const, value_type const> const_iterator;
+
+	LLUUIDFlatMap() : mSize(0), mMask(0) { }
+
+	size_type size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	iterator begin() { return iterator(this, nextUsed(0)); }
+	iterator end() { return iterator(this, mSlots.size()); }
+	const_iterator begin() const { return const_iterator(this, nextUsed(0)); }
+	const_iterator end() const { return const_iterator(this, mSlots.size()); }
+
+	iterator find(LLUUID const& key) { return iterator(this, lookup(key)); }
+	const_iterator find(LLUUID const& key) const { return const_iterator(this, lookup(key)); }
+	size_type count(LLUUID const& key) const { return lookup(key) != mSlots.size(); }
+
+	// Insert value if there is no element with its key yet. Like std::map::insert,
+	// returns the element with the key and whether value was inserted.
+	std::pair<iterator, bool> insert(value_type const& value)
+	{
+		size_type index = lookup(value.first);
+		if (index != mSlots.size())
+		{
+			return std::make_pair(iterator(this, index), false);
+		}
+		reserve(mSize + 1);
+		index = slotFor(value.first);
+		mSlots[index] = value;
+		mUsed[index] = 1;
+		++mSize;
+		return std::make_pair(iterator(this, index), true);
+	}
+
+	T& operator[](LLUUID const& key)
+	{
+		return insert(value_type(key, T())).first->second;
+	}
+
+	size_type erase(LLUUID const& key)
+	{
+		size_type hole = lookup(key);
+		if (hole == mSlots.size())
+		{
+			return 0;
+		}
+		// Move elements after the hole back into it, unless they are already
+		// at or after the slot they hash to (looking from the hole).
+		for (size_type index = (hole + 1) & mMask; mUsed[index]; index = (index + 1) & mMask)
+		{
+			size_type home = hash(mSlots[index].first);
+			if (((index - home) & mMask) >= ((index - hole) & mMask))
+			{
+				mSlots[hole] = mSlots[index];
+				hole = index;
+			}
+		}
+		mSlots[hole] = value_type();	// Release what T holds on to.
+		mUsed[hole] = 0;
+		--mSize;
+		return 1;
+	}
+
+	void clear()
+	{
+		mSlots.clear();
+		mUsed.clear();
+		mSize = 0;
+		mMask = 0;
+	}
+
+	void swap(LLUUIDFlatMap& map)
+	{
+		mSlots.swap(map.mSlots);
+		mUsed.swap(map.mUsed);
+		std::swap(mSize, map.mSize);
+		std::swap(mMask, map.mMask);
+	}
+
+	// Make room for size elements without rehashing.
+	void reserve(size_type size)
+	{
+		// Keep the load factor below 3/4.
+		size_type capacity = mSlots.size();
+		if (4 * size < 3 * capacity)
+		{
+			return;
+		}
+		if (capacity < 16)
+		{
+			capacity = 16;
+		}
+		while (4 * size >= 3 * capacity)
+		{
+			capacity *= 2;
+		}
+		std::vector<value_type> slots(capacity);
+		std::vector<U8> used(capacity);
+		slots.swap(mSlots);
+		used.swap(mUsed);
+		mMask = capacity - 1;
+		for (size_type i = 0; i < slots.size(); ++i)
+		{
+			if (used[i])
+			{
+				size_type index = slotFor(slots[i].first);
+				mSlots[index] = slots[i];
+				mUsed[index] = 1;
+			}
+		}
+	}
+
+private:
+	template<typename MAP, typename VALUE> friend class iterator_base;
+
+	size_type hash(LLUUID const& key) const
+	{
+		// Fibonacci hashing of the two halves of the (mostly random) UUID.
+		U64 low, high;
+		memcpy(&low, key.mData, sizeof(low));
+		memcpy(&high, key.mData + sizeof(low), sizeof(high));
+		return (size_type)(((low ^ high) * 0x9E3779B97F4A7C15ULL) >> 32) & mMask;
+	}
+
+	// Index of the element with key, or mSlots.size() if there is none.
+	size_type lookup(LLUUID const& key) const
+	{
+		if (mSize == 0)
+		{
+			return mSlots.size();
+		}
+		for (size_type index = hash(key); mUsed[index]; index = (index + 1) & mMask)
+		{
+			if (mSlots[index].first == key)
+			{
+				return index;
+			}
+		}
+		return mSlots.size();
+	}
+
+	// The empty slot where key goes.
+	size_type slotFor(LLUUID const& key) const
+	{
+		size_type index = hash(key);
+		while (mUsed[index])
+		{
+			index = (index + 1) & mMask;
+		}
+		return index;
+	}
+
+	size_type nextUsed(size_type index) const
+	{
+		while (index < mUsed.size() && !mUsed[index])
+		{
+			++index;
+		}
+		return index;
+	}
+
+	std::vector<value_type> mSlots;
+	std::vector<U8> mUsed;				// Whether the slot with the same index holds an element.
+	size_type mSize;
+	size_type mMask;					// Number of slots minus one.
+};
+
+#endif // LL_LLUUIDFLATMAP_H
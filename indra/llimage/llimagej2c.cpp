@@ -55,6 +55,8 @@ apr_dso_handle_t *j2cimpl_dso_handle;
 LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 void fallbackDestroyLLImageJ2CImpl(LLImageJ2CImpl* impl);
 const char* fallbackEngineInfoLLImageJ2CImpl();
+void fallbackInitLLImageJ2CImpl();
+void fallbackCleanupLLImageJ2CImpl();
 
 //static
 //Loads the required "create", "destroy" and "engineinfo" functions needed
@@ -156,12 +158,16 @@ void LLImageJ2C::openDSO()
 		}
 
 		j2cimpl_dso_memory_pool.destroy();
+
+		// Start the threads that the fallback encoder uses.
+		fallbackInitLLImageJ2CImpl();
 	}
 }
 
 //static
 void LLImageJ2C::closeDSO()
 {
+	fallbackCleanupLLImageJ2CImpl();
 	if ( j2cimpl_dso_handle ) apr_dso_unload(j2cimpl_dso_handle);
 	j2cimpl_dso_memory_pool.destroy();
 }
@@ -347,32 +353,6 @@ BOOL LLImageJ2C::encode(const LLImageRaw *raw_imagep, const char* comment_text,
 	return res;
 }
 
-//static
-S32 LLImageJ2C::calcHeaderSizeJ2C()
-{
-	return FIRST_PACKET_SIZE; // Hack. just needs to be >= actual header size...
-}
-
-//static
-S32 LLImageJ2C::calcDataSizeJ2C(S32 w, S32 h, S32 comp, S32 discard_level, F32 rate)
-{
-	// Note: this only provides an *estimate* of the size in bytes of an image level
-	// *TODO: find a way to read the true size (when available) and convey the fact
-	// that the result is an estimate in the other cases
-	if (rate <= 0.f) rate = .125f;
-	while (discard_level > 0)
-	{
-		if (w < 1 || h < 1)
-			break;
-		w >>= 1;
-		h >>= 1;
-		discard_level--;
-	}
-	S32 bytes = (S32)((F32)(w*h*comp)*rate);
-	bytes = llmax(bytes, calcHeaderSizeJ2C());
-	return bytes;
-}
-
 S32 LLImageJ2C::calcHeaderSize()
 {
 	return calcHeaderSizeJ2C();
@@ -66,6 +66,7 @@ public:
 	void setMaxBytes(S32 max_bytes);
 	S32 getMaxBytes() const { return mMaxBytes; }
 
+	// Inline so that code that only needs the size estimate, like LLTextureFetchRange and its test, doesn't link llimage.
 	static S32 calcHeaderSizeJ2C();
 	static S32 calcDataSizeJ2C(S32 w, S32 h, S32 comp, S32 discard_level, F32 rate = 0.f);
 
@@ -90,6 +91,32 @@ protected:
 	std::string mLastError;
 };
 
+//static
+inline S32 LLImageJ2C::calcHeaderSizeJ2C()
+{
+	return FIRST_PACKET_SIZE; // Hack. just needs to be >= actual header size...
+}
+
+//static
+inline S32 LLImageJ2C::calcDataSizeJ2C(S32 w, S32 h, S32 comp, S32 discard_level, F32 rate)
+{
+	// Note: this only provides an *estimate* of the size in bytes of an image level
+	// *TODO: find a way to read the true size (when available) and convey the fact
+	// that the result is an estimate in the other cases
+	if (rate <= 0.f) rate = .125f;
+	while (discard_level > 0)
+	{
+		if (w < 1 || h < 1)
+			break;
+		w >>= 1;
+		h >>= 1;
+		discard_level--;
+	}
+	S32 bytes = (S32)((F32)(w*h*comp)*rate);
+	bytes = llmax(bytes, calcHeaderSizeJ2C());
+	return bytes;
+}
+
 // Derive from this class to implement JPEG2000 decoding
 class LLImageJ2CImpl
 {
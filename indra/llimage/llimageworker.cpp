@@ -28,6 +28,7 @@
 
 #include "llimageworker.h"
 #include "llimagedxt.h"
+#include "llfasttimer.h"
 
 //----------------------------------------------------------------------------
 
@@ -113,9 +114,12 @@ LLImageDecodeThread::ImageRequest::~ImageRequest()
 //----------------------------------------------------------------------------
 
 
+static LLFastTimer::DeclareTimer FTM_IMAGE_DECODE_REQUEST("Image Decode Request");
+
 // Returns true when done, whether or not decode was successful.
 bool LLImageDecodeThread::ImageRequest::processRequest()
 {
+	LLFastTimer t(FTM_IMAGE_DECODE_REQUEST);
 	const F32 decode_time_slice = .1f;
 	bool done = true;
 	if (!mDecodedRaw && mFormattedImage.notNull())
@@ -31,8 +31,65 @@
 #include "openjpeg.h"
 
 #include "lltimer.h"
+#include "llthreadpool.h"
 //#include "llmemory.h"
 
+// Runs the parts of OpenJPEG encoding jobs that can run in parallel (see opj_set_parallel_for).
+static LLThreadPool* sEncodePool = NULL;
+
+// Maximum total size of the resolution levels that are kept between decodes of an image.
+static const S32 MAX_DECODE_CACHE_BYTES = 64 * 1024 * 1024;
+
+namespace
+{
+	class LLOpenJPEGJob : public LLThreadPool::Job
+	{
+	public:
+		LLOpenJPEGJob(opj_parallel_job_fn job, void* data, int index) : mJob(job), mData(data), mIndex(index) { }
+
+		/*virtual*/ void run(void) { mJob(mData, mIndex); }
+
+	private:
+		opj_parallel_job_fn mJob;
+		void* mData;
+		int mIndex;
+	};
+}
+
+static void parallel_for(opj_parallel_job_fn job, void* data, int count)
+{
+	LLThreadPool::Group group;
+	for (int index = 0; index < count; ++index)
+	{
+		LLPointer<LLThreadPool::Job> pool_job = new LLOpenJPEGJob(job, data, index);
+		if (!sEncodePool->post(pool_job, &group))
+		{
+			pool_job->run();
+		}
+	}
+	group.wait();
+}
+
+void fallbackInitLLImageJ2CImpl()
+{
+	if (!sEncodePool)
+	{
+		sEncodePool = new LLThreadPool("j2c encode");
+		opj_set_parallel_for(parallel_for);
+	}
+}
+
+void fallbackCleanupLLImageJ2CImpl()
+{
+	if (sEncodePool)
+	{
+		opj_set_parallel_for(NULL);
+		sEncodePool->shutdown();
+		delete sEncodePool;
+		sEncodePool = NULL;
+	}
+}
+
 const char* fallbackEngineInfoLLImageJ2CImpl()
 {
 	static std::string version_string = std::string("OpenJPEG: ") + opj_version();
@@ -95,14 +152,42 @@ int ceildivpow2(int a, int b)
 }
 
 
+LLAtomicS32 LLImageJ2COJ::sDecodeCacheBytes;
+
 LLImageJ2COJ::LLImageJ2COJ()
-	: LLImageJ2CImpl()
+	: LLImageJ2CImpl(),
+	  mDecodeCache(NULL),
+	  mDecodeCacheSize(0)
 {
 }
 
 
 LLImageJ2COJ::~LLImageJ2COJ()
 {
+	updateDecodeCache(true);
+}
+
+
+void LLImageJ2COJ::updateDecodeCache(bool release)
+{
+	if (!mDecodeCache)
+	{
+		return;
+	}
+	sDecodeCacheBytes -= mDecodeCacheSize;
+	mDecodeCacheSize = 0;
+	if (!release)
+	{
+		S32 size = opj_decode_cache_size(mDecodeCache);
+		if (sDecodeCacheBytes + size <= MAX_DECODE_CACHE_BYTES)
+		{
+			mDecodeCacheSize = size;
+			sDecodeCacheBytes += size;
+			return;
+		}
+	}
+	opj_destroy_decode_cache(mDecodeCache);
+	mDecodeCache = NULL;
 }
 
 
@@ -133,6 +218,15 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
 	parameters.cp_reduce = base.getRawDiscardLevel();
 
+	// While the image isn't decoded at full resolution, keep the resolution levels that are decoded,
+	// so that the next decode (with more data or a lower discard level) only has to decode the levels
+	// whose code-blocks changed. The final decode at discard level 0 still uses what was kept before.
+	if (!mDecodeCache && parameters.cp_reduce > 0 && sDecodeCacheBytes < MAX_DECODE_CACHE_BYTES)
+	{
+		mDecodeCache = opj_create_decode_cache();
+	}
+	parameters.decode_cache = mDecodeCache;
+
 	if(parameters.cp_reduce == 0 && *(U16*)(base.getData() + base.getDataSize() - 2) != 0xD9FF)
 	{
 		bool failed = true;
@@ -185,6 +279,9 @@ BOOL LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 	/* decode the stream and fill the image structure */
 	image = opj_decode(dinfo, cio);
 
+	// Nothing is decoded after full resolution, and what was kept is suspect if the decode failed.
+	updateDecodeCache(!image || parameters.cp_reduce == 0);
+
 	/* close the byte stream */
 	opj_cio_close(cio);
 
@@ -34,6 +34,9 @@
 #define LL_LLIMAGEJ2COJ_H
 
 #include "llimagej2c.h"
+#include "llatomic.h"
+
+typedef struct opj_decode_cache opj_decode_cache_t;
 
 class LLImageJ2COJ : public LLImageJ2CImpl
 {	
@@ -52,6 +55,17 @@ protected:
 		return (a + (1 << b) - 1) >> b;
 	}
 
+private:
+	// Account for the new size of mDecodeCache, or release it.
+	void updateDecodeCache(bool release);
+
+	// The resolution levels of the last decode of this image, reused by the next
+	// decode when more data arrived or the discard level dropped.
+	opj_decode_cache_t* mDecodeCache;
+	S32 mDecodeCacheSize;
+
+	// Total size of the decode caches of all images.
+	static LLAtomicS32 sDecodeCacheBytes;
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include "linden_common.h"
 #include "llinventory.h"
 
+#include "lldatapacker.h"
 #include "lldbstrings.h"
 #include "llfasttimer.h"
 #include "llinventorydefines.h"
@@ -1003,6 +1004,73 @@ BOOL LLInventoryItem::exportLegacyStream(std::ostream& output_stream, BOOL inclu
 	return TRUE;
 }
 
+// virtual
+void LLInventoryItem::packBinary(LLDataPacker& dp) const
+{
+	dp.packUUID(mUUID, "item_id");
+	dp.packUUID(mParentUUID, "parent_id");
+	dp.packUUID(mPermissions.getCreator(), "creator_id");
+	dp.packUUID(mPermissions.getOwner(), "owner_id");
+	dp.packUUID(mPermissions.getLastOwner(), "last_owner_id");
+	dp.packUUID(mPermissions.getGroup(), "group_id");
+	dp.packU32(mPermissions.getMaskBase(), "base_mask");
+	dp.packU32(mPermissions.getMaskOwner(), "owner_mask");
+	dp.packU32(mPermissions.getMaskGroup(), "group_mask");
+	dp.packU32(mPermissions.getMaskEveryone(), "everyone_mask");
+	dp.packU32(mPermissions.getMaskNextOwner(), "next_owner_mask");
+	dp.packUUID(mAssetUUID, "asset_id");
+	dp.packU8((U8)(S8)mType, "type");
+	dp.packU8((U8)(S8)mInventoryType, "inv_type");
+	dp.packU32(mFlags, "flags");
+	dp.packU8((U8)mSaleInfo.getSaleType(), "sale_type");
+	dp.packS32(mSaleInfo.getSalePrice(), "sale_price");
+	dp.packString(mName, "name");
+	dp.packString(mDescription, "desc");
+	dp.packS32((S32)mCreationDate, "creation_date");
+}
+
+// virtual
+BOOL LLInventoryItem::unpackBinary(LLDataPacker& dp)
+{
+	LLUUID creator_id, owner_id, last_owner_id, group_id;
+	U32 base_mask, owner_mask, group_mask, everyone_mask, next_owner_mask;
+	U8 type, inv_type, sale_type;
+	S32 sale_price, creation_date;
+
+	// Stop at the first field that doesn't fit, so that nothing is read beyond the buffer.
+	if (!dp.unpackUUID(mUUID, "item_id") ||
+		!dp.unpackUUID(mParentUUID, "parent_id") ||
+		!dp.unpackUUID(creator_id, "creator_id") ||
+		!dp.unpackUUID(owner_id, "owner_id") ||
+		!dp.unpackUUID(last_owner_id, "last_owner_id") ||
+		!dp.unpackUUID(group_id, "group_id") ||
+		!dp.unpackU32(base_mask, "base_mask") ||
+		!dp.unpackU32(owner_mask, "owner_mask") ||
+		!dp.unpackU32(group_mask, "group_mask") ||
+		!dp.unpackU32(everyone_mask, "everyone_mask") ||
+		!dp.unpackU32(next_owner_mask, "next_owner_mask") ||
+		!dp.unpackUUID(mAssetUUID, "asset_id") ||
+		!dp.unpackU8(type, "type") ||
+		!dp.unpackU8(inv_type, "inv_type") ||
+		!dp.unpackU32(mFlags, "flags") ||
+		!dp.unpackU8(sale_type, "sale_type") ||
+		!dp.unpackS32(sale_price, "sale_price") ||
+		!dp.unpackString(mName, "name") ||
+		!dp.unpackString(mDescription, "desc") ||
+		!dp.unpackS32(creation_date, "creation_date"))
+	{
+		return FALSE;
+	}
+
+	mPermissions.init(creator_id, owner_id, last_owner_id, group_id);
+	mPermissions.initMasks(base_mask, owner_mask, everyone_mask, group_mask, next_owner_mask);
+	mType = (LLAssetType::EType)(S8)type;
+	mInventoryType = (LLInventoryType::EType)(S8)inv_type;
+	mSaleInfo = LLSaleInfo((LLSaleInfo::EForSale)sale_type, sale_price);
+	mCreationDate = creation_date;
+	return TRUE;
+}
+
 LLSD LLInventoryItem::asLLSD() const
 {
 	LLSD sd = LLSD();
@@ -1632,6 +1700,35 @@ BOOL LLInventoryCategory::exportLegacyStream(std::ostream& output_stream, BOOL)
 	return TRUE;
 }
 
+// virtual
+void LLInventoryCategory::packBinary(LLDataPacker& dp) const
+{
+	dp.packUUID(mUUID, "cat_id");
+	dp.packUUID(mParentUUID, "parent_id");
+	dp.packU8((U8)(S8)mType, "type");
+	dp.packU8((U8)(S8)mPreferredType, "pref_type");
+	dp.packString(mName, "name");
+}
+
+// virtual
+BOOL LLInventoryCategory::unpackBinary(LLDataPacker& dp)
+{
+	U8 type, preferred_type;
+
+	if (!dp.unpackUUID(mUUID, "cat_id") ||
+		!dp.unpackUUID(mParentUUID, "parent_id") ||
+		!dp.unpackU8(type, "type") ||
+		!dp.unpackU8(preferred_type, "pref_type") ||
+		!dp.unpackString(mName, "name"))
+	{
+		return FALSE;
+	}
+
+	mType = (LLAssetType::EType)(S8)type;
+	mPreferredType = (LLFolderType::EType)(S8)preferred_type;
+	return TRUE;
+}
+
 ///----------------------------------------------------------------------------
 /// Local function definitions
 ///----------------------------------------------------------------------------
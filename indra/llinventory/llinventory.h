@@ -36,6 +36,7 @@
 #include "llsd.h"
 #include "lluuid.h"
 
+class LLDataPacker;
 class LLMessageSystem;
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -205,6 +206,10 @@ public:
 	virtual BOOL importLegacyStream(std::istream& input_stream);
 	virtual BOOL exportLegacyStream(std::ostream& output_stream, BOOL include_asset_key = TRUE) const;
 
+	// Compact binary form of the same fields, used by the inventory cache.
+	virtual void packBinary(LLDataPacker& dp) const;
+	virtual BOOL unpackBinary(LLDataPacker& dp);
+
 	//--------------------------------------------------------------------
 	// Helper Functions
 	//--------------------------------------------------------------------
@@ -278,6 +283,10 @@ public:
 	virtual BOOL importLegacyStream(std::istream& input_stream);
 	virtual BOOL exportLegacyStream(std::ostream& output_stream, BOOL include_asset_key = TRUE) const;
 
+	// Compact binary form of the same fields, used by the inventory cache.
+	virtual void packBinary(LLDataPacker& dp) const;
+	virtual BOOL unpackBinary(LLDataPacker& dp);
+
 	//--------------------------------------------------------------------
 	// Member Variables
 	//--------------------------------------------------------------------
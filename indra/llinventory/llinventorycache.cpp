@@ -0,0 +1,537 @@
+/**
+ * @file llinventorycache.cpp
+ * @brief Implementation of the binary inventory cache file.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llinventorycache.h"
+
+#include "lldatapacker.h"
+#include "llthreadpool.h"
+
+#if LL_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	char const CACHE_MAGIC[8] = { 'L', 'L', 'I', 'N', 'V', 'B', 'I', 'N' };
+	U32 const CACHE_FORMAT_VERSION = 1;
+	U32 const CACHE_BYTE_ORDER = 0x01020304;
+
+	struct LLInventoryCacheHeader
+	{
+		char mMagic[8];
+		U32 mFormatVersion;
+		U32 mByteOrder;				// CACHE_BYTE_ORDER, as written by the machine that wrote the file.
+		U32 mContentVersion;
+		U32 mNumEntries;
+		U32 mDirectoryOffset;
+	};
+
+	// Parses a range of records on a thread of the pool.
+	class LLInventoryCacheParseJob : public LLThreadPool::Job
+	{
+	public:
+		LLInventoryCacheParseJob(LLInventoryCacheParser const& parser, LLInventoryCacheReader const& reader, U32 first, U32 last) :
+			mParser(parser), mReader(reader), mFirst(first), mLast(last), mInvalid(0) { }
+
+		/*virtual*/ void run(void) { mInvalid = mParser.parse(mReader, mFirst, mLast, mCategories, mItems); }
+
+		LLInventoryCacheParser::cat_list_t mCategories;
+		LLInventoryCacheParser::item_list_t mItems;
+		U32 mInvalid;
+
+	private:
+		LLInventoryCacheParser const& mParser;
+		LLInventoryCacheReader const& mReader;
+		U32 mFirst;
+		U32 mLast;
+	};
+}
+
+//----------------------------------------------------------------------------
+// LLInventoryCacheReader
+
+LLInventoryCacheReader::LLInventoryCacheReader() :
+	mData(NULL), mSize(0), mEntries(NULL), mNumEntries(0),
+#if LL_WINDOWS
+	mFile(INVALID_HANDLE_VALUE), mMapping(NULL)
+#else
+	mFD(-1)
+#endif
+{
+}
+
+LLInventoryCacheReader::~LLInventoryCacheReader()
+{
+	close();
+}
+
+LLInventoryCacheReader::EStatus LLInventoryCacheReader::open(std::string const& filename, U32 content_version)
+{
+	close();
+	if (!LLFile::isfile(filename))
+	{
+		return NOT_FOUND;
+	}
+	if (!map(filename))
+	{
+		// Fall back to reading the whole file.
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		if (!fp)
+		{
+			return NOT_FOUND;
+		}
+		fseek(fp, 0, SEEK_END);
+		long size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		bool success = size > 0 && (U64)size < U32_MAX;
+		if (success)
+		{
+			mBuffer.resize(size);
+			success = fread(&mBuffer[0], 1, size, fp) == (size_t)size;
+		}
+		fclose(fp);
+		if (!success)
+		{
+			mBuffer.clear();
+			return CORRUPT;
+		}
+		mData = &mBuffer[0];
+		mSize = size;
+	}
+	EStatus status = validate(content_version);
+	if (status != OK)
+	{
+		close();
+	}
+	return status;
+}
+
+LLInventoryCacheReader::EStatus LLInventoryCacheReader::validate(U32 content_version)
+{
+	if (mSize < sizeof(CACHE_MAGIC) || memcmp(mData, CACHE_MAGIC, sizeof(CACHE_MAGIC)))
+	{
+		return OBSOLETE;
+	}
+	if (mSize < sizeof(LLInventoryCacheHeader))
+	{
+		return CORRUPT;
+	}
+	LLInventoryCacheHeader header;
+	memcpy(&header, mData, sizeof(header));
+	if (header.mFormatVersion != CACHE_FORMAT_VERSION ||
+		header.mByteOrder != CACHE_BYTE_ORDER ||
+		header.mContentVersion != content_version)
+	{
+		return OBSOLETE;
+	}
+	// The directory ends the file, and is preceded by at least one zero byte, so
+	// that a damaged string in the last record can't make a reader run off the end.
+	if (header.mDirectoryOffset <= sizeof(header) ||
+		header.mDirectoryOffset % sizeof(U32) ||
+		(U64)header.mDirectoryOffset + (U64)header.mNumEntries * sizeof(LLInventoryCacheEntry) != mSize ||
+		mData[header.mDirectoryOffset - 1] != 0)
+	{
+		return CORRUPT;
+	}
+	mEntries = reinterpret_cast<LLInventoryCacheEntry const*>(mData + header.mDirectoryOffset);
+	mNumEntries = header.mNumEntries;
+	for (U32 i = 0; i < mNumEntries; ++i)
+	{
+		LLInventoryCacheEntry const& entry(mEntries[i]);
+		if (entry.mOffset < sizeof(header) || (U64)entry.mOffset + entry.mSize >= header.mDirectoryOffset)
+		{
+			return CORRUPT;
+		}
+	}
+	return OK;
+}
+
+void LLInventoryCacheReader::close(void)
+{
+	unmap();
+	mBuffer.clear();
+	mData = NULL;
+	mSize = 0;
+	mEntries = NULL;
+	mNumEntries = 0;
+	mIndex.clear();
+}
+
+LLInventoryCacheEntry const* LLInventoryCacheReader::find(LLUUID const& category_id) const
+{
+	if (mIndex.empty())
+	{
+		for (U32 i = 0; i < mNumEntries; ++i)
+		{
+			mIndex[mEntries[i].mCategoryID] = i;
+		}
+	}
+	std::map<LLUUID, U32>::const_iterator iter = mIndex.find(category_id);
+	return iter == mIndex.end() ? NULL : &mEntries[iter->second];
+}
+
+#if LL_WINDOWS
+
+bool LLInventoryCacheReader::map(std::string const& filename)
+{
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	// FILE_SHARE_DELETE allows the writer to replace the file while it is open.
+	mFile = CreateFileW((LPCWSTR)utf16filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+						OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0 || size.QuadPart >= U32_MAX)
+	{
+		unmap();
+		return false;
+	}
+	mMapping = CreateFileMappingW(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping)
+	{
+		mData = static_cast<U8 const*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!mData)
+	{
+		llwarns << "Could not map " << filename << " in memory: " << GetLastError() << llendl;
+		unmap();
+		return false;
+	}
+	mSize = (U32)size.QuadPart;
+	return true;
+}
+
+void LLInventoryCacheReader::unmap(void)
+{
+	if (mData && mMapping)
+	{
+		UnmapViewOfFile(mData);
+		mData = NULL;
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+#else // LL_WINDOWS
+
+bool LLInventoryCacheReader::map(std::string const& filename)
+{
+	mFD = ::open(filename.c_str(), O_RDONLY);
+	if (mFD < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(mFD, &st) != 0 || st.st_size == 0 || (U64)st.st_size >= U32_MAX)
+	{
+		unmap();
+		return false;
+	}
+	void* address = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, mFD, 0);
+	if (address == MAP_FAILED)
+	{
+		llwarns << "Could not map " << filename << " in memory: " << LLFile::strerr() << llendl;
+		unmap();
+		return false;
+	}
+	mData = static_cast<U8 const*>(address);
+	mSize = (U32)st.st_size;
+	return true;
+}
+
+void LLInventoryCacheReader::unmap(void)
+{
+	if (mFD >= 0)
+	{
+		if (mData)
+		{
+			::munmap(const_cast<U8*>(mData), mSize);
+			mData = NULL;
+		}
+		::close(mFD);
+		mFD = -1;
+	}
+}
+
+#endif // LL_WINDOWS
+
+//----------------------------------------------------------------------------
+// LLInventoryCacheWriter
+
+LLInventoryCacheWriter::LLInventoryCacheWriter() : mContentVersion(0), mFile(NULL), mOffset(0)
+{
+}
+
+LLInventoryCacheWriter::~LLInventoryCacheWriter()
+{
+	abort();
+}
+
+bool LLInventoryCacheWriter::open(std::string const& filename, U32 content_version)
+{
+	abort();
+	mFilename = filename;
+	mContentVersion = content_version;
+	mTempFilename = filename + ".tmp";
+	mFile = LLFile::fopen(mTempFilename, "wb");
+	if (!mFile)
+	{
+		llwarns << "Unable to open " << mTempFilename << " for writing." << llendl;
+		return false;
+	}
+	mOffset = 0;
+	mEntries.clear();
+	// Written again by commit(), when the directory offset is known.
+	LLInventoryCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	return write(&header, sizeof(header));
+}
+
+bool LLInventoryCacheWriter::write(void const* data, U32 size)
+{
+	if (!mFile)
+	{
+		return false;
+	}
+	if (fwrite(data, 1, size, mFile) != size)
+	{
+		llwarns << "Error writing " << mTempFilename << llendl;
+		abort();
+		return false;
+	}
+	mOffset += size;
+	return true;
+}
+
+bool LLInventoryCacheWriter::addRecord(LLInventoryCategory const& category, S32 version, std::vector<LLInventoryItem const*> const& items)
+{
+	// Determine the size first.
+	LLDataPackerBinaryBuffer sizer;
+	category.packBinary(sizer);
+	for (std::vector<LLInventoryItem const*>::const_iterator iter = items.begin(); iter != items.end(); ++iter)
+	{
+		(*iter)->packBinary(sizer);
+	}
+	U32 size = sizer.getCurrentSize();
+	mBuffer.resize(size);
+	LLDataPackerBinaryBuffer dp(&mBuffer[0], size);
+	category.packBinary(dp);
+	for (std::vector<LLInventoryItem const*>::const_iterator iter = items.begin(); iter != items.end(); ++iter)
+	{
+		(*iter)->packBinary(dp);
+	}
+
+	LLInventoryCacheEntry entry;
+	entry.mCategoryID = category.getUUID();
+	entry.mVersion = version;
+	entry.mNumItems = items.size();
+	entry.mOffset = mOffset;
+	entry.mSize = size;
+	if (!write(&mBuffer[0], size))
+	{
+		return false;
+	}
+	mEntries.push_back(entry);
+	return true;
+}
+
+bool LLInventoryCacheWriter::copyRecord(LLInventoryCacheReader const& reader, LLInventoryCacheEntry const& entry)
+{
+	LLInventoryCacheEntry copy(entry);
+	copy.mOffset = mOffset;
+	if (!write(reader.getRecord(entry), entry.mSize))
+	{
+		return false;
+	}
+	mEntries.push_back(copy);
+	return true;
+}
+
+bool LLInventoryCacheWriter::commit(void)
+{
+	if (!mFile)
+	{
+		return false;
+	}
+	// At least one zero byte, and align the directory.
+	U8 const padding[sizeof(U32)] = { 0, 0, 0, 0 };
+	U32 padding_size = sizeof(U32) - (mOffset % sizeof(U32));
+	if (!write(padding, padding_size))
+	{
+		return false;
+	}
+	LLInventoryCacheHeader header;
+	memcpy(header.mMagic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.mFormatVersion = CACHE_FORMAT_VERSION;
+	header.mByteOrder = CACHE_BYTE_ORDER;
+	header.mContentVersion = mContentVersion;
+	header.mNumEntries = mEntries.size();
+	header.mDirectoryOffset = mOffset;
+	if ((!mEntries.empty() && !write(&mEntries[0], mEntries.size() * sizeof(LLInventoryCacheEntry))) ||
+		fseek(mFile, 0, SEEK_SET) != 0 ||
+		fwrite(&header, 1, sizeof(header), mFile) != sizeof(header))
+	{
+		llwarns << "Error writing " << mTempFilename << llendl;
+		abort();
+		return false;
+	}
+	int error = fclose(mFile);
+	mFile = NULL;
+	if (error)
+	{
+		llwarns << "Error writing " << mTempFilename << llendl;
+		LLFile::remove(mTempFilename);
+		return false;
+	}
+	// rename() doesn't replace an existing file on Windows.
+	LLFile::remove_nowarn(mFilename);
+	if (LLFile::rename(mTempFilename, mFilename) != 0)
+	{
+		LLFile::remove(mTempFilename);
+		return false;
+	}
+	return true;
+}
+
+void LLInventoryCacheWriter::abort(void)
+{
+	if (mFile)
+	{
+		fclose(mFile);
+		mFile = NULL;
+		LLFile::remove(mTempFilename);
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLInventoryCacheParser
+
+U32 LLInventoryCacheParser::parse(LLInventoryCacheReader const& reader, LLThreadPool* pool, cat_list_t& categories, item_list_t& items) const
+{
+	U32 num_entries = reader.getNumEntries();
+	if (!pool || pool->getThreadCount() < 2 || num_entries < 2)
+	{
+		return parse(reader, 0, num_entries, categories, items);
+	}
+
+	// Split the records in ranges of about the same number of bytes; a few per
+	// thread, because the cost per byte differs between items and categories.
+	U64 total_size = 0;
+	for (U32 i = 0; i < num_entries; ++i)
+	{
+		total_size += reader.getEntry(i).mSize;
+	}
+	U64 range_size = total_size / (4 * pool->getThreadCount()) + 1;
+	std::vector<LLPointer<LLInventoryCacheParseJob> > jobs;
+	{
+		LLThreadPool::Group group;
+		U32 first = 0;
+		U64 size = 0;
+		for (U32 i = 0; i < num_entries; ++i)
+		{
+			size += reader.getEntry(i).mSize;
+			if (size >= range_size || i == num_entries - 1)
+			{
+				LLPointer<LLInventoryCacheParseJob> job = new LLInventoryCacheParseJob(*this, reader, first, i + 1);
+				jobs.push_back(job);
+				if (!pool->post(job, &group))
+				{
+					job->run();
+				}
+				first = i + 1;
+				size = 0;
+			}
+		}
+		group.wait();
+	}
+
+	U32 invalid = 0;
+	for (std::vector<LLPointer<LLInventoryCacheParseJob> >::iterator iter = jobs.begin(); iter != jobs.end(); ++iter)
+	{
+		LLInventoryCacheParseJob* job = *iter;
+		categories.insert(categories.end(), job->mCategories.begin(), job->mCategories.end());
+		items.insert(items.end(), job->mItems.begin(), job->mItems.end());
+		invalid += job->mInvalid;
+	}
+	return invalid;
+}
+
+U32 LLInventoryCacheParser::parse(LLInventoryCacheReader const& reader, U32 first, U32 last, cat_list_t& categories, item_list_t& items) const
+{
+	U32 invalid = 0;
+	for (U32 i = first; i < last; ++i)
+	{
+		if (!parseRecord(reader, reader.getEntry(i), categories, items))
+		{
+			++invalid;
+		}
+	}
+	return invalid;
+}
+
+bool LLInventoryCacheParser::parseRecord(LLInventoryCacheReader const& reader, LLInventoryCacheEntry const& entry, cat_list_t& categories, item_list_t& items) const
+{
+	LLDataPackerBinaryBuffer dp(const_cast<U8*>(reader.getRecord(entry)), entry.mSize);
+	LLPointer<LLInventoryCategory> category = createCategory();
+	if (!category->unpackBinary(dp) || category->getUUID() != entry.mCategoryID)
+	{
+		return false;
+	}
+	item_list_t::size_type num_items = items.size();
+	for (U32 i = 0; i < entry.mNumItems; ++i)
+	{
+		LLPointer<LLInventoryItem> item = createItem();
+		if (!item->unpackBinary(dp))
+		{
+			items.resize(num_items);
+			return false;
+		}
+		items.push_back(item);
+	}
+	if (dp.getCurrentSize() != (S32)entry.mSize)
+	{
+		items.resize(num_items);
+		return false;
+	}
+	categories.push_back(category);
+	return true;
+}
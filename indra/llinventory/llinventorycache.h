@@ -0,0 +1,182 @@
+/**
+ * @file llinventorycache.h
+ * @brief Binary, memory mappable inventory cache file.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHE_H
+#define LL_LLINVENTORYCACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llfile.h"
+#include "llinventory.h"
+#include "llpointer.h"
+#include "lluuid.h"
+
+class LLThreadPool;
+
+//============================================================================
+// The inventory cache file.
+//
+// The file starts with a header, followed by one record per category and
+// ends with a directory that has an entry per record:
+//
+//   header | record | record | ... | 0 | directory
+//
+// A record is the category (see LLInventoryCategory::packBinary) followed
+// by all of its cached items (see LLInventoryItem::packBinary). Records can
+// be parsed independently of each other, so that loading can be split over
+// threads, and the record of a category that didn't change can be copied
+// verbatim into the next cache file.
+//
+// The file is written in native byte order; a file written on a machine
+// with another byte order, or with another format version, is obsolete.
+// So is a file with another content version: the application increments
+// that when what it caches changes incompatibly.
+
+// An entry of the directory.
+struct LLInventoryCacheEntry
+{
+	LLUUID mCategoryID;
+	S32 mVersion;					// Version of the category when the record was written.
+	U32 mNumItems;					// Number of items in the record.
+	U32 mOffset;					// Position of the record in the file.
+	U32 mSize;						// Size of the record in bytes.
+};
+
+// Maps a cache file in memory and gives access to its records.
+class LLInventoryCacheReader
+{
+public:
+	enum EStatus {
+		OK,
+		NOT_FOUND,					// There is no such file.
+		OBSOLETE,					// The file has another format or content version, or is not a binary cache at all.
+		CORRUPT						// The file is truncated or otherwise invalid.
+	};
+
+	LLInventoryCacheReader();
+	~LLInventoryCacheReader();
+
+	EStatus open(std::string const& filename, U32 content_version);
+	void close(void);
+	bool isOpen(void) const { return mData != NULL; }
+
+	U32 getNumEntries(void) const { return mNumEntries; }
+	LLInventoryCacheEntry const& getEntry(U32 index) const { return mEntries[index]; }
+	U8 const* getRecord(LLInventoryCacheEntry const& entry) const { return mData + entry.mOffset; }
+
+	// Return the entry of the record of category_id, or NULL if there is none.
+	LLInventoryCacheEntry const* find(LLUUID const& category_id) const;
+
+private:
+	// Not copyable.
+	LLInventoryCacheReader(LLInventoryCacheReader const&);
+	LLInventoryCacheReader& operator=(LLInventoryCacheReader const&);
+
+	bool map(std::string const& filename);
+	void unmap(void);
+	EStatus validate(U32 content_version);
+
+	U8 const* mData;
+	U32 mSize;
+	LLInventoryCacheEntry const* mEntries;
+	U32 mNumEntries;
+	mutable std::map<LLUUID, U32> mIndex;	// Built by the first call to find().
+	std::vector<U8> mBuffer;				// Holds the file when it could not be mapped.
+#if LL_WINDOWS
+	void* mFile;
+	void* mMapping;
+#else
+	int mFD;
+#endif
+};
+
+// Writes a new cache file next to the old one and replaces it when done,
+// so that an interrupted save never leaves a truncated cache behind.
+class LLInventoryCacheWriter
+{
+public:
+	LLInventoryCacheWriter();
+	~LLInventoryCacheWriter();		// Removes the new file if commit() wasn't called.
+
+	bool open(std::string const& filename, U32 content_version);
+
+	// Write a record with category and items.
+	bool addRecord(LLInventoryCategory const& category, S32 version, std::vector<LLInventoryItem const*> const& items);
+	// Copy a record from (usually the previous version of) the cache file.
+	bool copyRecord(LLInventoryCacheReader const& reader, LLInventoryCacheEntry const& entry);
+
+	// Write the directory and replace the cache file. On Windows a file can't be
+	// replaced while it is mapped, so any reader of the old file must be closed first.
+	bool commit(void);
+
+private:
+	// Not copyable.
+	LLInventoryCacheWriter(LLInventoryCacheWriter const&);
+	LLInventoryCacheWriter& operator=(LLInventoryCacheWriter const&);
+
+	bool write(void const* data, U32 size);
+	void abort(void);
+
+	std::string mFilename;
+	std::string mTempFilename;
+	U32 mContentVersion;
+	LLFILE* mFile;
+	U32 mOffset;
+	std::vector<LLInventoryCacheEntry> mEntries;
+	std::vector<U8> mBuffer;
+};
+
+// Turns the records of a cache file back into categories and items.
+// Derive from it to create viewer specific objects.
+class LLInventoryCacheParser
+{
+public:
+	typedef std::vector<LLPointer<LLInventoryCategory> > cat_list_t;
+	typedef std::vector<LLPointer<LLInventoryItem> > item_list_t;
+
+	LLInventoryCacheParser() { }
+	virtual ~LLInventoryCacheParser() { }
+
+	// Parse all records of reader and append their categories and items, in file
+	// order. If pool isn't NULL the records are split in ranges that are parsed by
+	// the threads of pool. Returns the number of records that were invalid, and skipped.
+	U32 parse(LLInventoryCacheReader const& reader, LLThreadPool* pool, cat_list_t& categories, item_list_t& items) const;
+
+	// Parse the records [first, last) of reader. Called from any thread.
+	U32 parse(LLInventoryCacheReader const& reader, U32 first, U32 last, cat_list_t& categories, item_list_t& items) const;
+
+protected:
+	// These are called from the threads of the pool.
+	virtual LLInventoryCategory* createCategory(void) const { return new LLInventoryCategory; }
+	virtual LLInventoryItem* createItem(void) const { return new LLInventoryItem; }
+
+private:
+	bool parseRecord(LLInventoryCacheReader const& reader, LLInventoryCacheEntry const& entry, cat_list_t& categories, item_list_t& items) const;
+};
+
+#endif // LL_LLINVENTORYCACHE_H
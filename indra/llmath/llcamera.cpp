@@ -284,6 +284,76 @@ S32 LLCamera::AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a&
 	return result?1:2;
 }
 
+void LLCamera::AABBsInFrustum(const LLCameraAABBBatch& batch, S32* results, bool far_clip, const LLPlane* planes)
+{
+	if(!planes)
+	{
+		//use agent space
+		planes = mAgentPlanes;
+	}
+
+	U32 max_planes = llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM);		// mAgentPlanes[] size is 7
+	for (U32 first = 0; first < batch.mCount; first += 4)
+	{
+		LLVector4a center[3], radius[3];
+		for (U32 k = 0; k < 3; k++)
+		{
+			center[k].load4a(&batch.mCenter[k][first]);
+			radius[k].load4a(&batch.mRadius[k][first]);
+		}
+
+		// One bit per box, like getGatheredBits().
+		U32 outside = 0;
+		U32 partial = 0;
+		for (U32 i = 0; i < max_planes && outside != 0xf; i++)
+		{
+			U8 mask = mPlaneMask[i];
+			if (mask >= PLANE_MASK_NUM || (!far_clip && i == AGENT_PLANE_FAR))
+			{
+				continue;
+			}
+			const LLPlane& p(planes[i]);
+			LLVector4a n[3], d;
+			for (U32 k = 0; k < 3; k++)
+			{
+				n[k].splat(p[k]);
+			}
+			d.splat(-p[3]);
+
+			// The same operations as AABBInFrustum(), in the same order, on four boxes: the results are identical.
+			LLVector4a minp[3], maxp[3];
+			for (U32 k = 0; k < 3; k++)
+			{
+				LLVector4a scaler, rscale;
+				scaler.splat(sFrustumScaler[mask][k]);
+				rscale.setMul(radius[k], scaler);
+				minp[k].setSub(center[k], rscale);
+				maxp[k].setAdd(center[k], rscale);
+			}
+			LLVector4a dot, t;
+			dot.setMul(n[0], minp[0]);
+			t.setMul(n[1], minp[1]);
+			dot.add(t);
+			t.setMul(n[2], minp[2]);
+			dot.add(t);
+			outside |= dot.greaterThan(d).getGatheredBits();
+
+			dot.setMul(n[0], maxp[0]);
+			t.setMul(n[1], maxp[1]);
+			dot.add(t);
+			t.setMul(n[2], maxp[2]);
+			dot.add(t);
+			partial |= dot.greaterThan(d).getGatheredBits();
+		}
+
+		U32 count = llmin(batch.mCount - first, (U32)4);
+		for (U32 j = 0; j < count; j++)
+		{
+			results[first + j] = (outside & (1 << j)) ? 0 : ((partial & (1 << j)) ? 1 : 2);
+		}
+	}
+}
+
 //exactly same as the function AABBInFrustumNoFarClip(...)
 //except uses mRegionPlanes instead of mAgentPlanes.
 S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius)
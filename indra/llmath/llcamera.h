@@ -51,6 +51,46 @@ const F32 MIN_FAR_PLANE 	= 0.2f;
 static const F32 MIN_FIELD_OF_VIEW = 5.0f * DEG_TO_RAD;
 static const F32 MAX_FIELD_OF_VIEW = 320.f * DEG_TO_RAD;
 
+// Up to MAX_BOXES axis aligned bounding boxes (center and half size, like LLSpatialGroup::mBounds),
+// stored as a structure of arrays so that LLCamera::AABBsInFrustum() can test four of them at a time.
+LL_ALIGN_PREFIX(16)
+class LLCameraAABBBatch
+{
+public:
+	enum { MAX_BOXES = 8 };
+
+	LLCameraAABBBatch() { clear(); }
+
+	void clear()
+	{
+		memset(mCenter, 0, sizeof(mCenter));
+		memset(mRadius, 0, sizeof(mRadius));
+		mCount = 0;
+	}
+
+	U32 getCount() const { return mCount; }
+	bool isFull() const { return mCount == MAX_BOXES; }
+
+	// Returns the index of the box, which is also the index of its result.
+	U32 add(const LLVector4a& center, const LLVector4a& radius)
+	{
+		llassert(mCount < MAX_BOXES);
+		for (U32 i = 0; i < 3; ++i)
+		{
+			mCenter[i][mCount] = center[i];
+			mRadius[i][mCount] = radius[i];
+		}
+		return mCount++;
+	}
+
+private:
+	friend class LLCamera;
+
+	LL_ALIGN_16(F32 mCenter[3][MAX_BOXES]);	// x, y and z of every box.
+	LL_ALIGN_16(F32 mRadius[3][MAX_BOXES]);
+	U32 mCount;
+} LL_ALIGN_POSTFIX(16);
+
 // An LLCamera is an LLCoorFrame with a view frustum.
 // This means that it has several methods for moving it around 
 // that are inherited from the LLCoordFrame() class :
@@ -207,6 +247,9 @@ public:
 	S32 AABBInRegionFrustum(const LLVector4a& center, const LLVector4a& radius);
 	S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
 	S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
+	// Tests all boxes of batch, four at a time, and stores the result of each box in results: exactly what
+	// AABBInFrustum() (far_clip) or AABBInFrustumNoFarClip() (!far_clip) returns for it.
+	void AABBsInFrustum(const LLCameraAABBBatch& batch, S32* results, bool far_clip = true, const LLPlane* planes = NULL);
 
 	//does a quick 'n dirty sphere-sphere check
 	S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius); 
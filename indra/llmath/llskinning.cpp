@@ -0,0 +1,207 @@
+/**
+ * @file llskinning.cpp
+ * @brief Vectorized CPU vertex skinning kernels.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmath.h"
+#include "llskinning.h"
+
+namespace
+{
+	// Skins one batch of vertices on a worker thread.
+	class LLSkinningJob : public LLThreadPool::Job
+	{
+	public:
+		LLSkinningJob(const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+					  const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+					  LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count, bool positions_only) :
+			mPalette(palette), mPaletteSize(palette_size), mBindShape(bind_shape),
+			mWeights(weights), mSrcPos(src_pos), mSrcNorm(src_norm),
+			mDstPos(dst_pos), mDstNorm(dst_norm), mCount(count), mPositionsOnly(positions_only) { }
+
+		/*virtual*/ void run(void)
+		{
+			if (mPositionsOnly)
+			{
+				LLSkinning::skinPositions(mPalette, mPaletteSize, mBindShape, mWeights, mSrcPos, mDstPos, mCount);
+			}
+			else
+			{
+				LLSkinning::skinVertices(mPalette, mPaletteSize, mBindShape, mWeights, mSrcPos, mSrcNorm, mDstPos, mDstNorm, mCount);
+			}
+		}
+
+	private:
+		// All pointers are owned by the poster, who waits for the job to finish.
+		const LLMatrix4a* mPalette;
+		U32 mPaletteSize;
+		const LLMatrix4a& mBindShape;
+		const LLVector4a* mWeights;
+		const LLVector4a* mSrcPos;
+		const LLVector4a* mSrcNorm;
+		LLVector4a* mDstPos;
+		LLVector4a* mDstNorm;
+		U32 mCount;
+		bool mPositionsOnly;
+	};
+
+	// Returns the number of vertices that the caller should skin itself, starting at vertex 0.
+	U32 post_batches(LLThreadPool* pool, LLThreadPool::Group& group,
+					 const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+					 const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+					 LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count, bool positions_only)
+	{
+		if (!pool || count < 2 * LLSkinning::MIN_BATCH_SIZE)
+		{
+			return count;
+		}
+
+		U32 batches = llmin(count / LLSkinning::MIN_BATCH_SIZE, (U32)pool->getThreadCount() + 1);
+		U32 batch_size = (count + batches - 1) / batches;
+		batch_size = (batch_size + 3) & ~3;		// Keep batches on a cache line boundary.
+
+		U32 first = llmin(batch_size, count);
+		for (U32 start = first; start < count; start += batch_size)
+		{
+			U32 n = llmin(batch_size, count - start);
+			LLPointer<LLThreadPool::Job> job = new LLSkinningJob(palette, palette_size, bind_shape, weights + start,
+												   src_pos + start, src_norm ? src_norm + start : NULL,
+												   dst_pos + start, dst_norm ? dst_norm + start : NULL,
+												   n, positions_only);
+			if (!pool->post(job, &group))
+			{	// Shutting down; do it ourselves.
+				job->run();
+			}
+		}
+		return first;
+	}
+}
+
+//static
+void LLSkinning::getBlendedMatrix(const LLMatrix4a* palette, U32 palette_size,
+								  const LLVector4a& packed_weight, LLMatrix4a& final_mat)
+{
+	// Weights are never negative, so truncation is the same as floorf().
+	__m128i packed_idx = _mm_cvttps_epi32(packed_weight);
+	LLVector4a wght;
+	wght.setSub(packed_weight, LLVector4a(_mm_cvtepi32_ps(packed_idx)));
+
+	LL_ALIGN_16(S32 idx[4]);
+	LL_ALIGN_16(F32 w[4]);
+	_mm_store_si128((__m128i*)idx, packed_idx);
+	wght.store4a(w);
+
+	// Summed in the same order as the scalar code, to get the same rounding.
+	F32 scale = w[0] + w[1] + w[2] + w[3];
+	if (scale > 0.f)
+	{
+		// LLVector4::operator*= leaves the fourth component alone, and the
+		// scalar loops relied on that; keep the results identical.
+		F32 inv_scale = 1.f / scale;
+		w[0] *= inv_scale;
+		w[1] *= inv_scale;
+		w[2] *= inv_scale;
+	}
+	else
+	{
+		w[0] = w[1] = w[2] = w[3] = F32_MAX;
+	}
+
+	final_mat.clear();
+	for (U32 k = 0; k < 4; ++k)
+	{
+		LLMatrix4a src;
+		src.setMul(palette[llmin((U32)idx[k], palette_size - 1)], w[k]);
+		final_mat.add(src);
+	}
+}
+
+//static
+void LLSkinning::skinPositions(const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							   const LLVector4a* weights, const LLVector4a* src, LLVector4a* dst, U32 count)
+{
+	LLMatrix4a final_mat;
+	LLVector4a t;
+	for (U32 i = 0; i < count; ++i)
+	{
+		getBlendedMatrix(palette, palette_size, weights[i], final_mat);
+		bind_shape.affineTransform(src[i], t);
+		final_mat.affineTransform(t, dst[i]);
+	}
+}
+
+//static
+void LLSkinning::skinVertices(const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							  const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+							  LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count)
+{
+	LLMatrix4a final_mat;
+	for (U32 i = 0; i < count; ++i)
+	{
+		getBlendedMatrix(palette, palette_size, weights[i], final_mat);
+		final_mat.mul(bind_shape);
+		final_mat.affineTransform(src_pos[i], dst_pos[i]);
+
+		if (dst_norm)
+		{
+			final_mat.invert();
+			final_mat.transpose();
+			final_mat.affineTransform(src_norm[i], dst_norm[i]);
+		}
+	}
+}
+
+//static
+void LLSkinning::getExtents(const LLVector4a* pos, U32 count, LLVector4a& min, LLVector4a& max)
+{
+	llassert(count > 0);
+	min = pos[0];
+	max = pos[0];
+	for (U32 i = 1; i < count; ++i)
+	{
+		min.setMin(min, pos[i]);
+		max.setMax(max, pos[i]);
+	}
+}
+
+//static
+void LLSkinning::skinPositions(LLThreadPool* pool, LLThreadPool::Group& group,
+							   const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							   const LLVector4a* weights, const LLVector4a* src, LLVector4a* dst, U32 count)
+{
+	U32 first = post_batches(pool, group, palette, palette_size, bind_shape, weights, src, NULL, dst, NULL, count, true);
+	skinPositions(palette, palette_size, bind_shape, weights, src, dst, first);
+}
+
+//static
+void LLSkinning::skinVertices(LLThreadPool* pool, LLThreadPool::Group& group,
+							  const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							  const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+							  LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count)
+{
+	U32 first = post_batches(pool, group, palette, palette_size, bind_shape, weights, src_pos, src_norm, dst_pos, dst_norm, count, false);
+	skinVertices(palette, palette_size, bind_shape, weights, src_pos, src_norm, dst_pos, dst_norm, first);
+}
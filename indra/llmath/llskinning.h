@@ -0,0 +1,85 @@
+/**
+ * @file llskinning.h
+ * @brief Vectorized CPU vertex skinning kernels.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSKINNING_H
+#define LL_LLSKINNING_H
+
+#include "llmatrix4a.h"
+#include "llthreadpool.h"
+
+// Rigged mesh weights are packed four per vertex in an LLVector4a: the
+// integer part of each component is an index into the matrix palette and
+// the fractional part is the (not yet normalized) weight of that joint.
+//
+// The kernels below do the same arithmetic, in the same order, as the
+// per-vertex loops they replace, so their output is bit identical to the
+// scalar code; they just avoid the LLVector4 round trips and never touch
+// a palette entry outside [0, palette_size).
+//
+// All kernels are reentrant; callers may skin disjoint vertex ranges from
+// several threads at once.
+class LLSkinning
+{
+public:
+	// Blend the palette matrices selected by packed_weight into final_mat.
+	static void getBlendedMatrix(const LLMatrix4a* palette, U32 palette_size,
+								 const LLVector4a& packed_weight, LLMatrix4a& final_mat);
+
+	// dst[i] = blend(weights[i]) * (bind_shape * src[i]), for i in [0, count).
+	// This is the transform used by LLRiggedVolume.
+	static void skinPositions(const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							  const LLVector4a* weights, const LLVector4a* src, LLVector4a* dst, U32 count);
+
+	// Like skinPositions, but the bind shape matrix is folded into each blended
+	// matrix, and normals (if dst_norm isn't NULL) are transformed by its inverse
+	// transpose. This is the transform used by software skinning of avatar
+	// vertex buffers.
+	static void skinVertices(const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							 const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+							 LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count);
+
+	// Axis aligned bounding box of count (> 0) positions.
+	static void getExtents(const LLVector4a* pos, U32 count, LLVector4a& min, LLVector4a& max);
+
+	// Parallel versions of skinPositions and skinVertices. The vertices are split into
+	// batches of at least MIN_BATCH_SIZE; all but the first batch are posted to pool
+	// with group, the first batch is skinned by the calling thread before returning.
+	// Call group.wait() before using the output, or touching any of the input; it
+	// skins the batches that no worker started yet itself, so a busy pool doesn't
+	// make the calling thread wait for unrelated jobs.
+	// With a NULL pool, or few vertices, everything is done by the calling thread.
+	static void skinPositions(LLThreadPool* pool, LLThreadPool::Group& group,
+							  const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							  const LLVector4a* weights, const LLVector4a* src, LLVector4a* dst, U32 count);
+	static void skinVertices(LLThreadPool* pool, LLThreadPool::Group& group,
+							 const LLMatrix4a* palette, U32 palette_size, const LLMatrix4a& bind_shape,
+							 const LLVector4a* weights, const LLVector4a* src_pos, const LLVector4a* src_norm,
+							 LLVector4a* dst_pos, LLVector4a* dst_norm, U32 count);
+
+	enum { MIN_BATCH_SIZE = 2048 };
+};
+
+#endif // LL_LLSKINNING_H
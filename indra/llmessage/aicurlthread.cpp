@@ -42,6 +42,7 @@
 #include "llhttpstatuscodes.h"
 #include "llbuffer.h"
 #include "llcontrol.h"
+#include "llfasttimer.h"
 #include <sys/types.h>
 #if !LL_WINDOWS
 #include <sys/select.h>
@@ -1440,6 +1441,10 @@ static bool is_bad(curl_socket_t fd, bool for_writing)
 }
 
 // The main loop of the curl thread.
+static LLFastTimer::DeclareTimer FTM_CURL_SELECT("Curl Select");
+static LLFastTimer::DeclareTimer FTM_CURL_COMMANDS("Curl Commands");
+static LLFastTimer::DeclareTimer FTM_CURL_SOCKET_ACTION("Curl Socket Action");
+
 void AICurlThread::run(void)
 {
   DoutEntering(dc::curl, "AICurlThread::run()");
@@ -1459,6 +1464,7 @@ void AICurlThread::run(void)
 		if (mWakeUpFlag)
 		{
 		  mWakeUpFlagMutex.unlock();
+		  LLFastTimer t(FTM_CURL_COMMANDS);
 		  process_commands(multi_handle_w);
 		  continue;
 		}
@@ -1559,7 +1565,10 @@ void AICurlThread::run(void)
 #endif
 	  AIPerService::current_fdsets(read_fd_set, write_fd_set);
 #endif
-	  ready = select(nfds, read_fd_set, write_fd_set, NULL, &timeout);
+	  {
+		LLFastTimer t(FTM_CURL_SELECT);
+		ready = select(nfds, read_fd_set, write_fd_set, NULL, &timeout);
+	  }
 	  mWakeUpFlagMutex.unlock();
 #ifdef CWDEBUG
 #ifdef DEBUG_CURLIO
@@ -1668,6 +1677,7 @@ void AICurlThread::run(void)
 		  --ready;
 		}
 		// Handle all active filedescriptors.
+		LLFastTimer t(FTM_CURL_SOCKET_ACTION);
 		MergeIterator iter(multi_handle_w->mReadPollSet, multi_handle_w->mWritePollSet);
 		curl_socket_t fd;
 		int ev_bitmask;
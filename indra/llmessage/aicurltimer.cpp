@@ -53,6 +53,7 @@
 
 #include "aicurltimer.h"
 #include "lltimer.h"
+#include "lldefs.h"
 
 static U64 const NEVER = ((U64)1) << 60;	// The year 36,560,871.
 
@@ -60,70 +61,71 @@ static U64 const NEVER = ((U64)1) << 60;	// The year 36,560,871.
 F64 const AICurlTimer::sClockWidth_1ms = 1000.0 / calc_clock_frequency();       // Time between two clock ticks, in 1ms units.
 U64 AICurlTimer::sTime_1ms;														// Time in 1ms units, set once per select() entry.
 U64 AICurlTimer::sNextExpiration = NEVER;
-AICurlTimer::timer_list_type AICurlTimer::sTimerList;
+LLTimerWheel AICurlTimer::sTimerWheel;
+
+//static
+void AICurlTimer::insert(AIRunningCurlTimer* running_timer, deltams_type expiration)
+{
+	sTimerWheel.insert(running_timer, sTime_1ms + expiration, sTime_1ms);
+	sNextExpiration = llmin(sNextExpiration, running_timer->expiration());
+}
 
 void AICurlTimer::create(deltams_type expiration, signal_type::slot_type const& slot)
 {
-	AIRunningCurlTimer new_timer(expiration, this);
-	llassert(mHandle.mRunningTimer == sTimerList.end());	// Create may only be called when the timer isn't already running.
-	mHandle.init(sTimerList.insert(new_timer), slot);
-	sNextExpiration = sTimerList.begin()->expiration();
+	llassert(!mHandle.mRunningTimer);	// Create may only be called when the timer isn't already running.
+	mHandle.mRunningTimer = new AIRunningCurlTimer(this, slot);
+	insert(mHandle.mRunningTimer, expiration);
 }
 
 void AICurlTimer::refresh(deltams_type expiration)
 {
 	// If not running, ignore this call.
-	if (mHandle.mRunningTimer != sTimerList.end())
+	if (mHandle.mRunningTimer)
 	{
-	  // Keep a copy of mHandle.mRunningTimer and the signal pointer.
-	  timer_list_type::iterator position = mHandle.mRunningTimer;
-	  // Reset mSignal in the old running timer so that it won't get deleted, and keep a copy.
-	  Signal* callback = mHandle.mRunningTimer->move();
-	  // Erase the old timer, advancing position to point to the next element.
-	  sTimerList.erase(position++);
-	  // Create a new AIRunningCurlTimer object with an updated expiration
-	  // and using the same callback. Insert it using position as hint.
-	  mHandle.init(sTimerList.insert(position, AIRunningCurlTimer(expiration, this)), callback);
-	  // Update sNextExpiration.
-	  sNextExpiration = sTimerList.begin()->expiration();
+	  // Move the running timer to the slot of its new expiration; this doesn't allocate.
+	  sTimerWheel.remove(mHandle.mRunningTimer);
+	  insert(mHandle.mRunningTimer, expiration);
 	}
 }
 
 void AICurlTimer::cancel(void)
 {
-    if (mHandle.mRunningTimer != sTimerList.end())
+    if (mHandle.mRunningTimer)
 	{
-		sTimerList.erase(mHandle.mRunningTimer);
-		mHandle.mRunningTimer = sTimerList.end();
-		sNextExpiration = sTimerList.empty() ? NEVER : sTimerList.begin()->expiration();
+		sTimerWheel.remove(mHandle.mRunningTimer);
+		delete mHandle.mRunningTimer;
+		mHandle.mRunningTimer = NULL;
+		// Otherwise sNextExpiration is left alone: it is a lower bound.
+		if (sTimerWheel.empty())
+		{
+			sNextExpiration = NEVER;
+		}
 	}
 }
 
 void AICurlTimer::handleExpiration(void)
 {
+	LLTimerWheel::List expired;
 	for(;;)
 	{
-		if (sTimerList.empty())
+		// This also returns timers that were created by the callbacks below with an expiration that already passed.
+		sTimerWheel.advance(sTime_1ms, expired);
+		if (expired.empty())
 		{
-			// No running timers left.
-			sNextExpiration = NEVER;
 			break;
 		}
-		timer_list_type::iterator running_timer = sTimerList.begin();
-		sNextExpiration = running_timer->expiration();
-		if (sNextExpiration > sTime_1ms)
+		do
 		{
-			// Didn't expire yet.
-			break;
+			AIRunningCurlTimer* running_timer = static_cast<AIRunningCurlTimer*>(expired.pop_front());
+			Handle& handle(running_timer->getTimer()->mHandle);
+			llassert_always(running_timer == handle.mRunningTimer);
+			handle.mRunningTimer = NULL;
+			running_timer->do_callback();		// May not throw exceptions.
+			// The callback might have called create() again, but that uses a new object.
+			delete running_timer;
 		}
-
-		Handle& handle(running_timer->getTimer()->mHandle);
-		llassert_always(running_timer == handle.mRunningTimer);
-		handle.mRunningTimer = sTimerList.end();
-		running_timer->do_callback();		// May not throw exceptions.
-
-		// Erase the timer from the running list.
-		sTimerList.erase(running_timer);
+		while (!expired.empty());
 	}
+	U64 next = sTimerWheel.nextExpiration();
+	sNextExpiration = next == LLTimerWheel::NEVER ? NEVER : next;
 }
-
@@ -33,8 +33,8 @@
 
 #include "llerror.h"			// llassert
 #include "stdtypes.h"			// U64, F64
+#include "lltimerwheel.h"
 #include <boost/signals2.hpp>
-#include <set>
 
 class AICurlTimer
 {
@@ -43,60 +43,27 @@ class AICurlTimer
 	typedef long deltams_type;
 
   private:
-	class AIRunningCurlTimer;
-	typedef std::multiset<AIRunningCurlTimer> timer_list_type;
-
-	// Use separate struct for this object because it is non-copyable.
-	struct Signal {
-		signal_type mSignal;
-	};
-
-	class AIRunningCurlTimer {
+	// The object in AICurlTimer::sTimerWheel. It is allocated by create() and
+	// deleted when the timer expires or is cancelled; refresh() reuses it.
+	class AIRunningCurlTimer : public LLTimerWheel::Node {
 	  private:
-		U64 mExpire;						// Time at which the timer expires, in miliseconds since the epoch (compared to LLCurlTimer::sTime_1ms).
 		AICurlTimer* mTimer;				// The actual timer.
-		// Can be mutable, since only the mExpire is used for ordering this object in the multiset AICurlTimer::sTimerList.
-		mutable Signal* mCallback;			// Pointer to callback struct, or NULL when the object wasn't added to sTimerList yet.
+		signal_type mSignal;
 
 	  public:
-		AIRunningCurlTimer(deltams_type expiration, AICurlTimer* timer) : mExpire(AICurlTimer::sTime_1ms + expiration), mTimer(timer), mCallback(NULL) { }
-		~AIRunningCurlTimer() { delete mCallback; }
-
-		// This function is called after the final object was added to sTimerList (where it is initialized in-place).
-		void init(signal_type::slot_type const& slot) const
-			{
-			  // We may only call init() once.
-			  llassert(!mCallback);
-			  mCallback = new Signal;
-			  mCallback->mSignal.connect(slot);
-			}
-		// Initialize the final object in-place (called from Handle::init).
-		void init(Signal* callback) const
-			{
-			  // We may only call init() once.
-			  llassert(!mCallback);
-			  mCallback = callback;
-			}
-		// Extract the callback.
-		Signal* move(void) const { Signal* ret = mCallback; mCallback = NULL; return ret; }
-
-		// Order AICurlTimer::sTimerList so that the timer that expires first is up front.
-		friend bool operator<(AIRunningCurlTimer const& ft1, AIRunningCurlTimer const& ft2) { return ft1.mExpire < ft2.mExpire; }
-
-		void do_callback(void) const { mCallback->mSignal(); }
-		U64 expiration(void) const { return mExpire; }
-		AICurlTimer* getTimer(void) const { return mTimer; }
+		AIRunningCurlTimer(AICurlTimer* timer, signal_type::slot_type const& slot) : mTimer(timer) { mSignal.connect(slot); }
 
-#if LL_DEBUG
-		// May not copy this object after it was initialized.
-		AIRunningCurlTimer(AIRunningCurlTimer const& running_curl_timer) :
-			mExpire(running_curl_timer.mExpire), mTimer(running_curl_timer.mTimer), mCallback(running_curl_timer.mCallback)
-			{ llassert(!mCallback); }
-#endif
+		void do_callback(void) const { mSignal(); }
+		// Time at which the timer expires, in miliseconds since the epoch (compared to AICurlTimer::sTime_1ms).
+		U64 expiration(void) const { return getExpiration(); }
+		AICurlTimer* getTimer(void) const { return mTimer; }
 	};
 
-	static timer_list_type sTimerList;			// List with all running timers.
-	static U64 sNextExpiration;					// Cache of smallest value in sTimerList.
+	static LLTimerWheel sTimerWheel;			// All running timers, in ticks of 1 ms.
+	static U64 sNextExpiration;					// Lower bound of the smallest expiration in sTimerWheel.
+
+	// Put running_timer in sTimerWheel, to expire expiration ms from now.
+	static void insert(AIRunningCurlTimer* running_timer, deltams_type expiration);
 
   public:
 	static F64 const sClockWidth_1ms;			// Time between two clock ticks in 1 ms units.
@@ -108,25 +75,10 @@ class AICurlTimer
   private:
 	class Handle {
 	  public:
-		timer_list_type::iterator mRunningTimer;	// Points to the running timer, or to sTimerList.end() when not running.
-													// Access to this iterator is protected by the AICurlTimer::sMutex!
+		AIRunningCurlTimer* mRunningTimer;			// Points to the running timer, or NULL when not running.
 
 		// Constructor for a not-running timer.
-		Handle(void) : mRunningTimer(sTimerList.end()) { }
-
-		// Actual initialization used by AICurlTimer::create.
-		void init(timer_list_type::iterator const& running_timer, signal_type::slot_type const& slot)
-			{
-			  mRunningTimer = running_timer;
-			  mRunningTimer->init(slot);
-			}
-
-		// Actual initialization used by AICurlTimer::refresh.
-		void init(timer_list_type::iterator const& running_timer, Signal* callback)
-			{
-			  mRunningTimer = running_timer;
-			  mRunningTimer->init(callback);
-			}
+		Handle(void) : mRunningTimer(NULL) { }
 
 	  private:
 		// No assignment operator.
@@ -153,7 +105,7 @@ class AICurlTimer
 	void refresh(deltams_type expiration);
 	void cancel(void);
 
-	bool isRunning(void) const { return mHandle.mRunningTimer != sTimerList.end(); }
+	bool isRunning(void) const { return mHandle.mRunningTimer != NULL; }
 
   public:
 	static void handleExpiration(void);
@@ -195,15 +195,29 @@ BOOL LLDataPackerBinaryBuffer::packString(const std::string& value, const char *
 
 BOOL LLDataPackerBinaryBuffer::unpackString(std::string& value, const char *name)
 {
-	BOOL success = TRUE;
-	S32 length = (S32)strlen((char *)mCurBufferp) + 1; /*Flawfinder: ignore*/
-
-	success &= verifyLength(length, name);
+	S32 length;
+	if (mWriteEnabled)
+	{
+		// Don't look for the terminating NULL beyond the end of the buffer.
+		S32 remaining = mBufferSize - (S32)(mCurBufferp - mBufferp);
+		U8 const* end = remaining > 0 ? (U8 const*)memchr(mCurBufferp, 0, remaining) : NULL;
+		if (!end)
+		{
+			llwarns << "Unterminated string in BinaryBuffer, field name " << name << "!" << llendl;
+			value.clear();
+			return FALSE;
+		}
+		length = (S32)(end - mCurBufferp) + 1;
+	}
+	else
+	{
+		length = (S32)strlen((char *)mCurBufferp) + 1; /*Flawfinder: ignore*/
+	}
 
-	value = std::string((char*)mCurBufferp); // We already assume NULL termination calling strlen()
+	value = std::string((char*)mCurBufferp, length - 1);
 	
 	mCurBufferp += length;
-	return success;
+	return TRUE;
 }
 
 BOOL LLDataPackerBinaryBuffer::packBinaryData(const U8 *value, S32 size, const char *name)
@@ -229,9 +243,12 @@ BOOL LLDataPackerBinaryBuffer::unpackBinaryData(U8 *value, S32 &size, const char
 {
 	BOOL success = TRUE;
 	success &= verifyLength(4, name);
-	htonmemcpy(&size, mCurBufferp, MVT_S32, 4);
-	mCurBufferp += 4;
-	success &= verifyLength(size, name);
+	if (success)
+	{
+		htonmemcpy(&size, mCurBufferp, MVT_S32, 4);
+		mCurBufferp += 4;
+		success &= size >= 0 && verifyLength(size, name);
+	}
 	if (success)
 	{
 		htonmemcpy(value, mCurBufferp, MVT_VARIABLE, size);
@@ -264,7 +281,10 @@ BOOL LLDataPackerBinaryBuffer::unpackBinaryDataFixed(U8 *value, S32 size, const
 {
 	BOOL success = TRUE;
 	success &= verifyLength(size, name);
-	htonmemcpy(value, mCurBufferp, MVT_VARIABLE, size);
+	if (success)
+	{
+		htonmemcpy(value, mCurBufferp, MVT_VARIABLE, size);
+	}
 	mCurBufferp += size;
 	return success;
 }
@@ -289,7 +309,10 @@ BOOL LLDataPackerBinaryBuffer::unpackU8(U8 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(sizeof(U8), name);
 
-	value = *mCurBufferp;
+	if (success)
+	{
+		value = *mCurBufferp;
+	}
 	mCurBufferp++;
 	return success;
 }
@@ -314,7 +337,10 @@ BOOL LLDataPackerBinaryBuffer::unpackU16(U16 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(sizeof(U16), name);
 
-	htonmemcpy(&value, mCurBufferp, MVT_U16, 2);
+	if (success)
+	{
+		htonmemcpy(&value, mCurBufferp, MVT_U16, 2);
+	}
 	mCurBufferp += 2;
 	return success;
 }
@@ -339,7 +365,10 @@ BOOL LLDataPackerBinaryBuffer::unpackU32(U32 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(sizeof(U32), name);
 
-	htonmemcpy(&value, mCurBufferp, MVT_U32, 4);
+	if (success)
+	{
+		htonmemcpy(&value, mCurBufferp, MVT_U32, 4);
+	}
 	mCurBufferp += 4;
 	return success;
 }
@@ -364,7 +393,10 @@ BOOL LLDataPackerBinaryBuffer::unpackS32(S32 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(sizeof(S32), name);
 
-	htonmemcpy(&value, mCurBufferp, MVT_S32, 4);
+	if (success)
+	{
+		htonmemcpy(&value, mCurBufferp, MVT_S32, 4);
+	}
 	mCurBufferp += 4;
 	return success;
 }
@@ -389,7 +421,10 @@ BOOL LLDataPackerBinaryBuffer::unpackF32(F32 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(sizeof(F32), name);
 
-	htonmemcpy(&value, mCurBufferp, MVT_F32, 4);
+	if (success)
+	{
+		htonmemcpy(&value, mCurBufferp, MVT_F32, 4);
+	}
 	mCurBufferp += 4;
 	return success;
 }
@@ -414,7 +449,10 @@ BOOL LLDataPackerBinaryBuffer::unpackColor4(LLColor4 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(16, name);
 
-	htonmemcpy(value.mV, mCurBufferp, MVT_LLVector4, 16);
+	if (success)
+	{
+		htonmemcpy(value.mV, mCurBufferp, MVT_LLVector4, 16);
+	}
 	mCurBufferp += 16;
 	return success;
 }
@@ -439,7 +477,10 @@ BOOL LLDataPackerBinaryBuffer::unpackColor4U(LLColor4U &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(4, name);
 
-	htonmemcpy(value.mV, mCurBufferp, MVT_VARIABLE, 4);
+	if (success)
+	{
+		htonmemcpy(value.mV, mCurBufferp, MVT_VARIABLE, 4);
+	}
 	mCurBufferp += 4;
 	return success;
 }
@@ -466,8 +507,11 @@ BOOL LLDataPackerBinaryBuffer::unpackVector2(LLVector2 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(8, name);
 
-	htonmemcpy(&value.mV[0], mCurBufferp, MVT_F32, 4);
-	htonmemcpy(&value.mV[1], mCurBufferp+4, MVT_F32, 4);
+	if (success)
+	{
+		htonmemcpy(&value.mV[0], mCurBufferp, MVT_F32, 4);
+		htonmemcpy(&value.mV[1], mCurBufferp+4, MVT_F32, 4);
+	}
 	mCurBufferp += 8;
 	return success;
 }
@@ -492,7 +536,10 @@ BOOL LLDataPackerBinaryBuffer::unpackVector3(LLVector3 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(12, name);
 
-	htonmemcpy(value.mV, mCurBufferp, MVT_LLVector3, 12);
+	if (success)
+	{
+		htonmemcpy(value.mV, mCurBufferp, MVT_LLVector3, 12);
+	}
 	mCurBufferp += 12;
 	return success;
 }
@@ -516,7 +563,10 @@ BOOL LLDataPackerBinaryBuffer::unpackVector4(LLVector4 &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(16, name);
 
-	htonmemcpy(value.mV, mCurBufferp, MVT_LLVector4, 16);
+	if (success)
+	{
+		htonmemcpy(value.mV, mCurBufferp, MVT_LLVector4, 16);
+	}
 	mCurBufferp += 16;
 	return success;
 }
@@ -540,7 +590,10 @@ BOOL LLDataPackerBinaryBuffer::unpackUUID(LLUUID &value, const char *name)
 	BOOL success = TRUE;
 	success &= verifyLength(16, name);
 
-	htonmemcpy(value.mData, mCurBufferp, MVT_LLUUID, 16);
+	if (success)
+	{
+		htonmemcpy(value.mData, mCurBufferp, MVT_LLUUID, 16);
+	}
 	mCurBufferp += 16;
 	return success;
 }
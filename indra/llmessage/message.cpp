@@ -36,6 +36,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #endif
+#include <algorithm>
 #include <iomanip>
 #include <iterator>
 #include <sstream>
@@ -2426,9 +2427,21 @@ void process_deny_trusted_circuit(LLMessageSystem *msg, void **)
 }
 
 
+namespace
+{
+	struct c_string_less
+	{
+		bool operator()(char const* lhs, char const* rhs) const { return strcmp(lhs, rhs) < 0; }
+	};
+}
+
 void dump_prehash_files()
 {
-	U32 i;
+	// The table is a hash table; sort the names so the generated files don't change needlessly.
+	std::vector<char const*> strings;
+	LLMessageStringTable::getInstance()->getStrings(strings);
+	std::sort(strings.begin(), strings.end(), c_string_less());
+
 	std::string filename("../../indra/llmessage/message_prehash.h");
 	LLFILE* fp = LLFile::fopen(filename, "w");	/* Flawfinder: ignore */
 	if (fp)
@@ -2450,11 +2463,11 @@ void dump_prehash_files()
 			" */\n",
 			gMessageSystem->mMessageFileVersionNumber);
 		fprintf(fp, "\n\nextern F32 const gPrehashVersionNumber;\n\n");
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (std::vector<char const*>::iterator iter = strings.begin(); iter != strings.end(); ++iter)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if ((*iter)[0] != '.')
 			{
-				fprintf(fp, "extern char const* const _PREHASH_%s;\n", LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "extern char const* const _PREHASH_%s;\n", *iter);
 			}
 		}
 		fprintf(fp, "\n\n#endif\n");
@@ -2480,11 +2493,11 @@ void dump_prehash_files()
 		fprintf(fp, "#include \"linden_common.h\"\n");
 		fprintf(fp, "#include \"message.h\"\n\n");
 		fprintf(fp, "\n\nF32 const gPrehashVersionNumber = %.3ff;\n\n", gMessageSystem->mMessageFileVersionNumber);
-		for (i = 0; i < MESSAGE_NUMBER_OF_HASH_BUCKETS; i++)
+		for (std::vector<char const*>::iterator iter = strings.begin(); iter != strings.end(); ++iter)
 		{
-			if (!LLMessageStringTable::getInstance()->mEmpty[i] && LLMessageStringTable::getInstance()->mString[i][0] != '.')
+			if ((*iter)[0] != '.')
 			{
-				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", LLMessageStringTable::getInstance()->mString[i], LLMessageStringTable::getInstance()->mString[i]);
+				fprintf(fp, "char const* const _PREHASH_%s = LLMessageStringTable::getInstance()->getString(\"%s\");\n", *iter, *iter);
 			}
 		}
 		fclose(fp);
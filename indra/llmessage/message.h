@@ -56,6 +56,7 @@
 #include "llsingleton.h"
 #include "message_prehash.h"
 #include "llstl.h"
+#include "llconcurrentstringtable.h"
 #include "llmsgvariabletype.h"
 #include "llmessagesenderinterface.h"
 
@@ -68,7 +69,7 @@ namespace
 }
 
 const U32 MESSAGE_MAX_STRINGS_LENGTH = 64;
-const U32 MESSAGE_NUMBER_OF_HASH_BUCKETS = 8192;
+const U32 MESSAGE_NUMBER_OF_HASH_BUCKETS = 8192;		// Initial size; the table grows as needed.
 
 const S32 MESSAGE_MAX_PER_FRAME = 400;
 
@@ -78,11 +79,16 @@ public:
 	LLMessageStringTable();
 	~LLMessageStringTable();
 
+	// Returns the same pointer for equal strings (truncated to MESSAGE_MAX_STRINGS_LENGTH - 1
+	// characters). Thread-safe; looking up a string that is already known takes no lock.
+	// The returned string may not be modified.
 	char *getString(const char *str);
 
-	U32	 mUsed;
-	BOOL mEmpty[MESSAGE_NUMBER_OF_HASH_BUCKETS];
-	char mString[MESSAGE_NUMBER_OF_HASH_BUCKETS][MESSAGE_MAX_STRINGS_LENGTH];	/* Flawfinder: ignore */
+	// Append all strings to strings (used to generate message_prehash.cpp).
+	void getStrings(std::vector<char const*>& strings) const { mTable.getStrings(strings); }
+
+private:
+	LLConcurrentStringTable mTable;
 };
 
 
@@ -371,6 +371,18 @@ std::string LLPluginMessage::generate(void) const
 	return result.str();
 }
 
+/**
+ * Flatten the message into binary LLSD.
+ *
+ * @return Binary LLSD, which always starts with the '{' of the map (see isBinary()).
+ */
+std::string LLPluginMessage::generateBinary(void) const
+{
+	std::ostringstream result;
+	LLSDSerialize::toBinary(mMessage, result);
+	return result.str();
+}
+
 /**
  *	Parse an incoming message into component parts. Clears all existing state before starting the parse.
  *
@@ -383,7 +395,15 @@ int LLPluginMessage::parse(const std::string &message)
 
 	std::istringstream input(message);
 	
-	S32 parse_result = LLSDSerialize::fromXML(mMessage, input);
+	S32 parse_result;
+	if (isBinary(message))
+	{
+		parse_result = LLSDSerialize::fromBinary(mMessage, input, (S32)message.size());
+	}
+	else
+	{
+		parse_result = LLSDSerialize::fromXML(mMessage, input);
+	}
 	
 	return (int)parse_result;
 }
@@ -88,7 +88,14 @@ public:
 	// Flatten the message into a string
 	std::string generate(void) const;
 
-	// Parse an incoming message into component parts
+	// Flatten the message into binary LLSD, which is smaller and much cheaper to generate and parse than XML.
+	// The result may contain null characters, so it can't be passed to a plugin DSO, which takes C strings.
+	std::string generateBinary(void) const;
+
+	// Returns true if message was made by generateBinary().
+	static bool isBinary(const std::string &message) { return !message.empty() && message[0] == '{'; }
+
+	// Parse an incoming message, made by generate() or by generateBinary(), into component parts
 	// (this clears out all existing state before starting the parse)
 	// Returns -1 on failure, otherwise returns the number of key/value pairs in the message.
 	int parse(const std::string &message);
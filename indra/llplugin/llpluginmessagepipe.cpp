@@ -29,12 +29,18 @@
 #include "linden_common.h"
 
 #include "llpluginmessagepipe.h"
+#include "llpluginmessage.h"
 #include "llbufferstream.h"
 
 #include "llapr.h"
 
 static const char MESSAGE_DELIMITER = '\0';
 
+// Binary messages (see LLPluginMessage::generateBinary) may contain null characters,
+// so they are sent as BINARY_MESSAGE_START, a four byte little endian length and the message.
+static const char BINARY_MESSAGE_START = '\1';
+static const size_t BINARY_MESSAGE_HEADER_SIZE = 5;
+
 LLPluginMessagePipeOwner::LLPluginMessagePipeOwner() :
 	mMessagePipe(NULL),
 	mSocketError(APR_SUCCESS)
@@ -122,8 +128,21 @@ bool LLPluginMessagePipe::addMessage(const std::string &message)
 	// queue the message for later output
 	//LLMutexLock lock(&mOutputMutex);
 	mOutputMutex.lock();
-	mOutput += message;
-	mOutput += MESSAGE_DELIMITER;	// message separator
+	if (LLPluginMessage::isBinary(message))
+	{
+		U32 size = (U32)message.size();
+		mOutput += BINARY_MESSAGE_START;
+		for (int i = 0; i < 4; ++i)
+		{
+			mOutput += (char)(size >> (8 * i));
+		}
+		mOutput += message;
+	}
+	else
+	{
+		mOutput += message;
+		mOutput += MESSAGE_DELIMITER;	// message separator
+	}
 	mOutputMutex.unlock();
 	return true;
 }
@@ -385,19 +404,50 @@ bool LLPluginMessagePipe::pumpInput(F64 timeout)
 
 void LLPluginMessagePipe::processInput(void)
 {
-	// Look for input delimiter(s) in the input buffer.
-	int delim;
+	// Look for complete messages in the input buffer.
 	mInputMutex.lock();
-	while((delim = mInput.find(MESSAGE_DELIMITER)) != std::string::npos)
-	{	
+	while(!mInput.empty())
+	{
+		size_t start, end, next;
+		if(mInput[0] == BINARY_MESSAGE_START)
+		{
+			if(mInput.size() < BINARY_MESSAGE_HEADER_SIZE)
+			{
+				break;
+			}
+			U32 size = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				size |= (U32)(U8)mInput[1 + i] << (8 * i);
+			}
+			start = BINARY_MESSAGE_HEADER_SIZE;
+			end = start + size;
+			if(mInput.size() < end)
+			{
+				break;
+			}
+			next = end;
+		}
+		else
+		{
+			// Look for an input delimiter.
+			start = 0;
+			end = mInput.find(MESSAGE_DELIMITER);
+			if(end == std::string::npos)
+			{
+				break;
+			}
+			next = end + 1;
+		}
+
 		// Let the owner process this message
 		if (mOwner)
 		{
 			// Pull the message out of the input buffer before calling receiveMessageRaw.
 			// It's now possible for this function to get called recursively (in the case where the plugin makes a blocking request)
 			// and this guarantees that the messages will get dequeued correctly.
-			std::string message(mInput, 0, delim);
-			mInput.erase(0, delim + 1);
+			std::string message(mInput, start, end - start);
+			mInput.erase(0, next);
 			mInputMutex.unlock();
 			mOwner->receiveMessageRaw(message);
 			mInputMutex.lock();
@@ -405,6 +455,7 @@ void LLPluginMessagePipe::processInput(void)
 		else
 		{
 			LL_WARNS("Plugin") << "!mOwner" << LL_ENDL;
+			break;
 		}
 	}
 	mInputMutex.unlock();
@@ -0,0 +1,207 @@
+/** 
+ * @file llpluginmessagering.cpp
+ * @brief A lock-free ring buffer of messages in shared memory.
+ *
+ * @cond
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ * @endcond
+ */
+
+#include "linden_common.h"
+
+#include "llpluginmessagering.h"
+
+#include <new>
+
+static const U32 MESSAGE_RING_MAGIC = 0x4c4c4d52;	// "LLMR"
+static const U32 LENGTH_SIZE = 4;
+static const U32 RECORD_HEADER_SIZE = 8;			// The length and the stamp.
+
+LLPluginMessageRing::LLPluginMessageRing() :
+	mHeader(NULL),
+	mData(NULL),
+	mMask(0)
+{
+}
+
+// static
+size_t LLPluginMessageRing::getSize(U32 capacity)
+{
+	llassert((capacity & (capacity - 1)) == 0);
+	return sizeof(Header) + capacity;
+}
+
+bool LLPluginMessageRing::create(void *address, size_t size)
+{
+	detach();
+	if (!address || size < getSize(RECORD_HEADER_SIZE))
+	{
+		return false;
+	}
+	// Use the largest power of two that fits, so that positions can be masked.
+	U32 capacity = RECORD_HEADER_SIZE;
+	while ((size_t)capacity * 2 <= size - sizeof(Header))
+	{
+		capacity *= 2;
+	}
+	Header *header = new (address) Header;
+	header->mCapacity = capacity;
+	header->mHead = 0;
+	header->mTail = 0;
+	header->mMagic = MESSAGE_RING_MAGIC;
+	return attach(address, size);
+}
+
+bool LLPluginMessageRing::attach(void *address, size_t size)
+{
+	detach();
+	Header *header = (Header *)address;
+	if (!header || size < sizeof(Header) || header->mMagic != MESSAGE_RING_MAGIC ||
+		header->mCapacity < RECORD_HEADER_SIZE || (header->mCapacity & (header->mCapacity - 1)) ||
+		getSize(header->mCapacity) > size)
+	{
+		LL_WARNS("Plugin") << "Not a message ring" << LL_ENDL;
+		return false;
+	}
+	mHeader = header;
+	mData = (char *)address + sizeof(Header);
+	mMask = header->mCapacity - 1;
+	return true;
+}
+
+void LLPluginMessageRing::detach(void)
+{
+	mHeader = NULL;
+	mData = NULL;
+	mMask = 0;
+}
+
+void LLPluginMessageRing::copyIn(U32 position, const char *data, U32 size)
+{
+	U32 offset = position & mMask;
+	U32 first = llmin(size, mMask + 1 - offset);
+	memcpy(mData + offset, data, first);
+	memcpy(mData, data + first, size - first);
+}
+
+void LLPluginMessageRing::copyOut(U32 position, char *data, U32 size) const
+{
+	U32 offset = position & mMask;
+	U32 first = llmin(size, mMask + 1 - offset);
+	memcpy(data, mData + offset, first);
+	memcpy(data + first, mData, size - first);
+}
+
+static void encodeU32(char *buffer, U32 value)
+{
+	for (U32 i = 0; i < sizeof(U32); ++i)
+	{
+		buffer[i] = (char)(value >> (8 * i));
+	}
+}
+
+static U32 decodeU32(const char *buffer)
+{
+	U32 value = 0;
+	for (U32 i = 0; i < sizeof(U32); ++i)
+	{
+		value |= (U32)(U8)buffer[i] << (8 * i);
+	}
+	return value;
+}
+
+bool LLPluginMessageRing::write(const std::string &message, U32 stamp)
+{
+	if (!mHeader)
+	{
+		return false;
+	}
+	U32 head = mHeader->mHead;
+	U32 tail = mHeader->mTail;
+	U32 size = (U32)message.size();
+	if (message.size() > mMask + 1 || (mMask + 1) - (head - tail) < RECORD_HEADER_SIZE + size)
+	{
+		return false;
+	}
+	char record_header[RECORD_HEADER_SIZE];
+	encodeU32(record_header, size);
+	encodeU32(record_header + LENGTH_SIZE, stamp);
+	copyIn(head, record_header, RECORD_HEADER_SIZE);
+	copyIn(head + RECORD_HEADER_SIZE, message.data(), size);
+	// Publish the message only after it was copied.
+	mHeader->mHead = head + RECORD_HEADER_SIZE + size;
+	return true;
+}
+
+bool LLPluginMessageRing::readRecordHeader(U32 &size, U32 &stamp)
+{
+	if (!mHeader)
+	{
+		return false;
+	}
+	U32 tail = mHeader->mTail;
+	U32 used = mHeader->mHead - tail;
+	if (used == 0)
+	{
+		return false;
+	}
+	size = 0;
+	if (used >= RECORD_HEADER_SIZE)
+	{
+		char record_header[RECORD_HEADER_SIZE];
+		copyOut(tail, record_header, RECORD_HEADER_SIZE);
+		size = decodeU32(record_header);
+		stamp = decodeU32(record_header + LENGTH_SIZE);
+	}
+	if (used < RECORD_HEADER_SIZE || used - RECORD_HEADER_SIZE < size)
+	{
+		// The other process wrote garbage; stop using the ring.
+		LL_WARNS("Plugin") << "Message ring is corrupt, detaching" << LL_ENDL;
+		detach();
+		return false;
+	}
+	return true;
+}
+
+bool LLPluginMessageRing::peek(U32 &stamp)
+{
+	U32 size;
+	return readRecordHeader(size, stamp);
+}
+
+bool LLPluginMessageRing::read(std::string &message)
+{
+	U32 size, stamp;
+	if (!readRecordHeader(size, stamp))
+	{
+		return false;
+	}
+	U32 tail = mHeader->mTail;
+	message.resize(size);
+	if (size)
+	{
+		copyOut(tail + RECORD_HEADER_SIZE, &message[0], size);
+	}
+	// Free the space only after the message was copied.
+	mHeader->mTail = tail + RECORD_HEADER_SIZE + size;
+	return true;
+}
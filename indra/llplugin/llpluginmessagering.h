@@ -0,0 +1,94 @@
+/** 
+ * @file llpluginmessagering.h
+ * @brief A lock-free ring buffer of messages in shared memory.
+ *
+ * @cond
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ * 
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ * @endcond
+ */
+
+#ifndef LL_LLPLUGINMESSAGERING_H
+#define LL_LLPLUGINMESSAGERING_H
+
+#include <string>
+
+#include "llatomic.h"
+
+/**
+ * @brief LLPluginMessageRing passes messages from one writer to one reader through a block of memory,
+ * usually an LLPluginSharedMemory segment, without locking and without a system call per message.
+ *
+ * The block starts with a header holding the write and read positions, followed by the messages,
+ * each of which is a four byte length, a four byte stamp and the message itself. The stamp is
+ * passed on as is; LLPluginProcessParent and LLPluginProcessChild use it to merge the messages
+ * of the ring with those that went through the socket in the order in which they were sent.
+ * The parent process formats the block with create(), the child process uses it after attach().
+ * Neither side is woken up by a new message: the reader has to poll with read().
+ */
+class LLPluginMessageRing
+{
+	LOG_CLASS(LLPluginMessageRing);
+public:
+	LLPluginMessageRing();
+
+	// The size of the memory block needed for a ring of capacity bytes (a power of two).
+	static size_t getSize(U32 capacity);
+
+	// Format the memory block at address as an empty ring. Returns false if size is too small.
+	bool create(void *address, size_t size);
+	// Use a ring formatted by create(), possibly in another process. Returns false if the block isn't a ring.
+	bool attach(void *address, size_t size);
+	void detach(void);
+	bool isAttached(void) const { return mHeader != NULL; }
+
+	// Writer side: append message. Returns false, without writing anything, if there is no room for it.
+	bool write(const std::string &message, U32 stamp = 0);
+	// Reader side: get the stamp of the oldest message without taking it. Returns false if there is none.
+	bool peek(U32 &stamp);
+	// Reader side: take the oldest message. Returns false if there is none.
+	bool read(std::string &message);
+
+private:
+	struct Header
+	{
+		U32 mMagic;
+		U32 mCapacity;
+		// Free running positions, modulo 2^32; the ring holds mHead - mTail bytes.
+		// They are on separate cache lines, because they are written by different processes.
+		char mPad0[56];
+		LLAtomicU32 mHead;			// Written by the writer.
+		char mPad1[64 - sizeof(LLAtomicU32)];
+		LLAtomicU32 mTail;			// Written by the reader.
+		char mPad2[64 - sizeof(LLAtomicU32)];
+	};
+
+	void copyIn(U32 position, const char *data, U32 size);
+	void copyOut(U32 position, char *data, U32 size) const;
+	// Get the length and stamp of the oldest message.
+	bool readRecordHeader(U32 &size, U32 &stamp);
+
+	Header *mHeader;
+	char *mData;
+	U32 mMask;						// Capacity - 1.
+};
+
+#endif // LL_LLPLUGINMESSAGERING_H
@@ -45,6 +45,10 @@ LLPluginProcessChild::LLPluginProcessChild()
 	mCPUElapsed = 0.0f;
 	mBlockingRequest = false;
 	mBlockingResponseReceived = false;
+	mMessageRingMemory = NULL;
+	mBinaryMessages = false;
+	mSocketMessagesSent = 0;
+	mSocketMessagesReceived = 0;
 }
 
 LLPluginProcessChild::~LLPluginProcessChild()
@@ -67,6 +71,11 @@ void LLPluginProcessChild::killSockets(void)
 {
 	killMessagePipe();
 	mSocket.reset();
+
+	mMessageRingOut.detach();
+	mMessageRingIn.detach();
+	delete mMessageRingMemory;
+	mMessageRingMemory = NULL;
 }
 
 void LLPluginProcessChild::init(U32 launcher_port)
@@ -131,7 +140,12 @@ void LLPluginProcessChild::idle(void)
 			break;
 			
 			case STATE_CONNECTED:
-				sendMessageToParent(LLPluginMessage(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello"));
+				{
+					LLPluginMessage hello(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello");
+					// Let the parent know it may send binary messages.
+					hello.setValueBoolean("binary_messages", true);
+					sendMessageToParent(hello);
+				}
 				setState(STATE_PLUGIN_LOADING);
 			break;
 						
@@ -166,6 +180,7 @@ void LLPluginProcessChild::idle(void)
 			break;
 			
 			case STATE_RUNNING:
+				receiveRingMessages();
 				if(mInstance != NULL)
 				{
 					// Provide some time to the plugin
@@ -280,6 +295,12 @@ bool LLPluginProcessChild::isDone(void)
 	return result;
 }
 
+// Media plugins send an update for every frame they draw.
+static bool isHighRateMessage(const LLPluginMessage &message)
+{
+	return message.getName() == "updated" && message.getClass() == LLPLUGIN_MESSAGE_CLASS_MEDIA;
+}
+
 // This is the SLPlugin process.
 // This is not part of a DSO.
 //
@@ -310,24 +331,84 @@ void LLPluginProcessChild::sendMessageToPlugin(const LLPluginMessage &message)
 // This function is called by SLPlugin to send 'message' to the viewer (the parent process).
 void LLPluginProcessChild::sendMessageToParent(const LLPluginMessage &message)
 {
-	std::string buffer = message.generate();
+	LL_DEBUGS("Plugin") << "Sending to parent: " << message << LL_ENDL;
 
-	LL_DEBUGS("Plugin") << "Sending to parent: " << buffer << LL_ENDL;
+	if(!mBinaryMessages)
+	{
+		// Write the serialized message to the pipe.
+		writeSocketMessage(message.generate());
+		return;
+	}
 
-	// Write the serialized message to the pipe.
-	writeMessageRaw(buffer);
+	std::string buffer = message.generateBinary();
+	if(isHighRateMessage(message) && mMessageRingOut.write(buffer, mSocketMessagesSent))
+	{
+		// The parent will pick it up from the ring, after the messages that were sent through the socket before it.
+		return;
+	}
+	writeSocketMessage(buffer);
+}
+
+bool LLPluginProcessChild::writeSocketMessage(const std::string &message)
+{
+	if(!writeMessageRaw(message))
+	{
+		return false;
+	}
+	++mSocketMessagesSent;
+	return true;
+}
+
+bool LLPluginProcessChild::attachMessageRing(const std::string &name, size_t size)
+{
+	mMessageRingMemory = new LLPluginSharedMemory;
+	if(mMessageRingMemory->attach(name, 2 * size))
+	{
+		// The first ring is written by the parent, the second one by the child.
+		char *address = (char *)mMessageRingMemory->getMappedAddress();
+		if(mMessageRingIn.attach(address, size) && mMessageRingOut.attach(address + size, size))
+		{
+			return true;
+		}
+	}
+	mMessageRingIn.detach();
+	delete mMessageRingMemory;
+	mMessageRingMemory = NULL;
+	return false;
+}
+
+void LLPluginProcessChild::receiveRingMessages(void)
+{
+	// Messages that the parent sent after a socket message that didn't arrive yet have to wait for it.
+	std::string buffer;
+	U32 stamp;
+	while(mMessageRingIn.peek(stamp) && (S32)(stamp - mSocketMessagesReceived) <= 0 && mMessageRingIn.read(buffer))
+	{
+		processMessageRaw(buffer);
+	}
 }
 
 // This is the SLPlugin process (the child process).
 // This is not part of a DSO.
 //
-// This function is called when the serialized message 'message' was received from the viewer.
-// It parses the message and handles LLPLUGIN_MESSAGE_CLASS_INTERNAL.
-// Other message classes are passed on to LLPluginInstance::sendMessage.
+// This function is called when the serialized message 'message' was received from the viewer through the socket.
 void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 {
-	// Incoming message from the TCP Socket
+	// First the messages the parent wrote into the ring before it sent this one.
+	receiveRingMessages();
+	++mSocketMessagesReceived;
 
+	processMessageRaw(message);
+}
+
+// This is the SLPlugin process (the child process).
+// This is not part of a DSO.
+//
+// This function is called for every message from the viewer, in the order in which they were sent.
+// It parses the message and handles LLPLUGIN_MESSAGE_CLASS_INTERNAL.
+// Other message classes are passed on to LLPluginInstance::sendMessage.
+void LLPluginProcessChild::processMessageRaw(const std::string &message)
+{
 	LL_DEBUGS("Plugin") << "Received from parent: " << message << LL_ENDL;
 
 	// Decode this message
@@ -366,6 +447,23 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 			{
 				mPluginFile = parsed.getValue("file");
 				mPluginDir = parsed.getValue("dir");
+				mBinaryMessages = parsed.getValueBoolean("binary_messages");
+			}
+			else if(message_name == "message_ring_add")
+			{
+				if(mMessageRingMemory)
+				{
+					LL_WARNS("Plugin") << "Adding a duplicate message ring!" << LL_ENDL;
+				}
+				else if(attachMessageRing(parsed.getValue("name"), (size_t)parsed.getValueS32("size")))
+				{
+					sendMessageToParent(LLPluginMessage(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "message_ring_add_response"));
+				}
+				else
+				{
+					// The parent keeps using the socket.
+					LL_WARNS("Plugin") << "Couldn't attach to the message ring shared memory segment" << LL_ENDL;
+				}
 			}
 			else if(message_name == "shm_add")
 			{
@@ -454,7 +552,8 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 	{
 		LLTimer elapsed;
 
-		mInstance->sendMessage(message);
+		// The plugin DSO only understands text messages.
+		mInstance->sendMessage(LLPluginMessage::isBinary(message) ? parsed.generate() : message);
 
 		mCPUElapsed += elapsed.getElapsedTimeF64();
 	}
@@ -486,12 +585,13 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 
 	// FIXME: how should we handle queueing here?
 	
+	// Decode this message
+	LLPluginMessage parsed;
+	parsed.parse(message);
+
 	// Intercept certain base messages (responses to ones sent by this class)
 	{
-		// Decode this message
-		LLPluginMessage parsed;
-		parsed.parse(message);
-		
+
 		if(parsed.hasValue("blocking_request"))
 		{
 			mBlockingRequest = true;
@@ -573,7 +673,15 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 	if(passMessage)
 	{
 		LL_DEBUGS("Plugin") << "Passing through to parent: " << message << LL_ENDL;
-		writeMessageRaw(message);
+		if(mBinaryMessages)
+		{
+			// It was parsed anyway, so the parent doesn't have to parse the XML again.
+			sendMessageToParent(parsed);
+		}
+		else
+		{
+			writeSocketMessage(message);
+		}
 	}
 	
 	while(mBlockingRequest)
@@ -603,7 +711,7 @@ void LLPluginProcessChild::deliverQueuedMessages()
 	{
 		while(!mMessageQueue.empty())
 		{
-			receiveMessageRaw(mMessageQueue.front());
+			processMessageRaw(mMessageQueue.front());
 			mMessageQueue.pop();
 		}
 	}
@@ -40,6 +40,7 @@
 
 #include "llpluginmessage.h"
 #include "llpluginmessagepipe.h"
+#include "llpluginmessagering.h"
 #include "llplugininstance.h"
 #include "llhost.h"
 #include "llpluginsharedmemory.h"
@@ -95,6 +96,15 @@ private:
 	};
 	void setState(EState state);
 
+	// Attach to the message rings the parent made.
+	bool attachMessageRing(const std::string &name, size_t size);
+	// Receive the messages the parent wrote into its message ring before it sent the last message that came through the socket.
+	void receiveRingMessages(void);
+	// Handle a message from the socket or the ring.
+	void processMessageRaw(const std::string &message);
+	// Write a message to the socket, counting it.
+	bool writeSocketMessage(const std::string &message);
+
 	EState mState;
 	
 	LLHost mLauncherHost;
@@ -107,6 +117,16 @@ private:
 
 	typedef std::map<std::string, LLPluginSharedMemory*> sharedMemoryRegionsType;
 	sharedMemoryRegionsType mSharedMemoryRegions;
+
+	// High rate messages go through these rings in shared memory instead of through the socket.
+	LLPluginSharedMemory *mMessageRingMemory;
+	LLPluginMessageRing mMessageRingOut;	// To the parent.
+	LLPluginMessageRing mMessageRingIn;		// From the parent.
+	bool mBinaryMessages;					// The parent can parse binary messages.
+	// The messages in the rings are stamped with the number of messages that were sent through the socket before them,
+	// so that both are received in the order in which they were sent.
+	U32 mSocketMessagesSent;
+	U32 mSocketMessagesReceived;
 	
 	LLTimer mHeartbeat;
 	F64		mSleepTime;
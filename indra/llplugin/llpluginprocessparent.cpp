@@ -99,6 +99,11 @@ LLPluginProcessParent::LLPluginProcessParent(LLPluginProcessParentOwner *owner)
 	mBlocked = false;
 	mPolledInput = false;
 	mReceivedShutdown = false;
+	mMessageRingMemory = NULL;
+	mMessageRingAttached = false;
+	mBinaryMessages = false;
+	mSocketMessagesSent = 0;
+	mSocketMessagesReceived = 0;
 	mPollFD.client_data = NULL;
 	mPollFDPool.create();
 
@@ -139,6 +144,10 @@ LLPluginProcessParent::~LLPluginProcessParent()
 		// and remove it from our map
 		mSharedMemoryRegions.erase(iter);
 	}
+
+	mMessageRingOut.detach();
+	mMessageRingIn.detach();
+	delete mMessageRingMemory;
 	
 	mProcess.kill();
 	killSockets();
@@ -212,6 +221,18 @@ void LLPluginProcessParent::idle(void)
 
 	do
 	{
+		// Pick up the messages from the ring that don't have to wait for a message from the socket.
+		// Like those, they are queued while input is polled on another thread.
+		if(mPolledInput)
+		{
+			LLMutexLock lock(&mIncomingQueueMutex);
+			receiveRingMessages();
+		}
+		else
+		{
+			receiveRingMessages();
+		}
+
 		// process queued messages
 		mIncomingQueueMutex.lock();
 		while(!mIncomingQueue.empty())
@@ -495,6 +516,8 @@ void LLPluginProcessParent::idle(void)
 					LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "load_plugin");
 					message.setValue("file", mPluginFile);
 					message.setValue("dir", mPluginDir);
+					// Let the plugin know it may send binary messages.
+					message.setValueBoolean("binary_messages", true);
 					sendMessage(message);
 				}
 
@@ -611,6 +634,13 @@ void LLPluginProcessParent::setSleepTime(F64 sleep_time, bool force_send)
 	}
 }
 
+// Mouse moves are sent at the frame rate.
+static bool isHighRateMessage(const LLPluginMessage &message)
+{
+	return message.getName() == "mouse_event" && message.getClass() == LLPLUGIN_MESSAGE_CLASS_MEDIA &&
+		   message.getValue("event") == "move";
+}
+
 // This is the viewer process (the parent process)
 //
 // This function is called to send a message to the plugin.
@@ -629,18 +659,26 @@ void LLPluginProcessParent::sendMessage(const LLPluginMessage &message)
 		mBlocked = true;
 	}
 	
-	std::string buffer = message.generate();
+	std::string buffer = mBinaryMessages ? message.generateBinary() : message.generate();
 #if LL_DEBUG
 	if (message.getName() == "mouse_event")
 	{
-		LL_DEBUGS("PluginMouseEvent") << "Sending: " << buffer << LL_ENDL;
+		LL_DEBUGS("PluginMouseEvent") << "Sending: " << message << LL_ENDL;
 	}
 	else
 	{
-		LL_DEBUGS("Plugin") << "Sending: " << buffer << LL_ENDL;
+		LL_DEBUGS("Plugin") << "Sending: " << message << LL_ENDL;
 	}
 #endif
-	writeMessageRaw(buffer);
+	if(mMessageRingAttached && isHighRateMessage(message) && mMessageRingOut.write(buffer, mSocketMessagesSent))
+	{
+		// The plugin will pick it up from the ring, after the messages that were sent through the socket before it.
+		return;
+	}
+	if(writeMessageRaw(buffer))
+	{
+		++mSocketMessagesSent;
+	}
 	
 	// Try to send message immediately.
 	if(mMessagePipe)
@@ -913,9 +951,21 @@ void LLPluginProcessParent::servicePoll()
 
 // This the viewer process (the parent process).
 //
-// This function is called when a message is received from a plugin.
-// It parses the message and passes it on to LLPluginProcessParent::receiveMessage.
+// This function is called when a message is received from a plugin through the socket.
 void LLPluginProcessParent::receiveMessageRaw(const std::string &message)
+{
+	// First the messages the plugin wrote into the ring before it sent this one.
+	receiveRingMessages();
+	++mSocketMessagesReceived;
+
+	processMessageRaw(message);
+}
+
+// This the viewer process (the parent process).
+//
+// This function is called for every message from a plugin, in the order in which they were sent.
+// It parses the message and passes it on to LLPluginProcessParent::receiveMessage.
+void LLPluginProcessParent::processMessageRaw(const std::string &message)
 {
 	LL_DEBUGS("PluginRaw") << "Received: " << message << LL_ENDL;
 	
@@ -993,6 +1043,7 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 			if(mState == STATE_CONNECTED)
 			{
 				// Plugin host has launched.  Tell it which plugin to load.
+				mBinaryMessages = message.getValueBoolean("binary_messages");
 				setState(STATE_HELLO);
 			}
 			else
@@ -1025,6 +1076,12 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 				llassert_always(mSleepTime != 0.f);
 				setSleepTime(mSleepTime, true);			
 
+				if(mBinaryMessages)
+				{
+					// The plugin host is recent enough to use message rings.
+					addMessageRing();
+				}
+
 				setState(STATE_RUNNING);
 			}
 			else
@@ -1052,6 +1109,11 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 		{
 			// Nothing to do here.
 		}
+		else if(message_name == "message_ring_add_response")
+		{
+			// The plugin host attached to the rings; from now on it reads high rate messages from mMessageRingOut.
+			mMessageRingAttached = true;
+		}
 		else if(message_name == "shm_remove_response")
 		{
 			std::string name = message.getValue("name");
@@ -1104,6 +1166,44 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
 	}
 }
 
+// The capacity of each message ring, in bytes.
+static const U32 MESSAGE_RING_CAPACITY = 64 * 1024;
+
+void LLPluginProcessParent::addMessageRing(void)
+{
+	size_t ring_size = LLPluginMessageRing::getSize(MESSAGE_RING_CAPACITY);
+	mMessageRingMemory = new LLPluginSharedMemory;
+	if(!mMessageRingMemory->create(2 * ring_size))
+	{
+		// Not fatal: all messages will simply go through the socket.
+		LL_WARNS("Plugin") << "Couldn't create the message ring shared memory segment" << LL_ENDL;
+		delete mMessageRingMemory;
+		mMessageRingMemory = NULL;
+		return;
+	}
+
+	// The first ring is written by the parent, the second one by the child.
+	char *address = (char *)mMessageRingMemory->getMappedAddress();
+	mMessageRingOut.create(address, ring_size);
+	mMessageRingIn.create(address + ring_size, ring_size);
+
+	LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "message_ring_add");
+	message.setValue("name", mMessageRingMemory->getName());
+	message.setValueS32("size", (S32)ring_size);
+	sendMessage(message);
+}
+
+void LLPluginProcessParent::receiveRingMessages(void)
+{
+	// Messages that the plugin sent after a socket message that didn't arrive yet have to wait for it.
+	std::string buffer;
+	U32 stamp;
+	while(mMessageRingIn.peek(stamp) && (S32)(stamp - mSocketMessagesReceived) <= 0 && mMessageRingIn.read(buffer))
+	{
+		processMessageRaw(buffer);
+	}
+}
+
 std::string LLPluginProcessParent::addSharedMemory(size_t size)
 {
 	std::string name;
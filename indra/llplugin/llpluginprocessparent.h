@@ -35,6 +35,7 @@
 #include "llprocesslauncher.h"
 #include "llpluginmessage.h"
 #include "llpluginmessagepipe.h"
+#include "llpluginmessagering.h"
 #include "llpluginsharedmemory.h"
 
 #include "lliosocket.h"
@@ -152,6 +153,13 @@ private:
 	bool pluginLockedUpOrQuit();
 
 	bool accept();
+
+	// Set up the message rings, once the plugin has been loaded.
+	void addMessageRing(void);
+	// Receive the messages the plugin wrote into its message ring before it sent the last message that came through the socket.
+	void receiveRingMessages(void);
+	// Handle a message from the socket or the ring.
+	void processMessageRaw(const std::string &message);
 		
 	LLSocket::ptr_t mListenSocket;
 	LLSocket::ptr_t mSocket;
@@ -167,6 +175,17 @@ private:
 	typedef std::map<std::string, LLPluginSharedMemory*> sharedMemoryRegionsType;
 	sharedMemoryRegionsType mSharedMemoryRegions;
 
+	// High rate messages go through these rings in shared memory instead of through the socket.
+	LLPluginSharedMemory *mMessageRingMemory;
+	LLPluginMessageRing mMessageRingOut;	// To the plugin.
+	LLPluginMessageRing mMessageRingIn;		// From the plugin.
+	bool mMessageRingAttached;				// The plugin reads mMessageRingOut.
+	bool mBinaryMessages;					// The plugin can parse binary messages.
+	// The messages in the rings are stamped with the number of messages that were sent through the socket before them,
+	// so that both are received in the order in which they were sent.
+	U32 mSocketMessagesSent;
+	U32 mSocketMessagesReceived;			// Protected by mIncomingQueueMutex while input is polled.
+
 	LLSD mMessageClassVersions;
 	std::string mPluginVersionString;
 	
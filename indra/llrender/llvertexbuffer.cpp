@@ -954,6 +954,7 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask, S32 usage) :
 	mFinal(false),
 	mEmpty(true),
 	mMappable(false),
+	mThreadedWrite(false),
 	mFence(NULL)
 {
 	mMappable = (mUsage == GL_DYNAMIC_DRAW_ARB && !sDisableVBOMapping);
@@ -1980,7 +1981,11 @@ template <class T,S32 type> struct VertexBufferStrider
 	{
 		if (type == LLVertexBuffer::TYPE_INDEX)
 		{
-			volatile U8* ptr = vbo.mapIndexBuffer(index, count, map_range);
+			volatile U8* ptr = vbo.getThreadedWritePointer(type, index);
+			if (!ptr)
+			{
+				ptr = vbo.mapIndexBuffer(index, count, map_range);
+			}
 
 			if (ptr == NULL)
 			{
@@ -1996,7 +2001,11 @@ template <class T,S32 type> struct VertexBufferStrider
 		{
 			S32 stride = LLVertexBuffer::sTypeSize[type];
 
-			volatile U8* ptr = vbo.mapVertexBuffer(type, index, count, map_range);
+			volatile U8* ptr = vbo.getThreadedWritePointer(type, index);
+			if (!ptr)
+			{
+				ptr = vbo.mapVertexBuffer(type, index, count, map_range);
+			}
 
 			if (ptr == NULL)
 			{
@@ -2161,8 +2170,40 @@ bool LLVertexBuffer::bindGLIndices(bool force_bind)
 	return ret;
 }
 
+void LLVertexBuffer::mapForThreadedWrite()
+{
+	llassert(!mThreadedWrite);
+	// TYPE_TEXTURE_INDEX is stored in the w of TYPE_VERTEX.
+	for (S32 type = 0; type < TYPE_TEXTURE_INDEX; ++type)
+	{
+		if (hasDataType(type))
+		{
+			mapVertexBuffer(type, 0, -1, false);
+		}
+	}
+	if (mNumIndices > 0)
+	{
+		mapIndexBuffer(0, -1, false);
+	}
+	mThreadedWrite = true;
+}
+
+volatile U8* LLVertexBuffer::getThreadedWritePointer(S32 type, S32 index) const
+{
+	if (!mThreadedWrite)
+	{
+		return NULL;
+	}
+	if (type == TYPE_INDEX)
+	{
+		return mMappedIndexData + sizeof(U16)*index;
+	}
+	return mMappedData+mOffsets[type]+sTypeSize[type]*index;
+}
+
 void LLVertexBuffer::flush()
 {
+	mThreadedWrite = false;
 	if (useVBOs())
 	{
 		unmapBuffer();
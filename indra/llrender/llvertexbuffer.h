@@ -258,6 +258,13 @@ public:
 	bool getWeightStrider(LLStrider<F32>& strider, S32 index=0, S32 count = -1, bool map_range = false);
 	bool getWeight4Strider(LLStrider<LLVector4a>& strider, S32 index=0, S32 count = -1, bool map_range = false);
 	bool getClothWeightStrider(LLStrider<LLVector4a>& strider, S32 index=0, S32 count = -1, bool map_range = false);
+
+	// Map all vertex data and the indices at once. Until the next flush(), the getXXXStrider() calls then only
+	// return addresses in the mapped data, so that jobs on other threads can fill (distinct parts of) the buffer.
+	void mapForThreadedWrite();
+	// The address that the getXXXStrider() calls return for element index of type (or TYPE_INDEX) while
+	// mapped by mapForThreadedWrite(), or NULL when it isn't.
+	volatile U8* getThreadedWritePointer(S32 type, S32 index) const;
 	
 
 	bool	useVBOs() const;
@@ -314,6 +321,7 @@ protected:
 	U32		mEmpty : 1;			// if true, client buffer is empty (or NULL). Old values have been discarded.	
 	
 	mutable bool	mMappable;     // if true, use memory mapping to upload data (otherwise doublebuffer and use glBufferSubData)
+	bool	mThreadedWrite;		// if true, mapped by mapForThreadedWrite() and the getXXXStrider() calls don't map
 
 	S32		mOffsets[TYPE_MAX];
 
@@ -27,6 +27,7 @@
 #include "linden_common.h"
 #include "llvfsthread.h"
 #include "llstl.h"
+#include "llfasttimer.h"
 
 //============================================================================
 
@@ -265,8 +266,11 @@ void LLVFSThread::Request::deleteRequest()
 	LLQueuedThread::QueuedRequest::deleteRequest();
 }
 
+static LLFastTimer::DeclareTimer FTM_VFS_REQUEST("VFS Request");
+
 bool LLVFSThread::Request::processRequest()
 {
+	LLFastTimer t(FTM_VFS_REQUEST);
 	bool complete = false;
 	if (mOperation ==  FILE_READ)
 	{
@@ -119,6 +119,7 @@
 #include "llworkerthread.h"
 #include "lltexturecache.h"
 #include "lltexturefetch.h"
+#include "llthreadpool.h"
 #include "llimageworker.h"
 
 // <edit>
@@ -227,7 +228,7 @@ extern BOOL gRandomizeFramerate;
 extern BOOL gPeriodicSlowFrame;
 extern BOOL gDebugGL;
 
-extern void startEngineThread(void);
+extern void startEngineThread(S32 num_threads);
 extern void stopEngineThread(void);
 
 ////////////////////////////////////////////////////////////
@@ -543,6 +544,7 @@ const std::string LLAppViewer::sCrashSettingsName = "CrashSettings";
 LLTextureCache* LLAppViewer::sTextureCache = NULL; 
 LLImageDecodeThread* LLAppViewer::sImageDecodeThread = NULL; 
 LLTextureFetch* LLAppViewer::sTextureFetch = NULL; 
+LLThreadPool* LLAppViewer::sWorkerPool = NULL;
 
 LLAppViewer::LLAppViewer() : 
 	mMarkerFile(),
@@ -641,6 +643,8 @@ bool LLAppViewer::init()
 
 	// Logging is initialized. Now it's safe to start the error thread.
 	startErrorThread();
+	// From here on, writing the log files is done by a thread of its own.
+	LLError::startLogWriterThread();
 
 	//
 	// OK to write stuff to logs now, we've now crash reported if necessary
@@ -1487,6 +1491,9 @@ bool LLAppViewer::cleanup()
 
 	cleanup_pose_stand();
 
+	// Write the fast timer trace, if one is being recorded.
+	gSavedSettings.setBOOL("FastTimerTrace", FALSE);
+
 	//flag all elements as needing to be destroyed immediately
 	// to ensure shutdown order
 	LLMortician::setZealous(TRUE);
@@ -1782,6 +1789,8 @@ bool LLAppViewer::cleanup()
     sTextureFetch = NULL;
 	delete sImageDecodeThread;
     sImageDecodeThread = NULL;
+	delete sWorkerPool;
+	sWorkerPool = NULL;
 
 
 	llinfos << "Cleaning up Media and Textures" << llendflush;
@@ -1864,6 +1873,9 @@ bool LLAppViewer::cleanup()
 
     llinfos << "Goodbye!" << llendflush;
 
+	// Write what is still queued, and log synchronously for whatever is left of the shutdown.
+	LLError::stopLogWriterThread();
+
 	// return 0;
 	return true;
 }
@@ -1903,8 +1915,8 @@ bool LLAppViewer::initThreads()
 		LLWatchdog::getInstance()->init(watchdog_killer_callback);
 	}
 
-	// State machine thread.
-	startEngineThread();
+	// State machine threads.
+	startEngineThread(gSavedSettings.getU32("StateMachineThreads"));
 
 	AICurlInterface::startCurlThread(&gSavedSettings);
 
@@ -1921,6 +1933,12 @@ bool LLAppViewer::initThreads()
 													enable_threads && true,
 													app_metrics_qa_mode);	
 
+	// Per-frame work that is split up over several cores (for example rigged mesh skinning).
+	// The main thread does its share of the work too, hence one thread less than there are cores.
+	if (enable_threads)
+	{
+		LLAppViewer::sWorkerPool = new LLThreadPool("worker", llmax(LLThreadPool::getDefaultThreadCount() - 1, 1));
+	}
 
 	// Mesh streaming and caching
 	gMeshRepo.init();
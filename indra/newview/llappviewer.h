@@ -41,6 +41,7 @@ class LLCommandLineParser;
 class LLTextureCache;
 class LLImageDecodeThread;
 class LLTextureFetch;
+class LLThreadPool;
 class LLWatchdogTimeout;
 
 class LLAppViewer : public LLApp
@@ -93,6 +94,8 @@ public:
 	static LLTextureCache* getTextureCache() { return sTextureCache; }
 	static LLImageDecodeThread* getImageDecodeThread() { return sImageDecodeThread; }
 	static LLTextureFetch* getTextureFetch() { return sTextureFetch; }
+	// General purpose pool for splitting up per-frame work. NULL when not running.
+	static LLThreadPool* getWorkerPool() { return sWorkerPool; }
 
 	static U32 getTextureCacheVersion() ;
 	static U32 getObjectCacheVersion() ;
@@ -236,6 +239,7 @@ private:
 	static LLTextureCache* sTextureCache; 
 	static LLImageDecodeThread* sImageDecodeThread; 
 	static LLTextureFetch* sTextureFetch;
+	static LLThreadPool* sWorkerPool;
 
 	S32 mNumSessions;
 
@@ -1213,6 +1213,26 @@ static LLFastTimer::DeclareTimer FTM_FACE_TEX_QUICK_NO_XFORM("No Xform");
 static LLFastTimer::DeclareTimer FTM_FACE_TEX_QUICK_XFORM("Xform");
 static LLFastTimer::DeclareTimer FTM_FACE_TEX_QUICK_PLANAR("Quick Planar");
 
+//static
+bool LLFace::useTransformFeedback()
+{
+	static LLCachedControl<bool> use_transform_feedback("RenderUseTransformFeedback", false);
+	return use_transform_feedback;
+}
+
+void LLFace::prepareGeometryVolume(const S32 &f)
+{
+	llassert(!useTransformFeedback());
+
+	//the tangents of a volume face are generated on demand, but the volume may be shared with other faces
+	const LLTextureEntry *tep = mVObjp->getTE(f);
+	if (mVertexBuffer->hasDataType(LLVertexBuffer::TYPE_TANGENT) ||
+		(tep && (tep->getBumpmap() || tep->getTexGen() != LLTextureEntry::TEX_GEN_DEFAULT)))
+	{
+		mVObjp->getVolume()->genTangents(f);
+	}
+}
+
 BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 							   const S32 &f,
 								const LLMatrix4a& mat_vert_in, const LLMatrix4a& mat_norm_in,
@@ -1398,10 +1418,8 @@ BOOL LLFace::getGeometryVolume(const LLVolume& volume,
 		}
 	}
 	
-	static LLCachedControl<bool> use_transform_feedback("RenderUseTransformFeedback", false);
-
 #ifdef GL_TRANSFORM_FEEDBACK_BUFFER
-	if (use_transform_feedback &&
+	if (useTransformFeedback() &&
 		gTransformPositionProgram.mProgramObject && //transform shaders are loaded
 		mVertexBuffer->useVBOs() && //target buffer is in VRAM
 		!rebuild_weights && //TODO: add support for weights
@@ -2200,6 +2218,22 @@ BOOL LLFace::hasMedia() const
 const F32 LEAST_IMPORTANCE = 0.05f ;
 const F32 LEAST_IMPORTANCE_FOR_LARGE_IMAGE = 0.3f ;
 
+void LLFace::setVirtualSize(F32 size)
+{
+	// Ignore < 20% difference, like LLViewerTextureList::updateImagesDecodePriorities does.
+	if (size < mVSize * .8f || size > mVSize * 1.25f)
+	{
+		for (U32 ch = 0; ch < LLRender::NUM_TEXTURE_CHANNELS; ++ch)
+		{
+			if (mTexture[ch].notNull())
+			{
+				mTexture[ch]->dirtyDecodePriority(size);
+			}
+		}
+	}
+	mVSize = size;
+}
+
 void LLFace::resetVirtualSize()
 {
 	setVirtualSize(0.f);
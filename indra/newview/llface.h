@@ -128,7 +128,7 @@ public:
 	void			setState(U32 state)			{ mState |= state; }
 	void			clearState(U32 state)		{ mState &= ~state; }
 	BOOL			isState(U32 state)	const	{ return ((mState & state) != 0) ? TRUE : FALSE; }
-	void			setVirtualSize(F32 size) { mVSize = size; }
+	void			setVirtualSize(F32 size);
 	void			setPixelArea(F32 area)	{ mPixelArea = area; }
 	F32				getVirtualSize() const { return mVSize; }
 	F32				getPixelArea() const { return mPixelArea; }
@@ -176,6 +176,12 @@ public:
 						const LLMatrix4a& mat_vert, const LLMatrix4a& mat_normal,
 						const U16 &index_offset,
 						bool force_rebuild = false);
+	// True if getGeometryVolume() may pack the vertex buffer with transform feedback, which must be done on the main thread.
+	static bool useTransformFeedback();
+	// Does on the main thread what getGeometryVolume(volume, f, ..., true) would change outside of this face, so
+	// that that call may then be made from a worker thread, provided that the vertex buffer was mapped with
+	// LLVertexBuffer::mapForThreadedWrite() and useTransformFeedback() is false.
+	void prepareGeometryVolume(const S32 &f);
 
 	// For avatar
 	U16			 getGeometryAvatar(
@@ -211,7 +211,10 @@ LLFolderView::LLFolderView( const std::string& name,
 	mUseEllipses(FALSE),
 	mDraggingOverItem(NULL),
 	mStatusTextBox(NULL),
-	mSearchType(1)
+	mSearchType(1),
+	mSearchIndexBuilt(false),
+	mSearchMatchGeneration(-1),
+	mUseSearchMatches(false)
 {
 	LLPanel* panel = parent_panel;
 	mParentPanel = panel->getHandle();
@@ -368,6 +371,11 @@ U32 LLFolderView::toggleSearchType(std::string toggle)
 		mSearchType = 1;
 	}
 
+	// The searchable labels changed; rebuild the index when it is needed again.
+	mSearchIndex.clear();
+	mSearchIndexBuilt = false;
+	mSearchMatchGeneration = -1;
+
 	if (getFilterSubString().length())
 	{
 		mFilter->setModified(LLInventoryFilter::FILTER_RESTART);
@@ -554,6 +562,7 @@ void LLFolderView::filter( LLInventoryFilter& filter )
 	{
 		mPassedFilter = FALSE;
 		mMinWidth = 0;
+		updateSearchMatches(filter);
 		LLFolderViewFolder::filter(filter);
 	}
 	else
@@ -2075,6 +2084,11 @@ LLRect LLFolderView::getVisibleRect()
 	return visible_rect;
 }
 
+bool LLFolderView::getVisibleRectIn(LLView* view, LLRect& rect)
+{
+	return mScrollContainer && localRectToOtherView(getVisibleRect(), &rect, view);
+}
+
 BOOL LLFolderView::getShowSelectionContext()
 {
 	if (mShowSelectionContext)
@@ -2106,6 +2120,78 @@ void LLFolderView::addItemID(const LLUUID& id, LLFolderViewItem* itemp)
 void LLFolderView::removeItemID(const LLUUID& id)
 {
 	mItemMap.erase(id);
+	if (mSearchIndexBuilt && mSearchIndex.remove(id))
+	{
+		mSearchMatchGeneration = -1;
+	}
+}
+
+void LLFolderView::updateSearchIndex(LLFolderViewItem* item)
+{
+	// The root is never searched (and is still being constructed the first time it gets here).
+	if (item == this || !mSearchIndexBuilt || !item->getListener())
+	{
+		return;
+	}
+	if (mSearchIndex.set(item->getListener()->getUUID(), item->getSearchableLabel()))
+	{
+		// The matches of the current filter string might have changed.
+		mSearchMatchGeneration = -1;
+	}
+}
+
+static LLFastTimer::DeclareTimer FTM_SEARCH_INDEX("Search Inventory Index");
+
+void LLFolderView::updateSearchMatches(LLInventoryFilter& filter)
+{
+	if (mSearchMatchGeneration == filter.getCurrentGeneration())
+	{
+		return;
+	}
+	LLFastTimer _(FTM_SEARCH_INDEX);
+	mSearchMatchGeneration = filter.getCurrentGeneration();
+	mSearchMatchFolders.clear();
+
+	// Only items with the filter string in their searchable label can pass the filter,
+	// except for folders when all folders are shown.
+	const std::string& filter_sub_string = filter.getFilterSubString();
+	mUseSearchMatches = LLSubstringIndex::canFind(filter_sub_string)
+		&& filter.getShowFolderState() != LLInventoryFilter::SHOW_ALL_FOLDERS;
+	if (!mUseSearchMatches)
+	{
+		return;
+	}
+
+	if (!mSearchIndexBuilt)
+	{
+		for (std::map<LLUUID, LLFolderViewItem*>::iterator iter = mItemMap.begin(); iter != mItemMap.end(); ++iter)
+		{
+			mSearchIndex.set(iter->first, iter->second->getSearchableLabel());
+		}
+		mSearchIndexBuilt = true;
+	}
+
+	uuid_vec_t matches;
+	mSearchIndex.find(filter_sub_string, matches);
+	for (uuid_vec_t::iterator iter = matches.begin(); iter != matches.end(); ++iter)
+	{
+		LLFolderViewItem* itemp = getItemByID(*iter);
+		if (!itemp)
+		{
+			continue;
+		}
+		// Stop at the first ancestor that is already in the set; so are all of its ancestors.
+		for (LLFolderViewFolder* folderp = itemp->getParentFolder();
+			 folderp && mSearchMatchFolders.insert(folderp).second;
+			 folderp = folderp->getParentFolder())
+		{
+		}
+	}
+}
+
+bool LLFolderView::mayHaveSearchMatches(LLFolderViewFolder* folder) const
+{
+	return !mUseSearchMatches || mSearchMatchFolders.count(folder);
 }
 
 LLFastTimer::DeclareTimer FTM_GET_ITEM_BY_ID("Get FolderViewItem by ID");
@@ -50,6 +50,7 @@
 #include "lldepthstack.h"
 #include "lleditmenuhandler.h"
 #include "llfontgl.h"
+#include "llsubstringindex.h"
 #include "lltooldraganddrop.h"
 #include "llviewertexture.h"
 
@@ -220,6 +221,10 @@ public:
 	void setScrollContainer(LLScrollContainer* parent);
 	LLRect getVisibleRect();
 
+	// The visible part of the folder view in the local coordinates of view.
+	// Returns false if the folder view isn't in a scroll container.
+	bool getVisibleRectIn(LLView* view, LLRect& rect);
+
 	BOOL search(LLFolderViewItem* first_item, const std::string &search_string, BOOL backward);
 	void setShowSelectionContext(BOOL show) { mShowSelectionContext = show; }
 	BOOL getShowSelectionContext();
@@ -233,6 +238,11 @@ public:
 	LLFolderViewItem* getItemByID(const LLUUID& id);
 	LLFolderViewFolder* getFolderByID(const LLUUID& id);
 
+	// Called when the searchable label of item changed.
+	void updateSearchIndex(LLFolderViewItem* item);
+	// FALSE if no descendant of folder can pass the current filter string.
+	bool mayHaveSearchMatches(LLFolderViewFolder* folder) const;
+
 	void	doIdle();						// Real idle routine
 	static void idle(void* user_data);		// static glue to doIdle()
 
@@ -259,6 +269,7 @@ public:
 private:
 	void updateMenuOptions(LLMenuGL* menu);
 	void updateRenamerPosition();
+	void updateSearchMatches(LLInventoryFilter& filter);
 
 protected:
 	LLScrollContainer* mScrollContainer;  // NULL if this is not a child of a scroll container.
@@ -317,6 +328,16 @@ protected:
 	S32								mRunningHeight;
 	std::map<LLUUID, LLFolderViewItem*> mItemMap;
 	BOOL							mDragAndDropThisFrame;
+
+	// Searchable labels of all items, by id. Built the first time that the filter
+	// string is long enough to look up, and kept up to date from then on.
+	LLSubstringIndex				mSearchIndex;
+	bool							mSearchIndexBuilt;
+	// The folders that contain items that match the filter string of generation
+	// mSearchMatchGeneration, if mUseSearchMatches.
+	std::set<LLFolderViewFolder*>	mSearchMatchFolders;
+	S32								mSearchMatchGeneration;
+	bool							mUseSearchMatches;
 	
 	LLUUID							mSelectThisID; // if non null, select this item
 	
@@ -96,6 +96,7 @@ LLFolderViewItem::LLFolderViewItem( const std::string& name, LLUIImagePtr icon,
 	LLUICtrl( name, LLRect(0, 0, 0, 0), TRUE, NULL, FOLLOWS_LEFT|FOLLOWS_TOP|FOLLOWS_RIGHT),
 	mLabelWidth(0),
 	mLabelWidthDirty(false),
+	mArrangeDeferred(false),
 	mParentFolder( NULL ),
 	mIsSelected( FALSE ),
 	mIsCurSelection( FALSE ),
@@ -408,6 +409,7 @@ BOOL LLFolderViewItem::addToFolder(LLFolderViewFolder* folder, LLFolderView* roo
 // makes sure that this view and it's children are the right size.
 S32 LLFolderViewItem::arrange( S32* width, S32* height, S32 filter_generation)
 {
+	mArrangeDeferred = false;
 	S32 indentation = LEFT_INDENTATION;
 	// Only indent deeper items in hierarchy
 	mIndentation = (getParentFolder() 
@@ -438,6 +440,29 @@ S32 LLFolderViewItem::getItemHeight()
 	return mItemHeight;
 }
 
+S32 LLFolderViewItem::deferArrange(S32* width)
+{
+	mArrangeDeferred = true;
+	// use the width from the last time we were arranged
+	*width = llmax(*width, mLabelWidth + mIndentation);
+	return getItemHeight();
+}
+
+void LLFolderViewItem::arrangeIfDeferred()
+{
+	if (mArrangeDeferred)
+	{
+		S32 width = 0;
+		S32 height = 0;
+		arrange(&width, &height, 0);
+		// the folder view needs to get wider if our label doesn't fit anymore
+		if (mParentFolder && width > getRoot()->getRect().getWidth())
+		{
+			mParentFolder->requestArrange();
+		}
+	}
+}
+
 void LLFolderViewItem::filter( LLInventoryFilter& filter)
 {
 	const BOOL previous_passed_filter = mPassedFilter;
@@ -649,6 +674,7 @@ void LLFolderViewItem::updateSearchLabelType()
 		}
 		mSearchable += mSearchableLabelCreator;
 	}
+	mRoot->updateSearchIndex(this);
 }
 
 const std::string& LLFolderViewItem::getSearchableLabel()
@@ -1138,7 +1164,8 @@ LLFolderViewFolder::LLFolderViewFolder( const std::string& name, LLUIImagePtr ic
 	mCompletedFilterGeneration(-1),
 	mMostFilteredDescendantGeneration(-1),
 	mNeedsSort(false),
-	mPassedFolderFilter(FALSE)
+	mPassedFolderFilter(FALSE),
+	mArrangedChildrenValid(false)
 {
 }
 
@@ -1209,6 +1236,14 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 			// Add sizes of children
 			S32 parent_item_height = getRect().getHeight();
 
+			// items that are more than a window height outside of the scroll window
+			// are only laid out, not arranged: there can be thousands of them
+			LLRect arrange_rect;
+			const bool defer_arrange = getRoot()->getVisibleRectIn(this, arrange_rect);
+			arrange_rect.stretch(0, arrange_rect.getHeight());
+			mArrangedChildren.clear();
+			mArrangedRows.clear();
+
 			for(folders_t::iterator fit = mFolders.begin(); fit != mFolders.end(); ++fit)
 			{
 				LLFolderViewFolder* folderp = (*fit);
@@ -1235,6 +1270,8 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 					running_height += (F32)child_height;
 					*width = llmax(*width, child_width);
 					folderp->setOrigin( 0, child_top - folderp->getRect().getHeight() );
+					mArrangedChildren.push_back(folderp);
+					mArrangedRows.addRow(child_height);
 				}
 			}
 			for(items_t::iterator iit = mItems.begin();
@@ -1256,15 +1293,27 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 					S32 child_height = 0;
 					S32 child_top = parent_item_height - ll_round(running_height);
 
-					target_height += itemp->arrange( &child_width, &child_height, filter_generation );
+					if (defer_arrange
+						&& (child_top <= arrange_rect.mBottom || child_top - itemp->getItemHeight() >= arrange_rect.mTop))
+					{
+						child_height = itemp->deferArrange( &child_width );
+						target_height += child_height;
+					}
+					else
+					{
+						target_height += itemp->arrange( &child_width, &child_height, filter_generation );
+					}
 					// don't change width, as this item is as wide as its parent folder by construction
 					itemp->reshape( itemp->getRect().getWidth(), child_height);
 
 					running_height += (F32)child_height;
 					*width = llmax(*width, child_width);
 					itemp->setOrigin( 0, child_top - itemp->getRect().getHeight() );
+					mArrangedChildren.push_back(itemp);
+					mArrangedRows.addRow(child_height);
 				}
 			}
+			mArrangedChildrenValid = true;
 		}
 
 		mTargetHeight = target_height;
@@ -1277,6 +1326,18 @@ S32 LLFolderViewFolder::arrange( S32* width, S32* height, S32 filter_generation)
 		*width = mLastCalculatedWidth;
 	}
 
+	// only the part of the animation that is in the scroll window can be seen,
+	// and every frame of it arranges us again: skip what happens below it
+	LLRect visible_rect;
+	if (mCurHeight != mTargetHeight && getRoot()->getVisibleRectIn(this, visible_rect))
+	{
+		const F32 window_bottom = (F32)(getRect().getHeight() - visible_rect.mBottom);
+		if (mCurHeight > window_bottom)
+		{
+			mCurHeight = llmax(mTargetHeight, window_bottom);
+		}
+	}
+
 	// animate current height towards target height
 	if (llabs(mCurHeight - mTargetHeight) > 1.f)
 	{
@@ -1415,6 +1476,14 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 		LLInventoryModelBackgroundFetch::instance().start(mListener->getUUID());
 	}
 
+	// when the filter string was looked up in the search index, none of our
+	// descendants can pass unless we contain one of the matches
+	if (!getRoot()->mayHaveSearchMatches(this))
+	{
+		setCompletedFilterGeneration(filter_generation, FALSE/*dont recurse up to root*/);
+		return;
+	}
+
 	// now query children
 	for (folders_t::iterator iter = mFolders.begin();
 		 iter != mFolders.end();
@@ -2000,6 +2069,7 @@ void LLFolderViewFolder::extractItem( LLFolderViewItem* item )
 	{
 		mItems.erase(it);
 	}
+	mArrangedChildrenValid = false;
 	//item has been removed, need to update filter
 	dirtyFilter();
 	//because an item is going away regardless of filter status, force rearrange
@@ -2555,12 +2625,36 @@ void LLFolderViewFolder::draw()
 	// draw children if root folder, or any other folder that is open or animating to closed state
 	if( getRoot() == this || (mIsOpen || mCurHeight != mTargetHeight ))
 	{
-		LLView::draw();
+		drawArrangedChildren();
 	}
 
 	mExpanderHighlighted = FALSE;
 }
 
+void LLFolderViewFolder::drawArrangedChildren()
+{
+	LLRect visible_rect;
+	if (!mArrangedChildrenValid || !getRoot()->getVisibleRectIn(this, visible_rect))
+	{
+		LLView::draw();
+		return;
+	}
+
+	// the rows start below our own label
+	const S32 rows_top = getRect().getHeight() - getItemHeight();
+	U32 first, last;
+	mArrangedRows.getRowsIn(rows_top - visible_rect.mTop, rows_top - visible_rect.mBottom, first, last);
+	for (U32 i = first; i < last; ++i)
+	{
+		LLFolderViewItem* childp = mArrangedChildren[i];
+		if (childp->getVisible())
+		{
+			childp->arrangeIfDeferred();
+			drawChild(childp);
+		}
+	}
+}
+
 time_t LLFolderViewFolder::getCreationDate() const
 {
 	return llmax<time_t>(mCreationDate, mSubtreeCreationDate);
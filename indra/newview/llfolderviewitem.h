@@ -28,6 +28,7 @@
 
 #include "llview.h"
 #include "lldarray.h"  // *TODO: Eliminate, forward declare
+#include "llrowlayout.h"
 #include "lluiimage.h"
 #include "lluictrl.h"
 
@@ -117,6 +118,7 @@ protected:
 	std::string					mSearchableLabelCreator;
 	S32							mLabelWidth;
 	bool						mLabelWidthDirty;
+	bool						mArrangeDeferred;
 	time_t						mCreationDate;
 	LLFolderViewFolder*			mParentFolder;
 	LLFolderViewEventListener*	mListener;
@@ -194,6 +196,11 @@ public:
 	virtual S32 arrange( S32* width, S32* height, S32 filter_generation );
 	virtual S32 getItemHeight();
 
+	// Lays out an item that is far outside the scroll window without arranging it
+	// (measuring its label); arrangeIfDeferred() does that when it gets drawn.
+	S32 deferArrange(S32* width);
+	void arrangeIfDeferred();
+
 	// applies filters to control visibility of inventory items
 	virtual void filter( LLInventoryFilter& filter);
 
@@ -390,6 +397,15 @@ protected:
 	bool		mNeedsSort;
 	bool		mPassedFolderFilter;
 
+	// The visible children in the order that arrange() laid them out, below our
+	// own label, and their rows; so that draw() only looks at the ones in the
+	// scroll window. Invalid when a child was removed since.
+	std::vector<LLFolderViewItem*> mArrangedChildren;
+	LLRowLayout	mArrangedRows;
+	bool		mArrangedChildrenValid;
+
+	void drawArrangedChildren();
+
 public:
 	typedef enum e_recurse_type
 	{
@@ -30,6 +30,7 @@
 #include "llagent.h"
 #include "llagentwearables.h"
 #include "llappearancemgr.h"
+#include "llinventorycache.h"
 #include "llinventoryclipboard.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
@@ -74,7 +75,9 @@ BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
 ///----------------------------------------------------------------------------
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
-const char CACHE_FORMAT_STRING[] = "%s.inv"; 
+const char CACHE_FORMAT_STRING[] = "%s.invbin"; 
+// The gzipped text cache of older viewers.
+const char LEGACY_CACHE_FORMAT_STRING[] = "%s.inv.gz"; 
 
 struct InventoryIDPtrLess
 {
@@ -84,6 +87,14 @@ struct InventoryIDPtrLess
 	}
 };
 
+// Creates viewer inventory objects from the records of the inventory cache.
+class LLViewerInventoryCacheParser : public LLInventoryCacheParser
+{
+protected:
+	/*virtual*/ LLInventoryCategory* createCategory(void) const { return new LLViewerInventoryCategory(LLUUID::null); }
+	/*virtual*/ LLInventoryItem* createItem(void) const { return new LLViewerInventoryItem; }
+};
+
 class LLCanCache : public LLInventoryCollectFunctor 
 {
 public:
@@ -1458,6 +1469,10 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
 	if (referent.notNull())
 	{
 		mChangedItemIDs.insert(referent);
+
+		// The cache stores items with their category.
+		LLViewerInventoryItem* item = getItem(referent);
+		mCacheDirtyCategories.insert(item ? item->getParentUUID() : referent);
 	}
 	
 	// Update all linked items.  Starting with just LABEL because I'm
@@ -1589,18 +1604,7 @@ void LLInventoryModel::cache(
 	agent_id.toString(agent_id_str);
 	std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, agent_id_str));
 	inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
-	saveToFile(inventory_filename, categories, items);
-	std::string gzip_filename(inventory_filename);
-	gzip_filename.append(".gz");
-	if(gzip_file(inventory_filename, gzip_filename))
-	{
-		lldebugs << "Successfully compressed " << inventory_filename << llendl;
-		LLFile::remove(inventory_filename);
-	}
-	else
-	{
-		llwarns << "Unable to compress " << inventory_filename << llendl;
-	}
+	saveToFile(inventory_filename, categories, items, &mCacheDirtyCategories);
 }
 
 
@@ -1898,25 +1902,11 @@ bool LLInventoryModel::loadSkeleton(
 		std::string inventory_filename;
 		inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
-		std::string gzip_filename(inventory_filename);
-		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
-		bool remove_inventory_file = false;
-		if (fp)
-		{
-			fclose(fp);
-			fp = NULL;
-			if (gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
-			{
-				llinfos << "Unable to gunzip " << gzip_filename << llendl;
-			}
+		// The cache of older viewers is never read anymore.
+		std::string legacy_filename = llformat(LEGACY_CACHE_FORMAT_STRING, path.c_str());
+		if (LLFile::isfile(legacy_filename))
+		{
+			LLFile::remove(legacy_filename);
 		}
 		bool is_cache_obsolete = false;
 		if (loadFromFile(inventory_filename, categories, items, is_cache_obsolete))
@@ -2091,16 +2081,10 @@ bool LLInventoryModel::loadSkeleton(
 			}
 		}
 
-		if (remove_inventory_file)
-		{
-			// clean up the gunzipped file.
-			LLFile::remove(inventory_filename);
-		}
 		if (is_cache_obsolete)
 		{
-			// If out of date, remove the gzipped file too.
 			llwarns << "Inv cache out of date, removing" << llendl;
-			LLFile::remove(gzip_filename);
+			LLFile::remove(inventory_filename);
 		}
 		categories.clear(); // will unref and delete entries
 	}
@@ -2393,97 +2377,60 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 		return false;
 	}
 	llinfos << "LLInventoryModel::loadFromFile(" << filename << ")" << llendl;
-	LLFILE* file = LLFile::fopen(filename, "rb");		/*Flawfinder: ignore*/
-	if(!file)
+	LLInventoryCacheReader reader;
+	switch (reader.open(filename, sCurrentInvCacheVersion))
 	{
-		llinfos << "unable to load inventory from: " << filename << llendl;
-		return false;
+		case LLInventoryCacheReader::OK:
+			break;
+		case LLInventoryCacheReader::NOT_FOUND:
+			llinfos << "unable to load inventory from: " << filename << llendl;
+			return false;
+		case LLInventoryCacheReader::OBSOLETE:
+		case LLInventoryCacheReader::CORRUPT:
+			is_cache_obsolete = true;
+			return false;
 	}
-	// *NOTE: This buffer size is hard coded into scanf() below.
-	char buffer[MAX_STRING];		/*Flawfinder: ignore*/
-	char keyword[MAX_STRING];		/*Flawfinder: ignore*/
-	char value[MAX_STRING];			/*Flawfinder: ignore*/
-	is_cache_obsolete = true;  		// Obsolete until proven current
-	while(!feof(file) && fgets(buffer, MAX_STRING, file)) 
+
+	// Every category is a separate record, so the worker threads can parse them in parallel.
+	LLViewerInventoryCacheParser parser;
+	LLInventoryCacheParser::cat_list_t cached_categories;
+	LLInventoryCacheParser::item_list_t cached_items;
+	U32 invalid = parser.parse(reader, LLAppViewer::getWorkerPool(), cached_categories, cached_items);
+	if (invalid)
 	{
-		sscanf(buffer, " %126s %126s", keyword, value);	/* Flawfinder: ignore */
-		if (0 == strcmp("inv_cache_version", keyword))
-		{
-			S32 version;
-			int succ = sscanf(value,"%d",&version);
-			if ((1 == succ) && (version == sCurrentInvCacheVersion))
-			{
-				// Cache is up to date
-				is_cache_obsolete = false;
-				continue;
-			}
-			else
-			{
-				// Cache is out of date
-				break;
-			}
-		}
-		else if(0 == strcmp("inv_category", keyword))
-		{
-			if (is_cache_obsolete)
-				break;
-			
-			LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
-			if(inv_cat->importFileLocal(file))
-			{
-				categories.put(inv_cat);
-			}
-			else
-			{
-				llwarns << "loadInventoryFromFile().  Ignoring invalid inventory category: " << inv_cat->getName() << llendl;
-				//delete inv_cat; // automatic when inv_cat is reassigned or destroyed
-			}
-		}
-		else if(0 == strcmp("inv_item", keyword))
-		{
-			if (is_cache_obsolete)
-				break;
+		llwarns << "loadInventoryFromFile().  Ignoring " << invalid << " invalid inventory categories." << llendl;
+	}
 
-			LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
-			if( inv_item->importFileLocal(file) )
-			{
-				// *FIX: Need a better solution, this prevents the
-				// application from freezing, but breaks inventory
-				// caching.
-				if(inv_item->getUUID().isNull())
-				{
-					//delete inv_item; // automatic when inv_cat is reassigned or destroyed
-					llwarns << "Ignoring inventory with null item id: "
-							<< inv_item->getName() << llendl;
-						
-				}
-				else
-				{
-					items.put(inv_item);
-				}
-			}
-			else
-			{
-				llwarns << "loadInventoryFromFile().  Ignoring invalid inventory item: " << inv_item->getName() << llendl;
-				//delete inv_item; // automatic when inv_cat is reassigned or destroyed
-			}
+	categories.reserve(categories.size() + cached_categories.size());
+	for (LLInventoryCacheParser::cat_list_t::iterator iter = cached_categories.begin(); iter != cached_categories.end(); ++iter)
+	{
+		categories.put(static_cast<LLViewerInventoryCategory*>(iter->get()));
+	}
+	items.reserve(items.size() + cached_items.size());
+	for (LLInventoryCacheParser::item_list_t::iterator iter = cached_items.begin(); iter != cached_items.end(); ++iter)
+	{
+		LLViewerInventoryItem* inv_item = static_cast<LLViewerInventoryItem*>(iter->get());
+		// *FIX: Need a better solution, this prevents the
+		// application from freezing, but breaks inventory
+		// caching.
+		if(inv_item->getUUID().isNull())
+		{
+			llwarns << "Ignoring inventory with null item id: "
+					<< inv_item->getName() << llendl;
 		}
 		else
 		{
-			llwarns << "Unknown token in inventory file '" << keyword << "'"
-					<< llendl;
+			items.put(inv_item);
 		}
 	}
-	fclose(file);
-	if (is_cache_obsolete)
-		return false;
 	return true;
 }
 
 // static
 bool LLInventoryModel::saveToFile(const std::string& filename,
 								  const cat_array_t& categories,
-								  const item_array_t& items)
+								  const item_array_t& items,
+								  const uuid_set_t* dirty_categories)
 {
 	if(filename.empty())
 	{
@@ -2491,32 +2438,71 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 		return false;
 	}
 	llinfos << "LLInventoryModel::saveToFile(" << filename << ")" << llendl;
-	LLFILE* file = LLFile::fopen(filename, "wb");		/*Flawfinder: ignore*/
-	if(!file)
+
+	// The cache has one record per category, with the items in it.
+	typedef std::map<LLUUID, std::vector<LLInventoryItem const*> > items_by_parent_t;
+	items_by_parent_t items_by_parent;
+	S32 count = items.count();
+	for (S32 i = 0; i < count; ++i)
+	{
+		items_by_parent[items[i]->getParentUUID()].push_back(items[i]);
+	}
+
+	// Records of categories that didn't change since they were written can be copied from the old file.
+	LLInventoryCacheReader previous;
+	if (dirty_categories)
+	{
+		previous.open(filename, sCurrentInvCacheVersion);
+	}
+
+	LLInventoryCacheWriter writer;
+	if (!writer.open(filename, sCurrentInvCacheVersion))
 	{
 		llwarns << "unable to save inventory to: " << filename << llendl;
 		return false;
 	}
-
-	fprintf(file, "\tinv_cache_version\t%d\n", sCurrentInvCacheVersion);
-	S32 count = categories.count();
-	S32 i;
-	for(i = 0; i < count; ++i)
+	std::vector<LLInventoryItem const*> const no_items;
+	S32 written = 0;
+	S32 copied = 0;
+	count = categories.count();
+	for (S32 i = 0; i < count; ++i)
 	{
 		LLViewerInventoryCategory* cat = categories[i];
-		if(cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
+		S32 version = cat->getVersion();
+		if (version == LLViewerInventoryCategory::VERSION_UNKNOWN)
+		{
+			continue;
+		}
+		items_by_parent_t::const_iterator children = items_by_parent.find(cat->getUUID());
+		std::vector<LLInventoryItem const*> const& cat_items(children == items_by_parent.end() ? no_items : children->second);
+		LLInventoryCacheEntry const* entry = previous.isOpen() ? previous.find(cat->getUUID()) : NULL;
+		// Removing an item doesn't change the category, but it changes the number of items.
+		if (entry && entry->mVersion == version && entry->mNumItems == cat_items.size() &&
+			dirty_categories->find(cat->getUUID()) == dirty_categories->end())
+		{
+			if (!writer.copyRecord(previous, *entry))
+			{
+				return false;
+			}
+			++copied;
+		}
+		else
 		{
-			cat->exportFileLocal(file);
+			if (!writer.addRecord(*cat, version, cat_items))
+			{
+				return false;
+			}
+			++written;
 		}
 	}
-
-	count = items.count();
-	for(i = 0; i < count; ++i)
+	// The old file must be closed before it can be replaced.
+	previous.close();
+	if (!writer.commit())
 	{
-		items[i]->exportFile(file);
+		llwarns << "unable to save inventory to: " << filename << llendl;
+		return false;
 	}
-
-	fclose(file);
+	lldebugs << "Wrote " << written << " categories, copied " << copied << " unchanged ones." << llendl;
 	return true;
 }
 
@@ -33,6 +33,7 @@
 #include "llframetimer.h"
 #include "llhttpclient.h"
 #include "lluuid.h"
+#include "lluuidflatmap.h"
 #include "llpermissionsflags.h"
 #include "llstring.h"
 
@@ -155,13 +156,13 @@ private:
 	// the inventory using several different identifiers.
 	// mInventory member data is the 'master' list of inventory, and
 	// mCategoryMap and mItemMap store uuid->object mappings. 
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-	typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+	typedef LLUUIDFlatMap<LLPointer<LLViewerInventoryItem> > item_map_t;
 	cat_map_t mCategoryMap;
 	item_map_t mItemMap;
 	// This last set of indices is used to map parents to children.
-	typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+	typedef LLUUIDFlatMap<cat_array_t*> parent_cat_map_t;
+	typedef LLUUIDFlatMap<item_array_t*> parent_item_map_t;
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
 
@@ -487,6 +488,8 @@ private:
 	// Variables used to track what has changed since the last notify.
 	U32 mModifyMask;
 	changed_items_t mChangedItemIDs;
+	// Categories that changed since login; cache() writes their records again.
+	uuid_set_t mCacheDirtyCategories;
 	
 	//--------------------------------------------------------------------
 	// Observers
@@ -527,9 +530,12 @@ protected:
 							 cat_array_t& categories,
 							 item_array_t& items,
 							 bool& is_cache_obsolete); 
+	// If dirty_categories is not NULL, records of the existing cache file are
+	// reused for categories that are not in it and didn't change version.
 	static bool saveToFile(const std::string& filename,
 						   const cat_array_t& categories,
-						   const item_array_t& items); 
+						   const item_array_t& items,
+						   const uuid_set_t* dirty_categories = NULL); 
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
@@ -562,8 +568,8 @@ protected:
 	cat_array_t* getUnlockedCatArray(const LLUUID& id);
 	item_array_t* getUnlockedItemArray(const LLUUID& id);
 private:
-	std::map<LLUUID, bool> mCategoryLock;
-	std::map<LLUUID, bool> mItemLock;
+	LLUUIDFlatMap<bool> mCategoryLock;
+	LLUUIDFlatMap<bool> mItemLock;
 
 
 public:
@@ -0,0 +1,274 @@
+/**
+ * @file llmeshheaderindex.cpp
+ * @brief Persistent index of decoded mesh asset headers.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llmeshheaderindex.h"
+
+#include "llapr.h"
+#include "llthread.h"
+
+// Bump this whenever Entry changes.
+static const U32 MESH_HEADER_INDEX_VERSION = 1;
+static const U32 MESH_HEADER_INDEX_MAGIC = 0x5848534d;	// "MSHX"
+// Sanity limit on the number of entries read from disk.
+static const U32 MAX_MESH_HEADER_INDEX_ENTRIES = 1 << 20;
+
+struct MeshHeaderIndexMetaInfo
+{
+	U32 mMagic;
+	U32 mVersion;
+	U32 mEntrySize;
+	U32 mNumEntries;
+};
+
+//static
+const char* LLMeshHeaderIndex::sBlockNames[NUM_BLOCKS] =
+{
+	"lowest_lod",
+	"low_lod",
+	"medium_lod",
+	"high_lod",
+	"skin",
+	"physics_convex",
+	"physics_mesh"
+};
+
+LLMeshHeaderIndex::LLMeshHeaderIndex()
+:	mMutex(new LLMutex),
+	mSaveMutex(new LLMutex),
+	mSavedEntries(0),
+	mRewrite(true)
+{
+}
+
+LLMeshHeaderIndex::~LLMeshHeaderIndex()
+{
+	delete mSaveMutex;
+	delete mMutex;
+}
+
+void LLMeshHeaderIndex::load(const std::string& filename)
+{
+	LLMutexLock lock(mMutex);
+
+	mFilename = filename;
+	mEntries.clear();
+	mUnsaved.clear();
+	mSavedEntries = 0;
+	mRewrite = true;
+
+	if (!LLAPRFile::isExist(mFilename))
+	{
+		return;
+	}
+
+	S32 file_size = 0;
+	LLAPRFile apr_file(mFilename, APR_READ|APR_BINARY, &file_size);
+
+	MeshHeaderIndexMetaInfo meta;
+	bool success = apr_file.read(&meta, sizeof(meta)) == sizeof(meta) &&
+		meta.mMagic == MESH_HEADER_INDEX_MAGIC &&
+		meta.mVersion == MESH_HEADER_INDEX_VERSION &&
+		meta.mEntrySize == sizeof(Entry) &&
+		meta.mNumEntries <= MAX_MESH_HEADER_INDEX_ENTRIES &&
+		//a longer file was interrupted while appending: the tail is overwritten by the next save()
+		(S64)file_size >= (S64)sizeof(meta) + (S64)meta.mNumEntries * sizeof(Entry);
+
+	if (success && meta.mNumEntries > 0)
+	{	//one read for the whole table
+		std::vector<Entry> entries(meta.mNumEntries);
+		S32 bytes = meta.mNumEntries * sizeof(Entry);
+		success = apr_file.read(&entries[0], bytes) == bytes;
+		if (success)
+		{
+			mEntries.rehash(entries.size());
+			for (std::vector<Entry>::iterator iter = entries.begin(); iter != entries.end(); ++iter)
+			{
+				mEntries[iter->mMeshID] = *iter;
+			}
+		}
+	}
+
+	if (success)
+	{	//appending again is fine, unless earlier appends left duplicates behind
+		mSavedEntries = meta.mNumEntries;
+		mRewrite = mEntries.size() != mSavedEntries;
+	}
+
+	if (!success)
+	{
+		llwarns << "Discarding invalid mesh header index " << mFilename << llendl;
+		mEntries.clear();
+		apr_file.close();
+		LLAPRFile::remove(mFilename);
+		return;
+	}
+
+	llinfos << "Loaded " << mEntries.size() << " mesh headers from " << mFilename << llendl;
+}
+
+void LLMeshHeaderIndex::save()
+{	//mSaveMutex keeps saves apart, mMutex is only held to take the entries so that lookups and updates don't wait for the disk
+	LLMutexLock save_lock(mSaveMutex);
+
+	MeshHeaderIndexMetaInfo meta;
+	meta.mMagic = MESH_HEADER_INDEX_MAGIC;
+	meta.mVersion = MESH_HEADER_INDEX_VERSION;
+	meta.mEntrySize = sizeof(Entry);
+
+	std::string filename;
+	std::vector<Entry> entries;
+	U32 saved_entries;
+	bool append;
+	{
+		LLMutexLock lock(mMutex);
+		if (mFilename.empty() || (!mRewrite && mUnsaved.empty()))
+		{
+			return;
+		}
+		filename = mFilename;
+		saved_entries = mSavedEntries;
+		append = !mRewrite && mSavedEntries + mUnsaved.size() <= MAX_MESH_HEADER_INDEX_ENTRIES;
+		if (append)
+		{	//entries added while writing go to the next save()
+			entries.swap(mUnsaved);
+		}
+	}
+
+	if (append)
+	{	//append the new entries, then count them in the header, so that an interrupted save loses only those
+		meta.mNumEntries = saved_entries + entries.size();
+		S32 offset = sizeof(meta) + saved_entries * sizeof(Entry);
+		S32 bytes = entries.size() * sizeof(Entry);
+		if (LLAPRFile::writeEx(filename, &entries[0], offset, bytes) == bytes &&
+			LLAPRFile::writeEx(filename, &meta, 0, sizeof(meta)) == sizeof(meta))
+		{
+			LLMutexLock lock(mMutex);
+			mSavedEntries = meta.mNumEntries;
+			return;
+		}
+		llwarns << "Failed to append to mesh header index " << filename << ", rewriting it" << llendl;
+		entries.clear();
+	}
+
+	{	//the rewrite holds every entry, including the ones that are still unsaved
+		LLMutexLock lock(mMutex);
+		meta.mNumEntries = llmin((U32)mEntries.size(), MAX_MESH_HEADER_INDEX_ENTRIES);
+		entries.reserve(meta.mNumEntries);
+		for (entry_map_t::iterator iter = mEntries.begin(); iter != mEntries.end() && entries.size() < meta.mNumEntries; ++iter)
+		{
+			entries.push_back(iter->second);
+		}
+		mUnsaved.clear();
+	}
+
+	bool success;
+	{
+		LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_TRUNCATE|APR_BINARY);
+		success = apr_file.write(&meta, sizeof(meta)) == sizeof(meta);
+		if (success && !entries.empty())
+		{
+			S32 bytes = entries.size() * sizeof(Entry);
+			success = apr_file.write(&entries[0], bytes) == bytes;
+		}
+	}
+	if (!success)
+	{
+		llwarns << "Failed to write mesh header index " << filename << llendl;
+		LLAPRFile::remove(filename);
+	}
+
+	LLMutexLock lock(mMutex);
+	if (!success)
+	{	//everything is written again by the next save()
+		mSavedEntries = 0;
+		mRewrite = true;
+		return;
+	}
+
+	mSavedEntries = meta.mNumEntries;
+	mRewrite = false;
+}
+
+void LLMeshHeaderIndex::update(const LLUUID& mesh_id, const LLSD& header, U32 header_size)
+{
+	if (header_size == 0 || header.has("404"))
+	{	//nothing worth remembering
+		return;
+	}
+
+	Entry entry;
+	entry.mMeshID = mesh_id;
+	entry.mHeaderSize = header_size;
+	entry.mVersion = header["version"].asInteger();
+	for (S32 i = 0; i < NUM_BLOCKS; ++i)
+	{
+		const LLSD& block = header[sBlockNames[i]];
+		entry.mOffset[i] = block.has("offset") ? block["offset"].asInteger() : -1;
+		entry.mSize[i] = block["size"].asInteger();
+	}
+
+	LLMutexLock lock(mMutex);
+	entry_map_t::iterator iter = mEntries.find(mesh_id);
+	if (iter != mEntries.end() && !memcmp(&iter->second, &entry, sizeof(Entry)))
+	{	//already known, headers don't change
+		return;
+	}
+	mEntries[mesh_id] = entry;
+	mUnsaved.push_back(entry);
+}
+
+bool LLMeshHeaderIndex::lookup(const LLUUID& mesh_id, LLSD& header, U32& header_size)
+{
+	LLMutexLock lock(mMutex);
+
+	entry_map_t::iterator iter = mEntries.find(mesh_id);
+	if (iter == mEntries.end())
+	{
+		return false;
+	}
+
+	const Entry& entry = iter->second;
+	header = LLSD::emptyMap();
+	header["version"] = entry.mVersion;
+	for (S32 i = 0; i < NUM_BLOCKS; ++i)
+	{
+		if (entry.mOffset[i] >= 0)
+		{
+			header[sBlockNames[i]]["offset"] = entry.mOffset[i];
+			header[sBlockNames[i]]["size"] = entry.mSize[i];
+		}
+	}
+	header_size = entry.mHeaderSize;
+	return true;
+}
+
+S32 LLMeshHeaderIndex::size()
+{
+	LLMutexLock lock(mMutex);
+	return (S32)mEntries.size();
+}
@@ -0,0 +1,102 @@
+/**
+ * @file llmeshheaderindex.h
+ * @brief Persistent index of decoded mesh asset headers.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMESHHEADERINDEX_H
+#define LL_LLMESHHEADERINDEX_H
+
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "llsd.h"
+#include "lluuid.h"
+
+class LLMutex;
+
+// Mesh asset headers are immutable, so once a header has been parsed the
+// block locations it describes are valid forever. LLMeshHeaderIndex keeps
+// those locations for every mesh seen so far in a flat binary file in the
+// cache directory, so that the next session can request LODs without
+// reading and parsing the LLSD header first.
+//
+// All methods are thread safe.
+class LLMeshHeaderIndex
+{
+public:
+	enum EBlock
+	{
+		BLOCK_LOWEST_LOD = 0,
+		BLOCK_LOW_LOD,
+		BLOCK_MEDIUM_LOD,
+		BLOCK_HIGH_LOD,
+		BLOCK_SKIN,
+		BLOCK_PHYSICS_CONVEX,
+		BLOCK_PHYSICS_MESH,
+		NUM_BLOCKS
+	};
+
+	// On-disk record, written as is.
+	struct Entry
+	{
+		LLUUID	mMeshID;
+		U32		mHeaderSize;
+		S32		mVersion;
+		S32		mOffset[NUM_BLOCKS];	// relative to the end of the header
+		S32		mSize[NUM_BLOCKS];
+	};
+
+	LLMeshHeaderIndex();
+	~LLMeshHeaderIndex();
+
+	// Read the whole index file in one pass; drops the index if the file is corrupt or of another version.
+	void load(const std::string& filename);
+	// Append the entries added since the last save() to the file, or rewrite it if it is missing,
+	// holds duplicates or an append failed. Cheap enough to call periodically; lookup() and update()
+	// don't wait for the file to be written.
+	void save();
+
+	// Record the block locations of a successfully parsed header; it is written to disk by the next save().
+	void update(const LLUUID& mesh_id, const LLSD& header, U32 header_size);
+
+	// Rebuild the subset of the LLSD header that the mesh repository uses.
+	// Returns false if mesh_id isn't indexed.
+	bool lookup(const LLUUID& mesh_id, LLSD& header, U32& header_size);
+
+	S32 size();
+
+	static const char* sBlockNames[NUM_BLOCKS];
+
+private:
+	typedef boost::unordered_map<LLUUID, Entry> entry_map_t;
+	entry_map_t mEntries;
+	std::string mFilename;
+	LLMutex* mMutex;
+	LLMutex* mSaveMutex;			// held by save() while it writes the file
+	std::vector<Entry> mUnsaved;	// added since the last save()
+	U32 mSavedEntries;				// number of entries in the file
+	bool mRewrite;					// the whole file must be written by the next save()
+};
+
+#endif // LL_LLMESHHEADERINDEX_H
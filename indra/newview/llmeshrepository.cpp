@@ -35,6 +35,7 @@
 #include "llappviewer.h"
 #include "llbufferstream.h"
 #include "llcallbacklist.h"
+#include "lldir.h"
 #include "lldatapacker.h"
 #include "llfasttimer.h"
 #include "llfloaterperms.h"
@@ -46,6 +47,7 @@
 #include "llsdutil_math.h"
 #include "llsdserialize.h"
 #include "llthread.h"
+#include "llthreadpool.h"
 #include "llvfile.h"
 #include "llviewercontrol.h"
 #include "llviewerinventory.h"
@@ -86,6 +88,8 @@ extern AIHTTPTimeoutPolicy wholeModelUploadResponder_timeout;
 LLMeshRepository gMeshRepo;
 
 const U32 MAX_MESH_REQUESTS_PER_SECOND = 100;
+// Seconds between writes of new entries to the mesh header index.
+const F32 MESH_HEADER_INDEX_SAVE_INTERVAL = 10.f;
 
 // Maximum mesh version to support.  Three least significant digits are reserved for the minor version, 
 // with major version changes indicating a format change that is not backwards compatible and should not
@@ -102,8 +106,9 @@ U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
 U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+LLAtomicU32 LLMeshRepository::sCacheBytesWritten(0);
 U32 LLMeshRepository::sPeakKbps = 0;
+F32 LLMeshRepository::sDecodeLatency = 0.f;
 	
 
 const U32 MAX_TEXTURE_UPLOAD_RETRIES = 5;
@@ -552,16 +557,64 @@ public:
 	/*virtual*/ char const* getName(void) const { return "LLWholeModelUploadResponder"; }
 };
 
+class LLMeshDecodeJob : public LLThreadPool::Job
+{
+public:
+	LLMeshDecodeJob(LLMeshRepoThread* thread, const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 cache_offset)
+		: mThread(thread), mMeshParams(mesh_params), mLOD(lod), mData((char*) data, data_size), mCacheOffset(cache_offset)
+	{
+	}
+
+	/*virtual*/ void run();
+
+private:
+	LLMeshRepoThread* mThread;
+	LLVolumeParams mMeshParams;
+	S32 mLOD;
+	std::string mData;
+	S32 mCacheOffset;
+	LLTimer mQueuedTimer;
+};
+
+void LLMeshDecodeJob::run()
+{ //called from a decode pool thread
+	if (LLApp::isQuitting())
+	{
+		return;
+	}
+
+	S32 data_size = mData.size();
+	bool success = data_size > 0 && mThread->lodReceived(mMeshParams, mLOD, (U8*) &mData[0], data_size);
+
+	if (success && mCacheOffset >= 0)
+	{ //good fetch from sim, write to VFS for caching
+		LLVFile file(gVFS, mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
+
+		if (file.getSize() >= mCacheOffset + data_size)
+		{
+			file.seek(mCacheOffset);
+			file.write((U8*) &mData[0], data_size);
+			LLMeshRepository::sCacheBytesWritten += data_size;
+		}
+	}
+
+	mThread->lodDecoded(mMeshParams, mLOD, success, mCacheOffset < 0, mQueuedTimer.getElapsedTimeF32());
+}
+
 LLMeshRepoThread::LLMeshRepoThread()
 : LLThread("mesh repo") 
 { 
 	mMutex = new LLMutex();
 	mHeaderMutex = new LLMutex();
 	mSignal = new LLCondition();
+	mDecodePool = new LLThreadPool("mesh decode");
 }
 
 LLMeshRepoThread::~LLMeshRepoThread()
 {
+	//decode jobs use the mutexes below, stop them first
+	delete mDecodePool;
+	mDecodePool = NULL;
 	delete mMutex;
 	mMutex = NULL;
 	delete mHeaderMutex;
@@ -570,6 +623,8 @@ LLMeshRepoThread::~LLMeshRepoThread()
 	mSignal = NULL;
 }
 
+static LLFastTimer::DeclareTimer FTM_MESH_FETCH("Mesh Fetch");
+
 void LLMeshRepoThread::run()
 {
 	LLCDResult res = LLConvexDecomposition::initThread();
@@ -583,6 +638,7 @@ void LLMeshRepoThread::run()
 	{
 		if (!LLApp::isQuitting())
 		{
+			LLFastTimer t(FTM_MESH_FETCH);
 			static U32 count = 0;
 
 			static F32 last_hundred = gFrameTimeSeconds;
@@ -613,6 +669,23 @@ void LLMeshRepoThread::run()
 				}
 			}
 
+			while (!mRefetchQ.empty() && count < MAX_MESH_REQUESTS_PER_SECOND && sActiveLODRequests < (S32)sMaxConcurrentRequests)
+			{
+				if (mMutex)
+				{
+					mMutex->lock();
+					LODRequest req = mRefetchQ.front();
+					mRefetchQ.pop();
+					mMutex->unlock();
+					if (!fetchMeshLOD(req.mMeshParams, req.mLOD, count, true))//failed, resubmit
+					{
+						mMutex->lock();
+						mRefetchQ.push(req);
+						mMutex->unlock();
+					}
+				}
+			}
+
 			while (!mHeaderReqQ.empty() && count < MAX_MESH_REQUESTS_PER_SECOND && sActiveHeaderRequests < (S32)sMaxConcurrentRequests)
 			{
 				if (mMutex)
@@ -669,6 +742,11 @@ void LLMeshRepoThread::run()
 				mPhysicsShapeRequests = incomplete;
 			}
 
+			if (mHeaderIndexSaveTimer.getElapsedTimeF32() > MESH_HEADER_INDEX_SAVE_INTERVAL)
+			{	//append the headers fetched since the last save, so that they survive a crash
+				mHeaderIndex.save();
+				mHeaderIndexSaveTimer.reset();
+			}
 		}
 
 		mSignal->wait();
@@ -710,9 +788,23 @@ void LLMeshRepoThread::lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32
 
 void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 { //could be called from any thread
+	const LLUUID& mesh_id = mesh_params.getSculptID();
+	bool have_header;
+	{
+		LLMutexLock lock(mMutex);
+		have_header = mMeshHeader.find(mesh_id) != mMeshHeader.end();
+	}
+	if (!have_header)
+	{ //the index lookup checks the VFS, don't make the other threads wait for mMutex meanwhile
+		have_header = loadHeaderFromIndex(mesh_id);
+	}
+
 	LLMutexLock lock(mMutex);
-	mesh_header_map::iterator iter = mMeshHeader.find(mesh_params.getSculptID());
-	if (iter != mMeshHeader.end())
+	if (!have_header)
+	{ //headerReceived may have stored the header meanwhile, then the LOD can be requested right away
+		have_header = mMeshHeader.find(mesh_id) != mMeshHeader.end();
+	}
+	if (have_header)
 	{ //if we have the header, request LOD byte range
 		LODRequest req(mesh_params, lod);
 		{
@@ -989,7 +1081,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, U32& c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, U32& count)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, U32& count, bool skip_cache)
 { 
 	LLUUID mesh_id = mesh_params.getSculptID();
 	MeshHeaderInfo info;
@@ -1003,7 +1095,7 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 	{
 		if(info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
 		{
-			if (loadInfoFromVFS(mesh_id, info, boost::bind(&LLMeshRepoThread::lodReceived, this, mesh_params, lod, _2, _3 )))
+			if (!skip_cache && loadInfoFromVFS(mesh_id, info, boost::bind(&LLMeshRepoThread::cachedLODReceived, this, mesh_params, lod, _2, _3 )))
 				return true;
 
 			//reading from VFS failed for whatever reason, fetch from sim
@@ -1077,6 +1169,8 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 			mMeshHeader[mesh_id] = header;
 		}
 
+		mHeaderIndex.update(mesh_id, header, header_size);
+
 		LLMutexLock lock(mMutex); // make sure only one thread access mPendingLOD at the same time.
 
 		//check for pending requests
@@ -1096,6 +1190,26 @@ bool LLMeshRepoThread::headerReceived(const LLVolumeParams& mesh_params, U8* dat
 	return true;
 }
 
+bool LLMeshRepoThread::loadHeaderFromIndex(const LLUUID& mesh_id)
+{ //the index only saves parsing the header, LODs fetched from the sim are only cached if the header was written to the VFS
+	if (!gVFS->getExists(mesh_id, LLAssetType::AT_MESH))
+	{
+		return false;
+	}
+
+	LLSD header;
+	U32 header_size = 0;
+	if (!mHeaderIndex.lookup(mesh_id, header, header_size))
+	{
+		return false;
+	}
+
+	LLMutexLock lock(mHeaderMutex);
+	mMeshHeaderSize[mesh_id] = header_size;
+	mMeshHeader[mesh_id] = header;
+	return true;
+}
+
 bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
 {
 	AIStateMachine::StateTimer timer("lodReceived");
@@ -1123,6 +1237,27 @@ bool LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U
 	return false;
 }
 
+void LLMeshRepoThread::queueLODDecode(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 cache_offset)
+{ //could be called from any thread
+	mDecodePool->post(new LLMeshDecodeJob(this, mesh_params, lod, data, data_size, cache_offset));
+}
+
+bool LLMeshRepoThread::cachedLODReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
+{ //called from loadInfoFromVFS, a decode failure makes lodDecoded fetch the LOD from the sim instead
+	queueLODDecode(mesh_params, lod, data, data_size, -1);
+	return true;
+}
+
+void LLMeshRepoThread::lodDecoded(const LLVolumeParams& mesh_params, S32 lod, bool success, bool from_cache, F32 latency)
+{ //called from a decode pool thread
+	LLMutexLock lock(mMutex);
+	LLMeshRepository::sDecodeLatency = lerp(LLMeshRepository::sDecodeLatency, latency * 1000.f, 0.1f);
+	if (!success && from_cache)
+	{
+		mRefetchQ.push(LODRequest(mesh_params, lod));
+	}
+}
+
 bool LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
 {
 	LLSD skin;
@@ -1791,22 +1926,9 @@ void LLMeshLODResponder::completedRaw(LLChannelDescriptors const& channels,
 		buffer->readAfter(channels.in(), NULL, data, data_size);
 	}
 
-	if (gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size))
-	{
-		AIStateMachine::StateTimer timer("FileOpen");
-		//good fetch from sim, write to VFS for caching
-		LLVFile file(gVFS, mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLVFile::WRITE);
-
-		S32 offset = mOffset;
-		S32 size = mRequestedBytes;
-
-		if (file.getSize() >= offset+size)
-		{
-			AIStateMachine::StateTimer timer("WriteData");
-			file.seek(offset);
-			file.write(data, size);
-			LLMeshRepository::sCacheBytesWritten += size;
-		}
+	if (data_size > 0)
+	{ //decoded and written to the VFS (if good) by the decode pool
+		gMeshRepo.mThread->queueLODDecode(mMeshParams, mLOD, data, llmin(data_size, (S32)mRequestedBytes), mOffset);
 	}
 
 	delete [] data;
@@ -2155,6 +2277,7 @@ void LLMeshRepository::init()
 	
 	
 	mThread = new LLMeshRepoThread();
+	mThread->mHeaderIndex.load(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "mesh_header_index.bin"));
 	mThread->start();
 }
 
@@ -2168,6 +2291,7 @@ void LLMeshRepository::shutdown()
 	{
 		apr_sleep(10);
 	}
+	mThread->mHeaderIndex.save();	//final flush
 	delete mThread;
 	mThread = NULL;
 
@@ -2549,6 +2673,13 @@ void LLMeshRepository::notifyMeshUnavailable(const LLVolumeParams& mesh_params,
 	}
 }
 
+//static
+S32 LLMeshRepository::getDecodeQueueDepth()
+{
+	LLMeshRepoThread* thread = gMeshRepo.mThread;
+	return thread ? thread->mDecodePool->getQueueDepth() + thread->mDecodePool->getActiveCount() : 0;
+}
+
 S32 LLMeshRepository::getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
 {
 	return mThread->getActualMeshLOD(mesh_params, lod);
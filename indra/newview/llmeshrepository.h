@@ -28,6 +28,7 @@
 #define LL_MESH_REPOSITORY_H
 
 #include "llassettype.h"
+#include "llatomic.h"
 #include "llmodel.h"
 #include "lluuid.h"
 #include "llviewertexture.h"
@@ -36,6 +37,7 @@
 #define LLCONVEXDECOMPINTER_STATIC 1
 
 #include "llconvexdecomposition.h"
+#include "llmeshheaderindex.h"
 #include "lluploadfloaterobservers.h"
 #include "aistatemachinethread.h"
 
@@ -45,6 +47,7 @@ class LLVOVolume;
 class LLMeshResponder;
 class LLMutex;
 class LLCondition;
+class LLThreadPool;
 class LLVFS;
 class LLMeshRepository;
 class AIMeshUpload;
@@ -232,6 +235,10 @@ public:
 	
 	std::map<LLUUID, U32> mMeshHeaderSize;
 
+	//block locations of every mesh header seen in this or previous sessions
+	LLMeshHeaderIndex mHeaderIndex;
+	LLTimer mHeaderIndexSaveTimer;
+
 	class HeaderRequest
 	{ 
 	public:
@@ -321,6 +328,12 @@ public:
 	//queue of successfully loaded meshes
 	std::queue<LoadedMesh> mLoadedQ;
 
+	//queue of LODs that were read from the VFS but failed to decode, and need to be fetched from the sim
+	std::queue<LODRequest> mRefetchQ;
+
+	//pool of threads that inflate and unpack received LODs, so that fetching never waits for decoding
+	LLThreadPool* mDecodePool;
+
 	//map of pending header requests and currently desired LODs
 	typedef std::map<LLVolumeParams, std::vector<S32> > pending_lod_map;
 	pending_lod_map mPendingLOD;
@@ -335,9 +348,18 @@ public:
 	void lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 	bool fetchMeshHeader(const LLVolumeParams& mesh_params, U32& count);
-	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, U32& count);
+	bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, U32& count, bool skip_cache = false);
 	bool headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
+	//fills mMeshHeader from mHeaderIndex if the mesh asset is in the VFS, returns true on success
+	bool loadHeaderFromIndex(const LLUUID& mesh_id);
+	//decodes LOD data in the calling thread, pushes the result onto mLoadedQ
 	bool lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	//copies LOD data and queues it for lodReceived on mDecodePool;
+	//cache_offset >= 0 means the data came from the sim and is written to the VFS at that offset once it decodes
+	void queueLODDecode(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 cache_offset);
+	bool cachedLODReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
+	//called from a decode thread when a queued LOD finished decoding
+	void lodDecoded(const LLVolumeParams& mesh_params, S32 lod, bool success, bool from_cache, F32 latency);
 	bool skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
 	bool physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
@@ -484,8 +506,11 @@ public:
 	static U32 sLODPending;
 	static U32 sLODProcessing;
 	static U32 sCacheBytesRead;
-	static U32 sCacheBytesWritten;
+	static LLAtomicU32 sCacheBytesWritten;	// also added to by the decode pool threads
 	static U32 sPeakKbps;
+	static F32 sDecodeLatency;		// moving average of queue-to-decoded time of LODs, in ms
+
+	static S32 getDecodeQueueDepth();
 	
 	static F32 getStreamingCost(LLSD& header, F32 radius, S32* bytes = NULL, S32* visible_bytes = NULL, S32 detail = -1, F32 *unscaled_value = NULL);
 
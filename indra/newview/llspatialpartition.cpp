@@ -1782,8 +1782,9 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 class LLOctreeCull : public LLSpatialGroup::OctreeTraveler
 {
 public:
-	LLOctreeCull(LLCamera* camera)
-		: mCamera(camera), mRes(0) { }
+	// far_clip: test the group bounds against the far clip plane too.
+	LLOctreeCull(LLCamera* camera, bool far_clip = false)
+		: mCamera(camera), mRes(0), mFarClip(far_clip), mPlanesRes(-1), mPlanesResGroup(NULL) { }
 
 	virtual bool earlyFail(LLSpatialGroup* group)
 	{
@@ -1803,6 +1804,7 @@ public:
 	virtual void traverse(const LLSpatialGroup::OctreeNode* n)
 	{
 		LLSpatialGroup* group = (LLSpatialGroup*) n->getListener(0);
+		S32 planes_res = takePlanesRes(group);
 
 		if (earlyFail(group))
 		{
@@ -1812,24 +1814,81 @@ public:
 		if (mRes == 2 || 
 			(mRes && group->isState(LLSpatialGroup::SKIP_FRUSTUM_CHECK)))
 		{	//fully in, just add everything
-			LLSpatialGroup::OctreeTraveler::traverse(n);
+			traverseNode(n);
 		}
 		else
 		{
-			mRes = frustumCheck(group);
+			mRes = frustumCheck(group, planes_res);
 				
 			if (mRes)
 			{ //at least partially in, run on down
-				LLSpatialGroup::OctreeTraveler::traverse(n);
+				traverseNode(n);
 			}
 
 			mRes = 0;
 		}
 	}
-	
-	virtual S32 frustumCheck(const LLSpatialGroup* group)
+
+	// Visit n and traverse its children. When the children will be tested against the frustum,
+	// their bounds are tested against the planes first, all at once.
+	void traverseNode(const LLSpatialGroup::OctreeNode* n)
+	{
+		if (mRes == 2)
+		{
+			LLSpatialGroup::OctreeTraveler::traverse(n);
+			return;
+		}
+
+		n->accept(this);
+
+		U32 const count = n->getChildCount();
+		for (U32 first = 0; first < count; first += LLCameraAABBBatch::MAX_BOXES)
+		{
+			U32 const batch_count = llmin(count - first, (U32)LLCameraAABBBatch::MAX_BOXES);
+			LLCameraAABBBatch batch;
+			S32 planes_res[LLCameraAABBBatch::MAX_BOXES];
+			for (U32 i = 0; i < batch_count; i++)
+			{
+				const LLSpatialGroup* child = (const LLSpatialGroup*) n->getChild(first + i)->getListener(0);
+				batch.add(child->mBounds[0], child->mBounds[1]);
+			}
+			mCamera->AABBsInFrustum(batch, planes_res, mFarClip);
+
+			for (U32 i = 0; i < batch_count; i++)
+			{
+				const LLSpatialGroup::OctreeNode* child = n->getChild(first + i);
+				mPlanesRes = planes_res[i];
+				mPlanesResGroup = (const LLSpatialGroup*) child->getListener(0);
+				traverse(child);
+			}
+		}
+	}
+
+	// Returns the result of the planes test of the bounds of group that traverseNode() did, or -1.
+	S32 takePlanesRes(const LLSpatialGroup* group)
+	{
+		S32 res = mPlanesResGroup == group ? mPlanesRes : -1;
+		mPlanesRes = -1;
+		mPlanesResGroup = NULL;
+		return res;
+	}
+
+	// Tests the bounds of group against the planes of the frustum.
+	S32 planesCheck(const LLSpatialGroup* group)
+	{
+		return mFarClip ? mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]) :
+						  mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+	}
+
+	// planes_res is the result of planesCheck(group) when it was already done, or -1.
+	S32 frustumCheck(const LLSpatialGroup* group, S32 planes_res = -1)
+	{
+		return refineFrustumCheck(group, planes_res < 0 ? planesCheck(group) : planes_res);
+	}
+
+	// Returns the result of the frustum check of group, given the result res of the planes test of its bounds.
+	virtual S32 refineFrustumCheck(const LLSpatialGroup* group, S32 res)
 	{
-		S32 res = mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
 		if (res != 0)
 		{
 			res = llmin(res, AABBSphereIntersect(group->mExtents[0], group->mExtents[1], mCamera->getOrigin(), mCamera->mFrustumCornerDist));
@@ -1894,6 +1953,9 @@ public:
 
 	LLCamera *mCamera;
 	S32 mRes;
+	bool mFarClip;
+	S32 mPlanesRes;
+	const LLSpatialGroup* mPlanesResGroup;
 };
 
 class LLOctreeCullNoFarClip : public LLOctreeCull
@@ -1902,9 +1964,9 @@ public:
 	LLOctreeCullNoFarClip(LLCamera* camera) 
 		: LLOctreeCull(camera) { }
 
-	virtual S32 frustumCheck(const LLSpatialGroup* group)
+	virtual S32 refineFrustumCheck(const LLSpatialGroup* group, S32 res)
 	{
-		return mCamera->AABBInFrustumNoFarClip(group->mBounds[0], group->mBounds[1]);
+		return res;
 	}
 
 	virtual S32 frustumCheckObjects(const LLSpatialGroup* group)
@@ -1918,11 +1980,11 @@ class LLOctreeCullShadow : public LLOctreeCull
 {
 public:
 	LLOctreeCullShadow(LLCamera* camera)
-		: LLOctreeCull(camera) { }
+		: LLOctreeCull(camera, true) { }
 
-	virtual S32 frustumCheck(const LLSpatialGroup* group)
+	virtual S32 refineFrustumCheck(const LLSpatialGroup* group, S32 res)
 	{
-		return mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]);
+		return res;
 	}
 
 	virtual S32 frustumCheckObjects(const LLSpatialGroup* group)
@@ -1952,6 +2014,7 @@ public:
 	virtual void traverse(const LLSpatialGroup::OctreeNode* n)
 	{
 		LLSpatialGroup* group = (LLSpatialGroup*) n->getListener(0);
+		S32 planes_res = takePlanesRes(group);
 
 		if (earlyFail(group))
 		{
@@ -1961,15 +2024,15 @@ public:
 		if ((mRes && group->isState(LLSpatialGroup::SKIP_FRUSTUM_CHECK)) ||
 			mRes == 2)
 		{	//don't need to do frustum check
-			LLSpatialGroup::OctreeTraveler::traverse(n);
+			traverseNode(n);
 		}
 		else
 		{  
-			mRes = frustumCheck(group);
+			mRes = frustumCheck(group, planes_res);
 				
 			if (mRes)
 			{ //at least partially in, run on down
-				LLSpatialGroup::OctreeTraveler::traverse(n);
+				traverseNode(n);
 			}
 
 			mRes = 0;
@@ -48,6 +48,7 @@
 
 #include "llagent.h"
 #include "lltexturecache.h"
+#include "lltexturefetchrange.h"
 #include "llviewercontrol.h"
 #include "llviewertexturelist.h"
 #include "llviewertexture.h"
@@ -207,6 +208,7 @@ private:
 	U32 calcWorkPriority();
 	void removeFromCache();
 	bool processSimulatorPackets();
+	void startCacheWrite();
 	bool writeToCacheComplete();
 	
 	// Threads:  Ttf
@@ -997,9 +999,12 @@ void LLTextureFetchWorker::startWork(S32 param)
 
 #include "llviewertexturelist.h" // debug
 
+static LLFastTimer::DeclareTimer FTM_TEXTURE_FETCH_WORK("Texture Fetch Worker");
+
 // Called from LLWorkerThread::processRequest()
 bool LLTextureFetchWorker::doWork(S32 param)
 {
+	LLFastTimer t(FTM_TEXTURE_FETCH_WORK);
 	LLMutexLock lock(&mWorkMutex);
 
 	if ((mFetcher->isQuitting() || getFlags(LLWorkerClass::WCF_DELETE_REQUESTED)))
@@ -1763,6 +1768,12 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		setState(DECODE_IMAGE_UPDATE);
 		LL_DEBUGS("Texture") << mID << ": Decoding. Bytes: " << mFormattedImage->getDataSize() << " Discard: " << discard
 				<< " All Data: " << mHaveAllData << LL_ENDL;
+		if (mWriteToCacheState == SHOULD_WRITE)
+		{
+			// Write the new data to the cache while it is being decoded, instead of after.
+			// Both only read mFormattedImage, which isn't touched again until the write completed.
+			startCacheWrite();
+		}
 		mDecodeHandle = mFetcher->mImageDecodeThread->decodeImage(mFormattedImage, image_priority, discard, mNeedsAux,
 																  new DecodeResponder(mFetcher, mID, this));
 		// fall though
@@ -1774,6 +1785,15 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		{
 			if (mDecodedDiscard < 0)
 			{
+				if (mCacheWriteHandle != LLTextureCache::nullHandle())
+				{
+					// The data that failed to decode is still being written to the cache; remove it once it's written.
+					if (!writeToCacheComplete())
+					{
+						return false;
+					}
+					removeFromCache();
+				}
 				LL_WARNS("Texture") << mID << ": Failed to Decode." << LL_ENDL;
 				if (mCachedSize > 0 && !mInLocalCache && mRetryAttempt == 0)
 				{
@@ -1810,35 +1830,19 @@ bool LLTextureFetchWorker::doWork(S32 param)
 
 	if (mState == WRITE_TO_CACHE)
 	{
-		if (mWriteToCacheState != SHOULD_WRITE || mFormattedImage.isNull())
-		{
-			// If we're in a local cache or we didn't actually receive any new data,
-			// or we failed to load anything, skip
-			setState(DONE);
-			return false;
-		}
-		S32 datasize = mFormattedImage->getDataSize();
-		if (mFileSize < datasize)	// This could happen when http fetching and sim fetching mixed.
+		if (mCacheWriteHandle == LLTextureCache::nullHandle())
 		{
-			if (mHaveAllData)
-			{
-				mFileSize = datasize;
-			}
-			else
+			if (mWriteToCacheState != SHOULD_WRITE || mFormattedImage.isNull())
 			{
-				mFileSize = datasize + 1; // flag not fully loaded.
+				// If we're in a local cache or we didn't actually receive any new data,
+				// or we failed to load anything, or the write was already started and finished
+				// while decoding, skip
+				setState(DONE);
+				return false;
 			}
+			startCacheWrite();
 		}
-		llassert_always(datasize);
-		setPriority(LLWorkerThread::PRIORITY_LOW | mWorkPriority); // Set priority first since Responder may change it
-		U32 cache_priority = mWorkPriority;
-		mWritten = FALSE;
 		setState(WAIT_ON_WRITE);
-		++mCacheWriteCount;
-		CacheWriteResponder* responder = new CacheWriteResponder(mFetcher, mID);
-		mCacheWriteHandle = mFetcher->mTextureCache->writeToCache(mID, cache_priority,
-																  mFormattedImage->getData(), datasize,
-																  mFileSize, responder);
 		// fall through
 	}
 	
@@ -2152,7 +2156,7 @@ void LLTextureFetchWorker::callbackCacheRead(bool success, LLImageFormatted* ima
 void LLTextureFetchWorker::callbackCacheWrite(bool success)
 {
 	LLMutexLock lock(&mWorkMutex);
-	if (mState != WAIT_ON_WRITE)
+	if (mCacheWriteHandle == LLTextureCache::nullHandle())
 	{
 // 		llwarns << "Write callback for " << mID << " with state = " << mState << llendl;
 		return;
@@ -2198,7 +2202,11 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 		{
 			LL_WARNS("Texture") << "DECODE FAILED: id = " << mID << ", mFormattedImage is Null!" << LL_ENDL;
 		}
-		removeFromCache();
+		if (mCacheWriteHandle == LLTextureCache::nullHandle())
+		{
+			removeFromCache();
+		}
+		// Else DECODE_IMAGE_UPDATE removes it after the write that was started with the decode completed.
 		mDecodedDiscard = -1; // Redundant, here for clarity and paranoia
 	}
 	mDecoded = TRUE;
@@ -2209,6 +2217,32 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 
 //////////////////////////////////////////////////////////////////////////////
 
+void LLTextureFetchWorker::startCacheWrite()
+{
+	S32 datasize = mFormattedImage->getDataSize();
+	if (mFileSize < datasize)	// This could happen when http fetching and sim fetching mixed.
+	{
+		if (mHaveAllData)
+		{
+			mFileSize = datasize;
+		}
+		else
+		{
+			mFileSize = datasize + 1; // flag not fully loaded.
+		}
+	}
+	llassert_always(datasize);
+	setPriority(LLWorkerThread::PRIORITY_LOW | mWorkPriority); // Set priority first since Responder may change it
+	U32 cache_priority = mWorkPriority;
+	mWritten = FALSE;
+	mWriteToCacheState = CAN_WRITE;		// Written (once mWritten is set); more data makes it SHOULD_WRITE again.
+	++mCacheWriteCount;
+	CacheWriteResponder* responder = new CacheWriteResponder(mFetcher, mID);
+	mCacheWriteHandle = mFetcher->mTextureCache->writeToCache(mID, cache_priority,
+															  mFormattedImage->getData(), datasize,
+															  mFileSize, responder);
+}
+
 bool LLTextureFetchWorker::writeToCacheComplete()
 {
 	// Complete write to cache
@@ -2295,7 +2329,7 @@ LLTextureFetch::~LLTextureFetch()
 }
 
 bool LLTextureFetch::createRequest(const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
-								   S32 w, S32 h, S32 c, S32 desired_discard, bool needs_aux, bool can_use_http)
+								   S32 w, S32 h, S32 c, S32 desired_discard, S32 final_discard, bool needs_aux, bool can_use_http)
 {
 	if (mDebugPause)
 	{
@@ -2336,9 +2370,11 @@ bool LLTextureFetch::createRequest(const std::string& url, const LLUUID& id, con
 	else if (w*h*c > 0)
 	{
 		// If the requester knows the dimensions of the image,
-		// this will calculate how much data we need without having to parse the header
-
-		desired_size = LLImageJ2C::calcDataSizeJ2C(w, h, c, desired_discard);
+		// this will calculate how much data we need without having to parse the header.
+		// Fetch the data of the levels up to final_discard in the same request when that costs little extra.
+		static LLCachedControl<U32> coalesce_bytes(gSavedSettings, "TextureFetchCoalesceBytes");
+		desired_discard = LLTextureFetchRange::calcCoalescedDiscard(w, h, c, desired_discard, final_discard, (S32)llmin((U32)coalesce_bytes, (U32)MAX_IMAGE_DATA_SIZE));
+		desired_size = desired_discard == 0 ? MAX_IMAGE_DATA_SIZE : LLImageJ2C::calcDataSizeJ2C(w, h, c, desired_discard);
 	}
 	else
 	{
@@ -3197,7 +3233,7 @@ S32 LLTextureFetch::getFetchState(const LLUUID& id, F32& data_progress_p, F32& r
 void LLTextureFetch::dump()
 {
 	llinfos << "LLTextureFetch REQUESTS:" << llendl;
-	for (request_queue_t::iterator iter = mRequestQueue.begin();
+	for (request_queue_t::const_iterator iter = mRequestQueue.begin();
 		 iter != mRequestQueue.end(); ++iter)
 	{
 		LLQueuedThread::QueuedRequest* qreq = *iter;
@@ -69,7 +69,7 @@ public:
 	void shutDownImageDecodeThread() ;  //called in the main thread after the ImageDecodeThread shuts down.
 
 	bool createRequest(const std::string& url, const LLUUID& id, const LLHost& host, F32 priority,
-					   S32 w, S32 h, S32 c, S32 discard, bool needs_aux, bool can_use_http);
+					   S32 w, S32 h, S32 c, S32 discard, S32 final_discard, bool needs_aux, bool can_use_http);
 	void deleteRequest(const LLUUID& id, bool cancel);
 	void deleteAllRequests();
 	bool getRequestFinished(const LLUUID& id, S32& discard_level,
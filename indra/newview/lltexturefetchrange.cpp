@@ -0,0 +1,46 @@
+/**
+ * @file lltexturefetchrange.cpp
+ * @brief Implementation of LLTextureFetchRange.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexturefetchrange.h"
+#include "llimagej2c.h"
+
+//static
+S32 LLTextureFetchRange::calcCoalescedDiscard(S32 w, S32 h, S32 c, S32 desired_discard, S32 final_discard, S32 max_extra_bytes)
+{
+	if (w * h * c <= 0 || max_extra_bytes <= 0 || final_discard < 0 || final_discard >= desired_discard)
+	{
+		return desired_discard;
+	}
+	S32 desired_size = LLImageJ2C::calcDataSizeJ2C(w, h, c, desired_discard);
+	S32 discard = desired_discard;
+	while (discard > final_discard && LLImageJ2C::calcDataSizeJ2C(w, h, c, discard - 1) - desired_size <= max_extra_bytes)
+	{
+		--discard;
+	}
+	return discard;
+}
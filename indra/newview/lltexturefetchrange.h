@@ -0,0 +1,51 @@
+/**
+ * @file lltexturefetchrange.h
+ * @brief Decides how much of a texture one fetch request asks for.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLTEXTUREFETCHRANGE_H
+#define LL_LLTEXTUREFETCHRANGE_H
+
+#include "stdtypes.h"
+
+//============================================================================
+// LLViewerFetchedTexture loads a texture progressively: every time a discard
+// level is decoded it asks LLTextureFetch for the next one or two levels, and
+// each of those steps costs a request (a round trip, plus waiting for the decode
+// and the cache write of the previous step). When it is already known that the
+// texture will need a lower discard level than the one asked for (the level its
+// decode priority is calculated from), LLTextureFetchRange lets the request for
+// the current step fetch the data of the levels in between too, as long as that
+// doesn't add too much to it.
+
+class LLTextureFetchRange
+{
+public:
+	// Returns the discard level, between final_discard and desired_discard, whose data a fetch of desired_discard
+	// of a w x h texture with c components should ask for: the lowest one that asks for at most max_extra_bytes
+	// bytes more than desired_discard needs. Returns desired_discard when the size of the texture isn't known.
+	static S32 calcCoalescedDiscard(S32 w, S32 h, S32 c, S32 desired_discard, S32 final_discard, S32 max_extra_bytes);
+};
+
+#endif // LL_LLTEXTUREFETCHRANGE_H
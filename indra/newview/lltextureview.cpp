@@ -677,6 +677,12 @@ void LLGLTexMemBar::draw()
 					AICurlInterface::getNumHTTPRunning(),
 					LLAppViewer::getImageDecodeThread()->getPending(), 
 					gTextureList.mCreateTextureList.size());
+	// Decode priority updates: dirty queue length, updated from it, their average/max wait and the age
+	// of the priorities the round robin update recalculates.
+	text += llformat("PRI:%d/%d %.0f/%.0fms %.1fs ",
+					 gTextureList.getNumDirtyPriorities(), LLViewerTextureList::sDirtyPriorityUpdates,
+					 LLViewerTextureList::sDirtyPriorityStalenessAvg * 1000.f, LLViewerTextureList::sDirtyPriorityStalenessMax * 1000.f,
+					 LLViewerTextureList::sPriorityUpdateAgeAvg);
 
 	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*2,
 									 text_color, LLFontGL::LEFT, LLFontGL::TOP);
@@ -618,6 +618,32 @@ static bool handlePhoenixNameSystemChanged(const LLSD& newvalue)
 
 bool handleUpdateFriends() { LLAvatarTracker::instance().updateFriends(); return true; }
 
+static bool handleFastTimerTraceChanged(const LLSD& newvalue)
+{
+	if (newvalue.asBoolean())
+	{
+		LLFastTimer::startTrace();
+		llinfos << "Started fast timer trace." << llendl;
+	}
+	else if (LLFastTimer::sTrace)
+	{
+		LLFastTimer::stopTrace();
+		// Load this file in chrome://tracing to see what all threads were doing.
+		std::string filename = gDirUtilp->getExpandedFilename(LL_PATH_LOGS, "fasttimer_trace.json");
+		llofstream os(filename);
+		if (os.is_open())
+		{
+			LLFastTimer::writeChromeTrace(os);
+			llinfos << "Wrote fast timer trace to " << filename << llendl;
+		}
+		else
+		{
+			llwarns << "Could not open " << filename << " for writing." << llendl;
+		}
+	}
+	return true;
+}
+
 static bool handleAllowLargeSounds(const LLSD& newvalue)
 {
 	if(gAudiop)
@@ -828,6 +854,7 @@ void settings_setup_listeners()
 	gSavedSettings.getControl("FriendNameSystem")->getSignal()->connect(boost::bind(handleUpdateFriends));
 
 	gSavedSettings.getControl("AllowLargeSounds")->getSignal()->connect(boost::bind(&handleAllowLargeSounds, _2));
+	gSavedSettings.getControl("FastTimerTrace")->getSignal()->connect(boost::bind(&handleFastTimerTraceChanged, _2));
 	gSavedSettings.getControl("LiruUseZQSDKeys")->getSignal()->connect(boost::bind(load_default_bindings, _2));
 	gSavedSettings.getControl("HighResSnapshot")->getSignal()->connect(boost::bind(&handleHighResChanged, _2));
 }
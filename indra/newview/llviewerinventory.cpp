@@ -28,6 +28,7 @@
 #include "llviewerinventory.h"
 
 #include "llnotificationsutil.h"
+#include "lldatapacker.h"
 #include "llsdserialize.h"
 #include "message.h"
 
@@ -473,6 +474,14 @@ bool LLViewerInventoryItem::importFileLocal(LLFILE* fp)
 	return rv;
 }
 
+// virtual
+BOOL LLViewerInventoryItem::unpackBinary(LLDataPacker& dp)
+{
+	BOOL rv = LLInventoryItem::unpackBinary(dp);
+	mIsComplete = FALSE;
+	return rv;
+}
+
 bool LLViewerInventoryItem::exportFileLocal(LLFILE* fp) const
 {
 	std::string uuid_str;
@@ -772,6 +781,23 @@ bool LLViewerInventoryCategory::exportFileLocal(LLFILE* fp) const
 	return true;
 }
 
+// virtual
+void LLViewerInventoryCategory::packBinary(LLDataPacker& dp) const
+{
+	LLInventoryCategory::packBinary(dp);
+	dp.packUUID(mOwnerID, "owner_id");
+	dp.packS32(mVersion, "version");
+}
+
+// virtual
+BOOL LLViewerInventoryCategory::unpackBinary(LLDataPacker& dp)
+{
+	BOOL success = LLInventoryCategory::unpackBinary(dp);
+	success &= dp.unpackUUID(mOwnerID, "owner_id");
+	success &= dp.unpackS32(mVersion, "version");
+	return success;
+}
+
 void LLViewerInventoryCategory::determineFolderType()
 {
 	/* Do NOT uncomment this code.  This is for future 2.1 support of ensembles.
@@ -130,6 +130,7 @@ public:
 	// other than cacheing.
 	bool exportFileLocal(LLFILE* fp) const;
 	bool importFileLocal(LLFILE* fp);
+	/*virtual*/ BOOL unpackBinary(LLDataPacker& dp);
 
 	// new methods
 	BOOL isComplete() const { return mIsComplete; }
@@ -226,6 +227,8 @@ public:
 	// other than caching.
 	bool exportFileLocal(LLFILE* fp) const;
 	bool importFileLocal(LLFILE* fp);
+	/*virtual*/ void packBinary(LLDataPacker& dp) const;
+	/*virtual*/ BOOL unpackBinary(LLDataPacker& dp);
 	void determineFolderType();
 	void changeType(LLFolderType::EType new_folder_type);
 
@@ -1011,6 +1011,9 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 	}
 	else
 	{
+		// Do the parallelizable part of the avatar animation updates up front.
+		LLVOAvatar::prepareMotions();
+
 		for (std::vector<LLViewerObject*>::iterator idle_iter = idle_list.begin();
 			idle_iter != idle_end; idle_iter++)
 		{
@@ -747,6 +747,7 @@ void LLViewerTexture::addFace(U32 ch, LLFace* facep)
 	facep->setIndexInTex(ch, mNumFaces[ch]) ;
 	mNumFaces[ch]++ ;
 	mLastFaceListUpdateTimer.reset() ;
+	dirtyDecodePriority(facep->getVirtualSize()) ;
 }
 
 //virtual
@@ -768,6 +769,7 @@ void LLViewerTexture::removeFace(U32 ch, LLFace* facep)
 		mNumFaces[ch] = 0 ;
 	}
 	mLastFaceListUpdateTimer.reset() ;
+	dirtyDecodePriority(facep->getVirtualSize()) ;
 }
 
 S32 LLViewerTexture::getTotalNumFaces() const
@@ -954,6 +956,10 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	{
 		mDecodePriority = 0.f;
 		mInImageList = 0;
+		mDirtyPriorityIndex = -1;
+		mDirtyVirtualSize = 0.f;
+		mDirtyPriorityTime = 0.0;
+		mPriorityUpdateTime = LLFrameTimer::getElapsedSeconds();
 	}
 
 	// Only set mIsMissingAsset true when we know for certain that the database
@@ -1615,6 +1621,15 @@ void LLViewerFetchedTexture::setDecodePriority(F32 priority)
 	}
 }
 
+//virtual
+void LLViewerFetchedTexture::dirtyDecodePriority(F32 virtual_size)
+{
+	if (mInImageList)
+	{
+		gTextureList.dirtyImagePriority(this, virtual_size);
+	}
+}
+
 void LLViewerFetchedTexture::setAdditionalDecodePriority(F32 priority)
 {
 	priority = llclamp(priority, 0.f, 1.f);
@@ -1781,6 +1796,8 @@ bool LLViewerFetchedTexture::updateFetch()
 				{
 					mIsRawImageValid = TRUE;			
 					addToCreateTexture() ;
+					// The discard level that the decode priority depends on changed.
+					dirtyDecodePriority(mMaxVirtualSize) ;
 				}
 
 				return TRUE ;
@@ -1840,6 +1857,7 @@ bool LLViewerFetchedTexture::updateFetch()
 		}
 	}
 
+	S32 final_discard = desired_discard;		// The level that the decode priority was calculated for.
 	bool make_request = true;	
 	if (decode_priority <= 0)
 	{
@@ -1913,13 +1931,13 @@ bool LLViewerFetchedTexture::updateFetch()
 		static const LLCachedControl<U32> override_tex_discard_level("TextureDiscardLevel");
 		if (override_tex_discard_level != 0)
 		{
-			desired_discard = override_tex_discard_level;
+			desired_discard = final_discard = override_tex_discard_level;
 		}
 		
 		// bypass texturefetch directly by pulling from LLTextureCache
 		bool fetch_request_created = false;
 		fetch_request_created = LLAppViewer::getTextureFetch()->createRequest(mUrl, getID(),getTargetHost(), decode_priority,
-																			  w, h, c, desired_discard, needsAux(), mCanUseHTTP);
+																			  w, h, c, desired_discard, final_discard, needsAux(), mCanUseHTTP);
 		
 		if (fetch_request_created)
 		{
@@ -150,6 +150,8 @@ public:
 
 	virtual void addFace(U32 channel, LLFace* facep) ;
 	virtual void removeFace(U32 channel, LLFace* facep) ; 
+	// Called when a face that uses this texture was added or removed, or its virtual size changed.
+	virtual void dirtyDecodePriority(F32 virtual_size) {}
 	S32 getTotalNumFaces() const;
 	S32 getNumFaces(U32 ch) const;
 	const ll_face_list_t* getFaceList(U32 channel) const {llassert(channel < LLRender::NUM_TEXTURE_CHANNELS); return &mFaceList[channel];}
@@ -248,6 +250,7 @@ class LLViewerFetchedTexture : public LLViewerTexture
 {
 	friend class LLTextureBar; // debug info only
 	friend class LLTextureView; // debug info only
+	friend class LLViewerTextureList;
 
 protected:
 	/*virtual*/ ~LLViewerFetchedTexture();
@@ -341,6 +344,8 @@ public:
 	BOOL isInImageList() const {return mInImageList ;}
 	void setInImageList(BOOL flag) {mInImageList = flag ;}
 
+	/*virtual*/ void dirtyDecodePriority(F32 virtual_size);
+
 	LLFrameTimer* getLastPacketTimer() {return &mLastPacketTimer;}
 
 	U32 getFetchPriority() const { return mFetchPriority ;}
@@ -475,6 +480,10 @@ protected:
 	LLFrameTimer mStopFetchingTimer;	// Time since mDecodePriority == 0.f.
 
 	BOOL  mInImageList;				// TRUE if image is in list (in which case don't reset priority!)
+	S32   mDirtyPriorityIndex;		// Index in LLViewerTextureList::mDirtyPriorityHeap, or -1 when the decode priority isn't dirty.
+	F32   mDirtyVirtualSize;		// The largest virtual size of a face reported since the decode priority became dirty.
+	F64   mDirtyPriorityTime;		// When the decode priority became dirty.
+	F64   mPriorityUpdateTime;		// When the decode priority was last calculated, or the texture was created.
 	BOOL  mNeedsCreateTexture;	
 
 	BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
@@ -74,6 +74,10 @@ void (*LLViewerTextureList::sUUIDCallback)(void **, const LLUUID&) = NULL;
 
 U32 LLViewerTextureList::sTextureBits = 0;
 U32 LLViewerTextureList::sTexturePackets = 0;
+S32 LLViewerTextureList::sDirtyPriorityUpdates = 0;
+F32 LLViewerTextureList::sDirtyPriorityStalenessAvg = 0.f;
+F32 LLViewerTextureList::sDirtyPriorityStalenessMax = 0.f;
+F32 LLViewerTextureList::sPriorityUpdateAgeAvg = 0.f;
 S32 LLViewerTextureList::sNumImages = 0;
 
 LLViewerTextureList gTextureList;
@@ -299,6 +303,7 @@ void LLViewerTextureList::shutdown()
 	
 	mUUIDMap.clear();
 	
+	mDirtyPriorityHeap.clear();
 	mImageList.clear();
 
 	mInitialized = FALSE ; //prevent loading textures again.
@@ -594,6 +599,11 @@ void LLViewerTextureList::removeImageFromList(LLViewerFetchedTexture *image)
 		llerrs << "LLViewerTextureList::removeImageFromList - Image not in list" << llendl;
 	}
 
+	if (dirty_priority_heap_t::contains(image))
+	{
+		mDirtyPriorityHeap.erase(image);
+	}
+
 	S32 count = mImageList.erase(image) ;
 	if(count != 1) 
 	{
@@ -604,6 +614,24 @@ void LLViewerTextureList::removeImageFromList(LLViewerFetchedTexture *image)
 	image->setInImageList(FALSE) ;
 }
 
+void LLViewerTextureList::dirtyImagePriority(LLViewerFetchedTexture *image, F32 virtual_size)
+{
+	if (dirty_priority_heap_t::contains(image))
+	{
+		if (virtual_size > image->mDirtyVirtualSize)
+		{
+			image->mDirtyVirtualSize = virtual_size;
+			mDirtyPriorityHeap.update(image);
+		}
+	}
+	else
+	{
+		image->mDirtyVirtualSize = virtual_size;
+		image->mDirtyPriorityTime = LLFrameTimer::getElapsedSeconds();
+		mDirtyPriorityHeap.push(image);
+	}
+}
+
 void LLViewerTextureList::addImage(LLViewerFetchedTexture *new_image)
 {
 	if (!new_image)
@@ -769,8 +797,32 @@ void LLViewerTextureList::clearFetchingRequests()
 
 void LLViewerTextureList::updateImagesDecodePriorities()
 {
-	// Update the decode priority for N images each frame
+	F64 const now = LLFrameTimer::getElapsedSeconds();
+
+	// Update the decode priority of the images that a changed face uses, those with the largest faces first
+	{
+		static LLCachedControl<S32> max_dirty_updates(gSavedSettings, "TextureUpdateDirtyPriorities");
+		S32 update_counter = llmin((S32)max_dirty_updates, (S32)mDirtyPriorityHeap.size());
+		sDirtyPriorityUpdates = llmax(update_counter, 0);
+		F32 staleness_sum = 0.f;
+		F32 staleness_max = 0.f;
+		while (update_counter-- > 0)
+		{
+			LLPointer<LLViewerFetchedTexture> imagep = mDirtyPriorityHeap.pop();
+			F32 staleness = (F32)(now - imagep->mDirtyPriorityTime);
+			staleness_sum += staleness;
+			staleness_max = llmax(staleness_max, staleness);
+			updateImageDecodePriority(imagep);
+		}
+		sDirtyPriorityStalenessAvg = sDirtyPriorityUpdates ? staleness_sum / sDirtyPriorityUpdates : 0.f;
+		sDirtyPriorityStalenessMax = staleness_max;
+	}
+
+	// Update the decode priority for N images each frame, for the changes that aren't reported
+	// (recently visible faces becoming invisible after a while) and to flush unused images
 	{
+		S32 age_count = 0;
+		F32 age_sum = 0.f;
         static const S32 MAX_PRIO_UPDATES = gSavedSettings.getS32("TextureFetchUpdatePriorities");         // default: 32
 		const size_t max_update_count = llmin((S32) (MAX_PRIO_UPDATES*MAX_PRIO_UPDATES*gFrameIntervalSeconds) + 1, MAX_PRIO_UPDATES);
 		S32 update_counter = llmin(max_update_count, mUUIDMap.size());
@@ -843,20 +895,33 @@ void LLViewerTextureList::updateImagesDecodePriorities()
 			{
 				continue;
 			}
-			imagep->processTextureStats();
-			F32 old_priority = imagep->getDecodePriority();
-			F32 old_priority_test = llmax(old_priority, 0.0f);
-			F32 decode_priority = imagep->calcDecodePriority();
-			F32 decode_priority_test = llmax(decode_priority, 0.0f);
-			// Ignore < 20% difference
-			if ((decode_priority_test < old_priority_test * .8f) ||
-				(decode_priority_test > old_priority_test * 1.25f))
-			{
-				removeImageFromList(imagep);
-				imagep->setDecodePriority(decode_priority);
-				addImageToList(imagep);
-			}
+			age_sum += (F32)(now - imagep->mPriorityUpdateTime);
+			++age_count;
+			updateImageDecodePriority(imagep);
 		}
+		sPriorityUpdateAgeAvg = age_count ? age_sum / age_count : 0.f;
+	}
+}
+
+void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imagep)
+{
+	if (dirty_priority_heap_t::contains(imagep))
+	{
+		mDirtyPriorityHeap.erase(imagep);
+	}
+	imagep->mPriorityUpdateTime = LLFrameTimer::getElapsedSeconds();
+	imagep->processTextureStats();
+	F32 old_priority = imagep->getDecodePriority();
+	F32 old_priority_test = llmax(old_priority, 0.0f);
+	F32 decode_priority = imagep->calcDecodePriority();
+	F32 decode_priority_test = llmax(decode_priority, 0.0f);
+	// Ignore < 20% difference
+	if ((decode_priority_test < old_priority_test * .8f) ||
+		(decode_priority_test > old_priority_test * 1.25f))
+	{
+		removeImageFromList(imagep);
+		imagep->setDecodePriority(decode_priority);
+		addImageToList(imagep);
 	}
 }
 
@@ -1042,6 +1107,7 @@ void LLViewerTextureList::decodeAllImages(F32 max_time)
 	}
 
 	llassert_always(image_list.size() == mImageList.size()) ;
+	mDirtyPriorityHeap.clear();
 	mImageList.clear();
 	for (std::vector<LLPointer<LLViewerFetchedTexture> >::iterator iter = image_list.begin();
 		 iter != image_list.end(); ++iter)
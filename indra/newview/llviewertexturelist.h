@@ -30,6 +30,7 @@
 #include "lluuid.h"
 //#include "message.h"
 #include "llgl.h"
+#include "llindexedheap.h"
 #include "llstat.h"
 #include "llviewertexture.h"
 #include "llui.h"
@@ -89,6 +90,10 @@ public:
 	LLViewerFetchedTexture *findImage(const LLUUID &image_id);
 
 	void dirtyImage(LLViewerFetchedTexture *image);
+
+	// Queue the decode priority of image for recalculation. virtual_size is the virtual size of the face
+	// that changed; the images with the largest faces are updated first.
+	void dirtyImagePriority(LLViewerFetchedTexture *image, F32 virtual_size);
 	
 	// Using image stats, determine what images are necessary, and perform image updates.
 	void updateImages(F32 max_time);
@@ -104,6 +109,7 @@ public:
 	S32	getMaxResidentTexMem() const	{ return mMaxResidentTexMemInMegaBytes; }
 	S32 getMaxTotalTextureMem() const   { return mMaxTotalTextureMemInMegaBytes;}
 	S32 getNumImages()					{ return mImageList.size(); }
+	S32 getNumDirtyPriorities() const	{ return mDirtyPriorityHeap.size(); }
 
 	void updateMaxResidentTexMem(S32 mem);
 	
@@ -117,6 +123,7 @@ public:
 	
 private:
 	void updateImagesDecodePriorities();
+	void updateImageDecodePriority(LLViewerFetchedTexture* imagep);
 	F32  updateImagesCreateTextures(F32 max_time);
 	F32  updateImagesFetchTextures(F32 max_time);
 	void updateImagesUpdateStats();
@@ -190,6 +197,29 @@ private:
 	typedef std::set<LLPointer<LLViewerFetchedTexture>, LLViewerFetchedTexture::Compare> image_priority_list_t;	
 	image_priority_list_t mImageList;
 
+	// Images whose decode priority must be recalculated, because a face that uses it changed.
+	// Raw pointers: an image is removed from the heap when it is removed from mImageList.
+	struct dirty_priority_less
+	{
+		bool operator()(LLViewerFetchedTexture const* lhs, LLViewerFetchedTexture const* rhs) const
+		{
+			if (lhs->mDirtyVirtualSize != rhs->mDirtyVirtualSize)
+			{
+				return lhs->mDirtyVirtualSize > rhs->mDirtyVirtualSize;
+			}
+			return lhs->mDirtyPriorityTime < rhs->mDirtyPriorityTime;
+		}
+	};
+	struct dirty_priority_heap_index
+	{
+		S32& operator()(LLViewerFetchedTexture* image) const
+		{
+			return image->mDirtyPriorityIndex;
+		}
+	};
+	typedef LLIndexedHeap<LLViewerFetchedTexture*, dirty_priority_less, dirty_priority_heap_index> dirty_priority_heap_t;
+	dirty_priority_heap_t mDirtyPriorityHeap;
+
 	// simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
 	std::set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
@@ -203,6 +233,14 @@ public:
 	static U32 sTextureBits;
 	static U32 sTexturePackets;
 
+	// Decode priority statistics of the last frame: the number of recalculations because a face changed,
+	// how long those images waited (in seconds), and how long ago the images that were recalculated
+	// by the round robin update were recalculated before.
+	static S32 sDirtyPriorityUpdates;
+	static F32 sDirtyPriorityStalenessAvg;
+	static F32 sDirtyPriorityStalenessMax;
+	static F32 sPriorityUpdateAgeAvg;
+
 private:
 	static S32 sNumImages;
 	static void (*sUUIDCallback)(void**, const LLUUID &);
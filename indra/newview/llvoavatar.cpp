@@ -45,6 +45,7 @@
 #include "llagentcamera.h"
 #include "llagentwearables.h"
 #include "llanimationstates.h"
+#include "llappviewer.h"
 #include "llavatarnamecache.h"
 #include "llavatarpropertiesprocessor.h"
 #include "llphysicsmotion.h"
@@ -70,6 +71,7 @@
 #include "llmanipscale.h"  // for get_default_max_prim_scale()
 #include "llmeshrepository.h"
 #include "llmutelist.h"
+#include "llskinning.h"
 #include "llnotificationsutil.h"
 #include "llquantize.h"
 #include "llrand.h"
@@ -8734,6 +8736,35 @@ S32 LLVOAvatar::getUnbakedPixelAreaRank()
 	return 0;
 }
 
+static LLFastTimer::DeclareTimer FTM_PREPARE_MOTIONS("Prepare Motions");
+
+// static
+void LLVOAvatar::prepareMotions()
+{
+	LLFastTimer t(FTM_PREPARE_MOTIONS);
+
+	static std::vector<LLCharacter*> characters;
+	characters.clear();
+	for (std::vector<LLCharacter*>::iterator iter = LLCharacter::sInstances.begin();
+		iter != LLCharacter::sInstances.end(); ++iter)
+	{
+		LLVOAvatar* inst = (LLVOAvatar*) *iter;
+		if (inst->isDead() || inst->mDrawable.isNull())
+		{
+			continue;
+		}
+		// Guess which avatars get a normal update in updateCharacter(), using last frame's
+		// update period; a wrong guess only costs some work, the result is the same.
+		if (inst->isSelf() ||
+			(inst->mDrawable->isVisible() && (LLDrawable::getCurrentFrame() + inst->mID.mData[0]) % inst->mUpdatePeriod == 0))
+		{
+			characters.push_back(inst);
+		}
+	}
+
+	LLCharacter::prepareMotions(characters, LLAppViewer::getWorkerPool());
+}
+
 struct CompareScreenAreaGreater
 {
 	BOOL operator()(const LLCharacter* const& lhs, const LLCharacter* const& rhs)
@@ -8976,49 +9007,11 @@ void LLVOAvatar::updateSoftwareSkinnedVertices(const LLMeshSkinInfo* skin, const
 	LLMatrix4a bind_shape_matrix;
 	bind_shape_matrix.loadu(skin->mBindShapeMatrix);
 
-	for (U32 j = 0; j < (U32)buffer->getNumVerts(); ++j)
-	{
-		LLMatrix4a final_mat;
-		final_mat.clear();
-
-		S32 idx[4];
-
-		LLVector4 wght;
-
-		F32 scale = 0.f;
-		for (U32 k = 0; k < 4; k++)
-		{
-			F32 w = weight[j][k];
-
-			idx[k] = (S32) floorf(w);
-			wght[k] = w - floorf(w);
-			scale += wght[k];
-		}
-
-		if(scale > 0.f)
-			wght *= 1.f/scale;
-		else
-			wght = LLVector4(F32_MAX,F32_MAX,F32_MAX,F32_MAX);
-
-		for (U32 k = 0; k < 4; k++)
-		{
-			F32 w = wght[k];
-			LLMatrix4a src;
-			src.setMul(mp[idx[k]], w);
-
-			final_mat.add(src);
-		}
-		
-		final_mat.mul(bind_shape_matrix);
-		final_mat.affineTransform(vol_face.mPositions[j], pos[j]);
-
-		if (norm)
-		{
-			final_mat.invert();
-			final_mat.transpose();
-			final_mat.affineTransform(vol_face.mNormals[j], norm[j]);
-		}
-	}
+	// Batches that no worker started by the time of the wait are skinned on this thread.
+	LLThreadPool::Group group;
+	LLSkinning::skinVertices(LLAppViewer::getWorkerPool(), group, mp, count, bind_shape_matrix,
+							 weight, vol_face.mPositions, vol_face.mNormals, pos, norm, buffer->getNumVerts());
+	group.wait();
 }
 U32 LLVOAvatar::getPartitionType() const
 { 
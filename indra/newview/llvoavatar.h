@@ -524,6 +524,8 @@ private:
 	//--------------------------------------------------------------------
 public:
 	static void	cullAvatarsByPixelArea();
+	// Evaluate the keyframe motions of all avatars that will be animated this frame on the worker pool.
+	static void	prepareMotions();
 	BOOL		isCulled() const { return mCulled; }
 private:
 	BOOL		mCulled;
@@ -74,10 +74,12 @@
 #include "pipeline.h"
 #include "llsdutil.h"
 #include "llmatrix4a.h"
+#include "llskinning.h"
 #include "llmediaentry.h"
 #include "llmediadataclient.h"
 #include "llmeshrepository.h"
 #include "llagent.h"
+#include "llappviewer.h"
 #include "llviewermediafocus.h"
 #include "lldatapacker.h"
 #include "llviewershadermgr.h"
@@ -3898,89 +3900,53 @@ void LLRiggedVolume::update(const LLMeshSkinInfo* skin, LLVOAvatar* avatar, cons
 		}
 	}
 
+	LLMatrix4a bind_shape_matrix;
+	bind_shape_matrix.loadu(skin->mBindShapeMatrix);
+
+	{
+		LLFastTimer t(FTM_SKIN_RIGGED);
+
+		// Skin all faces at once, spread over the worker pool. The wait skins what the
+		// workers didn't get to on this thread.
+		LLThreadPool::Group group;
+		for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
+		{
+			const LLVolumeFace& vol_face = volume->getVolumeFace(i);
+			LLVolumeFace& dst_face = mVolumeFaces[i];
+
+			if (vol_face.mWeights && dst_face.mPositions && dst_face.mExtents && dst_face.mNumVertices > 0)
+			{
+				LLSkinning::skinPositions(LLAppViewer::getWorkerPool(), group, mp, count, bind_shape_matrix,
+										  vol_face.mWeights, vol_face.mPositions, dst_face.mPositions, dst_face.mNumVertices);
+			}
+		}
+		group.wait();
+	}
+
 	for (S32 i = 0; i < volume->getNumVolumeFaces(); ++i)
 	{
 		const LLVolumeFace& vol_face = volume->getVolumeFace(i);
 		
 		LLVolumeFace& dst_face = mVolumeFaces[i];
 		
-		LLVector4a* weight = vol_face.mWeights;
-
-		if(!weight)
+		if(!vol_face.mWeights)
 		{
 			continue;
 		}
 
-		LLMatrix4a bind_shape_matrix;
-		bind_shape_matrix.loadu(skin->mBindShapeMatrix);
-
 		LLVector4a* pos = dst_face.mPositions;
 
-		if( pos && dst_face.mExtents )
+		if( pos && dst_face.mExtents && dst_face.mNumVertices > 0 )
 		{
-			LLFastTimer t(FTM_SKIN_RIGGED);
-
-			for (U32 j = 0; j < (U32)dst_face.mNumVertices; ++j)
-			{
-				LLMatrix4a final_mat;
-				final_mat.clear();
-
-				S32 idx[4];
-
-				LLVector4 wght;
-
-				F32 scale = 0.f;
-				for (U32 k = 0; k < 4; k++)
-				{
-					F32 w = weight[j][k];
-
-					idx[k] = (S32) floorf(w);
-					wght[k] = w - floorf(w);
-					scale += wght[k];
-				}
-
-				if(scale > 0.f)
-					wght *= 1.f/scale;
-				else
-					wght = LLVector4(F32_MAX,F32_MAX,F32_MAX,F32_MAX);
-
-				for (U32 k = 0; k < 4; k++)
-				{
-					F32 w = wght[k];
-					LLMatrix4a src;
-					src.setMul(mp[idx[k]], w);
-
-					final_mat.add(src);
-				}
-
-				
-				LLVector4a& v = vol_face.mPositions[j];
-				LLVector4a t;
-				LLVector4a dst;
-				bind_shape_matrix.affineTransform(v, t);
-				final_mat.affineTransform(t, dst);
-				pos[j] = dst;
-			}
-
 			//update bounding box
-			LLVector4a& min = dst_face.mExtents[0];
-			LLVector4a& max = dst_face.mExtents[1];
-
-			min = pos[0];
-			max = pos[1];
-
-			for (U32 j = 1; j < (U32)dst_face.mNumVertices; ++j)
-			{
-				min.setMin(min, pos[j]);
-				max.setMax(max, pos[j]);
-			}
+			LLSkinning::getExtents(pos, dst_face.mNumVertices, dst_face.mExtents[0], dst_face.mExtents[1]);
 
 			dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
 			dst_face.mCenter->mul(0.5f);
-
 		}
 
 		{
+			// The octree nodes come from a (not thread safe) pool, so this stays on the main thread.
 			LLFastTimer t(FTM_RIGGED_OCTREE);
 			delete dst_face.mOctree;
 			dst_face.mOctree = NULL;
@@ -5471,6 +5437,108 @@ static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_FACE_SIZE("Face Sizing");
 static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_ALLOCATE("Allocate VB");
 static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_FIND_VB("Find VB");
 static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_RESIZE_VB("Resize VB");
+static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_PREPARE_GEOM("Prepare Face Geom");
+static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_FACE_GEOM("Face Geom Jobs");
+static LLFastTimer::DeclareTimer FTM_GEN_DRAW_INFO_FLUSH_VB("Flush VB");
+
+namespace
+{
+	// A face whose geometry goes into a vertex buffer that was mapped with LLVertexBuffer::mapForThreadedWrite().
+	struct LLFaceGeometryEntry
+	{
+		LLFace* mFace;
+		const LLVolume* mVolume;
+		const LLMatrix4a* mXform;			// Those of the LLVOVolume of the face.
+		const LLMatrix4a* mXformInvTrans;
+		U16 mIndexOffset;
+	};
+
+	// A vertex buffer that was mapped with LLVertexBuffer::mapForThreadedWrite(), and how much of it is used.
+	struct LLMappedBufferEntry
+	{
+		LLVertexBuffer* mBuffer;
+		U16 mVertexCount;
+		U32 mIndexCount;
+	};
+
+	void write_face_geometry(LLFaceGeometryEntry const* begin, LLFaceGeometryEntry const* end)
+	{
+		for (LLFaceGeometryEntry const* entry = begin; entry != end; ++entry)
+		{
+			LLFace* facep = entry->mFace;
+			if (!facep->getGeometryVolume(*entry->mVolume, facep->getTEOffset(),
+				*entry->mXform, *entry->mXformInvTrans, entry->mIndexOffset, true))
+			{
+				llwarns << "Failed to get geometry for face!" << llendl;
+			}
+		}
+	}
+
+	// Transforms the vertices and generates the texture coordinates of a range of faces on a worker thread.
+	class LLFaceGeometryJob : public LLThreadPool::Job
+	{
+	public:
+		LLFaceGeometryJob(LLFaceGeometryEntry const* begin, LLFaceGeometryEntry const* end) : mBegin(begin), mEnd(end) { }
+		/*virtual*/ void run(void) { write_face_geometry(mBegin, mEnd); }
+
+	private:
+		LLFaceGeometryEntry const* mBegin;
+		LLFaceGeometryEntry const* mEnd;
+	};
+
+	// Fills the mapped vertex buffers, spread over the worker pool when there is enough to do, and then uploads them.
+	void write_mapped_buffers(std::vector<LLFaceGeometryEntry> const& faces, std::vector<LLMappedBufferEntry> const& buffers)
+	{
+		// Fewer vertices than this aren't worth a job.
+		const U32 VERTICES_PER_JOB = 4096;
+
+		if (!faces.empty())
+		{
+			LLFastTimer t(FTM_GEN_DRAW_INFO_FACE_GEOM);
+			LLThreadPool* pool = LLAppViewer::getWorkerPool();
+			LLThreadPool::Group group;
+			LLFaceGeometryEntry const* first = &faces[0];
+			LLFaceGeometryEntry const* end = first + faces.size();
+			// The first job is done by this thread, after posting the rest.
+			LLFaceGeometryEntry const* first_end = end;
+			LLFaceGeometryEntry const* begin = first;
+			U32 vertices = 0;
+			for (LLFaceGeometryEntry const* entry = first; entry != end; ++entry)
+			{
+				vertices += entry->mFace->getGeomCount();
+				if (vertices >= VERTICES_PER_JOB || entry + 1 == end)
+				{
+					if (begin == first)
+					{
+						first_end = entry + 1;
+					}
+					else
+					{
+						LLPointer<LLThreadPool::Job> job = new LLFaceGeometryJob(begin, entry + 1);
+						if (!pool || !pool->post(job, &group))
+						{
+							job->run();
+						}
+					}
+					begin = entry + 1;
+					vertices = 0;
+				}
+			}
+			write_face_geometry(first, first_end);
+			group.wait();
+		}
+
+		LLFastTimer t(FTM_GEN_DRAW_INFO_FLUSH_VB);
+		for (std::vector<LLMappedBufferEntry>::const_iterator iter = buffers.begin(); iter != buffers.end(); ++iter)
+		{
+			if (iter->mVertexCount > 0)
+			{
+				iter->mBuffer->validateRange(0, iter->mVertexCount - 1, iter->mIndexCount, 0);
+			}
+			iter->mBuffer->flush();
+		}
+	}
+}
 
 
 
@@ -5493,6 +5561,13 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 	}
 #endif
 
+	//transform the vertices and generate the texture coordinates of the faces on the worker pool, after
+	//mapping the vertex buffers here (see write_mapped_buffers)
+	static const LLCachedControl<bool> parallel_geometry("RenderParallelGeometry", true);
+	bool threaded_geom = parallel_geometry && !LLPipeline::sDelayVBUpdate && !LLFace::useTransformFeedback();
+	std::vector<LLFaceGeometryEntry> geom_faces;
+	std::vector<LLMappedBufferEntry> geom_buffers;
+
 	//calculate maximum number of vertices to store in a single buffer
 	static const LLCachedControl<S32> render_max_vbo_size("RenderMaxVBOSize", 512);
 	U32 max_vertices = (render_max_vbo_size*1024)/LLVertexBuffer::calcVertexSize(group->mSpatialPartition->mVertexDataMask);
@@ -5808,6 +5883,12 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 			buffer->allocateBuffer(geom_count, index_count, TRUE);
 		}
 
+		if (threaded_geom)
+		{
+			LLFastTimer t(FTM_GEN_DRAW_INFO_PREPARE_GEOM);
+			buffer->mapForThreadedWrite();
+		}
+
 		group->mGeometryBytes += buffer->getSize() + buffer->getIndicesSize();
 
 
@@ -6287,24 +6368,34 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 				LLVOVolume* vobj = drawablep->getVOVolume();
 				LLVolume* volume = vobj->getVolume();
 
-				if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
-				{
-					vobj->updateRelativeXform(true);
-				}
-
 				U32 te_idx = facep->getTEOffset();
 
 				llassert(!facep->isState(LLFace::RIGGED));
 
-				if (!facep->getGeometryVolume(*volume, te_idx, 
-					vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
-				{
-					llwarns << "Failed to get geometry for face!" << llendl;
+				if (threaded_geom && !drawablep->isState(LLDrawable::ANIMATED_CHILD))
+				{ //done by write_mapped_buffers
+					LLFastTimer t(FTM_GEN_DRAW_INFO_PREPARE_GEOM);
+					facep->prepareGeometryVolume(te_idx);
+					LLFaceGeometryEntry entry = { facep, volume, &vobj->getRelativeXform(), &vobj->getRelativeXformInvTrans(), index_offset };
+					geom_faces.push_back(entry);
 				}
-
-				if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+				else
 				{
-					vobj->updateRelativeXform(false);
+					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+					{
+						vobj->updateRelativeXform(true);
+					}
+
+					if (!facep->getGeometryVolume(*volume, te_idx, 
+						vobj->getRelativeXform(), vobj->getRelativeXformInvTrans(), index_offset,true))
+					{
+						llwarns << "Failed to get geometry for face!" << llendl;
+					}
+
+					if (drawablep->isState(LLDrawable::ANIMATED_CHILD))
+					{
+						vobj->updateRelativeXform(false);
+					}
 				}
 			}
 
@@ -6314,12 +6405,25 @@ void LLVolumeGeometryManager::genDrawInfo(LLSpatialGroup* group, U32 mask, LLFac
 			++face_iter;
 		}
 
-		if(index_offset > 0)
+		if (threaded_geom)
+		{ //validated and flushed by write_mapped_buffers
+			LLMappedBufferEntry entry = { buffer, index_offset, indices_index };
+			geom_buffers.push_back(entry);
+		}
+		else
 		{
-			buffer->validateRange(0,  index_offset - 1, indices_index, 0);
+			if(index_offset > 0)
+			{
+				buffer->validateRange(0,  index_offset - 1, indices_index, 0);
+			}
+
+			buffer->flush();
 		}
+	}
 
-		buffer->flush();
+	if (threaded_geom)
+	{
+		write_mapped_buffers(geom_faces, geom_buffers);
 	}
 
 	group->mBufferMap[mask].clear();
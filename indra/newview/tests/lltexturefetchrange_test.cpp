@@ -0,0 +1,172 @@
+/**
+ * @file lltexturefetchrange_test.cpp
+ * @brief Tests for LLTextureFetchRange.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+// Precompiled header: almost always required for newview cpp files
+#include "../llviewerprecompiledheaders.h"
+// Class to test
+#include "../lltexturefetchrange.h"
+// Dependencies
+#include "llimagej2c.h"
+
+// Tut header
+#include "../test/lltut.h"
+
+// -------------------------------------------------------------------------------------------
+// Stubbing: Declarations required to link and run the class being tested
+// Notes:
+// * Add here stubbed implementation of the few classes and methods used in the class to be tested
+// * Add as little as possible (let the link errors guide you)
+// * Do not make any assumption as to how those classes or methods work (i.e. don't copy/paste code)
+// * A simulator for a class can be implemented here. Please comment and document thoroughly.
+
+// None: LLImageJ2C::calcDataSizeJ2C(), the size estimate that decides what LLTextureFetchRange
+// coalesces, is inline in llimagej2c.h, so this test uses the real one.
+
+// End Stubbing
+// -------------------------------------------------------------------------------------------
+
+// -------------------------------------------------------------------------------------------
+// TUT
+// -------------------------------------------------------------------------------------------
+
+namespace tut
+{
+	// A model of the texture HTTP server, not a measurement: every range request costs a fixed round
+	// trip plus the transfer time of the requested bytes at a fixed rate, and the requests are counted.
+	class TestTextureServer
+	{
+	public:
+		TestTextureServer(F64 latency, F64 bytes_per_second) : mLatency(latency), mBytesPerSecond(bytes_per_second), mRequests(0) { }
+
+		// Returns the time it takes to get bytes [offset, offset + size).
+		F64 get(S32 offset, S32 size)
+		{
+			++mRequests;
+			return mLatency + size / mBytesPerSecond;
+		}
+
+		S32 getRequests() const { return mRequests; }
+
+	private:
+		F64 mLatency;
+		F64 mBytesPerSecond;
+		S32 mRequests;
+	};
+
+	// Replays what LLViewerFetchedTexture::updateFetch() and LLTextureFetchWorker do to load a w x h texture
+	// with c components from the discard level of its first packet down to final_discard: request one level
+	// more each time (the level that is asked for can be lowered by LLTextureFetchRange), fetch the missing
+	// bytes, decode them and write them to the cache. With overlap_write the cache write runs while the
+	// data is decoded. Returns the time until final_discard was decoded in this model; the costs below are
+	// round numbers chosen to compare the request patterns, not timings of the real decoder or cache.
+	F64 load_texture(TestTextureServer& server, S32 w, S32 h, S32 c, S32 final_discard, S32 coalesce_bytes, bool overlap_write)
+	{
+		const F64 decode_seconds_per_pixel = 0.25e-6;
+		const F64 write_seconds_per_byte = 0.05e-6;
+		S32 current_discard = 5;
+		S32 have_bytes = FIRST_PACKET_SIZE;
+		F64 time = 0.0;
+		while (current_discard > final_discard)
+		{
+			S32 desired_discard = llmax(final_discard, current_discard - 1);
+			desired_discard = LLTextureFetchRange::calcCoalescedDiscard(w, h, c, desired_discard, final_discard, coalesce_bytes);
+			S32 desired_size = LLImageJ2C::calcDataSizeJ2C(w, h, c, desired_discard);
+			time += server.get(have_bytes, desired_size - have_bytes);
+			F64 decode_time = (w >> desired_discard) * (h >> desired_discard) * decode_seconds_per_pixel;
+			F64 write_time = desired_size * write_seconds_per_byte;
+			time += overlap_write ? llmax(decode_time, write_time) : decode_time + write_time;
+			have_bytes = desired_size;
+			current_discard = desired_discard;
+		}
+		return time;
+	}
+
+	// Test wrapper declarations
+	struct texturefetchrange_test
+	{
+	};
+
+	// Tut templating thingamagic: test group, object and test instance
+	typedef test_group<texturefetchrange_test> texturefetchrange_t;
+	typedef texturefetchrange_t::object texturefetchrange_object_t;
+	tut::texturefetchrange_t tut_texturefetchrange("LLTextureFetchRange");
+
+	// ---------------------------------------------------------------------------------------
+	// Test functions
+	// ---------------------------------------------------------------------------------------
+
+	// Nothing is coalesced when it can't or shouldn't be
+	template<> template<>
+	void texturefetchrange_object_t::test<1>()
+	{
+		ensure_equals("unknown size", LLTextureFetchRange::calcCoalescedDiscard(0, 0, 0, 3, 0, 131072), 3);
+		ensure_equals("no budget", LLTextureFetchRange::calcCoalescedDiscard(1024, 1024, 3, 3, 0, 0), 3);
+		ensure_equals("final level", LLTextureFetchRange::calcCoalescedDiscard(1024, 1024, 3, 3, 3, 131072), 3);
+		ensure_equals("unknown final level", LLTextureFetchRange::calcCoalescedDiscard(1024, 1024, 3, 3, -1, 131072), 3);
+	}
+
+	// The levels in between are fetched as long as they fit in the budget, but never past the final level
+	template<> template<>
+	void texturefetchrange_object_t::test<2>()
+	{
+		// 256x256x3: discard 2 is 1536 bytes, 1 is 6144, 0 is 24576.
+		ensure_equals("all of a small texture", LLTextureFetchRange::calcCoalescedDiscard(256, 256, 3, 2, 0, 131072), 0);
+		ensure_equals("up to the final level", LLTextureFetchRange::calcCoalescedDiscard(256, 256, 3, 2, 1, 131072), 1);
+		ensure_equals("within the budget", LLTextureFetchRange::calcCoalescedDiscard(256, 256, 3, 2, 0, 4608), 1);
+		ensure_equals("over the budget", LLTextureFetchRange::calcCoalescedDiscard(256, 256, 3, 2, 0, 4607), 2);
+	}
+
+	// In the model, coalescing needs fewer requests and doesn't take longer to get to full resolution, whether
+	// or not the cache write overlaps the decode. Only the request count is a property of the real code.
+	template<> template<>
+	void texturefetchrange_object_t::test<3>()
+	{
+		const S32 sizes[] = { 256, 512, 1024 };
+		for (S32 overlap_write = 0; overlap_write < 2; ++overlap_write)
+		{
+			for (S32 i = 0; i < 3; ++i)
+			{
+				for (S32 final_discard = 0; final_discard <= 2; ++final_discard)
+				{
+					S32 size = sizes[i];
+					TestTextureServer separate(0.1, 1024.0 * 1024.0);
+					TestTextureServer coalesced(0.1, 1024.0 * 1024.0);
+					F64 separate_time = load_texture(separate, size, size, 3, final_discard, 0, overlap_write != 0);
+					F64 coalesced_time = load_texture(coalesced, size, size, 3, final_discard, 131072, overlap_write != 0);
+					ensure("no more requests", coalesced.getRequests() <= separate.getRequests());
+					ensure("not slower", coalesced_time <= separate_time);
+				}
+			}
+		}
+		// The bigger levels of a 1024x1024 texture don't fit in the budget, the smaller ones do.
+		TestTextureServer separate(0.1, 1024.0 * 1024.0);
+		TestTextureServer coalesced(0.1, 1024.0 * 1024.0);
+		load_texture(separate, 1024, 1024, 3, 0, 0, false);
+		load_texture(coalesced, 1024, 1024, 3, 0, 131072, false);
+		ensure_equals("separate requests", separate.getRequests(), 5);
+		ensure("fewer requests", coalesced.getRequests() < separate.getRequests());
+	}
+}
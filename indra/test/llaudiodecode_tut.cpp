@@ -0,0 +1,256 @@
+/**
+ * @file llaudiodecode_tut.cpp
+ * @brief Tests of LLDecodedAudioCache and of decoding Ogg Vorbis sounds serially and on a thread pool, and a benchmark of both.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "lldecodedaudiocache.h"
+#include "llvorbisdecode.h"
+#include "llvorbisencode.h"
+#include "llapr.h"
+#include "llfile.h"
+#include "llmath.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	static U32 const NUM_SOUNDS = 24;
+
+	// Decodes one Ogg asset.
+	class LLDecodeJob : public LLThreadPool::Job
+	{
+	public:
+		LLDecodeJob(LLUUID const& id, std::vector<U8> const& ogg, std::vector<U8>& wav, LLAtomicU32& failed) :
+			mID(id), mOgg(ogg), mWAV(wav), mFailed(failed) { }
+
+		/*virtual*/ void run(void)
+		{
+			bool corrupt;
+			if (!decode_vorbis_to_wav(mID, &mOgg[0], (S32)mOgg.size(), false, mWAV, corrupt))
+			{
+				mFailed++;
+			}
+		}
+
+	private:
+		LLUUID mID;
+		std::vector<U8> const& mOgg;
+		std::vector<U8>& mWAV;
+		LLAtomicU32& mFailed;
+	};
+
+	struct audiodecode_data
+	{
+		// Write a 16-bit mono 44.1 kHz WAV file of num_samples samples of a decaying tone.
+		static void writeWAV(std::string const& filename, U32 num_samples, F32 frequency)
+		{
+			std::vector<U8> wav(44 + num_samples * 2);
+			U32 const data_size = num_samples * 2;
+			U32 const riff_size = 36 + data_size;
+			memcpy(&wav[0], "RIFF", 4);
+			for (int i = 0; i < 4; ++i)
+			{
+				wav[4 + i] = (U8)(riff_size >> (8 * i));
+				wav[40 + i] = (U8)(data_size >> (8 * i));
+			}
+			static U8 const fmt[] = {
+				'W', 'A', 'V', 'E', 'f', 'm', 't', ' ',
+				16, 0, 0, 0,				// chunk size
+				1, 0, 1, 0,					// PCM, mono
+				0x44, 0xac, 0, 0,			// 44100 Hz
+				0x88, 0x58, 0x01, 0,		// bytes per second
+				2, 0, 16, 0,				// block align, bits per sample
+				'd', 'a', 't', 'a' };
+			memcpy(&wav[8], fmt, sizeof(fmt));
+			for (U32 i = 0; i < num_samples; ++i)
+			{
+				F32 t = (F32)i / LLVORBIS_CLIP_SAMPLE_RATE;
+				S16 sample = (S16)(20000.f * expf(-2.f * t) * sinf(F_TWO_PI * frequency * t));
+				wav[44 + 2 * i] = (U8)sample;
+				wav[45 + 2 * i] = (U8)((U16)sample >> 8);
+			}
+			LLAPRFile::writeEx(filename, &wav[0], 0, (S32)wav.size());
+		}
+
+		// Encode a sound like writeWAV() writes it to an Ogg Vorbis asset, like an upload does.
+		static std::vector<U8> encodeOgg(U32 num_samples, F32 frequency)
+		{
+			std::string const tmpdir(LLFile::tmpdir());
+			std::string wav_name = tmpdir + "llaudiodecode_tut.wav";
+			std::string ogg_name = tmpdir + "llaudiodecode_tut.ogg";
+			writeWAV(wav_name, num_samples, frequency);
+			ensure_equals("encoded", encode_vorbis_file(wav_name, ogg_name), (S32)LLVORBISENC_NOERR);
+			S32 size = LLAPRFile::size(ogg_name);
+			ensure("ogg size", size > 0);
+			std::vector<U8> ogg(size);
+			ensure_equals("read", LLAPRFile::readEx(ogg_name, &ogg[0], 0, size), size);
+			LLFile::remove(wav_name);
+			LLFile::remove(ogg_name);
+			return ogg;
+		}
+
+		static U32 littleEndian32(std::vector<U8> const& data, size_t offset)
+		{
+			return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((U32)data[offset + 3] << 24);
+		}
+	};
+	typedef test_group<audiodecode_data> audiodecode_test;
+	typedef audiodecode_test::object audiodecode_object;
+	tut::audiodecode_test audiodecode_testcase("audiodecode");
+
+	template<> template<>
+	void audiodecode_object::test<1>()
+	{
+		// The cache stays within its size, drops the least recently used sounds first,
+		// and doesn't keep sounds larger than all of it.
+		LLDecodedAudioCache cache(1000);
+		LLUUID ids[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			ids[i].generate();
+		}
+		std::vector<U8> wav(400, 1);
+		cache.add(ids[0], wav);
+		ensure("data taken", wav.empty());
+		wav.assign(400, 2);
+		cache.add(ids[1], wav);
+		ensure_equals("size", cache.getSize(), 800U);
+		ensure("get", cache.get(ids[0]) && (*cache.get(ids[0]))[0] == 1);
+		// ids[1] is now the least recently used.
+		wav.assign(400, 3);
+		cache.add(ids[2], wav);
+		ensure_equals("count", cache.getCount(), 2U);
+		ensure("evicted", !cache.has(ids[1]) && cache.has(ids[0]) && cache.has(ids[2]));
+		ensure("size after evicting", cache.getSize() <= 1000);
+		wav.assign(1001, 4);
+		cache.add(ids[3], wav);
+		ensure("too large", !cache.has(ids[3]) && cache.getCount() == 2);
+		cache.remove(ids[0]);
+		ensure_equals("removed", cache.getSize(), 400U);
+		ensure("gone", cache.get(ids[0]) == NULL);
+	}
+
+	template<> template<>
+	void audiodecode_object::test<2>()
+	{
+		// A sound decoded with decode_vorbis_to_wav() on the calling thread, and by jobs on a thread
+		// pool the way LLAudioDecodeMgr posts them, is a complete 16-bit mono 44.1 kHz WAV file
+		// image with all samples of the sound, and both give the same bytes.
+		U32 const num_samples = LLVORBIS_CLIP_SAMPLE_RATE / 2;
+		U32 const num_sounds = 4;
+		std::vector<U8> ogg = encodeOgg(num_samples, 440.f);
+		LLUUID id;
+		id.generate();
+
+		std::vector<U8> serial;
+		bool corrupt = true;
+		ensure("decoded serially", decode_vorbis_to_wav(id, &ogg[0], (S32)ogg.size(), false, serial, corrupt));
+		ensure("not corrupt", !corrupt);
+		ensure_equals("length", (U32)serial.size(), 44 + 2 * num_samples);
+		ensure("RIFF", !memcmp(&serial[0], "RIFF", 4) && !memcmp(&serial[8], "WAVEfmt ", 8) && !memcmp(&serial[36], "data", 4));
+		ensure_equals("RIFF size", littleEndian32(serial, 4), (U32)serial.size() - 8);
+		ensure_equals("format chunk size", littleEndian32(serial, 16), 16U);
+		ensure_equals("PCM, mono", littleEndian32(serial, 20), 0x00010001U);
+		ensure_equals("sample rate", littleEndian32(serial, 24), (U32)LLVORBIS_CLIP_SAMPLE_RATE);
+		ensure_equals("block align, bits per sample", littleEndian32(serial, 32), 0x00100002U);
+		ensure_equals("data size", littleEndian32(serial, 40), 2 * num_samples);
+
+		LLThreadPool pool("audio decode test", 2);
+		std::vector<std::vector<U8> > parallel(num_sounds);
+		LLAtomicU32 failed(0);
+		{
+			LLThreadPool::Group group;
+			for (U32 i = 0; i < num_sounds; ++i)
+			{
+				LLPointer<LLThreadPool::Job> job = new LLDecodeJob(id, ogg, parallel[i], failed);
+				if (!pool.post(job, &group))
+				{
+					job->run();
+				}
+			}
+			group.wait();
+		}
+		ensure_equals("all decoded on the pool", (U32)failed, 0U);
+		for (U32 i = 0; i < num_sounds; ++i)
+		{
+			ensure("same bytes", parallel[i] == serial);
+		}
+	}
+
+	template<> template<>
+	void audiodecode_object::test<3>()
+	{
+		// Benchmark: encode a set of sounds of one to ten seconds and decode them all
+		// serially, like LLAudioDecodeMgr did on the main thread, and on a thread pool.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		std::vector<std::vector<U8> > oggs(NUM_SOUNDS);
+		std::vector<LLUUID> ids(NUM_SOUNDS);
+		for (U32 i = 0; i < NUM_SOUNDS; ++i)
+		{
+			oggs[i] = encodeOgg((1 + i % 10) * LLVORBIS_CLIP_SAMPLE_RATE - 1000, 220.f + 40.f * i);
+			ids[i].generate();
+		}
+
+		std::vector<std::vector<U8> > serial(NUM_SOUNDS);
+		LLAtomicU32 failed(0);
+		LLTimer timer;
+		for (U32 i = 0; i < NUM_SOUNDS; ++i)
+		{
+			LLPointer<LLThreadPool::Job> job = new LLDecodeJob(ids[i], oggs[i], serial[i], failed);
+			job->run();
+		}
+		F64 serial_time = timer.getElapsedTimeF64();
+		ensure_equals("all decoded serially", (U32)failed, 0U);
+
+		LLThreadPool pool("audio decode benchmark");
+		std::vector<std::vector<U8> > parallel(NUM_SOUNDS);
+		timer.reset();
+		{
+			LLThreadPool::Group group;
+			for (U32 i = 0; i < NUM_SOUNDS; ++i)
+			{
+				pool.post(new LLDecodeJob(ids[i], oggs[i], parallel[i], failed), &group);
+			}
+			group.wait();
+		}
+		F64 parallel_time = timer.getElapsedTimeF64();
+		ensure_equals("all decoded on the pool", (U32)failed, 0U);
+
+		U32 total_size = 0;
+		for (U32 i = 0; i < NUM_SOUNDS; ++i)
+		{
+			total_size += (U32)serial[i].size();
+		}
+
+		llinfos << "Decoding " << NUM_SOUNDS << " sounds (" << total_size / 1024 << " kB of PCM) took " << serial_time * 1000.0
+				<< " ms serially, " << parallel_time * 1000.0 << " ms on " << pool.getThreadCount() << " threads." << llendl;
+	}
+}
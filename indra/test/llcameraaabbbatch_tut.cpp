@@ -0,0 +1,303 @@
+/**
+ * @file llcameraaabbbatch_tut.cpp
+ * @brief Tests comparing LLCamera::AABBsInFrustum with the single box frustum tests.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llcamera.h"
+#include "lltimer.h"
+
+#include <vector>
+
+namespace tut
+{
+	struct aabb_batch_data
+	{
+		// A node of the synthetic octree: bounds like LLSpatialGroup::mBounds, and the index of the first of its
+		// eight children in mNodes, or 0 for a leaf.
+		struct Node
+		{
+			LLVector4a mBounds[2];
+			U32 mFirstChild;
+		};
+
+		LLCamera mCamera;
+		std::vector<Node> mNodes;
+		U32 mSeed;
+
+		aabb_batch_data() : mCamera(60.f * DEG_TO_RAD, 16.f / 9.f, 1024, 0.5f, 256.f), mSeed(12345)
+		{
+		}
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		F32 random()
+		{
+			return (F32)next() / 32768.f;
+		}
+
+		// Point the camera from origin at target and calculate the agent frustum planes, like
+		// LLViewerCamera::updateFrustumPlanes does from the GL matrices.
+		void setCamera(const LLVector3& origin, const LLVector3& target)
+		{
+			mCamera.lookAt(origin, target);
+			F32 h = mCamera.getNear() * tanf(mCamera.getView() * 0.5f);
+			F32 w = h * mCamera.getAspect();
+			LLVector3 center = origin + mCamera.getAtAxis() * mCamera.getNear();
+			LLVector3 left = mCamera.getLeftAxis() * w;
+			LLVector3 up = mCamera.getUpAxis() * h;
+			LLVector3 frust[8];
+			frust[0] = center + left - up;
+			frust[1] = center - left - up;
+			frust[2] = center - left + up;
+			frust[3] = center + left + up;
+			for (U32 i = 0; i < 4; i++)
+			{
+				LLVector3 vec = frust[i] - origin;
+				vec.normVec();
+				frust[i + 4] = origin + vec * mCamera.getFar();
+			}
+			mCamera.calcAgentFrustumPlanes(frust);
+		}
+
+		// Frame frame of frames of a fly-through: circle the region at roof height, looking around.
+		void flyThrough(U32 frame, U32 frames)
+		{
+			F32 t = (F32)frame / frames * F_TWO_PI;
+			LLVector3 origin(128.f + 90.f * cosf(t), 128.f + 90.f * sinf(t), 25.f + 10.f * sinf(3.f * t));
+			LLVector3 target = origin + LLVector3(cosf(t * 5.f), sinf(t * 5.f), -0.2f);
+			setCamera(origin, target);
+		}
+
+		// depth levels of boxes that fill the octants of their parent partly, like the groups of a
+		// spatial partition of a 256 m region.
+		void buildOctree(U32 depth)
+		{
+			mNodes.clear();
+			Node root;
+			root.mBounds[0].set(128.f, 128.f, 128.f);
+			root.mBounds[1].set(128.f, 128.f, 128.f);
+			root.mFirstChild = 0;
+			mNodes.push_back(root);
+			U32 level_start = 0;
+			for (U32 level = 0; level < depth; level++)
+			{
+				U32 level_end = mNodes.size();
+				for (U32 parent = level_start; parent < level_end; parent++)
+				{
+					mNodes[parent].mFirstChild = mNodes.size();
+					LLVector4a center = mNodes[parent].mBounds[0];
+					LLVector4a radius = mNodes[parent].mBounds[1];
+					for (U32 octant = 0; octant < 8; octant++)
+					{
+						Node child;
+						F32 c[3], r[3];
+						for (U32 k = 0; k < 3; k++)
+						{
+							F32 half = radius[k] * 0.5f;
+							r[k] = half * (0.5f + random() * 0.5f);
+							c[k] = center[k] + ((octant & (1 << k)) ? half : -half) + (half - r[k]) * (random() * 2.f - 1.f);
+						}
+						child.mBounds[0].set(c[0], c[1], c[2]);
+						child.mBounds[1].set(r[0], r[1], r[2]);
+						child.mFirstChild = 0;
+						mNodes.push_back(child);
+					}
+				}
+				level_start = level_end;
+			}
+		}
+
+		S32 check(U32 node, bool far_clip)
+		{
+			return far_clip ? mCamera.AABBInFrustum(mNodes[node].mBounds[0], mNodes[node].mBounds[1]) :
+							  mCamera.AABBInFrustumNoFarClip(mNodes[node].mBounds[0], mNodes[node].mBounds[1]);
+		}
+
+		// Collect the visible nodes like LLOctreeCull: test a node unless its parent is fully in.
+		void cullScalar(U32 node, S32 res, bool far_clip, std::vector<U32>& visible)
+		{
+			if (res != 2)
+			{
+				res = check(node, far_clip);
+				if (!res)
+				{
+					return;
+				}
+			}
+			visible.push_back(node);
+			if (mNodes[node].mFirstChild)
+			{
+				for (U32 i = 0; i < 8; i++)
+				{
+					cullScalar(mNodes[node].mFirstChild + i, res, far_clip, visible);
+				}
+			}
+		}
+
+		// The same, testing the eight children of a node that is partly in at once.
+		void cullBatched(U32 node, S32 res, bool far_clip, std::vector<U32>& visible)
+		{
+			if (!res)
+			{
+				return;
+			}
+			visible.push_back(node);
+			U32 first = mNodes[node].mFirstChild;
+			if (first)
+			{
+				S32 results[8];
+				if (res == 2)
+				{
+					for (U32 i = 0; i < 8; i++)
+					{
+						results[i] = 2;
+					}
+				}
+				else
+				{
+					LLCameraAABBBatch batch;
+					for (U32 i = 0; i < 8; i++)
+					{
+						batch.add(mNodes[first + i].mBounds[0], mNodes[first + i].mBounds[1]);
+					}
+					mCamera.AABBsInFrustum(batch, results, far_clip);
+				}
+				for (U32 i = 0; i < 8; i++)
+				{
+					cullBatched(first + i, results[i], far_clip, visible);
+				}
+			}
+		}
+	};
+	typedef test_group<aabb_batch_data> aabb_batch_test;
+	typedef aabb_batch_test::object aabb_batch_object;
+	tut::aabb_batch_test aabb_batch_testcase("camera AABB batch");
+
+	template<> template<>
+	void aabb_batch_object::test<1>()
+	{
+		// The batched test gives exactly the result of the single box tests, for every number of boxes.
+		setCamera(LLVector3(10.f, 20.f, 30.f), LLVector3(100.f, 60.f, 25.f));
+		ensure_equals("box in front is in", mCamera.AABBInFrustum(LLVector4a(60.f, 40.f, 27.5f), LLVector4a(1.f, 1.f, 1.f)), 2);
+		ensure_equals("box behind is out", mCamera.AABBInFrustum(LLVector4a(-40.f, 0.f, 30.f), LLVector4a(1.f, 1.f, 1.f)), 0);
+
+		for (U32 pass = 0; pass < 3; pass++)
+		{
+			if (pass == 2)
+			{
+				// With a user clip plane, as used for water reflections.
+				mCamera.setUserClipPlane(LLPlane(LLVector3(0.f, 0.f, 28.f), LLVector3(0.f, 0.f, -1.f)));
+			}
+			bool far_clip = pass != 1;
+			for (U32 round = 0; round < 200; round++)
+			{
+				LLCameraAABBBatch batch;
+				LLVector4a centers[LLCameraAABBBatch::MAX_BOXES];
+				LLVector4a radii[LLCameraAABBBatch::MAX_BOXES];
+				U32 count = 1 + round % LLCameraAABBBatch::MAX_BOXES;
+				for (U32 i = 0; i < count; i++)
+				{
+					// Many boxes near the planes, some of them exactly on one.
+					centers[i].set(random() * 400.f - 100.f, random() * 400.f - 100.f, random() * 80.f - 10.f);
+					F32 size = (round & 1) ? random() * 4.f : (F32)(next() % 8);
+					radii[i].set(size, size * random(), size);
+					batch.add(centers[i], radii[i]);
+				}
+				S32 results[LLCameraAABBBatch::MAX_BOXES];
+				mCamera.AABBsInFrustum(batch, results, far_clip);
+				for (U32 i = 0; i < count; i++)
+				{
+					S32 expected = far_clip ? mCamera.AABBInFrustum(centers[i], radii[i]) : mCamera.AABBInFrustumNoFarClip(centers[i], radii[i]);
+					ensure_equals("same result as the single box test", results[i], expected);
+				}
+			}
+		}
+	}
+
+	template<> template<>
+	void aabb_batch_object::test<2>()
+	{
+		// Culling a small octree along a camera path, testing the children of a node together finds
+		// exactly the nodes that testing every node on its own finds, with and without the far plane.
+		buildOctree(3);
+		const U32 FRAMES = 40;
+		std::vector<U32> scalar_visible, batched_visible;
+		for (U32 frame = 0; frame < FRAMES; frame++)
+		{
+			flyThrough(frame, FRAMES);
+			for (int far_clip = 0; far_clip < 2; far_clip++)
+			{
+				scalar_visible.clear();
+				batched_visible.clear();
+				cullScalar(0, 0, far_clip, scalar_visible);
+				cullBatched(0, check(0, far_clip), far_clip, batched_visible);
+				ensure("same visible nodes", scalar_visible == batched_visible);
+			}
+		}
+	}
+
+	template<> template<>
+	void aabb_batch_object::test<3>()
+	{
+		// Benchmark: cull a synthetic octree along a scripted camera path, once testing every node on its own
+		// and once testing the children of a node together.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		buildOctree(5);
+		const U32 FRAMES = 300;
+		std::vector<U32> scalar_visible, batched_visible;
+		F64 scalar_time = 0.0, batched_time = 0.0;
+		U32 visible_total = 0;
+		for (U32 frame = 0; frame < FRAMES; frame++)
+		{
+			flyThrough(frame, FRAMES);
+			bool far_clip = frame & 1;
+
+			scalar_visible.clear();
+			batched_visible.clear();
+			LLTimer timer;
+			cullScalar(0, 0, far_clip, scalar_visible);
+			scalar_time += timer.getElapsedTimeF64();
+			timer.reset();
+			cullBatched(0, check(0, far_clip), far_clip, batched_visible);
+			batched_time += timer.getElapsedTimeF64();
+
+			visible_total += scalar_visible.size();
+		}
+		llinfos << "Culling " << mNodes.size() << " nodes (" << visible_total / FRAMES << " visible) took "
+				<< scalar_time * 1000000.0 / FRAMES << " us per frame testing one box at a time, "
+				<< batched_time * 1000000.0 / FRAMES << " us per frame testing the children of a node together." << llendl;
+	}
+}
@@ -0,0 +1,285 @@
+/**
+ * @file llcharacter_tut.cpp
+ * @brief Tests and benchmark of preparing character motions on a thread pool.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llcharacter.h"
+#include "llformat.h"
+#include "llframetimer.h"
+#include "llkeyframemotion.h"
+#include "llstl.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	static const U32 NUM_JOINTS = 40;
+	static const U32 NUM_KEYS = 60;
+	static const U32 NUM_CHARACTERS = 64;
+	static const U32 NUM_FRAMES = 50;
+
+	// A headless character: just a chain of joints, no meshes and no world.
+	class LLTestCharacter : public LLCharacter
+	{
+	public:
+		LLTestCharacter()
+		{
+			mID.generate();
+			for (U32 i = 0; i < NUM_JOINTS; ++i)
+			{
+				mJoints.push_back(new LLJoint(i == 0 ? std::string("mPelvis") : llformat("mJoint%d", i), i == 0 ? NULL : mJoints.back()));
+			}
+		}
+
+		/*virtual*/ ~LLTestCharacter()
+		{
+			deactivateAllMotions();
+			flushAllMotions();
+			for_each(mJoints.begin(), mJoints.end(), DeletePointer());
+		}
+
+		/*virtual*/ const char* getAnimationPrefix() { return "avatar"; }
+		/*virtual*/ LLJoint* getRootJoint() { return mJoints[0]; }
+		/*virtual*/ LLVector3 getCharacterPosition() { return LLVector3::zero; }
+		/*virtual*/ LLQuaternion getCharacterRotation() { return LLQuaternion::DEFAULT; }
+		/*virtual*/ LLVector3 getCharacterVelocity() { return LLVector3::zero; }
+		/*virtual*/ LLVector3 getCharacterAngularVelocity() { return LLVector3::zero; }
+		/*virtual*/ void getGround(const LLVector3& inPos, LLVector3& outPos, LLVector3& outNorm) { outPos = inPos; outNorm = LLVector3::z_axis; }
+		/*virtual*/ LLJoint* getCharacterJoint(U32 i) { return i < mJoints.size() ? mJoints[i] : NULL; }
+		/*virtual*/ F32 getTimeDilation() { return 1.f; }
+		/*virtual*/ F32 getPixelArea() const { return 10000.f; }
+		/*virtual*/ LLPolyMesh* getHeadMesh() { return NULL; }
+		/*virtual*/ LLPolyMesh* getUpperBodyMesh() { return NULL; }
+		/*virtual*/ LLVector3d getPosGlobalFromAgent(const LLVector3& position) { return LLVector3d(position); }
+		/*virtual*/ LLVector3 getPosAgentFromGlobal(const LLVector3d& position) { return LLVector3(position); }
+		/*virtual*/ void addDebugText(const std::string& text) { }
+		/*virtual*/ const LLUUID& getID() const { return mID; }
+
+		std::vector<LLJoint*> mJoints;
+
+	private:
+		LLUUID mID;
+	};
+
+	struct character_data
+	{
+		LLUUID mAnimID;
+		LLKeyframeMotion::JointMotionListPtr mJointMotionList;	// Keeps the cache entry alive.
+
+		character_data()
+		{
+			// Put a looping animation that moves every joint in the keyframe cache,
+			// so that LLKeyframeMotion::onInitialize doesn't need the VFS or asset storage.
+			mAnimID.generate();
+			mJointMotionList = LLKeyframeDataCache::createKeyframeData(mAnimID);
+			mJointMotionList->mDuration = 2.f;
+			mJointMotionList->mLoop = TRUE;
+			mJointMotionList->mLoopInPoint = 0.f;
+			mJointMotionList->mLoopOutPoint = 2.f;
+			mJointMotionList->mBasePriority = LLJoint::MEDIUM_PRIORITY;
+			mJointMotionList->mMaxPriority = LLJoint::MEDIUM_PRIORITY;
+			for (U32 i = 0; i < NUM_JOINTS; ++i)
+			{
+				LLKeyframeMotion::JointMotion* joint_motion = new LLKeyframeMotion::JointMotion;
+				joint_motion->mJointName = i == 0 ? std::string("mPelvis") : llformat("mJoint%d", i);
+				joint_motion->mPriority = LLJoint::USE_MOTION_PRIORITY;
+				joint_motion->mUsage = LLJointState::ROT | LLJointState::POS;
+				joint_motion->mRotationCurve.mInterpolationType = LLKeyframeMotion::IT_LINEAR;
+				joint_motion->mPositionCurve.mInterpolationType = LLKeyframeMotion::IT_LINEAR;
+				joint_motion->mRotationCurve.mNumKeys = NUM_KEYS;
+				joint_motion->mPositionCurve.mNumKeys = NUM_KEYS;
+				for (U32 k = 0; k < NUM_KEYS; ++k)
+				{
+					F32 t = 2.f * k / (NUM_KEYS - 1);
+					LLQuaternion rot(t * F_PI + i * 0.1f, LLVector3(1.f, (F32)i, 0.5f));
+					joint_motion->mRotationCurve.addKey(LLKeyframeMotion::RotationKey(t, rot));
+					joint_motion->mPositionCurve.addKey(LLKeyframeMotion::PositionKey(t, LLVector3(sinf(t + i), cosf(t), 0.1f * i)));
+				}
+				mJointMotionList->mJointMotionArray.push_back(joint_motion);
+			}
+		}
+
+		void createCharacters(std::vector<LLCharacter*>& characters, U32 count)
+		{
+			for (U32 i = 0; i < count; ++i)
+			{
+				LLCharacter* character = new LLTestCharacter;
+				// Start at different offsets, so that not every character evaluates the same keys.
+				character->startMotion(mAnimID, 0.03f * i);
+				characters.push_back(character);
+			}
+		}
+
+		static void updateCharacters(std::vector<LLCharacter*>& characters)
+		{
+			for (std::vector<LLCharacter*>::iterator iter = characters.begin(); iter != characters.end(); ++iter)
+			{
+				(*iter)->updateMotions(LLCharacter::NORMAL_UPDATE);
+			}
+		}
+
+		static bool samePose(LLCharacter* a, LLCharacter* b)
+		{
+			std::vector<LLJoint*>& ja = static_cast<LLTestCharacter*>(a)->mJoints;
+			std::vector<LLJoint*>& jb = static_cast<LLTestCharacter*>(b)->mJoints;
+			for (U32 i = 0; i < NUM_JOINTS; ++i)
+			{
+				if (ja[i]->getRotation() != jb[i]->getRotation() || ja[i]->getPosition() != jb[i]->getPosition())
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static void deleteCharacters(std::vector<LLCharacter*>& characters)
+		{
+			for_each(characters.begin(), characters.end(), DeletePointer());
+			characters.clear();
+		}
+	};
+	typedef test_group<character_data> character_test;
+	typedef character_test::object character_object;
+	tut::character_test character_testcase("character");
+
+	template<> template<>
+	void character_object::test<1>()
+	{
+		// Preparing the motions on a pool gives the same poses as the plain serial update.
+		// Both sets are created in the same frame, so their motion controller timers agree.
+		std::vector<LLCharacter*> serial;
+		std::vector<LLCharacter*> parallel;
+		LLFrameTimer::updateFrameTime();
+		createCharacters(serial, 8);
+		createCharacters(parallel, 8);
+
+		LLThreadPool pool("character test", 3);
+		for (U32 frame = 0; frame < 10; ++frame)
+		{
+			ms_sleep(5);
+			LLFrameTimer::updateFrameTime();
+			LLCharacter::prepareMotions(parallel, &pool);
+			updateCharacters(parallel);
+			updateCharacters(serial);
+			for (U32 i = 0; i < serial.size(); ++i)
+			{
+				ensure("prepared motions give the same pose", samePose(serial[i], parallel[i]));
+			}
+		}
+
+		deleteCharacters(serial);
+		deleteCharacters(parallel);
+	}
+
+	// Looks up an animation in the keyframe cache over and over again.
+	class LLCacheReaderJob : public LLThreadPool::Job
+	{
+	public:
+		LLCacheReaderJob(LLUUID const& id, LLAtomicS32& found) : mID(id), mFound(found) { }
+
+		/*virtual*/ void run(void)
+		{
+			for (S32 i = 0; i < 1000; ++i)
+			{
+				LLKeyframeMotion::JointMotionListPtr list = LLKeyframeDataCache::getKeyframeData(mID);
+				if (list && list->getNumJointMotions() == NUM_JOINTS)
+				{
+					mFound++;
+				}
+			}
+		}
+
+	private:
+		LLUUID mID;
+		LLAtomicS32& mFound;
+	};
+
+	template<> template<>
+	void character_object::test<2>()
+	{
+		// Concurrent readers of the keyframe cache all get the same entry, and
+		// don't corrupt its reference count.
+		LLAtomicS32 found(0);
+		{
+			LLThreadPool pool("keyframe cache test", 4);
+			LLThreadPool::Group group;
+			for (S32 i = 0; i < 16; ++i)
+			{
+				pool.post(new LLCacheReaderJob(mAnimID, found), &group);
+			}
+			group.wait();
+		}
+		ensure_equals("every lookup found the cached keyframe data", (S32)found, 16 * 1000);
+
+		mJointMotionList = LLKeyframeMotion::JointMotionListPtr();
+		ensure("the cache entry is removed with its last reference", !LLKeyframeDataCache::getKeyframeData(mAnimID));
+	}
+
+	template<> template<>
+	void character_object::test<3>()
+	{
+		// Benchmark: animate NUM_CHARACTERS synthetic characters serially, and with the
+		// keyframe curves evaluated on a pool with one thread per core.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		std::vector<LLCharacter*> serial;
+		std::vector<LLCharacter*> parallel;
+		LLFrameTimer::updateFrameTime();
+		createCharacters(serial, NUM_CHARACTERS);
+		createCharacters(parallel, NUM_CHARACTERS);
+
+		LLThreadPool pool("character benchmark");
+		LLTimer timer;
+		F64 serial_time = 0.0;
+		F64 parallel_time = 0.0;
+		for (U32 frame = 0; frame < NUM_FRAMES; ++frame)
+		{
+			ms_sleep(1);
+			LLFrameTimer::updateFrameTime();
+
+			timer.reset();
+			LLCharacter::prepareMotions(parallel, &pool);
+			updateCharacters(parallel);
+			parallel_time += timer.getElapsedTimeF64();
+
+			timer.reset();
+			updateCharacters(serial);
+			serial_time += timer.getElapsedTimeF64();
+		}
+		ensure("benchmark poses match", samePose(serial.back(), parallel.back()));
+
+		llinfos << NUM_CHARACTERS << " characters, " << NUM_FRAMES << " frames: serial " << serial_time * 1000.0
+				<< " ms, prepared on " << pool.getThreadCount() << " threads " << parallel_time * 1000.0
+				<< " ms, " << pool.getStealCount() << " steals." << llendl;
+
+		deleteCharacters(serial);
+		deleteCharacters(parallel);
+	}
+}
@@ -0,0 +1,223 @@
+/**
+ * @file llconcurrentstringtable_tut.cpp
+ * @brief Tests of LLConcurrentStringTable, and a contention benchmark against a locked LLStringTable.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llconcurrentstringtable.h"
+#include "llstringtable.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	static U32 const NUM_NAMES = 2000;
+	static U32 const NUM_JOBS = 8;
+
+	// Interns all names, in an order that depends on seed, and records the results.
+	class LLInternJob : public LLThreadPool::Job
+	{
+	public:
+		LLInternJob(LLConcurrentStringTable& table, std::vector<std::string> const& names, U32 seed, std::vector<char const*>& results) :
+			mTable(table), mNames(names), mSeed(seed), mResults(results) { }
+
+		/*virtual*/ void run(void)
+		{
+			mResults.resize(mNames.size());
+			for (U32 i = 0; i < mNames.size(); ++i)
+			{
+				U32 index = (i * 7919 + mSeed * 104729) % mNames.size();
+				mResults[index] = mTable.insert(mNames[index]);
+			}
+		}
+
+	private:
+		LLConcurrentStringTable& mTable;
+		std::vector<std::string> const& mNames;
+		U32 mSeed;
+		std::vector<char const*>& mResults;
+	};
+
+	// Looks up names over and over, in the concurrent table, or in an LLStringTable under a mutex.
+	class LLLookupJob : public LLThreadPool::Job
+	{
+	public:
+		LLLookupJob(LLConcurrentStringTable* table, LLStringTable* locked_table, LLMutex* mutex, std::vector<std::string> const& names, LLAtomicU32& found) :
+			mTable(table), mLockedTable(locked_table), mMutex(mutex), mNames(names), mFound(found) { }
+
+		/*virtual*/ void run(void)
+		{
+			U32 found = 0;
+			for (U32 round = 0; round < 200; ++round)
+			{
+				for (U32 i = 0; i < mNames.size(); ++i)
+				{
+					if (mTable)
+					{
+						found += mTable->find(mNames[i].c_str()) != NULL;
+					}
+					else
+					{
+						LLMutexLock lock(mMutex);
+						found += mLockedTable->checkString(mNames[i].c_str()) != NULL;
+					}
+				}
+			}
+			mFound += found;
+		}
+
+	private:
+		LLConcurrentStringTable* mTable;
+		LLStringTable* mLockedTable;
+		LLMutex* mMutex;
+		std::vector<std::string> const& mNames;
+		LLAtomicU32& mFound;
+	};
+
+	struct concurrentstringtable_data
+	{
+		std::vector<std::string> mNames;
+
+		concurrentstringtable_data()
+		{
+			// Names like the ones of the message template.
+			for (U32 i = 0; i < NUM_NAMES; ++i)
+			{
+				mNames.push_back(llformat("Block%uData%u", i % 37, i));
+			}
+		}
+	};
+	typedef test_group<concurrentstringtable_data> concurrentstringtable_test;
+	typedef concurrentstringtable_test::object concurrentstringtable_object;
+	tut::concurrentstringtable_test concurrentstringtable_testcase("concurrentstringtable");
+
+	template<> template<>
+	void concurrentstringtable_object::test<1>()
+	{
+		// Equal strings give the same pointer, also after the table grew a few times.
+		LLConcurrentStringTable table(16, 64);
+		std::vector<char const*> interned;
+		for (U32 i = 0; i < mNames.size(); ++i)
+		{
+			ensure("not found before it is inserted", table.find(mNames[i]) == NULL);
+			interned.push_back(table.insert(mNames[i]));
+			ensure_equals("copy is equal", std::string(interned.back()), mNames[i]);
+		}
+		ensure_equals("size", table.size(), NUM_NAMES);
+		for (U32 i = 0; i < mNames.size(); ++i)
+		{
+			ensure("find returns the interned copy", table.find(mNames[i]) == interned[i]);
+			ensure("insert returns the interned copy", table.insert(std::string(mNames[i])) == interned[i]);
+		}
+		ensure_equals("size after inserting again", table.size(), NUM_NAMES);
+		std::vector<char const*> strings;
+		table.getStrings(strings);
+		ensure_equals("getStrings returns every string", (U32)strings.size(), NUM_NAMES);
+
+		// Long strings are truncated, and strings equal after truncation are the same.
+		std::string long_name(100, 'x');
+		char const* truncated = table.insert(long_name);
+		ensure_equals("truncated length", (U32)strlen(truncated), 63U);
+		ensure("equal after truncation", table.insert(long_name + "y") == truncated);
+		ensure("truncated string can be found", table.find(std::string(63, 'x')) == truncated);
+	}
+
+	template<> template<>
+	void concurrentstringtable_object::test<2>()
+	{
+		// Threads that intern the same strings at the same time, in different orders, all get the same copies.
+		LLConcurrentStringTable table(16, 64);
+		std::vector<std::vector<char const*> > results(NUM_JOBS);
+		{
+			LLThreadPool pool("string table test", 4);
+			LLThreadPool::Group group;
+			for (U32 i = 0; i < NUM_JOBS; ++i)
+			{
+				pool.post(new LLInternJob(table, mNames, i, results[i]), &group);
+			}
+			group.wait();
+		}
+		ensure_equals("size", table.size(), NUM_NAMES);
+		for (U32 i = 0; i < NUM_NAMES; ++i)
+		{
+			ensure_equals("interned copy", std::string(results[0][i]), mNames[i]);
+			for (U32 j = 1; j < NUM_JOBS; ++j)
+			{
+				ensure("every thread got the same copy", results[j][i] == results[0][i]);
+			}
+		}
+	}
+
+	template<> template<>
+	void concurrentstringtable_object::test<3>()
+	{
+		// Benchmark: threads looking up known names, like prehashed message names are,
+		// in LLConcurrentStringTable, and in an LLStringTable protected by a mutex.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		LLConcurrentStringTable table(8192, 64);
+		LLStringTable locked_table(8192);
+		LLMutex mutex;
+		for (U32 i = 0; i < mNames.size(); ++i)
+		{
+			table.insert(mNames[i]);
+			locked_table.addString(mNames[i]);
+		}
+
+		LLThreadPool pool("string table benchmark", 4);
+		LLTimer timer;
+		LLAtomicU32 found(0);
+		{
+			LLThreadPool::Group group;
+			for (U32 i = 0; i < NUM_JOBS; ++i)
+			{
+				pool.post(new LLLookupJob(&table, NULL, NULL, mNames, found), &group);
+			}
+			group.wait();
+		}
+		F64 concurrent_time = timer.getElapsedTimeF64();
+		ensure_equals("all names found in the concurrent table", (U32)found, NUM_JOBS * 200 * NUM_NAMES);
+
+		found = 0;
+		timer.reset();
+		{
+			LLThreadPool::Group group;
+			for (U32 i = 0; i < NUM_JOBS; ++i)
+			{
+				pool.post(new LLLookupJob(NULL, &locked_table, &mutex, mNames, found), &group);
+			}
+			group.wait();
+		}
+		F64 locked_time = timer.getElapsedTimeF64();
+		ensure_equals("all names found in the locked table", (U32)found, NUM_JOBS * 200 * NUM_NAMES);
+
+		llinfos << NUM_JOBS * 200 * NUM_NAMES << " lookups on " << pool.getThreadCount() << " threads: LLConcurrentStringTable took "
+				<< concurrent_time * 1000.0 << " ms, locked LLStringTable took " << locked_time * 1000.0 << " ms." << llendl;
+	}
+}
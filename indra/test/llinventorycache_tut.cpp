@@ -0,0 +1,291 @@
+/**
+ * @file llinventorycache_tut.cpp
+ * @brief Tests of the binary inventory cache, and a load benchmark against the text format.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <sstream>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llinventorycache.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+
+// Defined in inventory.cpp.
+LLPointer<LLInventoryItem> create_random_inventory_item();
+LLPointer<LLInventoryCategory> create_random_inventory_cat();
+
+namespace tut
+{
+	static U32 const CONTENT_VERSION = 7;
+
+	struct inventorycache_data
+	{
+		std::string mFilename;
+		LLInventoryCacheParser::cat_list_t mCategories;
+		LLInventoryCacheParser::item_list_t mItems;
+
+		inventorycache_data() : mFilename(std::string(LLFile::tmpdir()) + "llinventorycache_tut.invbin") { }
+		~inventorycache_data() { LLFile::remove_nowarn(mFilename); }
+
+		// num_categories categories, with items_per_category items each.
+		void createInventory(U32 num_categories, U32 items_per_category)
+		{
+			for (U32 i = 0; i < num_categories; ++i)
+			{
+				LLPointer<LLInventoryCategory> cat = create_random_inventory_cat();
+				cat->rename(llformat("Folder %u", i));
+				mCategories.push_back(cat);
+				for (U32 j = 0; j < items_per_category; ++j)
+				{
+					LLPointer<LLInventoryItem> item = create_random_inventory_item();
+					item->setParent(cat->getUUID());
+					item->rename(llformat("Item %u of folder %u", j, i));
+					mItems.push_back(item);
+				}
+			}
+		}
+
+		std::vector<LLInventoryItem const*> itemsOf(U32 category) const
+		{
+			std::vector<LLInventoryItem const*> items;
+			for (U32 i = 0; i < mItems.size(); ++i)
+			{
+				if (mItems[i]->getParentUUID() == mCategories[category]->getUUID())
+				{
+					items.push_back(mItems[i]);
+				}
+			}
+			return items;
+		}
+
+		void writeCache(void)
+		{
+			LLInventoryCacheWriter writer;
+			ensure("open writer", writer.open(mFilename, CONTENT_VERSION));
+			for (U32 i = 0; i < mCategories.size(); ++i)
+			{
+				ensure("add record", writer.addRecord(*mCategories[i], i, itemsOf(i)));
+			}
+			ensure("commit", writer.commit());
+		}
+
+		template<class T>
+		static std::string legacy(T const& object)
+		{
+			std::ostringstream str;
+			object.exportLegacyStream(str);
+			return str.str();
+		}
+	};
+	typedef test_group<inventorycache_data> inventorycache_test;
+	typedef inventorycache_test::object inventorycache_object;
+	tut::inventorycache_test inventorycache_testcase("inventorycache");
+
+	template<> template<>
+	void inventorycache_object::test<1>()
+	{
+		// What is written is read back, also when the records are parsed on several threads.
+		createInventory(20, 10);
+		writeCache();
+
+		LLInventoryCacheReader reader;
+		ensure_equals("open reader", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+		ensure_equals("number of records", reader.getNumEntries(), (U32)mCategories.size());
+		LLInventoryCacheEntry const* entry = reader.find(mCategories[3]->getUUID());
+		ensure("find record", entry && entry->mVersion == 3 && entry->mNumItems == 10);
+
+		LLThreadPool pool("inventory cache test", 4);
+		LLInventoryCacheParser parser;
+		for (int threaded = 0; threaded < 2; ++threaded)
+		{
+			LLInventoryCacheParser::cat_list_t categories;
+			LLInventoryCacheParser::item_list_t items;
+			ensure_equals("no invalid records", parser.parse(reader, threaded ? &pool : NULL, categories, items), 0U);
+			ensure_equals("number of categories", categories.size(), mCategories.size());
+			ensure_equals("number of items", items.size(), mItems.size());
+			for (U32 i = 0; i < categories.size(); ++i)
+			{
+				ensure_equals("category", legacy(*categories[i]), legacy(*mCategories[i]));
+			}
+			for (U32 i = 0; i < items.size(); ++i)
+			{
+				ensure_equals("item", legacy(*items[i]), legacy(*mItems[i]));
+			}
+		}
+	}
+
+	template<> template<>
+	void inventorycache_object::test<2>()
+	{
+		// Saving again with a changed category copies the other records from the old file.
+		createInventory(5, 4);
+		writeCache();
+		mCategories[2]->rename("Renamed");
+		{
+			LLInventoryCacheReader previous;
+			ensure_equals("open previous", previous.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+			LLInventoryCacheWriter writer;
+			ensure("open writer", writer.open(mFilename, CONTENT_VERSION));
+			for (U32 i = 0; i < mCategories.size(); ++i)
+			{
+				if (i == 2)
+				{
+					ensure("add record", writer.addRecord(*mCategories[i], i, itemsOf(i)));
+				}
+				else
+				{
+					ensure("copy record", writer.copyRecord(previous, *previous.find(mCategories[i]->getUUID())));
+				}
+			}
+			previous.close();
+			ensure("commit", writer.commit());
+		}
+
+		LLInventoryCacheReader reader;
+		ensure_equals("open reader", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+		LLInventoryCacheParser::cat_list_t categories;
+		LLInventoryCacheParser::item_list_t items;
+		ensure_equals("no invalid records", LLInventoryCacheParser().parse(reader, NULL, categories, items), 0U);
+		ensure_equals("renamed category", categories[2]->getName(), std::string("Renamed"));
+		for (U32 i = 0; i < items.size(); ++i)
+		{
+			ensure_equals("item", legacy(*items[i]), legacy(*mItems[i]));
+		}
+	}
+
+	template<> template<>
+	void inventorycache_object::test<3>()
+	{
+		// Files that can't be used are recognized as such.
+		LLInventoryCacheReader reader;
+		LLFile::remove_nowarn(mFilename);
+		ensure_equals("missing file", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::NOT_FOUND);
+
+		createInventory(3, 3);
+		writeCache();
+		ensure_equals("other content version", reader.open(mFilename, CONTENT_VERSION + 1), LLInventoryCacheReader::OBSOLETE);
+
+		std::vector<char> data(100000);
+		LLFILE* fp = LLFile::fopen(mFilename, "rb");
+		size_t size = fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+
+		// Damage the first record so that its strings don't end within the record. Only that record is invalid.
+		ensure_equals("open reader", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+		LLInventoryCacheEntry first = reader.getEntry(0);
+		reader.close();
+		std::vector<char> damaged(data.begin(), data.begin() + size);
+		memset(&damaged[first.mOffset], 'x', first.mSize);
+		fp = LLFile::fopen(mFilename, "wb");
+		fwrite(&damaged[0], 1, size, fp);
+		fclose(fp);
+		ensure_equals("damaged record", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+		LLInventoryCacheParser::cat_list_t categories;
+		LLInventoryCacheParser::item_list_t items;
+		ensure_equals("one invalid record", LLInventoryCacheParser().parse(reader, NULL, categories, items), 1U);
+		ensure_equals("other categories", categories.size(), (size_t)2);
+		ensure_equals("other items", items.size(), (size_t)6);
+		reader.close();
+
+		// Truncate it.
+		fp = LLFile::fopen(mFilename, "wb");
+		fwrite(&data[0], 1, size - 10, fp);
+		fclose(fp);
+		ensure_equals("truncated file", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::CORRUPT);
+
+		// The text cache of older viewers.
+		fp = LLFile::fopen(mFilename, "wb");
+		fputs("\tinv_cache_version\t2\n", fp);
+		fclose(fp);
+		ensure_equals("text cache", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OBSOLETE);
+	}
+
+	template<> template<>
+	void inventorycache_object::test<4>()
+	{
+		// Benchmark: load an inventory of 200,000 items in 4,000 folders from the binary
+		// cache, and parse the same inventory in the text format of the old cache.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		U32 const num_categories = 4000;
+		U32 const items_per_category = 50;
+		createInventory(num_categories, items_per_category);
+		writeCache();
+
+		LLThreadPool pool("inventory cache benchmark");
+		LLTimer timer;
+		LLInventoryCacheReader reader;
+		ensure_equals("open reader", reader.open(mFilename, CONTENT_VERSION), LLInventoryCacheReader::OK);
+		LLInventoryCacheParser::cat_list_t categories;
+		LLInventoryCacheParser::item_list_t items;
+		LLInventoryCacheParser().parse(reader, &pool, categories, items);
+		F64 binary_time = timer.getElapsedTimeF64();
+		ensure_equals("binary items", (U32)items.size(), num_categories * items_per_category);
+
+		std::ostringstream text;
+		for (U32 i = 0; i < mCategories.size(); ++i)
+		{
+			mCategories[i]->exportLegacyStream(text);
+		}
+		for (U32 i = 0; i < mItems.size(); ++i)
+		{
+			mItems[i]->exportLegacyStream(text);
+		}
+		std::istringstream input(text.str());
+		timer.reset();
+		categories.clear();
+		items.clear();
+		char buffer[MAX_STRING];
+		char keyword[MAX_STRING];
+		while (input.getline(buffer, MAX_STRING))
+		{
+			if (sscanf(buffer, " %254s", keyword) < 1)
+			{
+				continue;
+			}
+			if (!strcmp(keyword, "inv_category"))
+			{
+				LLPointer<LLInventoryCategory> cat = new LLInventoryCategory;
+				cat->importLegacyStream(input);
+				categories.push_back(cat);
+			}
+			else if (!strcmp(keyword, "inv_item"))
+			{
+				LLPointer<LLInventoryItem> item = new LLInventoryItem;
+				item->importLegacyStream(input);
+				items.push_back(item);
+			}
+		}
+		F64 text_time = timer.getElapsedTimeF64();
+		ensure_equals("text items", (U32)items.size(), num_categories * items_per_category);
+
+		llinfos << items.size() << " items in " << categories.size() << " folders: binary cache (" << pool.getThreadCount()
+				<< " threads) took " << binary_time * 1000.0 << " ms, text format took " << text_time * 1000.0 << " ms." << llendl;
+	}
+}
@@ -0,0 +1,220 @@
+/**
+ * @file llkeyframemotion_tut.cpp
+ * @brief Tests and benchmark of the LLKeyframeMotion curves.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llkeyframemotion.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	static const F32 DURATION = 4.f;
+
+	struct keyframemotion_data
+	{
+		typedef std::map<F32, LLQuaternion> rotation_map_t;
+		typedef std::map<F32, LLVector3> position_map_t;
+
+		U32 mSeed;
+
+		keyframemotion_data() : mSeed(4321) { }
+
+		// Deterministic, so that failures are reproducible.
+		F32 random()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (F32)((mSeed >> 16) & 0x7fff) / 32768.f;
+		}
+
+		// Fill both curves with the same num_keys random keys, added in random order.
+		void makeCurves(U32 num_keys, LLKeyframeMotion::RotationCurve& rot_curve, rotation_map_t& rot_map,
+						LLKeyframeMotion::PositionCurve& pos_curve, position_map_t& pos_map)
+		{
+			for (U32 k = 0; k < num_keys; ++k)
+			{
+				// Quantized like the times in an animation asset, so that some keys have the same time.
+				F32 t = floorf(random() * 200.f) * DURATION / 200.f;
+				LLQuaternion rot(random() * F_TWO_PI, LLVector3(random() - 0.5f, random() - 0.5f, random() + 0.1f));
+				LLVector3 pos(random() - 0.5f, random() - 0.5f, random() - 0.5f);
+				rot_curve.addKey(LLKeyframeMotion::RotationKey(t, rot));
+				pos_curve.addKey(LLKeyframeMotion::PositionKey(t, pos));
+				rot_map[t] = rot;
+				pos_map[t] = pos;
+			}
+			rot_curve.mNumKeys = num_keys;
+			pos_curve.mNumKeys = num_keys;
+		}
+
+		// The curve evaluation as it was done with keys in a std::map and scalar math.
+		static LLQuaternion mapValue(rotation_map_t& keys, F32 time)
+		{
+			rotation_map_t::iterator right = keys.lower_bound(time);
+			if (right == keys.end())
+			{
+				return (--right)->second;
+			}
+			if (right == keys.begin() || right->first == time)
+			{
+				return right->second;
+			}
+			rotation_map_t::iterator left = right; --left;
+			F32 u = (time - left->first) / (right->first - left->first);
+			return nlerp(u, left->second, right->second);
+		}
+
+		static LLVector3 mapValue(position_map_t& keys, F32 time)
+		{
+			position_map_t::iterator right = keys.lower_bound(time);
+			if (right == keys.end())
+			{
+				return (--right)->second;
+			}
+			if (right == keys.begin() || right->first == time)
+			{
+				return right->second;
+			}
+			position_map_t::iterator left = right; --left;
+			F32 u = (time - left->first) / (right->first - left->first);
+			return lerp(left->second, right->second, u);
+		}
+
+		static bool similar(const LLQuaternion& a, const LLQuaternion& b)
+		{
+			return fabsf(dot(a, b)) > 0.99999f;
+		}
+	};
+	typedef test_group<keyframemotion_data> keyframemotion_test;
+	typedef keyframemotion_test::object keyframemotion_object;
+	tut::keyframemotion_test keyframemotion_testcase("keyframemotion");
+
+	template<> template<>
+	void keyframemotion_object::test<1>()
+	{
+		// Keys end up sorted and unique, with the last value added for each time.
+		LLKeyframeMotion::RotationCurve rot_curve;
+		LLKeyframeMotion::PositionCurve pos_curve;
+		rotation_map_t rot_map;
+		position_map_t pos_map;
+		makeCurves(300, rot_curve, rot_map, pos_curve, pos_map);
+
+		ensure_equals("one rotation time per key", rot_curve.mTimes.size(), rot_curve.mRotations.size());
+		ensure_equals("duplicate times are merged", rot_curve.mTimes.size(), rot_map.size());
+		U32 k = 0;
+		for (position_map_t::iterator iter = pos_map.begin(); iter != pos_map.end(); ++iter, ++k)
+		{
+			ensure("position keys are sorted", pos_curve.mTimes[k] == iter->first);
+			ensure("last added key wins", pos_curve.mPositions[k] == iter->second);
+		}
+	}
+
+	template<> template<>
+	void keyframemotion_object::test<2>()
+	{
+		// The curves give the same values as the std::map based evaluation, both
+		// with a cursor while playing (forward, and looping back) and without one.
+		LLKeyframeMotion::RotationCurve rot_curve;
+		LLKeyframeMotion::PositionCurve pos_curve;
+		rotation_map_t rot_map;
+		position_map_t pos_map;
+		makeCurves(60, rot_curve, rot_map, pos_curve, pos_map);
+
+		U32 rot_cursor = 0;
+		U32 pos_cursor = 0;
+		for (F32 t = -0.1f; t < 3.f * DURATION; t += 0.0173f)
+		{
+			// Loop, like LLKeyframeMotion does, but start a little before the first key.
+			F32 time = t < DURATION ? t : fmodf(t, DURATION);
+			LLQuaternion rot = rot_curve.getValue(time, DURATION, rot_cursor);
+			LLVector3 pos = pos_curve.getValue(time, DURATION, pos_cursor);
+			ensure("rotation with cursor", similar(rot, mapValue(rot_map, time)));
+			ensure("position with cursor", dist_vec(pos, mapValue(pos_map, time)) < 0.00001f);
+			ensure("rotation without cursor", similar(rot_curve.getValue(time, DURATION), mapValue(rot_map, time)));
+		}
+
+		// Exactly on the keys.
+		for (rotation_map_t::iterator iter = rot_map.begin(); iter != rot_map.end(); ++iter)
+		{
+			ensure("rotation on a key", rot_curve.getValue(iter->first, DURATION, rot_cursor) == iter->second);
+		}
+
+		LLKeyframeMotion::RotationCurve empty;
+		ensure("empty curve", empty.getValue(1.f, DURATION, rot_cursor) == LLQuaternion::DEFAULT);
+	}
+
+	template<> template<>
+	void keyframemotion_object::test<3>()
+	{
+		// Benchmark: 4000 rotation and position curves (about a hundred avatars
+		// playing a few animations each), evaluated for 100 frames at 45 fps.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		const U32 num_curves = 4000;
+		const U32 num_frames = 100;
+		std::vector<LLKeyframeMotion::RotationCurve> rot_curves(num_curves);
+		std::vector<LLKeyframeMotion::PositionCurve> pos_curves(num_curves);
+		std::vector<rotation_map_t> rot_maps(num_curves);
+		std::vector<position_map_t> pos_maps(num_curves);
+		for (U32 i = 0; i < num_curves; ++i)
+		{
+			makeCurves(100, rot_curves[i], rot_maps[i], pos_curves[i], pos_maps[i]);
+		}
+
+		std::vector<LLKeyframeMotion::CurveCursors> cursors(num_curves);
+		LLQuaternion rot_sum;
+		LLVector3 pos_sum;
+		LLTimer timer;
+		for (U32 frame = 0; frame < num_frames; ++frame)
+		{
+			F32 time = fmodf(frame / 45.f, DURATION);
+			for (U32 i = 0; i < num_curves; ++i)
+			{
+				rot_sum = rot_sum * rot_curves[i].getValue(time, DURATION, cursors[i].mRotation);
+				pos_sum += pos_curves[i].getValue(time, DURATION, cursors[i].mPosition);
+			}
+		}
+		F64 curve_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		for (U32 frame = 0; frame < num_frames; ++frame)
+		{
+			F32 time = fmodf(frame / 45.f, DURATION);
+			for (U32 i = 0; i < num_curves; ++i)
+			{
+				rot_sum = rot_sum * mapValue(rot_maps[i], time);
+				pos_sum += mapValue(pos_maps[i], time);
+			}
+		}
+		F64 map_time = timer.getElapsedTimeF64();
+
+		ensure("benchmark result is used", rot_sum.isFinite() && pos_sum.isFinite());
+		llinfos << num_curves << " curves, " << num_frames << " frames: " << curve_time * 1000.0
+				<< " ms with cursors, " << map_time * 1000.0 << " ms with std::map keys." << llendl;
+	}
+}
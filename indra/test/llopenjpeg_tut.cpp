@@ -0,0 +1,436 @@
+/**
+ * @file llopenjpeg_tut.cpp
+ * @brief Tests of parallel encoding, SIMD and progressive decoding in the bundled OpenJPEG, with benchmarks.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+#include "openjpeg.h"
+
+namespace tut
+{
+	// Like the parallel_for that llimagej2coj installs.
+	static LLThreadPool* sPool;
+
+	class LLOpenJPEGTestJob : public LLThreadPool::Job
+	{
+	public:
+		LLOpenJPEGTestJob(opj_parallel_job_fn job, void* data, int index) : mJob(job), mData(data), mIndex(index) { }
+		/*virtual*/ void run(void) { mJob(mData, mIndex); }
+
+	private:
+		opj_parallel_job_fn mJob;
+		void* mData;
+		int mIndex;
+	};
+
+	static void test_parallel_for(opj_parallel_job_fn job, void* data, int count)
+	{
+		LLThreadPool::Group group;
+		for (int index = 0; index < count; ++index)
+		{
+			sPool->post(new LLOpenJPEGTestJob(job, data, index), &group);
+		}
+		group.wait();
+	}
+
+	struct openjpeg_data
+	{
+		// An RGB image with gradients, edges and some noise, like a photo or a baked texture. Its top left
+		// corner is at (origin, origin) on the reference grid; an odd origin makes the wavelet transforms
+		// start on odd coordinates.
+		static opj_image_t* createImage(int width, int height, int origin = 0)
+		{
+			opj_image_cmptparm_t cmptparm[3];
+			memset(cmptparm, 0, sizeof(cmptparm));
+			for (int c = 0; c < 3; ++c)
+			{
+				cmptparm[c].prec = 8;
+				cmptparm[c].bpp = 8;
+				cmptparm[c].dx = 1;
+				cmptparm[c].dy = 1;
+				cmptparm[c].w = width;
+				cmptparm[c].h = height;
+				cmptparm[c].x0 = origin;
+				cmptparm[c].y0 = origin;
+			}
+			opj_image_t* image = opj_image_create(3, cmptparm, CLRSPC_SRGB);
+			image->x0 = origin;
+			image->y0 = origin;
+			image->x1 = origin + width;
+			image->y1 = origin + height;
+			U32 seed = 4321;
+			for (int i = 0; i < width * height; ++i)
+			{
+				int x = i % width;
+				int y = i / width;
+				for (int c = 0; c < 3; ++c)
+				{
+					seed = seed * 1103515245 + 12345;
+					image->comps[c].data[i] = ((x * (c + 1) + y * (3 - c)) / 4 + (x / 32 + y / 32) % 2 * 60 + (seed >> 16) % 16) & 255;
+				}
+			}
+			return image;
+		}
+
+		// Encode with the parameters of LLImageJ2COJ::encodeImpl, in tiles of tile_size if that isn't zero.
+		static std::string encode(opj_image_t* image, bool reversible, int tile_size = 0)
+		{
+			opj_cparameters_t parameters;
+			opj_set_default_encoder_parameters(&parameters);
+			parameters.cod_format = 0;
+			if (tile_size)
+			{
+				parameters.tile_size_on = true;
+				parameters.cp_tdx = tile_size;
+				parameters.cp_tdy = tile_size;
+			}
+			parameters.cp_disto_alloc = 1;
+			parameters.cp_comment = (char*)"";
+			if (reversible)
+			{
+				parameters.tcp_numlayers = 1;
+				parameters.tcp_rates[0] = 0.0f;
+			}
+			else
+			{
+				parameters.tcp_numlayers = 5;
+				parameters.tcp_rates[0] = 1920.0f;
+				parameters.tcp_rates[1] = 480.0f;
+				parameters.tcp_rates[2] = 120.0f;
+				parameters.tcp_rates[3] = 30.0f;
+				parameters.tcp_rates[4] = 10.0f;
+				parameters.irreversible = 1;
+				parameters.tcp_mct = 1;
+			}
+			opj_cinfo_t* cinfo = opj_create_compress(CODEC_J2K);
+			opj_setup_encoder(cinfo, &parameters, image);
+			opj_cio_t* cio = opj_cio_open((opj_common_ptr)cinfo, NULL, 0);
+			std::string codestream;
+			if (opj_encode(cinfo, cio, image, NULL))
+			{
+				codestream.assign((char const*)cio->buffer, cio_tell(cio));
+			}
+			opj_cio_close(cio);
+			opj_destroy_compress(cinfo);
+			return codestream;
+		}
+
+		static opj_image_t* decode(std::string const& codestream, int reduce = 0, opj_decode_cache_t* cache = NULL)
+		{
+			opj_dparameters_t parameters;
+			opj_set_default_decoder_parameters(&parameters);
+			parameters.cp_reduce = reduce;
+			parameters.decode_cache = cache;
+			opj_dinfo_t* dinfo = opj_create_decompress(CODEC_J2K);
+			opj_setup_decoder(dinfo, &parameters);
+			opj_cio_t* cio = opj_cio_open((opj_common_ptr)dinfo, (unsigned char*)codestream.data(), (int)codestream.size());
+			opj_image_t* image = opj_decode(dinfo, cio);
+			opj_cio_close(cio);
+			opj_destroy_decompress(dinfo);
+			return image;
+		}
+
+		// The first bytes of codestream that LLImageJ2C::calcDataSizeJ2C asks for at discard level discard
+		// of a size x size texture, with the default rate and at least FIRST_PACKET_SIZE.
+		static std::string dataForDiscard(std::string const& codestream, int size, int discard)
+		{
+			int length = llclamp((size >> discard) * (size >> discard) * 3 / 8, 600, (int)codestream.size());
+			return std::string(codestream, 0, discard ? length : codestream.size());
+		}
+
+		static bool sameImage(opj_image_t const* a, opj_image_t const* b)
+		{
+			if (!a || !b || a->numcomps != b->numcomps)
+			{
+				return false;
+			}
+			for (int c = 0; c < a->numcomps; ++c)
+			{
+				opj_image_comp_t const& comp_a(a->comps[c]);
+				opj_image_comp_t const& comp_b(b->comps[c]);
+				if (comp_a.w != comp_b.w || comp_a.h != comp_b.h || memcmp(comp_a.data, comp_b.data, comp_a.w * comp_a.h * sizeof(int)))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	typedef test_group<openjpeg_data> openjpeg_test;
+	typedef openjpeg_test::object openjpeg_object;
+	tut::openjpeg_test openjpeg_testcase("openjpeg");
+
+	template<> template<>
+	void openjpeg_object::test<1>()
+	{
+		// Encoding on a thread pool gives the same codestream, and lossless images decode to the original.
+		LLThreadPool pool("openjpeg test", 4);
+		sPool = &pool;
+		opj_image_t* image = createImage(300, 300);
+		for (int reversible = 0; reversible < 2; ++reversible)
+		{
+			opj_set_parallel_for(NULL);
+			std::string serial = encode(image, reversible);
+			opj_set_parallel_for(test_parallel_for);
+			std::string parallel = encode(image, reversible);
+			opj_set_parallel_for(NULL);
+			ensure("encoded", !serial.empty());
+			ensure("same codestream", serial == parallel);
+
+			opj_image_t* decoded = decode(parallel);
+			ensure("decoded", decoded && decoded->numcomps == 3);
+			if (reversible)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					ensure("lossless", !memcmp(decoded->comps[c].data, image->comps[c].data, 300 * 300 * sizeof(int)));
+				}
+			}
+			opj_image_destroy(decoded);
+		}
+		opj_image_destroy(image);
+	}
+
+	template<> template<>
+	void openjpeg_object::test<2>()
+	{
+		// Benchmark: encode images of 1024x1024 and 2048x2048 like texture and snapshot uploads, on the calling thread and on a pool.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		LLThreadPool pool("openjpeg benchmark");
+		sPool = &pool;
+		for (int size = 1024; size <= 2048; size *= 2)
+		{
+			opj_image_t* image = createImage(size, size);
+			LLTimer timer;
+			opj_set_parallel_for(NULL);
+			std::string serial = encode(image, false);
+			F64 serial_time = timer.getElapsedTimeF64();
+			timer.reset();
+			opj_set_parallel_for(test_parallel_for);
+			std::string parallel = encode(image, false);
+			F64 parallel_time = timer.getElapsedTimeF64();
+			opj_set_parallel_for(NULL);
+			ensure("same codestream", serial == parallel);
+			opj_image_destroy(image);
+
+			llinfos << "Encoding " << size << "x" << size << " took " << serial_time * 1000.0 << " ms on one thread, "
+					<< parallel_time * 1000.0 << " ms with " << pool.getThreadCount() << " threads." << llendl;
+		}
+	}
+
+	template<> template<>
+	void openjpeg_object::test<3>()
+	{
+		// Benchmark: decode textures like the ones in-world, lossy ones at full size and at lower
+		// discard levels and lossless sculpt maps, with the plain C and with the SSE2 wavelet and
+		// colour transforms. test<5> checks that both decode the same images.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		struct Texture
+		{
+			int mSize;
+			bool mReversible;
+			int mReduce;
+		};
+		static Texture const corpus[] = {
+			{ 64, true, 0 }, { 128, true, 0 },
+			{ 128, false, 0 }, { 256, false, 0 }, { 512, false, 0 }, { 512, false, 1 },
+			{ 1024, false, 0 }, { 1024, false, 2 }, { 1024, true, 0 }
+		};
+		int const repeats = 4;
+		F64 total_time[2] = { 0.0, 0.0 };
+		for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); ++i)
+		{
+			Texture const& texture(corpus[i]);
+			opj_image_t* image = createImage(texture.mSize, texture.mSize);
+			std::string codestream = encode(image, texture.mReversible);
+			opj_image_destroy(image);
+			ensure("encoded", !codestream.empty());
+
+			opj_image_t* decoded[2];
+			F64 time[2];
+			for (int use_simd = 0; use_simd < 2; ++use_simd)
+			{
+				opj_set_use_simd(use_simd);
+				LLTimer timer;
+				decoded[use_simd] = NULL;
+				for (int r = 0; r < repeats; ++r)
+				{
+					if (decoded[use_simd])
+					{
+						opj_image_destroy(decoded[use_simd]);
+					}
+					decoded[use_simd] = decode(codestream, texture.mReduce);
+				}
+				time[use_simd] = timer.getElapsedTimeF64() / repeats;
+				total_time[use_simd] += time[use_simd];
+				ensure("decoded", decoded[use_simd] && decoded[use_simd]->numcomps == 3);
+			}
+			opj_image_destroy(decoded[0]);
+			opj_image_destroy(decoded[1]);
+
+			llinfos << "Decoding " << texture.mSize << "x" << texture.mSize << (texture.mReversible ? " lossless" : " lossy")
+					<< " at discard level " << texture.mReduce << " took " << time[0] * 1000.0 << " ms with plain C, "
+					<< time[1] * 1000.0 << " ms with SSE2 transforms." << llendl;
+		}
+		llinfos << "Decoding the corpus took " << total_time[0] * 1000.0 << " ms with plain C, "
+				<< total_time[1] * 1000.0 << " ms with SSE2 transforms." << llendl;
+	}
+
+	template<> template<>
+	void openjpeg_object::test<4>()
+	{
+		// Benchmark: decode textures the way LLTextureFetchWorker does, at discard level 5 down to 0,
+		// each time with the amount of data that LLImageJ2C::calcDataSizeJ2C asks for, and then again
+		// at lower discard levels once all data arrived, every step from scratch and with a decode cache
+		// kept between the steps. test<6> checks that both decode the same images.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		static int const sizes[] = { 128, 512, 1024 };
+		F64 total_time[2] = { 0.0, 0.0 };
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			int const size = sizes[i];
+			opj_image_t* image = createImage(size, size);
+			std::string codestream = encode(image, false);
+			opj_image_destroy(image);
+			ensure("encoded", !codestream.empty());
+
+			for (int all_data = 0; all_data < 2; ++all_data)
+			{
+				F64 time[2] = { 0.0, 0.0 };
+				opj_decode_cache_t* cache = opj_create_decode_cache();
+				for (int discard = 5; discard >= 0; --discard)
+				{
+					std::string data = all_data ? codestream : dataForDiscard(codestream, size, discard);
+					for (int cached = 0; cached < 2; ++cached)
+					{
+						LLTimer timer;
+						opj_image_t* decoded = decode(data, discard, cached ? cache : NULL);
+						time[cached] += timer.getElapsedTimeF64();
+						ensure("decoded", decoded && decoded->numcomps == 3);
+						opj_image_destroy(decoded);
+					}
+				}
+				opj_destroy_decode_cache(cache);
+				total_time[0] += time[0];
+				total_time[1] += time[1];
+
+				llinfos << "Decoding " << size << "x" << size << (all_data ? " with all data" : " as it arrives")
+						<< " at discard levels 5 to 0 took " << time[0] * 1000.0 << " ms from scratch, "
+						<< time[1] * 1000.0 << " ms with a decode cache." << llendl;
+			}
+		}
+		llinfos << "Progressive decoding took " << total_time[0] * 1000.0 << " ms from scratch, "
+				<< total_time[1] * 1000.0 << " ms with a decode cache." << llendl;
+	}
+
+	template<> template<>
+	void openjpeg_object::test<5>()
+	{
+		// The SSE2 wavelet and colour transforms decode exactly the same images as the plain C ones,
+		// lossy and lossless, with rows and columns left over after the groups of four, and with tiles
+		// and resolution levels that start on odd coordinates.
+		struct Texture
+		{
+			int mWidth;
+			int mHeight;
+			int mOrigin;
+			int mTileSize;
+		};
+		static Texture const textures[] = {
+			{ 128, 128, 0, 0 }, { 61, 37, 0, 0 }, { 61, 37, 1, 0 }, { 45, 58, 3, 0 }, { 150, 99, 3, 64 }
+		};
+		for (size_t i = 0; i < sizeof(textures) / sizeof(textures[0]); ++i)
+		{
+			Texture const& texture(textures[i]);
+			opj_image_t* image = createImage(texture.mWidth, texture.mHeight, texture.mOrigin);
+			for (int reversible = 0; reversible < 2; ++reversible)
+			{
+				std::string codestream = encode(image, reversible, texture.mTileSize);
+				ensure("encoded", !codestream.empty());
+				for (int reduce = 0; reduce < 3; ++reduce)
+				{
+					opj_image_t* decoded[2];
+					for (int use_simd = 0; use_simd < 2; ++use_simd)
+					{
+						opj_set_use_simd(use_simd);
+						decoded[use_simd] = decode(codestream, reduce);
+						ensure("decoded", decoded[use_simd] && decoded[use_simd]->numcomps == 3);
+					}
+					ensure("same image", sameImage(decoded[0], decoded[1]));
+					opj_image_destroy(decoded[0]);
+					opj_image_destroy(decoded[1]);
+				}
+			}
+			opj_image_destroy(image);
+		}
+	}
+
+	template<> template<>
+	void openjpeg_object::test<6>()
+	{
+		// Decoding a texture at discard level 5 down to 0 as its data arrives, and then again at
+		// every level with all data, gives exactly the same images with a decode cache kept
+		// between the steps as decoding every step from scratch.
+		for (int reversible = 0; reversible < 2; ++reversible)
+		{
+			int const size = 128;
+			opj_image_t* image = createImage(size, size);
+			std::string codestream = encode(image, reversible);
+			opj_image_destroy(image);
+			ensure("encoded", !codestream.empty());
+
+			opj_decode_cache_t* cache = opj_create_decode_cache();
+			for (int all_data = 0; all_data < 2; ++all_data)
+			{
+				for (int discard = 5; discard >= 0; --discard)
+				{
+					std::string data = all_data ? codestream : dataForDiscard(codestream, size, discard);
+					opj_image_t* scratch = decode(data, discard);
+					opj_image_t* cached = decode(data, discard, cache);
+					ensure("decoded", scratch && cached);
+					ensure("same image", sameImage(scratch, cached));
+					opj_image_destroy(scratch);
+					opj_image_destroy(cached);
+				}
+			}
+			opj_destroy_decode_cache(cache);
+		}
+	}
+}
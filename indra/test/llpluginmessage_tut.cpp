@@ -0,0 +1,212 @@
+/**
+ * @file llpluginmessage_tut.cpp
+ * @brief Tests of binary LLPluginMessages and LLPluginMessageRing, and a loopback benchmark against XML messages.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <deque>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llpluginmessage.h"
+#include "llpluginmessageclasses.h"
+#include "llpluginmessagering.h"
+#include "llpluginsharedmemory.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct pluginmessage_data
+	{
+		U32 mSeed;
+
+		pluginmessage_data() : mSeed(1357) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		// The message a media plugin sends for every frame it draws.
+		static LLPluginMessage updatedMessage(S32 frame)
+		{
+			LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_MEDIA, "updated");
+			message.setValueS32("left", 0);
+			message.setValueS32("top", frame % 512);
+			message.setValueS32("right", 1024);
+			message.setValueS32("bottom", frame % 512 + 16);
+			message.setValueReal("current_time", frame / 60.0);
+			message.setValueReal("duration", 600.0);
+			message.setValueReal("current_rate", 1.0);
+			return message;
+		}
+	};
+	typedef test_group<pluginmessage_data> pluginmessage_test;
+	typedef pluginmessage_test::object pluginmessage_object;
+	tut::pluginmessage_test pluginmessage_testcase("pluginmessage");
+
+	template<> template<>
+	void pluginmessage_object::test<1>()
+	{
+		// Binary messages parse back to the same values, and XML messages still parse.
+		LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_MEDIA, "test");
+		message.setValueS32("s32", -12345);
+		message.setValueU32("u32", 0xdeadbeef);
+		message.setValueBoolean("boolean", true);
+		message.setValueReal("real", 0.25);
+		message.setValuePointer("pointer", &message);
+		LLSD map;
+		map["key"] = "value";
+		message.setValueLLSD("llsd", map);
+
+		std::string binary = message.generateBinary();
+		std::string xml = message.generate();
+		ensure("binary", LLPluginMessage::isBinary(binary));
+		ensure("xml", !LLPluginMessage::isBinary(xml));
+		ensure("smaller", binary.size() < xml.size());
+
+		for (int i = 0; i < 2; ++i)
+		{
+			LLPluginMessage parsed;
+			ensure("parses", parsed.parse(i ? xml : binary) != -1);
+			ensure_equals("class", parsed.getClass(), std::string(LLPLUGIN_MESSAGE_CLASS_MEDIA));
+			ensure_equals("name", parsed.getName(), std::string("test"));
+			ensure_equals("s32", parsed.getValueS32("s32"), -12345);
+			ensure_equals("u32", parsed.getValueU32("u32"), 0xdeadbeef);
+			ensure("boolean", parsed.getValueBoolean("boolean"));
+			ensure_equals("real", parsed.getValueReal("real"), 0.25);
+			ensure("pointer", parsed.getValuePointer("pointer") == &message);
+			ensure_equals("llsd", parsed.getValueLLSD("llsd")["key"].asString(), std::string("value"));
+		}
+		// Unlike text messages, binary messages can contain null characters.
+		std::string const with_null("with a \0 in it", 14);
+		message.setValue("string", with_null);
+		LLPluginMessage parsed;
+		ensure("parses with a null character", parsed.parse(message.generateBinary()) != -1);
+		ensure_equals("string with a null character", parsed.getValue("string"), with_null);
+		ensure("truncated", parsed.parse(binary.substr(0, binary.size() / 2)) == -1);
+	}
+
+	template<> template<>
+	void pluginmessage_object::test<2>()
+	{
+		// A small ring wraps around many times and passes all messages, with their stamps, in order.
+		std::vector<char> memory(LLPluginMessageRing::getSize(256) + 17);
+		LLPluginMessageRing writer, reader;
+		ensure("too small", !writer.create(&memory[0], 16));
+		ensure("not a ring", !reader.attach(&memory[0], memory.size()));
+		ensure("create", writer.create(&memory[0], memory.size()));
+		ensure("attach", reader.attach(&memory[0], memory.size()));
+		ensure("too large", !writer.write(std::string(300, 'x')));
+
+		std::deque<std::string> sent;
+		std::string message;
+		U32 stamp;
+		U32 count = 0;
+		for (U32 i = 0; i < 10000; ++i)
+		{
+			if (next() % 2)
+			{
+				message = std::string(next() % 100, (char)('a' + count++ % 26));
+				if (writer.write(message, (U32)message.size()))
+				{
+					sent.push_back(message);
+				}
+				else
+				{
+					ensure("only fails when full", sent.size() > 1);
+				}
+			}
+			else if (reader.peek(stamp))
+			{
+				ensure("not empty", !sent.empty());
+				ensure_equals("stamp", stamp, (U32)sent.front().size());
+				ensure("read", reader.read(message));
+				ensure_equals("in order", message, sent.front());
+				sent.pop_front();
+			}
+			else
+			{
+				ensure("only fails when empty", sent.empty());
+			}
+		}
+		while (reader.read(message))
+		{
+			ensure_equals("the rest in order", message, sent.front());
+			sent.pop_front();
+		}
+		ensure("all read", sent.empty());
+	}
+
+	template<> template<>
+	void pluginmessage_object::test<3>()
+	{
+		// Benchmark: pass the per-frame updates of 20 media plugins during 500 frames
+		// from a plugin to the viewer, as XML text and as binary messages through a
+		// message ring in a shared memory segment. Both sides run in this process.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		S32 const num_messages = 20 * 500;
+		LLPluginSharedMemory parent_memory, child_memory;
+		size_t ring_size = LLPluginMessageRing::getSize(64 * 1024);
+		ensure("create", parent_memory.create(ring_size));
+		ensure("attach", child_memory.attach(parent_memory.getName(), ring_size));
+		LLPluginMessageRing viewer_ring, plugin_ring;
+		ensure("create ring", viewer_ring.create(parent_memory.getMappedAddress(), ring_size));
+		ensure("attach ring", plugin_ring.attach(child_memory.getMappedAddress(), ring_size));
+
+		LLTimer timer;
+		S32 total = 0;
+		for (S32 frame = 0; frame < num_messages; ++frame)
+		{
+			std::string buffer = updatedMessage(frame).generate();
+			LLPluginMessage parsed;
+			parsed.parse(buffer);
+			total += parsed.getValueS32("top");
+		}
+		F64 xml_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		S32 binary_total = 0;
+		std::string buffer;
+		for (S32 frame = 0; frame < num_messages; ++frame)
+		{
+			ensure("write", plugin_ring.write(updatedMessage(frame).generateBinary()));
+			ensure("read", viewer_ring.read(buffer));
+			LLPluginMessage parsed;
+			parsed.parse(buffer);
+			binary_total += parsed.getValueS32("top");
+		}
+		F64 binary_time = timer.getElapsedTimeF64();
+		ensure_equals("same messages", binary_total, total);
+
+		llinfos << num_messages << " media updates: " << xml_time * 1000.0 << " ms as XML, "
+				<< binary_time * 1000.0 << " ms as binary messages through a message ring." << llendl;
+	}
+}
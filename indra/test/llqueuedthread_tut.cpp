@@ -0,0 +1,271 @@
+/**
+ * @file llqueuedthread_tut.cpp
+ * @brief Tests of LLIndexedHeap and the LLQueuedThread request queue, and a contention benchmark.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <algorithm>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llindexedheap.h"
+#include "llqueuedthread.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct heap_element
+	{
+		S32 mKey;
+		S32 mHeapIndex;
+
+		heap_element(S32 key) : mKey(key), mHeapIndex(-1) { }
+	};
+
+	struct heap_element_less
+	{
+		bool operator()(heap_element const* lhs, heap_element const* rhs) const { return lhs->mKey < rhs->mKey; }
+	};
+
+	struct heap_element_index
+	{
+		S32& operator()(heap_element* element) const { return element->mHeapIndex; }
+	};
+
+	typedef LLIndexedHeap<heap_element*, heap_element_less, heap_element_index> test_heap_t;
+
+	// A request that takes mSteps calls to processRequest() to finish, and records when it finished.
+	class LLTestRequest : public LLQueuedThread::QueuedRequest
+	{
+	public:
+		LLTestRequest(LLQueuedThread::handle_t handle, U32 priority, U32 steps, std::vector<U32>* finished, LLMutex* finished_mutex) :
+			LLQueuedThread::QueuedRequest(handle, priority, LLQueuedThread::FLAG_AUTO_COMPLETE),
+			mSteps(steps), mFinished(finished), mFinishedMutex(finished_mutex) { }
+
+		/*virtual*/ bool processRequest()
+		{
+			return --mSteps == 0;
+		}
+
+		/*virtual*/ void finishRequest(bool completed)
+		{
+			LLMutexLock lock(mFinishedMutex);
+			mFinished->push_back(getPriority());
+		}
+
+	private:
+		U32 mSteps;
+		std::vector<U32>* mFinished;
+		LLMutex* mFinishedMutex;
+	};
+
+	class LLTestQueue : public LLQueuedThread
+	{
+	public:
+		LLTestQueue(bool threaded, bool should_pause = false) : LLQueuedThread("queued thread test", threaded, should_pause) { }
+
+		handle_t add(U32 priority, U32 steps = 1)
+		{
+			handle_t handle = generateHandle();
+			addRequest(new LLTestRequest(handle, priority, steps, &mFinished, &mFinishedMutex));
+			return handle;
+		}
+
+		std::vector<U32> mFinished;
+		LLMutex mFinishedMutex;
+	};
+
+	struct queuedthread_data
+	{
+		U32 mSeed;
+
+		queuedthread_data() : mSeed(9876) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		// A random priority in the normal range, like the texture fetcher uses.
+		U32 priority()
+		{
+			return LLQueuedThread::PRIORITY_NORMAL | ((next() * 32768 + next()) & LLQueuedThread::PRIORITY_LOWBITS);
+		}
+
+		static bool finishedInOrder(std::vector<U32> const& finished)
+		{
+			for (U32 i = 1; i < finished.size(); ++i)
+			{
+				if (finished[i - 1] < finished[i])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+	typedef test_group<queuedthread_data> queuedthread_test;
+	typedef queuedthread_test::object queuedthread_object;
+	tut::queuedthread_test queuedthread_testcase("queuedthread");
+
+	template<> template<>
+	void queuedthread_object::test<1>()
+	{
+		// Random pushes, key changes and erases; popping everything gives the keys in order.
+		std::vector<heap_element*> elements;
+		test_heap_t heap;
+		for (U32 i = 0; i < 2000; ++i)
+		{
+			elements.push_back(new heap_element(next()));
+			heap.push(elements.back());
+		}
+		for (U32 i = 0; i < 3000; ++i)
+		{
+			heap_element* element = elements[next() % elements.size()];
+			if (!test_heap_t::contains(element))
+			{
+				heap.push(element);
+			}
+			else if (i % 5 == 0)
+			{
+				heap.erase(element);
+			}
+			else
+			{
+				element->mKey = next();
+				heap.update(element);
+			}
+		}
+		std::vector<S32> keys;
+		for (std::vector<heap_element*>::iterator iter = elements.begin(); iter != elements.end(); ++iter)
+		{
+			if (test_heap_t::contains(*iter))
+			{
+				keys.push_back((*iter)->mKey);
+			}
+		}
+		ensure_equals("heap size", heap.size(), (U32)keys.size());
+		std::sort(keys.begin(), keys.end());
+		for (U32 i = 0; i < keys.size(); ++i)
+		{
+			ensure_equals("popped in order", heap.pop()->mKey, keys[i]);
+		}
+		ensure("heap is empty", heap.empty());
+		for (std::vector<heap_element*>::iterator iter = elements.begin(); iter != elements.end(); ++iter)
+		{
+			ensure("popped elements are not in the heap", !test_heap_t::contains(*iter));
+			delete *iter;
+		}
+	}
+
+	template<> template<>
+	void queuedthread_object::test<2>()
+	{
+		// Without a thread, requests are processed on update() in the order of their
+		// priority, including the priorities that were changed after queuing.
+		LLTestQueue queue(false);
+		std::vector<LLQueuedThread::handle_t> handles;
+		for (U32 i = 0; i < 500; ++i)
+		{
+			handles.push_back(queue.add(priority()));
+		}
+		for (U32 i = 0; i < 1000; ++i)
+		{
+			queue.setPriority(handles[next() % handles.size()], priority());
+		}
+		ensure_equals("all requests are pending", queue.getPending(), 500);
+		queue.update(0);
+		ensure_equals("all requests finished", (U32)queue.mFinished.size(), 500U);
+		ensure("requests finished in order of priority", finishedInOrder(queue.mFinished));
+	}
+
+	template<> template<>
+	void queuedthread_object::test<3>()
+	{
+		// Priority changes made by another thread are batched, and the thread applies
+		// them before it takes the next request.
+		LLTestQueue queue(true, true);
+		std::vector<LLQueuedThread::handle_t> handles;
+		for (U32 i = 0; i < 1000; ++i)
+		{
+			handles.push_back(queue.add(LLQueuedThread::PRIORITY_NORMAL));
+		}
+		for (U32 i = 0; i < handles.size(); ++i)
+		{
+			queue.setPriority(handles[i], priority());
+		}
+		queue.unpause();
+		while (queue.getPending() > 0)
+		{
+			ms_sleep(1);
+		}
+		queue.waitOnPending();
+		ensure_equals("all requests finished", (U32)queue.mFinished.size(), 1000U);
+		ensure("requests finished in order of their new priority", finishedInOrder(queue.mFinished));
+	}
+
+	template<> template<>
+	void queuedthread_object::test<4>()
+	{
+		// Benchmark: 20000 requests that each need a few passes (so they are popped and
+		// pushed back repeatedly), while this thread reprioritizes all of them every
+		// "frame", like LLTextureFetch does while the camera moves.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		const U32 num_requests = 20000;
+		LLTestQueue queue(true);
+		std::vector<LLQueuedThread::handle_t> handles;
+		for (U32 i = 0; i < num_requests; ++i)
+		{
+			handles.push_back(queue.add(priority(), 1 + i % 20));
+		}
+
+		LLTimer timer;
+		F64 set_priority_time = 0.0;
+		U32 frames = 0;
+		U32 calls = 0;
+		while (queue.getPending() > 0)
+		{
+			timer.reset();
+			for (std::vector<LLQueuedThread::handle_t>::iterator iter = handles.begin(); iter != handles.end(); ++iter)
+			{
+				queue.setPriority(*iter, priority());
+			}
+			set_priority_time += timer.getElapsedTimeF64();
+			calls += handles.size();
+			++frames;
+			queue.update(0);
+		}
+		queue.waitOnPending();
+		ensure_equals("all requests finished", (U32)queue.mFinished.size(), num_requests);
+
+		llinfos << num_requests << " requests, " << frames << " frames: " << calls << " setPriority calls took "
+				<< set_priority_time * 1000.0 << " ms (" << set_priority_time * 1.0e9 / llmax(calls, 1U) << " ns per call)." << llendl;
+	}
+}
@@ -0,0 +1,142 @@
+/**
+ * @file llrowlayout_tut.cpp
+ * @brief Tests of LLRowLayout, and a benchmark of finding the visible rows of a 50,000 item folder.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llrowlayout.h"
+#include "llrect.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct rowlayout_data
+	{
+		U32 mSeed;
+
+		rowlayout_data() : mSeed(2468) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+	};
+	typedef test_group<rowlayout_data> rowlayout_test;
+	typedef rowlayout_test::object rowlayout_object;
+	tut::rowlayout_test rowlayout_testcase("rowlayout");
+
+	template<> template<>
+	void rowlayout_object::test<1>()
+	{
+		// The rows found are exactly the rows that overlap the window, also with
+		// empty rows (hidden by an animation) and windows outside of all rows.
+		LLRowLayout layout;
+		ensure("empty", layout.empty() && layout.getTotalHeight() == 0);
+		for (U32 i = 0; i < 300; ++i)
+		{
+			S32 top = layout.addRow(next() % 5 ? 20 : next() % 3 * 200);
+			ensure_equals("top", top, layout.getTop(i));
+		}
+		ensure_equals("size", layout.size(), 300U);
+		for (U32 i = 0; i < 2000; ++i)
+		{
+			S32 top = (S32)(next() % (layout.getTotalHeight() + 200)) - 100;
+			S32 bottom = top + (S32)(next() % 500);
+			U32 first, last;
+			layout.getRowsIn(top, bottom, first, last);
+			for (U32 row = 0; row < layout.size(); ++row)
+			{
+				bool overlaps = layout.getTop(row) + layout.getHeight(row) > top && layout.getTop(row) < bottom;
+				bool found = row >= first && row < last;
+				// Empty rows at the edges of the window may go either way.
+				if (layout.getHeight(row) > 0 || (layout.getTop(row) > top && layout.getTop(row) < bottom))
+				{
+					ensure_equals("found the rows in the window", found, overlaps);
+				}
+			}
+		}
+		layout.clear();
+		ensure("cleared", layout.empty() && layout.size() == 0 && layout.getTotalHeight() == 0);
+	}
+
+	template<> template<>
+	void rowlayout_object::test<2>()
+	{
+		// Benchmark: a folder with 50,000 items of 18 pixels in a window of 600 pixels,
+		// scrolled from top to bottom. Find the rows to draw in each frame by testing
+		// the rectangle of every row, like LLView::drawChildren() does, and with the layout.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		U32 const num_items = 50000;
+		S32 const item_height = 18;
+		S32 const window_height = 600;
+		std::vector<LLRect> rects(num_items);
+		LLRowLayout layout;
+		layout.reserve(num_items);
+		LLTimer timer;
+		for (U32 i = 0; i < num_items; ++i)
+		{
+			S32 top = -layout.addRow(item_height);
+			rects[i].setLeftTopAndSize(0, top, 200, item_height);
+		}
+		F64 layout_time = timer.getElapsedTimeF64();
+
+		U32 const num_frames = 1000;
+		S32 const scroll_step = layout.getTotalHeight() / num_frames;
+		timer.reset();
+		U32 scanned_rows = 0;
+		for (U32 frame = 0; frame < num_frames; ++frame)
+		{
+			LLRect window;
+			window.setLeftTopAndSize(0, -(S32)frame * scroll_step, 200, window_height);
+			for (U32 i = 0; i < num_items; ++i)
+			{
+				scanned_rows += rects[i].mBottom < window.mTop && rects[i].mTop > window.mBottom;
+			}
+		}
+		F64 scan_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		U32 found_rows = 0;
+		for (U32 frame = 0; frame < num_frames; ++frame)
+		{
+			U32 first, last;
+			layout.getRowsIn(frame * scroll_step, frame * scroll_step + window_height, first, last);
+			found_rows += last - first;
+		}
+		F64 layout_find_time = timer.getElapsedTimeF64();
+		ensure_equals("same rows", found_rows, scanned_rows);
+
+		llinfos << num_items << " rows: laying them out took " << layout_time * 1000.0 << " ms; finding the visible rows of "
+				<< num_frames << " frames took " << scan_time * 1000.0 << " ms by testing every row, "
+				<< layout_find_time * 1000.0 << " ms with a binary search." << llendl;
+	}
+}
@@ -0,0 +1,293 @@
+/**
+ * @file llskinning_tut.cpp
+ * @brief Tests comparing the LLSkinning kernels with the scalar skinning loops.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llmath.h"
+#include "llquaternion.h"
+#include "llskinning.h"
+#include "lltimer.h"
+#include "m4math.h"
+#include "v4math.h"
+
+namespace tut
+{
+	static const U32 PALETTE_SIZE = 52;
+	static const U32 VERTEX_COUNT = 1000;
+
+	// Keeps a worker busy until released.
+	class LLBusyJob : public LLThreadPool::Job
+	{
+	public:
+		LLBusyJob(LLAtomicU32* release) : mRelease(release) { }
+
+		/*virtual*/ void run(void)
+		{
+			while (!*mRelease)
+			{
+				ms_sleep(1);
+			}
+		}
+
+	private:
+		LLAtomicU32* mRelease;
+	};
+
+	struct skinning_data
+	{
+		LLMatrix4a mPalette[PALETTE_SIZE];
+		LLMatrix4a mBindShape;
+		LLVector4a* mWeights;
+		LLVector4a* mPositions;
+		LLVector4a* mNormals;
+		U32 mSeed;
+
+		skinning_data() : mSeed(12345)
+		{
+			mWeights = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+			mPositions = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+			mNormals = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+
+			for (U32 i = 0; i < PALETTE_SIZE; ++i)
+			{
+				LLQuaternion rot(random(), LLVector3(random(), random(), random() + 0.1f));
+				LLMatrix4 mat(rot, LLVector4(random(), random(), random(), 1.f));
+				mPalette[i].loadu(mat);
+			}
+
+			LLMatrix4 bind_shape;
+			bind_shape.initScale(LLVector3(1.5f, 0.5f, 2.f));
+			bind_shape.setTranslation(0.25f, -0.5f, 1.f);
+			mBindShape.loadu(bind_shape);
+
+			for (U32 i = 0; i < VERTEX_COUNT; ++i)
+			{
+				// Packed weights: joint index in the integer part, weight in the fraction.
+				// Every 100th vertex has all zero weights, which takes the F32_MAX path.
+				F32 w[4];
+				for (U32 k = 0; k < 4; ++k)
+				{
+					w[k] = (F32)(next() % PALETTE_SIZE) + (i % 100 ? random() * 0.999f : 0.f);
+				}
+				mWeights[i].set(w[0], w[1], w[2], w[3]);
+				mPositions[i].set(random() * 4.f - 2.f, random() * 4.f - 2.f, random() * 4.f - 2.f, 1.f);
+				mNormals[i].set(random() - 0.5f, random() - 0.5f, random() - 0.5f, 0.f);
+				mNormals[i].normalize3fast();
+			}
+		}
+
+		~skinning_data()
+		{
+			ll_aligned_free_16(mWeights);
+			ll_aligned_free_16(mPositions);
+			ll_aligned_free_16(mNormals);
+		}
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		F32 random()
+		{
+			return (F32)next() / 32768.f;
+		}
+
+		// The per-vertex blend as done by LLRiggedVolume::update and LLVOAvatar::updateSoftwareSkinnedVertices.
+		void scalarBlend(const LLVector4a& weight, LLMatrix4a& final_mat)
+		{
+			final_mat.clear();
+
+			S32 idx[4];
+
+			LLVector4 wght;
+
+			F32 scale = 0.f;
+			for (U32 k = 0; k < 4; k++)
+			{
+				F32 w = weight[k];
+
+				idx[k] = (S32) floorf(w);
+				wght[k] = w - floorf(w);
+				scale += wght[k];
+			}
+
+			if(scale > 0.f)
+				wght *= 1.f/scale;
+			else
+				wght = LLVector4(F32_MAX,F32_MAX,F32_MAX,F32_MAX);
+
+			for (U32 k = 0; k < 4; k++)
+			{
+				F32 w = wght[k];
+				LLMatrix4a src;
+				src.setMul(mPalette[idx[k]], w);
+
+				final_mat.add(src);
+			}
+		}
+
+		bool equals(const LLVector4a& a, const LLVector4a& b)
+		{
+			return memcmp(&a, &b, sizeof(F32) * 3) == 0;
+		}
+	};
+	typedef test_group<skinning_data> skinning_test;
+	typedef skinning_test::object skinning_object;
+	tut::skinning_test skinning_testcase("skinning");
+
+	template<> template<>
+	void skinning_object::test<1>()
+	{
+		// Rigged volume path: bind shape applied first, then the blended matrix.
+		LLVector4a* result = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+		LLSkinning::skinPositions(mPalette, PALETTE_SIZE, mBindShape, mWeights, mPositions, result, VERTEX_COUNT);
+
+		for (U32 j = 0; j < VERTEX_COUNT; ++j)
+		{
+			LLMatrix4a final_mat;
+			scalarBlend(mWeights[j], final_mat);
+
+			LLVector4a t;
+			LLVector4a dst;
+			mBindShape.affineTransform(mPositions[j], t);
+			final_mat.affineTransform(t, dst);
+
+			ensure("skinPositions matches the scalar path", equals(dst, result[j]));
+		}
+		ll_aligned_free_16(result);
+	}
+
+	template<> template<>
+	void skinning_object::test<2>()
+	{
+		// Software skinned vertex buffer path, including normals.
+		LLVector4a* pos = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+		LLVector4a* norm = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+		LLSkinning::skinVertices(mPalette, PALETTE_SIZE, mBindShape, mWeights, mPositions, mNormals, pos, norm, VERTEX_COUNT);
+
+		for (U32 j = 0; j < VERTEX_COUNT; ++j)
+		{
+			if (j % 100 == 0)
+			{	// F32_MAX weights overflow, the scalar result isn't meaningful to compare.
+				continue;
+			}
+
+			LLMatrix4a final_mat;
+			scalarBlend(mWeights[j], final_mat);
+			final_mat.mul(mBindShape);
+
+			LLVector4a dst_pos;
+			LLVector4a dst_norm;
+			final_mat.affineTransform(mPositions[j], dst_pos);
+			final_mat.invert();
+			final_mat.transpose();
+			final_mat.affineTransform(mNormals[j], dst_norm);
+
+			ensure("skinVertices position matches the scalar path", equals(dst_pos, pos[j]));
+			ensure("skinVertices normal matches the scalar path", equals(dst_norm, norm[j]));
+		}
+		ll_aligned_free_16(pos);
+		ll_aligned_free_16(norm);
+	}
+
+	template<> template<>
+	void skinning_object::test<3>()
+	{
+		// Skinning in batches (as the worker pool does) gives the same result as a single pass.
+		LLVector4a* whole = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+		LLVector4a* batched = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * VERTEX_COUNT);
+		LLSkinning::skinPositions(mPalette, PALETTE_SIZE, mBindShape, mWeights, mPositions, whole, VERTEX_COUNT);
+		for (U32 start = 0; start < VERTEX_COUNT; start += 64)
+		{
+			U32 count = llmin(64U, VERTEX_COUNT - start);
+			LLSkinning::skinPositions(mPalette, PALETTE_SIZE, mBindShape, mWeights + start, mPositions + start, batched + start, count);
+		}
+		ensure("batched skinning is deterministic", memcmp(whole, batched, sizeof(LLVector4a) * VERTEX_COUNT) == 0);
+
+		// Vertex 0 has zero weights and isn't finite; take the extents of the next 99.
+		LLVector4a min, max;
+		LLSkinning::getExtents(whole + 1, 99, min, max);
+		for (U32 j = 1; j < 100; ++j)
+		{
+			ensure("extents contain every vertex", whole[j].greaterEqual(min).areAllSet(LLVector4Logical::MASK_XYZ) &&
+												   max.greaterEqual(whole[j]).areAllSet(LLVector4Logical::MASK_XYZ));
+		}
+		ll_aligned_free_16(whole);
+		ll_aligned_free_16(batched);
+	}
+
+	template<> template<>
+	void skinning_object::test<4>()
+	{
+		// Skinning on a thread pool gives the same result as on the calling thread,
+		// also when all workers are busy with other jobs and group.wait() has to do the batches.
+		const U32 count = 4 * LLSkinning::MIN_BATCH_SIZE + 3;
+		LLVector4a* weights = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * count);
+		LLVector4a* src_pos = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * count);
+		LLVector4a* src_norm = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * count);
+		for (U32 j = 0; j < count; ++j)
+		{
+			weights[j] = mWeights[j % VERTEX_COUNT];
+			src_pos[j] = mPositions[j % VERTEX_COUNT];
+			src_norm[j] = mNormals[j % VERTEX_COUNT];
+		}
+
+		LLVector4a* serial = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * count * 2);
+		LLVector4a* parallel = (LLVector4a*) ll_aligned_malloc_16(sizeof(LLVector4a) * count * 2);
+		LLSkinning::skinVertices(mPalette, PALETTE_SIZE, mBindShape, weights, src_pos, src_norm, serial, serial + count, count);
+
+		const S32 num_threads = 3;
+		LLAtomicU32 release(0);		// Outlives the pool, which may still run LLBusyJob.
+		LLThreadPool pool("skinning test", num_threads);
+		for (int busy = 0; busy < 2; ++busy)
+		{
+			for (S32 i = 0; busy && i < num_threads; ++i)
+			{
+				pool.post(new LLBusyJob(&release));
+			}
+			memset(parallel, 0, sizeof(LLVector4a) * count * 2);
+			LLThreadPool::Group group;
+			LLSkinning::skinVertices(&pool, group, mPalette, PALETTE_SIZE, mBindShape, weights, src_pos, src_norm, parallel, parallel + count, count);
+			group.wait();
+			bool same = memcmp(serial, parallel, sizeof(LLVector4a) * count * 2) == 0;
+			if (busy)
+			{
+				release = 1;
+			}
+			ensure("parallel skinning is deterministic", same);
+		}
+
+		ll_aligned_free_16(weights);
+		ll_aligned_free_16(src_pos);
+		ll_aligned_free_16(src_norm);
+		ll_aligned_free_16(serial);
+		ll_aligned_free_16(parallel);
+	}
+}
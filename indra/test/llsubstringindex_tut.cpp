@@ -0,0 +1,186 @@
+/**
+ * @file llsubstringindex_tut.cpp
+ * @brief Tests of LLSubstringIndex, and a benchmark of inventory name searches against a linear scan.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <algorithm>
+#include <map>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llsubstringindex.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct substringindex_data
+	{
+		U32 mSeed;
+		std::map<LLUUID, std::string> mTexts;
+
+		substringindex_data() : mSeed(1234) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		// A name made of a few words from a small vocabulary, so that many names share trigrams.
+		std::string randomName()
+		{
+			static char const* const words[] = { "BLUE", "SHIRT", "HAIR", "SKIN", "SHAPE", "JEANS", "BOOTS", "HUD", "AO", "DRESS", "RED", "LONG" };
+			std::string name;
+			for (U32 count = 1 + next() % 4; count; --count)
+			{
+				if (!name.empty())
+				{
+					name += ' ';
+				}
+				name += words[next() % LL_ARRAY_SIZE(words)];
+			}
+			if (next() % 2)
+			{
+				name += llformat(" %u", next() % 1000);
+			}
+			return name;
+		}
+
+		// The ids of the texts that contain substring, the slow way.
+		uuid_vec_t scan(std::string const& substring) const
+		{
+			uuid_vec_t result;
+			for (std::map<LLUUID, std::string>::const_iterator iter = mTexts.begin(); iter != mTexts.end(); ++iter)
+			{
+				if (iter->second.find(substring) != std::string::npos)
+				{
+					result.push_back(iter->first);
+				}
+			}
+			return result;
+		}
+
+		static uuid_vec_t sorted(uuid_vec_t ids)
+		{
+			std::sort(ids.begin(), ids.end());
+			return ids;
+		}
+	};
+	typedef test_group<substringindex_data> substringindex_test;
+	typedef substringindex_test::object substringindex_object;
+	tut::substringindex_test substringindex_testcase("substringindex");
+
+	template<> template<>
+	void substringindex_object::test<1>()
+	{
+		// After random additions, renames and removals the index finds what a scan finds.
+		LLSubstringIndex index;
+		std::vector<LLUUID> ids(500);
+		for (U32 i = 0; i < ids.size(); ++i)
+		{
+			ids[i].generate();
+		}
+		static char const* const substrings[] = { "SHI", "SHIRT", "BLUE SH", "T BOOTS", "AOA", "RED 1", "HUD HUD", "EEE", "S 9" };
+		for (U32 round = 0; round < 20; ++round)
+		{
+			for (U32 i = 0; i < 200; ++i)
+			{
+				LLUUID const& id(ids[next() % ids.size()]);
+				if (next() % 4)
+				{
+					std::string name = randomName();
+					index.set(id, name);
+					mTexts[id] = name;
+				}
+				else
+				{
+					index.remove(id);
+					mTexts.erase(id);
+				}
+			}
+			ensure_equals("size", index.size(), (U32)mTexts.size());
+			for (U32 i = 0; i < LL_ARRAY_SIZE(substrings); ++i)
+			{
+				uuid_vec_t matches;
+				ensure("can find", index.find(substrings[i], matches));
+				ensure("same matches", sorted(matches) == scan(substrings[i]));
+			}
+		}
+
+		uuid_vec_t matches;
+		ensure("too short", !index.find("SH", matches) && matches.empty());
+		index.clear();
+		ensure("cleared", index.size() == 0 && index.find("SHIRT", matches) && matches.empty());
+	}
+
+	template<> template<>
+	void substringindex_object::test<2>()
+	{
+		// Benchmark: find the items of an inventory of 200,000 items while a name is
+		// being typed, with the index and with a scan of all names.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		LLSubstringIndex index;
+		for (U32 i = 0; i < 200000; ++i)
+		{
+			LLUUID id;
+			id.generate();
+			mTexts[id] = randomName();
+		}
+		LLTimer timer;
+		for (std::map<LLUUID, std::string>::const_iterator iter = mTexts.begin(); iter != mTexts.end(); ++iter)
+		{
+			index.set(iter->first, iter->second);
+		}
+		F64 build_time = timer.getElapsedTimeF64();
+
+		std::string const typed = "BLUE SHIRT 42";
+		timer.reset();
+		U32 index_matches = 0;
+		for (U32 length = LLSubstringIndex::MIN_SUBSTRING_LENGTH; length <= typed.length(); ++length)
+		{
+			uuid_vec_t matches;
+			index.find(typed.substr(0, length), matches);
+			index_matches += matches.size();
+		}
+		F64 index_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		U32 scan_matches = 0;
+		for (U32 length = LLSubstringIndex::MIN_SUBSTRING_LENGTH; length <= typed.length(); ++length)
+		{
+			scan_matches += scan(typed.substr(0, length)).size();
+		}
+		F64 scan_time = timer.getElapsedTimeF64();
+		ensure_equals("same number of matches", index_matches, scan_matches);
+
+		llinfos << mTexts.size() << " names: building the index took " << build_time * 1000.0 << " ms; typing \"" << typed << "\" took "
+				<< index_time * 1000.0 << " ms with the index, " << scan_time * 1000.0 << " ms with a scan." << llendl;
+	}
+}
@@ -0,0 +1,135 @@
+/**
+ * @file llthreadpool_tut.cpp
+ * @brief Tests of LLThreadPool::Group.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llthreadpool.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	// Keeps a worker busy until released.
+	class LLBlockingJob : public LLThreadPool::Job
+	{
+	public:
+		LLBlockingJob(LLAtomicU32* release) : mRelease(release) { }
+
+		/*virtual*/ void run(void)
+		{
+			while (!*mRelease)
+			{
+				ms_sleep(1);
+			}
+		}
+
+	private:
+		LLAtomicU32* mRelease;
+	};
+
+	// Records which pool, if any, ran it.
+	class LLRecordingJob : public LLThreadPool::Job
+	{
+	public:
+		LLRecordingJob(LLThreadPool** ran_by) : mRanBy(ran_by) { }
+
+		/*virtual*/ void run(void)
+		{
+			*mRanBy = LLThread::tldata().mThreadPool;
+		}
+
+	private:
+		LLThreadPool** mRanBy;
+	};
+
+	class LLCountingJob : public LLThreadPool::Job
+	{
+	public:
+		LLCountingJob(LLAtomicS32* count) : mCount(count) { }
+
+		/*virtual*/ void run(void)
+		{
+			(*mCount)++;
+		}
+
+	private:
+		LLAtomicS32* mCount;
+	};
+
+	struct threadpool_data
+	{
+	};
+	typedef test_group<threadpool_data> threadpool_test;
+	typedef threadpool_test::object threadpool_object;
+	tut::threadpool_test threadpool_testcase("threadpool");
+
+	template<> template<>
+	void threadpool_object::test<1>()
+	{
+		// Group::wait() doesn't wait for busy workers: it runs the queued jobs of its group itself.
+		S32 const num_threads = 2;
+		LLAtomicU32 release(0);		// Outlives the pool, which may still run LLBlockingJob.
+		LLThreadPool pool("thread pool test", num_threads);
+		for (S32 i = 0; i < num_threads; ++i)
+		{
+			pool.post(new LLBlockingJob(&release));
+		}
+
+		S32 const num_jobs = 10;
+		LLThreadPool* ran_by[num_jobs];
+		LLThreadPool::Group group;
+		for (S32 i = 0; i < num_jobs; ++i)
+		{
+			ran_by[i] = &pool;
+			ensure("post", pool.post(new LLRecordingJob(&ran_by[i]), &group));
+		}
+		group.wait();
+		release = 1;
+
+		for (S32 i = 0; i < num_jobs; ++i)
+		{
+			ensure("ran on the waiting thread", ran_by[i] == NULL);
+		}
+		ensure_equals("nothing left in the queues", pool.getQueueDepth(), 0);
+	}
+
+	template<> template<>
+	void threadpool_object::test<2>()
+	{
+		// Jobs that the workers run are still waited for.
+		LLThreadPool pool("thread pool test", 2);
+		S32 const num_jobs = 1000;
+		LLAtomicS32 count(0);
+		{
+			LLThreadPool::Group group;
+			for (S32 i = 0; i < num_jobs; ++i)
+			{
+				pool.post(new LLCountingJob(&count), &group);
+			}
+		}
+		ensure_equals("every job ran", (S32)count, num_jobs);
+	}
+}
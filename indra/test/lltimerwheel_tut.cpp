@@ -0,0 +1,249 @@
+/**
+ * @file lltimerwheel_tut.cpp
+ * @brief Tests of LLTimerWheel, and a benchmark against an ordered set.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <set>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "lltimerwheel.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	struct test_timer : public LLTimerWheel::Node
+	{
+		U64 mExpire;			// Expected expiration, or 0 when not queued.
+		U64 mFired;				// The tick at which advance() returned it.
+
+		test_timer() : mExpire(0), mFired(0) { }
+	};
+
+	struct timerwheel_data
+	{
+		U32 mSeed;
+
+		timerwheel_data() : mSeed(1234) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+
+		// A delay that is usually short, sometimes crosses a few levels and rarely overflows.
+		U64 delay()
+		{
+			U32 kind = next() % 16;
+			if (kind < 10)
+			{
+				return next() % 300;
+			}
+			if (kind < 15)
+			{
+				return ((U64)next() << (next() % 20));
+			}
+			return ((U64)next() << 32) + next();
+		}
+
+		// Collect what expired, check that it was due and not returned before.
+		static void collect(LLTimerWheel& wheel, U64 now, std::multiset<U64>& reference)
+		{
+			LLTimerWheel::List expired;
+			wheel.advance(now, expired);
+			while (!expired.empty())
+			{
+				test_timer* timer = static_cast<test_timer*>(expired.pop_front());
+				ensure("expired timer was due", timer->mExpire <= now);
+				std::multiset<U64>::iterator iter = reference.find(timer->mExpire);
+				ensure("expired timer was running", iter != reference.end());
+				reference.erase(iter);
+				timer->mFired = now;
+				timer->mExpire = 0;
+			}
+			ensure("all due timers expired", reference.empty() || *reference.begin() > now);
+			ensure_equals("wheel size", wheel.size(), (U32)reference.size());
+		}
+	};
+	typedef test_group<timerwheel_data> timerwheel_test;
+	typedef timerwheel_test::object timerwheel_object;
+	tut::timerwheel_test timerwheel_testcase("timerwheel");
+
+	template<> template<>
+	void timerwheel_object::test<1>()
+	{
+		// Random inserts, removes and advances give the same expirations as an ordered set,
+		// and nextExpiration() never lies about the first one.
+		const U32 num_timers = 2000;
+		test_timer* timers = new test_timer[num_timers];
+		std::multiset<U64> reference;
+		LLTimerWheel wheel;
+		U64 now = ((U64)1 << 32) - 5000;		// Start close to where the overflow list is used.
+		for (U32 i = 0; i < 20000; ++i)
+		{
+			test_timer& timer(timers[next() % num_timers]);
+			if (timer.isQueued())
+			{
+				reference.erase(reference.find(timer.mExpire));
+				wheel.remove(&timer);
+				timer.mExpire = 0;
+			}
+			if (next() % 4 != 0)
+			{
+				timer.mExpire = now + delay();
+				reference.insert(timer.mExpire);
+				wheel.insert(&timer, timer.mExpire, now);
+			}
+			if (i % 7 == 0)
+			{
+				U64 next_expiration = wheel.nextExpiration();
+				ensure("nextExpiration is a lower bound", reference.empty() ? next_expiration == LLTimerWheel::NEVER : next_expiration <= *reference.begin());
+				// Sometimes jump to the next expiration, sometimes just a bit ahead.
+				now = (next_expiration != LLTimerWheel::NEVER && next() % 2) ? next_expiration : now + next() % 500;
+				collect(wheel, now, reference);
+			}
+		}
+		// Run out the rest, including the far away ones.
+		while (!reference.empty())
+		{
+			now = wheel.nextExpiration();
+			collect(wheel, now, reference);
+		}
+		ensure("wheel is empty", wheel.empty());
+		delete [] timers;
+	}
+
+	template<> template<>
+	void timerwheel_object::test<2>()
+	{
+		// A timer inserted after its expiration fires on the next advance; removing
+		// a timer from the expired list works too.
+		LLTimerWheel wheel;
+		test_timer late, early, removed;
+		wheel.insert(&early, 100, 0);
+		wheel.insert(&removed, 100, 0);
+		LLTimerWheel::List expired;
+		wheel.advance(150, expired);
+		wheel.remove(&removed);
+		ensure("early expired", expired.pop_front() == &early);
+		ensure("removed timer is gone", expired.empty() && !removed.isQueued());
+		wheel.insert(&late, 120, 150);
+		ensure_equals("late timer is due", wheel.nextExpiration(), (U64)120);
+		wheel.advance(150, expired);
+		ensure("late expired", expired.pop_front() == &late && expired.empty());
+		ensure("wheel is empty", wheel.empty());
+	}
+
+	template<> template<>
+	void timerwheel_object::test<3>()
+	{
+		// Benchmark: 100,000 running timers (like the curl thread has with that many
+		// connections) of which a random one is restarted every step, while time advances.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		const U32 num_timers = 100000;
+		const U32 steps = 1000000;
+
+		test_timer* timers = new test_timer[num_timers];
+		LLTimerWheel wheel;
+		U64 now = 1000;
+		for (U32 i = 0; i < num_timers; ++i)
+		{
+			wheel.insert(&timers[i], now + 1 + next() % 30000, now);
+		}
+		// The same timers in a set, ordered by (expiration, index), like AIFrameTimer used to keep them.
+		typedef std::set<std::pair<U64, U32> > reference_type;
+		reference_type reference;
+		for (U32 i = 0; i < num_timers; ++i)
+		{
+			timers[i].mExpire = timers[i].getExpiration();
+			reference.insert(std::make_pair(timers[i].mExpire, i));
+		}
+
+		U32 const seed = mSeed;
+		U64 const start = now;
+		LLTimer timer;
+		LLTimerWheel::List expired;
+		U32 fired = 0;
+		for (U32 i = 0; i < steps; ++i)
+		{
+			test_timer& t(timers[(next() * 32768 + next()) % num_timers]);
+			wheel.remove(&t);
+			wheel.insert(&t, now + 1 + next() % 30000, now);
+			if (i % 100 == 0)
+			{
+				wheel.advance(++now, expired);
+				while (!expired.empty())
+				{
+					test_timer* e = static_cast<test_timer*>(expired.pop_front());
+					wheel.insert(e, now + 1 + next() % 30000, now);
+					++fired;
+				}
+			}
+		}
+		F64 wheel_time = timer.getElapsedTimeF64();
+
+		// The same operations on the set, starting with the same random numbers.
+		mSeed = seed;
+		now = start;
+		timer.reset();
+		U32 set_fired = 0;
+		for (U32 i = 0; i < steps; ++i)
+		{
+			U32 index = (next() * 32768 + next()) % num_timers;
+			reference.erase(std::make_pair(timers[index].mExpire, index));
+			timers[index].mExpire = now + 1 + next() % 30000;
+			reference.insert(std::make_pair(timers[index].mExpire, index));
+			if (i % 100 == 0)
+			{
+				++now;
+				while (reference.begin()->first <= now)
+				{
+					index = reference.begin()->second;
+					reference.erase(reference.begin());
+					timers[index].mExpire = now + 1 + next() % 30000;
+					reference.insert(std::make_pair(timers[index].mExpire, index));
+					++set_fired;
+				}
+			}
+		}
+		F64 set_time = timer.getElapsedTimeF64();
+
+		llinfos << num_timers << " timers, " << steps << " restarts: LLTimerWheel took " << wheel_time * 1000.0
+				<< " ms (" << fired << " expired), std::set took " << set_time * 1000.0 << " ms (" << set_fired << " expired)." << llendl;
+
+		for (U32 i = 0; i < num_timers; ++i)
+		{
+			wheel.remove(&timers[i]);
+		}
+		ensure("wheel is empty", wheel.empty());
+		delete [] timers;
+	}
+}
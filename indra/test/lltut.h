@@ -38,6 +38,7 @@
 #include "is_approx_equal_fraction.h" // instead of llmath.h
 
 #include <tut/tut.hpp>
+#include <cstdlib>
 #include <cstring>
 
 class LLDate;
@@ -46,6 +47,13 @@ class LLURI;
 
 namespace tut
 {
+	// Benchmarks only time code and log the result, so they are only run
+	// when the environment variable LL_TEST_BENCHMARKS is set.
+	inline bool benchmarks_enabled()
+	{
+		return getenv("LL_TEST_BENCHMARKS") != NULL;
+	}
+
 	inline void ensure_approximately_equals(const char* msg, F64 actual, F64 expected, U32 frac_bits)
 	{
 		if(!is_approx_equal_fraction(actual, expected, frac_bits))
@@ -0,0 +1,224 @@
+/**
+ * @file lluuidflatmap_tut.cpp
+ * @brief Tests of LLUUIDFlatMap, and a benchmark of inventory-like lookups against std::map.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <map>
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "lluuidflatmap.h"
+#include "llstl.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	// A synthetic inventory: folders in a tree, with items in them.
+	struct test_node
+	{
+		LLUUID mID;
+		LLUUID mParentID;
+		bool mIsFolder;
+		U32 mFlags;
+	};
+
+	typedef std::vector<test_node const*> child_list_t;
+
+	// Collect the ids of all items under folder_id that have flag set, like
+	// LLInventoryModel::collectDescendentsIf() does, with either kind of map.
+	template<class OBJECT_MAP, class CHILD_MAP>
+	static void collect_descendents_if(OBJECT_MAP const& objects, CHILD_MAP const& children, LLUUID const& folder_id, U32 flag, std::vector<LLUUID>& result)
+	{
+		child_list_t const* list = get_ptr_in_map(children, folder_id);
+		if (!list)
+		{
+			return;
+		}
+		for (child_list_t::const_iterator iter = list->begin(); iter != list->end(); ++iter)
+		{
+			// Look the child up by id, as the model does.
+			test_node const* object = get_ptr_in_map(objects, (*iter)->mID);
+			if (object->mIsFolder)
+			{
+				collect_descendents_if(objects, children, object->mID, flag, result);
+			}
+			else if (object->mFlags & flag)
+			{
+				result.push_back(object->mID);
+			}
+		}
+	}
+
+	struct uuidflatmap_data
+	{
+		U32 mSeed;
+
+		uuidflatmap_data() : mSeed(4321) { }
+
+		// Deterministic, so that failures are reproducible.
+		U32 next()
+		{
+			mSeed = mSeed * 1103515245 + 12345;
+			return (mSeed >> 16) & 0x7fff;
+		}
+	};
+	typedef test_group<uuidflatmap_data> uuidflatmap_test;
+	typedef uuidflatmap_test::object uuidflatmap_object;
+	tut::uuidflatmap_test uuidflatmap_testcase("uuidflatmap");
+
+	template<> template<>
+	void uuidflatmap_object::test<1>()
+	{
+		// Random inserts, lookups and erases give the same results as std::map. Keys
+		// only differ in a few bytes, so that there are long probe sequences to erase from.
+		LLUUIDFlatMap<U32> map;
+		std::map<LLUUID, U32> reference;
+		for (U32 i = 0; i < 200000; ++i)
+		{
+			LLUUID key;
+			key.mData[0] = next() % 64;
+			key.mData[11] = next() % 32;
+			switch (next() % 3)
+			{
+				case 0:
+					map[key] = i;
+					reference[key] = i;
+					break;
+				case 1:
+					ensure_equals("erase", map.erase(key), reference.erase(key));
+					break;
+				default:
+				{
+					LLUUIDFlatMap<U32>::const_iterator iter = map.find(key);
+					std::map<LLUUID, U32>::const_iterator ref = reference.find(key);
+					ensure_equals("found", iter == map.end(), ref == reference.end());
+					if (ref != reference.end())
+					{
+						ensure_equals("value", iter->second, ref->second);
+					}
+				}
+			}
+			ensure_equals("size", map.size(), reference.size());
+		}
+		size_t count = 0;
+		for (LLUUIDFlatMap<U32>::iterator iter = map.begin(); iter != map.end(); ++iter, ++count)
+		{
+			ensure_equals("iterated value", iter->second, reference[iter->first]);
+		}
+		ensure_equals("iterated all", count, reference.size());
+
+		// The null key is a key like any other.
+		map[LLUUID::null] = 17;
+		ensure_equals("null is found", map.find(LLUUID::null)->second, 17U);
+		map.clear();
+		ensure("cleared", map.empty() && map.find(LLUUID::null) == map.end() && map.begin() == map.end());
+	}
+
+	template<> template<>
+	void uuidflatmap_object::test<2>()
+	{
+		// Benchmark: 200,000 items in 10,000 folders. Look up every object, and
+		// collect the items with a flag under the root, with std::map and LLUUIDFlatMap.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		U32 const num_folders = 10000;
+		U32 const num_items = 200000;
+		std::vector<test_node> objects(num_folders + num_items);
+		for (U32 i = 0; i < objects.size(); ++i)
+		{
+			test_node& object(objects[i]);
+			object.mID.generate();
+			object.mIsFolder = i < num_folders;
+			// Folder 0 is the root; every other object is in a folder created before it.
+			object.mParentID = i ? objects[(next() * 32768 + next()) % llmin(i, num_folders)].mID : LLUUID::null;
+			object.mFlags = next();
+		}
+
+		std::map<LLUUID, test_node const*> tree_objects;
+		std::map<LLUUID, child_list_t*> tree_children;
+		LLUUIDFlatMap<test_node const*> flat_objects;
+		LLUUIDFlatMap<child_list_t*> flat_children;
+		std::vector<child_list_t> children(num_folders + 1);
+		for (U32 i = 0; i < num_folders; ++i)
+		{
+			tree_children[objects[i].mID] = flat_children[objects[i].mID] = &children[i];
+		}
+		tree_children[LLUUID::null] = flat_children[LLUUID::null] = &children[num_folders];
+		for (U32 i = 0; i < objects.size(); ++i)
+		{
+			tree_objects[objects[i].mID] = flat_objects[objects[i].mID] = &objects[i];
+			flat_children[objects[i].mParentID]->push_back(&objects[i]);
+		}
+
+		LLTimer timer;
+		U32 found = 0;
+		for (U32 round = 0; round < 10; ++round)
+		{
+			for (U32 i = 0; i < objects.size(); ++i)
+			{
+				found += get_ptr_in_map(tree_objects, objects[i].mID) == &objects[i];
+			}
+		}
+		F64 tree_lookup_time = timer.getElapsedTimeF64();
+		ensure_equals("std::map lookups", found, 10 * (U32)objects.size());
+
+		timer.reset();
+		found = 0;
+		for (U32 round = 0; round < 10; ++round)
+		{
+			for (U32 i = 0; i < objects.size(); ++i)
+			{
+				found += get_ptr_in_map(flat_objects, objects[i].mID) == &objects[i];
+			}
+		}
+		F64 flat_lookup_time = timer.getElapsedTimeF64();
+		ensure_equals("LLUUIDFlatMap lookups", found, 10 * (U32)objects.size());
+
+		std::vector<LLUUID> tree_result, flat_result;
+		timer.reset();
+		for (U32 round = 0; round < 10; ++round)
+		{
+			tree_result.clear();
+			collect_descendents_if(tree_objects, tree_children, objects[0].mID, 0x40, tree_result);
+		}
+		F64 tree_collect_time = timer.getElapsedTimeF64();
+
+		timer.reset();
+		for (U32 round = 0; round < 10; ++round)
+		{
+			flat_result.clear();
+			collect_descendents_if(flat_objects, flat_children, objects[0].mID, 0x40, flat_result);
+		}
+		F64 flat_collect_time = timer.getElapsedTimeF64();
+		ensure("same items collected", tree_result == flat_result && !flat_result.empty());
+
+		llinfos << objects.size() << " objects: 10 rounds of lookups took " << tree_lookup_time * 1000.0 << " ms with std::map, "
+				<< flat_lookup_time * 1000.0 << " ms with LLUUIDFlatMap; 10 recursive collects of " << flat_result.size() << " items took "
+				<< tree_collect_time * 1000.0 << " ms with std::map, " << flat_collect_time * 1000.0 << " ms with LLUUIDFlatMap." << llendl;
+	}
+}
@@ -0,0 +1,266 @@
+/**
+ * @file llwindgen_tut.cpp
+ * @brief Tests of LLWindGen against the sample at a time generator it replaced, and a benchmark.
+ *
+ * $LicenseInfo:firstyear=2013&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2013, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <tut/tut.hpp>
+#include "linden_common.h"
+#include "lltut.h"
+#include "llwindgen.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+namespace tut
+{
+	// The wind generator as it was, generating and filtering one sample at a time with rand().
+	template<class T>
+	class LLReferenceWindGen
+	{
+	public:
+		LLReferenceWindGen(U32 sample_rate = 44100) :
+			mTargetGain(0.f), mTargetFreq(100.f), mTargetPanGainR(0.5f),
+			mBuf0(0.f), mBuf1(0.f), mBuf2(0.f), mY0(0.f), mY1(0.f),
+			mCurrentGain(0.f), mCurrentFreq(100.f), mCurrentPanGainR(0.5f), mLastSample(0.f)
+		{
+			mSamplePeriod = 2.f / (F32)sample_rate;
+			mB2 = expf(-F_TWO_PI * 50.f * mSamplePeriod);
+		}
+
+		F32 noise(S16*) { return (F32)rand() * (1.0f / (F32)(RAND_MAX / (U16_MAX / 8))) + (F32)(S16_MIN / 8); }
+		F32 noise(F32*) { return ll_frand() - .5f; }
+		static S16 store(S16*, bool clip, F32 sample) { return (S16)(clip ? (F32)llclamp((S32)sample, (S32)S16_MIN, (S32)S16_MAX) : sample); }
+		static F32 store(F32*, bool, F32 sample) { return sample; }
+
+		T* windGenerate(T* newbuffer, int numsamples)
+		{
+			T* cursamplep = newbuffer;
+			F32 a0 = 0.0f, b1 = 0.0f;
+			bool clip = mCurrentGain > 2.0f;
+			bool interp_freq = false;
+			if (llabs(mTargetFreq - mCurrentFreq) < (mCurrentFreq * 0.112))
+			{
+				mCurrentFreq = mTargetFreq;
+				b1 = (-4.0f * mB2) / (1.0f + mB2) * cosf(F_TWO_PI * (mCurrentFreq * mSamplePeriod));
+				a0 = (1.0f - mB2) * sqrtf(1.0f - (b1 * b1) / (4.0f * mB2));
+			}
+			else
+			{
+				interp_freq = true;
+			}
+			while (numsamples)
+			{
+				F32 next_sample = noise((T*)NULL);
+				mBuf0 = mBuf0 * 0.99765f + next_sample * 0.0990460f;
+				mBuf1 = mBuf1 * 0.96300f + next_sample * 0.2965164f;
+				mBuf2 = mBuf2 * 0.57000f + next_sample * 1.0526913f;
+				next_sample = mBuf0 + mBuf1 + mBuf2 + next_sample * 0.1848f;
+				if (interp_freq)
+				{
+					mCurrentFreq = (0.999f * mCurrentFreq) + (0.001f * mTargetFreq);
+					b1 = (-4.0f * mB2) / (1.0f + mB2) * cosf(F_TWO_PI * (mCurrentFreq * mSamplePeriod));
+					a0 = (1.0f - mB2) * sqrtf(1.0f - (b1 * b1) / (4.0f * mB2));
+				}
+				next_sample = a0 * next_sample - b1 * mY0 - mB2 * mY1;
+				mY1 = mY0;
+				mY0 = next_sample;
+				mCurrentGain = (0.999f * mCurrentGain) + (0.001f * mTargetGain);
+				mCurrentPanGainR = (0.999f * mCurrentPanGainR) + (0.001f * mTargetPanGainR);
+				next_sample *= mCurrentGain;
+				F32 delta = (next_sample - mLastSample) / 2.f;
+				for (U8 i = 2; i && numsamples; --i, --numsamples)
+				{
+					mLastSample = mLastSample + delta;
+					T sample_right = store((T*)NULL, clip, mLastSample * mCurrentPanGainR);
+					T sample_left = store((T*)NULL, clip, mLastSample - (F32)sample_right);
+					*cursamplep++ = sample_left;
+					*cursamplep++ = sample_right;
+				}
+			}
+			return newbuffer;
+		}
+
+		F32 mTargetGain;
+		F32 mTargetFreq;
+		F32 mTargetPanGainR;
+
+	private:
+		F32 mSamplePeriod;
+		F32 mB2;
+		F32 mBuf0, mBuf1, mBuf2, mY0, mY1;
+		F32 mCurrentGain, mCurrentFreq, mCurrentPanGainR, mLastSample;
+	};
+
+	// Signal statistics of a stereo buffer, after the gain settled.
+	struct LLWindStats
+	{
+		F64 mRMS[2];				// Per channel.
+		F64 mCrossings;				// Zero crossings of the left channel per frame; a measure of the dominant frequency.
+	};
+
+	struct windgen_data
+	{
+		// Run a generator for frames frames, in buffers of buffer_frames, with the targets set, and measure the second half.
+		template<class GEN, class T>
+		static LLWindStats measure(GEN& gen, F32 gain, F32 freq, F32 pan, int frames, int buffer_frames)
+		{
+			gen.mTargetGain = gain;
+			gen.mTargetFreq = freq;
+			gen.mTargetPanGainR = pan;
+			std::vector<T> buffer(frames * 2);
+			for (int done = 0; done < frames; done += buffer_frames)
+			{
+				gen.windGenerate(&buffer[done * 2], llmin(buffer_frames, frames - done));
+			}
+			LLWindStats stats;
+			F64 sum[2] = { 0.0, 0.0 };
+			int crossings = 0;
+			for (int i = frames / 2; i < frames; ++i)
+			{
+				sum[0] += (F64)buffer[i * 2] * buffer[i * 2];
+				sum[1] += (F64)buffer[i * 2 + 1] * buffer[i * 2 + 1];
+				crossings += (buffer[i * 2] < 0) != (buffer[i * 2 - 2] < 0);
+			}
+			stats.mRMS[0] = sqrt(sum[0] / (frames - frames / 2));
+			stats.mRMS[1] = sqrt(sum[1] / (frames - frames / 2));
+			stats.mCrossings = (F64)crossings / (frames - frames / 2);
+			return stats;
+		}
+
+		template<class T>
+		static void compare(F32 gain, F32 freq, F32 pan, int buffer_frames)
+		{
+			// Start from another frequency, so that it is interpolated at first.
+			LLWindGen<T> gen;
+			LLReferenceWindGen<T> reference;
+			gen.mTargetFreq = reference.mTargetFreq = freq * 2.f;
+			LLWindStats stats = measure<LLWindGen<T>, T>(gen, gain, freq, pan, 441000, buffer_frames);
+			LLWindStats expected = measure<LLReferenceWindGen<T>, T>(reference, gain, freq, pan, 441000, buffer_frames);
+			for (int channel = 0; channel < 2; ++channel)
+			{
+				ensure("sound", stats.mRMS[channel] > 0.0 || expected.mRMS[channel] == 0.0);
+				ensure("same level", llabs(stats.mRMS[channel] - expected.mRMS[channel]) <= 0.1 * expected.mRMS[channel] + 1.0);
+			}
+			ensure("same frequencies", llabs(stats.mCrossings - expected.mCrossings) <= 0.1 * expected.mCrossings);
+		}
+	};
+	typedef test_group<windgen_data> windgen_test;
+	typedef windgen_test::object windgen_object;
+	tut::windgen_test windgen_testcase("windgen");
+
+	template<> template<>
+	void windgen_object::test<1>()
+	{
+		// The block generator sounds the same as the old one: the same level per channel and about as many
+		// zero crossings, in the 16-bit format of OpenAL and the float format of FMOD, also for buffers
+		// that aren't a whole number of blocks.
+		compare<S16>(1.f, 100.f, 0.5f, 4410);
+		compare<S16>(3.f, 400.f, 0.2f, 1023);
+		compare<S16>(0.5f, 800.f, 0.9f, 7);
+		compare<F32>(1.f, 100.f, 0.5f, 1024);
+		compare<F32>(0.f, 300.f, 0.5f, 1024);
+		compare<F32>(4.f, 250.f, 0.7f, 333);
+	}
+
+	template<> template<>
+	void windgen_object::test<2>()
+	{
+		// The 16-bit output is clamped, and full right panning leaves (almost) nothing on the left channel.
+		LLWindGen<S16> gen;
+		gen.mTargetGain = 1000.f;
+		gen.mTargetPanGainR = 1.f;
+		std::vector<S16> buffer(2 * 44100);
+		for (int i = 0; i < 10; ++i)
+		{
+			gen.windGenerate(&buffer[0], 44100);
+		}
+		bool clamped = false;
+		for (int i = 0; i < 44100; ++i)
+		{
+			clamped |= buffer[2 * i + 1] == S16_MAX || buffer[2 * i + 1] == S16_MIN;
+			ensure("left silent", llabs(buffer[2 * i]) <= 2 || buffer[2 * i + 1] == S16_MAX || buffer[2 * i + 1] == S16_MIN);
+		}
+		ensure("clamped", clamped);
+	}
+
+	template<> template<>
+	void windgen_object::test<3>()
+	{
+		// Benchmark: samples per second, in the buffer sizes that FMOD (1024 frames of floats) and OpenAL
+		// (a tenth of a second of 16-bit samples) ask for.
+		if (!benchmarks_enabled())
+		{
+			return;
+		}
+
+		int const seconds = 100;
+		std::vector<F32> float_buffer(2 * 1024);
+		std::vector<S16> short_buffer(2 * 4410);
+		F64 times[4];
+		LLTimer timer;
+		{
+			LLReferenceWindGen<F32> reference;
+			reference.mTargetGain = 1.f;
+			for (int i = 0; i < seconds * 44100 / 1024; ++i)
+			{
+				reference.windGenerate(&float_buffer[0], 1024);
+			}
+			times[0] = timer.getElapsedTimeF64();
+		}
+		timer.reset();
+		{
+			LLWindGen<F32> gen;
+			gen.mTargetGain = 1.f;
+			for (int i = 0; i < seconds * 44100 / 1024; ++i)
+			{
+				gen.windGenerate(&float_buffer[0], 1024);
+			}
+			times[1] = timer.getElapsedTimeF64();
+		}
+		timer.reset();
+		{
+			LLReferenceWindGen<S16> reference;
+			reference.mTargetGain = 1.f;
+			for (int i = 0; i < seconds * 10; ++i)
+			{
+				reference.windGenerate(&short_buffer[0], 4410);
+			}
+			times[2] = timer.getElapsedTimeF64();
+		}
+		timer.reset();
+		{
+			LLWindGen<S16> gen;
+			gen.mTargetGain = 1.f;
+			for (int i = 0; i < seconds * 10; ++i)
+			{
+				gen.windGenerate(&short_buffer[0], 4410);
+			}
+			times[3] = timer.getElapsedTimeF64();
+		}
+
+		F64 const frames = seconds * 44100.0;
+		llinfos << "Wind, millions of stereo frames per second: float " << frames / times[0] / 1e6 << " before, "
+				<< frames / times[1] / 1e6 << " now; 16-bit " << frames / times[2] / 1e6 << " before, "
+				<< frames / times[3] / 1e6 << " now." << llendl;
+	}
+}